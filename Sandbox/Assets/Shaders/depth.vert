@@ -0,0 +1,45 @@
+#version 450
+
+//---------------------------------------------------------------------------------------------------------------------
+//-- Input from Program, position stream only (see Helper::VertexLayoutP)
+layout(location = 0) in vec4 in_Pos;        // xyz: unorm inside mesh bounds, w: tangent handedness, unused here
+
+// Must match triangle.vert bit for bit, forward pass tests LESS_OR_EQUAL against this depth!
+invariant gl_Position;
+
+//---------------------------------------------------------------------------------------------------------------------
+//-- Uniforms, same layout as triangle.vert
+layout(set = 0, binding = 0) uniform mvpData
+{
+    mat4 World;
+    mat4 View;
+    mat4 Projection;
+
+    vec4 albedoColor;
+    vec4 emissionColor;
+    vec4 hasTextureAEN;
+    vec4 hasTextureRMO;
+    float occlusion;
+    float roughness;
+    float metalness;
+
+}shaderData;
+
+//-- Per mesh dequantization bounds
+layout(push_constant) uniform meshData
+{
+    vec4 boundsMin;
+    vec4 boundsExtent;
+    vec4 gridOffset;
+
+}meshBounds;
+
+//---------------------------------------------------------------------------------------------------------------------
+void main()
+{
+    // Whole grid steps first, so pages sharing a vertex compute exactly the same position
+    vec3 grid = round(in_Pos.xyz * 65535.0f) + meshBounds.gridOffset.xyz;
+    vec3 position = meshBounds.boundsMin.xyz + grid * (meshBounds.boundsExtent.xyz / 65535.0f);
+
+    gl_Position = shaderData.Projection * shaderData.View * shaderData.World * vec4(position, 1.0f);
+}
@@ -29,6 +29,9 @@ layout(set = 0, binding = 0) uniform mvpData
 
 //-- Textures
 layout(set = 0, binding = 1) uniform sampler2D samplerAlbedoTexture;
+layout(set = 0, binding = 2) uniform sampler2D samplerORMTexture;        // Occlusion | Roughness | Metalness
+layout(set = 0, binding = 3) uniform sampler2D samplerNormalTexture;
+layout(set = 0, binding = 4) uniform sampler2D samplerEmissionTexture;
 
 //---------------------------------------------------------------------------------------------------------------------
 void main()
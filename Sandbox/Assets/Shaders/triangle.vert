@@ -1,18 +1,32 @@
 #version 450
 
 //---------------------------------------------------------------------------------------------------------------------
-//-- Input from Program
-layout(location = 0) in vec3 in_Pos;
-layout(location = 1) in vec3 in_Normal;
-layout(location = 2) in vec3 in_Tangent;
-layout(location = 3) in vec3 in_BiNormal;
-layout(location = 4) in vec2 in_UV;
+//-- One variant per Helper::EVertexFormat, inputs must match its Helper::VertexLayout exactly. Built by
+//-- VulkanApplication::RunShaderCompiler:
+//--    triangle_pn.vert.spv    glslc triangle.vert -o triangle_pn.vert.spv
+//--    triangle_pnu.vert.spv   glslc -DHAS_UV triangle.vert -o triangle_pnu.vert.spv
+//--    triangle.vert.spv       glslc -DHAS_UV -DHAS_TANGENT triangle.vert -o triangle.vert.spv
+//-- Tangent isn't read yet, nothing normal maps. Only cooked with Helper::g_bCookTangents on!
+
+//---------------------------------------------------------------------------------------------------------------------
+//-- Input from Program, quantized (see Helper::VertexLayout). Position is binding 0, the rest binding 1
+layout(location = 0) in vec4 in_Pos;        // xyz: unorm inside mesh bounds, w: tangent handedness 0 | 1
+layout(location = 1) in vec2 in_Normal;     // octahedral
+#ifdef HAS_TANGENT
+layout(location = 2) in vec2 in_Tangent;    // octahedral
+#endif
+#ifdef HAS_UV
+layout(location = 3) in vec2 in_UV;
+#endif
 
 //---------------------------------------------------------------------------------------------------------------------
 //-- Output to Fragment shader
 layout(location = 0) out vec2 vs_outUV;
 layout(location = 1) out vec3 vs_outNormal;
 
+// Depth prepass computes the same position, both must land on exactly the same depth!
+invariant gl_Position;
+
 //---------------------------------------------------------------------------------------------------------------------
 //-- Uniforms
 layout(set = 0, binding = 0) uniform mvpData
@@ -31,10 +45,39 @@ layout(set = 0, binding = 0) uniform mvpData
 
 }shaderData;
 
+//-- Per mesh dequantization bounds
+layout(push_constant) uniform meshData
+{
+    vec4 boundsMin;
+    vec4 boundsExtent;
+    vec4 gridOffset;
+
+}meshBounds;
+
+//---------------------------------------------------------------------------------------------------------------------
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0f);
+    n.x += (n.x >= 0.0f) ? -t : t;
+    n.y += (n.y >= 0.0f) ? -t : t;
+
+    return normalize(n);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void main()
 {
-    gl_Position = shaderData.Projection * shaderData.View * shaderData.World * vec4(in_Pos, 1.0f);
+    // Whole grid steps first, so pages sharing a vertex compute exactly the same position
+    vec3 grid = round(in_Pos.xyz * 65535.0f) + meshBounds.gridOffset.xyz;
+    vec3 position = meshBounds.boundsMin.xyz + grid * (meshBounds.boundsExtent.xyz / 65535.0f);
+    vec3 normal = OctahedralDecode(in_Normal);
+
+    gl_Position = shaderData.Projection * shaderData.View * shaderData.World * vec4(position, 1.0f);
+#ifdef HAS_UV
     vs_outUV = in_UV;
-    vs_outNormal = in_Normal;
+#else
+    vs_outUV = vec2(0.0f);
+#endif
+    vs_outNormal = normal;
 }
\ No newline at end of file
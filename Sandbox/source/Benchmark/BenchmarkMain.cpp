@@ -0,0 +1,63 @@
+#include "sandboxPCH.h"
+#include "Benchmarks.h"
+#include "Core/Core.h"
+
+namespace
+{
+	struct Benchmark
+	{
+		const char*		strName;
+		bool			(*pfnRun)();
+	};
+
+	const Benchmark gBenchmarks[] =
+	{
+		{ "textures",	RunTextureUploadBenchmark },
+		{ "meshopt",	RunMeshOptimizerBenchmark },
+		{ "meshproc",	RunMeshProcessingBenchmark },
+	};
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Benchmark [name...]
+//	textures			uploads one texture set through the staging ring & with host image copy. Run it on lavapipe
+//						(VK_ICD_FILENAMES pointing at lvp_icd json) for numbers comparable between machines
+//	meshopt				vertex cache & overdraw passes on fixed meshes, cache stats before & after with time per pass
+//	meshproc			welding & tangents by MeshProcessor (caller only & on all cores) vs Assimp on one generated model
+// Runs all of them when no name is given!
+int main(int argc, char** argv)
+{
+	std::vector<const Benchmark*> listBenchmarks;
+
+	for (int i = 1; i < argc; i++)
+	{
+		auto iter = std::find_if(std::begin(gBenchmarks), std::end(gBenchmarks), [&](const Benchmark& benchmark) { return benchmark.strName == std::string(argv[i]); });
+		if (iter == std::end(gBenchmarks))
+		{
+			LOG_ERROR("Unknown benchmark {0}!", argv[i]);
+			return EXIT_FAILURE;
+		}
+
+		listBenchmarks.push_back(&(*iter));
+	}
+
+	if (listBenchmarks.empty())
+	{
+		for (const Benchmark& benchmark : gBenchmarks)
+			listBenchmarks.push_back(&benchmark);
+	}
+
+	bool bSucceeded = true;
+	for (const Benchmark* pBenchmark : listBenchmarks)
+	{
+		LOG_INFO("---------- {0} ----------", pBenchmark->strName);
+
+		if (!pBenchmark->pfnRun())
+		{
+			LOG_ERROR("Benchmark {0} couldn't run!", pBenchmark->strName);
+			bSucceeded = false;
+		}
+	}
+
+	return bSucceeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
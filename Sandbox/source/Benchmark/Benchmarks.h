@@ -0,0 +1,14 @@
+#pragma once
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every benchmark runs on fixed inputs it builds itself, so numbers only move when the code they measure does. Each
+// logs its own report & returns false only if it couldn't run at all!
+
+// Same texture set uploaded through the staging ring & with host image copy, needs a Vulkan device but no window
+bool RunTextureUploadBenchmark();
+
+// Vertex cache & overdraw passes on shuffled generated meshes, ACMR/ATVR before & after plus time per pass
+bool RunMeshOptimizerBenchmark();
+
+// MeshProcessor against Assimp's JoinIdenticalVertices & CalcTangentSpace on the same generated model, triangles/s
+bool RunMeshProcessingBenchmark();
@@ -0,0 +1,154 @@
+#include "sandboxPCH.h"
+#include "Benchmarks.h"
+#include "Renderables/MeshOptimizer.h"
+#include "glm/gtc/constants.hpp"
+#include "Core/Core.h"
+
+namespace
+{
+	const uint32_t gNumRounds = 5;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	struct BenchmarkMesh
+	{
+		const char*						strName;
+		std::vector<glm::vec3>			listPositions;
+		std::vector<uint32_t>			listIndices;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Triangle order scrambled with a fixed seed, so the passes start from the worst case an importer could hand them
+	// & every run starts from the same one!
+	void ShuffleTriangles(std::vector<uint32_t>& listIndices, uint32_t uiSeed)
+	{
+		const size_t numTriangles = listIndices.size() / 3;
+
+		for (size_t i = numTriangles - 1; i > 0; i--)
+		{
+			uiSeed ^= uiSeed << 13;
+			uiSeed ^= uiSeed >> 17;
+			uiSeed ^= uiSeed << 5;
+
+			const size_t other = uiSeed % (i + 1);
+			std::swap_ranges(listIndices.begin() + i * 3, listIndices.begin() + i * 3 + 3, listIndices.begin() + other * 3);
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Flat terrain like grid, (size + 1)^2 vertices & 2 * size^2 triangles
+	BenchmarkMesh CreateGrid(uint32_t size)
+	{
+		BenchmarkMesh mesh;
+		mesh.strName = "Grid";
+
+		for (uint32_t z = 0; z <= size; z++)
+		{
+			for (uint32_t x = 0; x <= size; x++)
+				mesh.listPositions.push_back(glm::vec3(static_cast<float>(x), 0.0f, static_cast<float>(z)));
+		}
+
+		for (uint32_t z = 0; z < size; z++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const uint32_t corner = z * (size + 1) + x;
+				mesh.listIndices.insert(mesh.listIndices.end(), { corner, corner + size + 1, corner + 1 });
+				mesh.listIndices.insert(mesh.listIndices.end(), { corner + 1, corner + size + 1, corner + size + 2 });
+			}
+		}
+
+		ShuffleTriangles(mesh.listIndices, 0x9E3779B9);
+		return mesh;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Closed UV sphere, the overdraw pass has both front & back facing clusters to sort here. Seam column is duplicated
+	// like a textured mesh would have it!
+	BenchmarkMesh CreateSphere(uint32_t rings, uint32_t segments)
+	{
+		BenchmarkMesh mesh;
+		mesh.strName = "Sphere";
+
+		for (uint32_t ring = 0; ring <= rings; ring++)
+		{
+			const float theta = glm::pi<float>() * ring / rings;
+
+			for (uint32_t segment = 0; segment <= segments; segment++)
+			{
+				const float phi = glm::two_pi<float>() * segment / segments;
+				mesh.listPositions.push_back(glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+			}
+		}
+
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				const uint32_t corner = ring * (segments + 1) + segment;
+				mesh.listIndices.insert(mesh.listIndices.end(), { corner, corner + 1, corner + segments + 1 });
+				mesh.listIndices.insert(mesh.listIndices.end(), { corner + 1, corner + segments + 2, corner + segments + 1 });
+			}
+		}
+
+		ShuffleTriangles(mesh.listIndices, 0x85EBCA6B);
+		return mesh;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	float ElapsedMs(std::chrono::steady_clock::time_point startTime)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Both passes run on a fresh copy of the shuffled indices every round, stats come from the last round. They're
+	// deterministic, so any round gives the same ones!
+	void RunPasses(const BenchmarkMesh& mesh)
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(mesh.listPositions.size());
+		const float* pPositions = &(mesh.listPositions[0].x);
+
+		const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.listIndices, vertexCount);
+		VertexCacheStats afterCache = {};
+		VertexCacheStats afterOverdraw = {};
+
+		float fBestCacheMs = std::numeric_limits<float>::max();
+		float fBestOverdrawMs = std::numeric_limits<float>::max();
+
+		for (uint32_t round = 0; round < gNumRounds; round++)
+		{
+			std::vector<uint32_t> listIndices = mesh.listIndices;
+
+			auto startTime = std::chrono::steady_clock::now();
+			MeshOptimizer::OptimizeVertexCache(listIndices, vertexCount);
+			fBestCacheMs = std::min(fBestCacheMs, ElapsedMs(startTime));
+
+			afterCache = MeshOptimizer::AnalyzeVertexCache(listIndices, vertexCount);
+
+			startTime = std::chrono::steady_clock::now();
+			MeshOptimizer::OptimizeOverdraw(listIndices, pPositions, sizeof(glm::vec3), vertexCount);
+			fBestOverdrawMs = std::min(fBestOverdrawMs, ElapsedMs(startTime));
+
+			afterOverdraw = MeshOptimizer::AnalyzeVertexCache(listIndices, vertexCount);
+		}
+
+		const size_t numTriangles = mesh.listIndices.size() / 3;
+		LOG_INFO("{0}: {1} vertices, {2} triangles", mesh.strName, vertexCount, numTriangles);
+		LOG_INFO("    shuffled       ACMR {0:.3f}, ATVR {1:.3f}", before.fACMR, before.fATVR);
+		LOG_INFO("    vertex cache   ACMR {0:.3f}, ATVR {1:.3f}, {2:.2f} ms, {3:.1f} M tris/s", afterCache.fACMR, afterCache.fATVR, fBestCacheMs,
+			numTriangles / (fBestCacheMs * 1000.0f));
+		LOG_INFO("    + overdraw     ACMR {0:.3f}, ATVR {1:.3f}, {2:.2f} ms, {3:.1f} M tris/s", afterOverdraw.fACMR, afterOverdraw.fATVR, fBestOverdrawMs,
+			numTriangles / (fBestOverdrawMs * 1000.0f));
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool RunMeshOptimizerBenchmark()
+{
+	LOG_INFO("Best of {0} rounds, 16 entry FIFO cache", gNumRounds);
+
+	RunPasses(CreateGrid(256));
+	RunPasses(CreateSphere(256, 512));
+
+	return true;
+}
@@ -0,0 +1,187 @@
+#include "sandboxPCH.h"
+#include "Benchmarks.h"
+#include "Renderables/MeshProcessor.h"
+#include "Core/ThreadPool.h"
+#include "Core/Core.h"
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "glm/gtc/constants.hpp"
+
+namespace
+{
+	const uint32_t gNumRounds = 5;
+
+	// Same flags ModelImporter reads with, everything after them is what gets timed
+	const uint32_t gImportFlags = aiProcess_Triangulate | aiProcess_FixInfacingNormals | aiProcess_FlipUVs;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	struct ProcessTimings
+	{
+		ProcessTimings() : fBestMs(std::numeric_limits<float>::max()), numTriangles(0), numVertices(0) {}
+
+		float							fBestMs;
+		uint64_t						numTriangles;
+		uint64_t						numVertices;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Grid & UV sphere with positions, normals & UVs as an OBJ, so Assimp imports it like any model file. OBJ faces
+	// index each attribute on their own, Assimp hands out one vertex per face corner & both paths have all of the
+	// welding to do!
+	std::string CreateObjFile(uint32_t gridSize, uint32_t rings, uint32_t segments)
+	{
+		std::ostringstream obj;
+		obj << std::fixed << std::setprecision(6);
+
+		obj << "o Grid\n";
+		for (uint32_t z = 0; z <= gridSize; z++)
+		{
+			for (uint32_t x = 0; x <= gridSize; x++)
+			{
+				obj << "v " << x << " 0 " << z << "\n";
+				obj << "vt " << x / static_cast<float>(gridSize) << " " << z / static_cast<float>(gridSize) << "\n";
+			}
+		}
+
+		obj << "vn 0 1 0\n";
+		for (uint32_t z = 0; z < gridSize; z++)
+		{
+			for (uint32_t x = 0; x < gridSize; x++)
+			{
+				// OBJ indices are 1 based
+				const uint32_t corner = z * (gridSize + 1) + x + 1;
+				const uint32_t c[4] = { corner, corner + gridSize + 1, corner + 1, corner + gridSize + 2 };
+
+				obj << "f " << c[0] << "/" << c[0] << "/1 " << c[1] << "/" << c[1] << "/1 " << c[2] << "/" << c[2] << "/1\n";
+				obj << "f " << c[2] << "/" << c[2] << "/1 " << c[1] << "/" << c[1] << "/1 " << c[3] << "/" << c[3] << "/1\n";
+			}
+		}
+
+		// Sphere's attributes come after the grid's, OBJ indices run over the whole file
+		const uint32_t firstPosition = (gridSize + 1) * (gridSize + 1) + 1;
+		const uint32_t firstNormal = 2;
+
+		obj << "o Sphere\n";
+		for (uint32_t ring = 0; ring <= rings; ring++)
+		{
+			const float theta = glm::pi<float>() * ring / rings;
+
+			for (uint32_t segment = 0; segment <= segments; segment++)
+			{
+				const float phi = glm::two_pi<float>() * segment / segments;
+				const glm::vec3 position(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+				obj << "v " << position.x << " " << position.y << " " << position.z << "\n";
+				obj << "vn " << position.x << " " << position.y << " " << position.z << "\n";
+				obj << "vt " << segment / static_cast<float>(segments) << " " << ring / static_cast<float>(rings) << "\n";
+			}
+		}
+
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				const uint32_t corner = ring * (segments + 1) + segment;
+				const uint32_t c[4] = { corner, corner + 1, corner + segments + 1, corner + segments + 2 };
+
+				obj << "f";
+				for (uint32_t k : { 0, 1, 2 })
+					obj << " " << firstPosition + c[k] << "/" << firstPosition + c[k] << "/" << firstNormal + c[k];
+				obj << "\nf";
+				for (uint32_t k : { 1, 3, 2 })
+					obj << " " << firstPosition + c[k] << "/" << firstPosition + c[k] << "/" << firstNormal + c[k];
+				obj << "\n";
+			}
+		}
+
+		return obj.str();
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Fresh import every round since both paths rewrite the meshes, only welding & tangents are timed. Same split
+	// ModelImporter::ProcessMeshes times & logs!
+	bool RunRounds(const std::string& objFile, bool bMeshProcessor, ThreadPool* pWorkers, ProcessTimings* pOutTimings)
+	{
+		for (uint32_t round = 0; round <= gNumRounds; round++)
+		{
+			Assimp::Importer importer;
+			const aiScene* scene = importer.ReadFileFromMemory(objFile.data(), objFile.size(), gImportFlags, "obj");
+			if (!scene)
+			{
+				LOG_ERROR("Failed to Assimp read generated model! {0}", importer.GetErrorString());
+				return false;
+			}
+
+			uint64_t numTriangles = 0;
+			auto startTime = std::chrono::steady_clock::now();
+
+			if (bMeshProcessor)
+			{
+				for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+					numTriangles += MeshProcessor::Process(scene->mMeshes[i], pWorkers).uiTriangles;
+			}
+			else
+			{
+				scene = importer.ApplyPostProcessing(aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace);
+				if (!scene)
+				{
+					LOG_ERROR("Assimp post processing failed! {0}", importer.GetErrorString());
+					return false;
+				}
+
+				for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+					numTriangles += scene->mMeshes[i]->mNumFaces;
+			}
+
+			const float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+			// First round warms up allocator & workers
+			if (round == 0)
+				continue;
+
+			pOutTimings->fBestMs = std::min(pOutTimings->fBestMs, elapsedMs);
+			pOutTimings->numTriangles = numTriangles;
+			pOutTimings->numVertices = 0;
+
+			for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+				pOutTimings->numVertices += scene->mMeshes[i]->mNumVertices;
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void LogTimings(const std::string& strPath, const ProcessTimings& timings)
+	{
+		LOG_INFO("{0}: best {1:.2f} ms, {2:.2f} M triangles/s, {3} vertices after welding", strPath, timings.fBestMs,
+					timings.numTriangles / (timings.fBestMs * 1000.0f), timings.numVertices);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool RunMeshProcessingBenchmark()
+{
+	const std::string objFile = CreateObjFile(512, 256, 512);
+
+	const uint32_t numCores = std::thread::hardware_concurrency();
+	const uint32_t numWorkers = numCores > 0 ? numCores : 1;
+	ThreadPool workers(numWorkers);
+
+	LOG_INFO("Generated grid & sphere, {0:.1f} MB of OBJ, best of {1} rounds", objFile.size() / (1024.0f * 1024.0f), gNumRounds);
+
+	ProcessTimings assimpTimings, singleTimings, workerTimings;
+	if (!RunRounds(objFile, false, nullptr, &assimpTimings) || !RunRounds(objFile, true, nullptr, &singleTimings) ||
+		!RunRounds(objFile, true, &workers, &workerTimings))
+	{
+		return false;
+	}
+
+	LOG_INFO("{0} triangles", assimpTimings.numTriangles);
+	LogTimings("Assimp JoinIdenticalVertices + CalcTangentSpace", assimpTimings);
+	LogTimings("MeshProcessor, caller only", singleTimings);
+	LogTimings("MeshProcessor, " + std::to_string(numWorkers) + " workers", workerTimings);
+	LOG_INFO("MeshProcessor is {0:.2f}x (caller only) & {1:.2f}x ({2} workers) as fast as Assimp", assimpTimings.fBestMs / singleTimings.fBestMs,
+				assimpTimings.fBestMs / workerTimings.fBestMs, numWorkers);
+
+	return true;
+}
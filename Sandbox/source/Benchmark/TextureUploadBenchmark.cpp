@@ -0,0 +1,414 @@
+#include "sandboxPCH.h"
+#include "Benchmarks.h"
+#include "Renderer/VulkanContext.h"
+#include "Renderer/VulkanStagingRing.h"
+#include "Renderer/VulkanTexture.h"
+#include "Renderer/VulkanUploadBatch.h"
+#include "Core/Core.h"
+
+namespace
+{
+	// Same capacity as the renderer's ring, whole set fits in half of it just like one streamer batch may!
+	const VkDeviceSize gStagingRingSize = 128 * 1024 * 1024;
+	const uint32_t gNumRounds = 5;
+
+	// Square RGBA8 textures with full mip chains, ~60 MB in all
+	const uint32_t gTextureSizes[][2] =
+	{
+		{ 2048, 1 },
+		{ 1024, 4 },
+		{ 512, 8 },
+		{ 256, 16 },
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	struct SourceTexture
+	{
+		uint32_t						uiSize;
+		uint32_t						uiNumMips;
+		std::vector<unsigned char>		listPixels;					// smallest mip first, like cooked textures
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	struct UploadTimings
+	{
+		UploadTimings() : fBestMs(std::numeric_limits<float>::max()), fTotalMs(0.0f) {}
+
+		float							fBestMs;
+		float							fTotalMs;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Noise, so no driver can take a shortcut on constant data. Fixed seed, every run uploads the same bytes!
+	std::vector<SourceTexture> CreateTextureSet()
+	{
+		std::vector<SourceTexture> listTextures;
+		uint32_t uiState = 0x9E3779B9;
+
+		for (const auto& sizeAndCount : gTextureSizes)
+		{
+			for (uint32_t i = 0; i < sizeAndCount[1]; i++)
+			{
+				SourceTexture texture;
+				texture.uiSize = sizeAndCount[0];
+				texture.uiNumMips = Helper::GetMipCount(texture.uiSize, texture.uiSize);
+				texture.listPixels.resize(static_cast<size_t>(Helper::GetMipRangeSize(texture.uiSize, texture.uiSize, 0, texture.uiNumMips)));
+
+				for (unsigned char& pixel : texture.listPixels)
+				{
+					uiState ^= uiState << 13;
+					uiState ^= uiState >> 17;
+					uiState ^= uiState << 5;
+					pixel = static_cast<unsigned char>(uiState);
+				}
+
+				listTextures.push_back(std::move(texture));
+			}
+		}
+
+		return listTextures;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Same checks VulkanDevice does before it enables host image copy!
+	bool QueryHostImageCopySupport(VkPhysicalDevice physicalDevice)
+	{
+#ifdef VK_EXT_host_image_copy
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+		std::vector<VkExtensionProperties> listExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, listExtensions.data());
+
+		if (std::none_of(listExtensions.begin(), listExtensions.end(), [](const VkExtensionProperties& extension) { return strcmp(extension.extensionName, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) == 0; }))
+			return false;
+
+		VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {};
+		hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &hostImageCopyFeatures;
+
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+		if (!hostImageCopyFeatures.hostImageCopy)
+			return false;
+
+		VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProps = {};
+		hostImageCopyProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT;
+
+		VkPhysicalDeviceProperties2 props2 = {};
+		props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		props2.pNext = &hostImageCopyProps;
+
+		vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+
+		std::vector<VkImageLayout> listDstLayouts(hostImageCopyProps.copyDstLayoutCount);
+		hostImageCopyProps.pCopyDstLayouts = listDstLayouts.data();
+		hostImageCopyProps.copySrcLayoutCount = 0;
+
+		vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+
+		return std::find(listDstLayouts.begin(), listDstLayouts.end(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) != listDstLayouts.end();
+#else
+		return false;
+#endif
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// No surface, no swapchain: first device with a graphics queue, which does transfers too. Host image copy is
+	// enabled whenever it's there, just like the renderer does.
+	bool CreateHeadlessContext(VulkanContext* pContext)
+	{
+		VkApplicationInfo appInfo = {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Benchmark";
+		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.pEngineName = "Sandbox";
+		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.apiVersion = VK_API_VERSION_1_3;
+
+		VkInstanceCreateInfo instCreateInfo = {};
+		instCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instCreateInfo.pApplicationInfo = &appInfo;
+
+		VK_CHECK(vkCreateInstance(&instCreateInfo, nullptr, &(pContext->vkInst)));
+
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(pContext->vkInst, &deviceCount, nullptr);
+
+		std::vector<VkPhysicalDevice> listDevices(deviceCount);
+		vkEnumeratePhysicalDevices(pContext->vkInst, &deviceCount, listDevices.data());
+
+		std::optional<uint32_t> graphicsFamily;
+		for (VkPhysicalDevice physicalDevice : listDevices)
+		{
+			uint32_t queueFamilyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+			std::vector<VkQueueFamilyProperties> listQueueFamilies(queueFamilyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, listQueueFamilies.data());
+
+			for (uint32_t i = 0; i < queueFamilyCount && !graphicsFamily.has_value(); i++)
+			{
+				if (listQueueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+					graphicsFamily = i;
+			}
+
+			if (graphicsFamily.has_value())
+			{
+				pContext->vkPhysicalDevice = physicalDevice;
+				break;
+			}
+		}
+
+		if (pContext->vkPhysicalDevice == VK_NULL_HANDLE)
+		{
+			LOG_ERROR("No Vulkan device with a graphics queue!");
+			return false;
+		}
+
+		VkPhysicalDeviceProperties deviceProps;
+		vkGetPhysicalDeviceProperties(pContext->vkPhysicalDevice, &deviceProps);
+		vkGetPhysicalDeviceMemoryProperties(pContext->vkPhysicalDevice, &(pContext->vkDeviceMemoryProps));
+
+		LOG_INFO("Device: {0}", deviceProps.deviceName);
+
+		float queuePriority = 1.0f;
+
+		VkDeviceQueueCreateInfo queueCreateInfo = {};
+		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueCreateInfo.queueFamilyIndex = graphicsFamily.value();
+		queueCreateInfo.queueCount = 1;
+		queueCreateInfo.pQueuePriorities = &queuePriority;
+
+		VkDeviceCreateInfo deviceCreateInfo = {};
+		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceCreateInfo.queueCreateInfoCount = 1;
+		deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
+
+		std::vector<const char*> listExtensions;
+
+#ifdef VK_EXT_host_image_copy
+		VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {};
+		hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+
+		if (QueryHostImageCopySupport(pContext->vkPhysicalDevice))
+		{
+			listExtensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+			hostImageCopyFeatures.hostImageCopy = VK_TRUE;
+			deviceCreateInfo.pNext = &hostImageCopyFeatures;
+			pContext->bHostImageCopy = true;
+		}
+#endif
+
+		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(listExtensions.size());
+		deviceCreateInfo.ppEnabledExtensionNames = listExtensions.data();
+
+		VK_CHECK(vkCreateDevice(pContext->vkPhysicalDevice, &deviceCreateInfo, nullptr, &(pContext->vkDevice)));
+
+		pContext->uiGraphicsQueueFamily = graphicsFamily.value();
+		pContext->uiTransferQueueFamily = graphicsFamily.value();
+		vkGetDeviceQueue(pContext->vkDevice, graphicsFamily.value(), 0, &(pContext->vkQueueGraphics));
+		pContext->vkQueueTransfer = pContext->vkQueueGraphics;
+
+#ifdef VK_EXT_host_image_copy
+		if (pContext->bHostImageCopy)
+		{
+			pContext->pfnCopyMemoryToImage = reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(vkGetDeviceProcAddr(pContext->vkDevice, "vkCopyMemoryToImageEXT"));
+			pContext->pfnTransitionImageLayout = reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(vkGetDeviceProcAddr(pContext->vkDevice, "vkTransitionImageLayoutEXT"));
+
+			pContext->bHostImageCopy = pContext->pfnCopyMemoryToImage && pContext->pfnTransitionImageLayout;
+		}
+#endif
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = graphicsFamily.value();
+
+		VK_CHECK(vkCreateCommandPool(pContext->vkDevice, &poolInfo, nullptr, &(pContext->vkGraphicsCommandPool)));
+		VK_CHECK(vkCreateCommandPool(pContext->vkDevice, &poolInfo, nullptr, &(pContext->vkTransferCommandPool)));
+
+		pContext->pStagingRing = new VulkanStagingRing();
+		CHECK(pContext->pStagingRing->Initialize(pContext, gStagingRingSize));
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void DestroyHeadlessContext(VulkanContext* pContext)
+	{
+		if (pContext->pStagingRing)
+		{
+			pContext->pStagingRing->Cleanup(pContext);
+			SAFE_DELETE(pContext->pStagingRing);
+		}
+
+		if (pContext->vkDevice != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(pContext->vkDevice, pContext->vkGraphicsCommandPool, nullptr);
+			vkDestroyCommandPool(pContext->vkDevice, pContext->vkTransferCommandPool, nullptr);
+			vkDestroyDevice(pContext->vkDevice, nullptr);
+		}
+
+		if (pContext->vkInst != VK_NULL_HANDLE)
+			vkDestroyInstance(pContext->vkInst, nullptr);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// What the streamer does for one batch: each file is read into a ring allocation of its own (memcpy stands in for
+	// the read), images are allocated & every copy goes into one submit. Timed till its fence has signaled!
+	bool UploadWithStaging(const VulkanContext* pContext, const std::vector<SourceTexture>& listSources, std::vector<VulkanTexture*>& outListTextures,
+							float* pOutElapsedMs)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+
+		VulkanUploadBatch batch;
+		bool bUploaded = batch.Begin(pContext, 0);
+
+		for (size_t i = 0; bUploaded && i < listSources.size(); i++)
+		{
+			const SourceTexture& source = listSources[i];
+
+			StagingAllocation staging;
+			bUploaded = pContext->pStagingRing->Allocate(pContext, source.listPixels.size(), &staging);
+			if (!bUploaded)
+				break;
+
+			memcpy(staging.pMappedData, source.listPixels.data(), source.listPixels.size());
+			batch.AdoptStaging(staging);
+
+			VulkanTexture* pTexture = new VulkanTexture();
+			outListTextures.push_back(pTexture);
+
+			bUploaded = pTexture->AllocateImage(pContext, source.uiSize, source.uiSize, source.uiNumMips, 0, VK_FORMAT_R8G8B8A8_UNORM);
+			if (bUploaded)
+				pTexture->RecordUpload(&batch, staging.offset, 0, source.uiNumMips, staging.buffer);
+		}
+
+		bUploaded = bUploaded && batch.Submit(pContext);
+		*pOutElapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		batch.Cleanup(pContext);
+		return bUploaded;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// What a streamer worker does per file with host image copy: allocate & write every mip straight from memory.
+	// Single threaded here, just like the staging path above!
+	bool UploadWithHostCopy(const VulkanContext* pContext, const std::vector<SourceTexture>& listSources, std::vector<VulkanTexture*>& outListTextures,
+							float* pOutElapsedMs)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+
+		bool bUploaded = true;
+		for (size_t i = 0; bUploaded && i < listSources.size(); i++)
+		{
+			const SourceTexture& source = listSources[i];
+
+			VulkanTexture* pTexture = new VulkanTexture();
+			outListTextures.push_back(pTexture);
+
+			bUploaded = pTexture->AllocateImage(pContext, source.uiSize, source.uiSize, source.uiNumMips, 0, VK_FORMAT_R8G8B8A8_UNORM, true) &&
+						pTexture->UploadFromHost(pContext, source.listPixels.data(), 0, source.uiNumMips);
+		}
+
+		*pOutElapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		return bUploaded;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// One warm up round first, it pays for first time driver allocations on either path!
+	bool RunRounds(const VulkanContext* pContext, const std::vector<SourceTexture>& listSources, bool bHostCopy, UploadTimings* pOutTimings)
+	{
+		for (uint32_t round = 0; round <= gNumRounds; round++)
+		{
+			std::vector<VulkanTexture*> listTextures;
+			float elapsedMs = 0.0f;
+
+			bool bUploaded = bHostCopy ? UploadWithHostCopy(pContext, listSources, listTextures, &elapsedMs)
+										: UploadWithStaging(pContext, listSources, listTextures, &elapsedMs);
+
+			vkDeviceWaitIdle(pContext->vkDevice);
+
+			for (VulkanTexture* pTexture : listTextures)
+			{
+				pTexture->Cleanup(pContext);
+				SAFE_DELETE(pTexture);
+			}
+
+			if (!bUploaded)
+			{
+				LOG_ERROR("{0} upload failed!", bHostCopy ? "Host image copy" : "Staging");
+				return false;
+			}
+
+			if (round == 0)
+				continue;
+
+			pOutTimings->fBestMs = std::min(pOutTimings->fBestMs, elapsedMs);
+			pOutTimings->fTotalMs += elapsedMs;
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void LogTimings(const char* strPath, const UploadTimings& timings, uint64_t totalBytes)
+	{
+		const float totalMB = totalBytes / (1024.0f * 1024.0f);
+		LOG_INFO("{0}: best {1:.2f} ms, average {2:.2f} ms, {3:.0f} MB/s", strPath, timings.fBestMs, timings.fTotalMs / gNumRounds, totalMB / (timings.fBestMs / 1000.0f));
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool RunTextureUploadBenchmark()
+{
+	std::vector<SourceTexture> listSources = CreateTextureSet();
+
+	uint64_t totalBytes = 0;
+	for (const SourceTexture& source : listSources)
+		totalBytes += source.listPixels.size();
+
+	VulkanContext context;
+	if (!CreateHeadlessContext(&context))
+	{
+		DestroyHeadlessContext(&context);
+		return false;
+	}
+
+	LOG_INFO("{0} textures, {1:.1f} MB with mips, best of {2} rounds", listSources.size(), totalBytes / (1024.0f * 1024.0f), gNumRounds);
+
+	bool bSucceeded = true;
+
+	UploadTimings stagingTimings;
+	if (RunRounds(&context, listSources, false, &stagingTimings))
+		LogTimings("Staging ring + submit", stagingTimings, totalBytes);
+	else
+		bSucceeded = false;
+
+	if (!context.SupportsHostImageCopy(VK_FORMAT_R8G8B8A8_UNORM))
+	{
+		LOG_WARNING("Device can't host copy RGBA8, only the staging path was measured!");
+	}
+	else
+	{
+		UploadTimings hostCopyTimings;
+		if (RunRounds(&context, listSources, true, &hostCopyTimings))
+		{
+			LogTimings("Host image copy", hostCopyTimings, totalBytes);
+
+			if (bSucceeded)
+				LOG_INFO("Host image copy takes {0:.2f}x the time of the staging path", hostCopyTimings.fBestMs / stagingTimings.fBestMs);
+		}
+		else
+		{
+			bSucceeded = false;
+		}
+	}
+
+	DestroyHeadlessContext(&context);
+	return bSucceeded;
+}
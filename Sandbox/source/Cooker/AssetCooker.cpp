@@ -0,0 +1,570 @@
+#include "sandboxPCH.h"
+#include "AssetCooker.h"
+#include "Renderer/CookedFormat.h"
+#include "Renderer/ImageDecoder.h"
+#include "Renderer/VertexLayout.h"
+#include "Renderables/ModelImporter.h"
+#include "World/SceneFile.h"
+#include "World/SceneSnapshot.h"
+#include "Core/VirtualFileSystem.h"
+#include "PackBuilder.h"
+#include "Core/ThreadPool.h"
+#include "Core/Core.h"
+
+namespace
+{
+	const std::string g_strManifestPath = Helper::g_strCookedRoot + "CookManifest.txt";
+	const uint32_t g_uiManifestVersion = 1;
+
+	const std::set<std::string> g_setTextureExtensions = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".hdr" };
+	const std::set<std::string> g_setModelExtensions = { ".fbx", ".obj", ".gltf", ".glb", ".dae" };
+	const std::set<std::string> g_setSceneExtensions = { ".scene" };
+
+	//-----------------------------------------------------------------------------------------------------------------
+	std::string GetLowerExtension(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		return extension;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+AssetCooker::AssetCooker(bool bForce, bool bMeshProcessor)
+{
+	m_MapManifest.clear();
+	m_bForce = bForce;
+	m_bMeshProcessor = bMeshProcessor;
+
+	uint32_t numCores = std::thread::hardware_concurrency();
+	m_pWorkers = new ThreadPool(numCores > 0 ? numCores : 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+AssetCooker::~AssetCooker()
+{
+	SAFE_DELETE(m_pWorkers);
+	m_MapManifest.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// One job per source file, all of them on the pool. Each job only fills its own manifest entry, they're merged back
+// once everything is done so nothing is shared while jobs run! Scenes go last, their snapshots read the cooked models.
+bool AssetCooker::Run()
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	// Read even when forced, outputs of sources that went away are still cleaned up
+	if (!LoadManifest())
+		LOG_INFO("No usable manifest at {0}, cooking everything", g_strManifestPath);
+
+	std::vector<CookJob> listJobs;
+	GatherJobs(listJobs);
+
+	enum class JobResult { SKIPPED, COOKED, FAILED };
+
+	std::vector<ManifestEntry> listEntries(listJobs.size());
+	std::vector<JobResult> listResults(listJobs.size(), JobResult::FAILED);
+
+	auto EnqueueJob = [&](size_t i)
+	{
+		auto it = m_MapManifest.find(listJobs[i].strOutputPath);
+		if (it != m_MapManifest.end())
+			listEntries[i] = it->second;
+
+		m_pWorkers->Enqueue([this, &listJobs, &listEntries, &listResults, i, bKnown = it != m_MapManifest.end()]()
+		{
+			const CookJob& job = listJobs[i];
+
+			if (bKnown && !m_bForce && IsUpToDate(job, listEntries[i]))
+			{
+				listResults[i] = JobResult::SKIPPED;
+				return;
+			}
+
+			ManifestEntry entry;
+			bool bCooked = false;
+			switch (job.eType)
+			{
+				case CookJobType::TEXTURE:	bCooked = CookTexture(job, entry);	break;
+				case CookJobType::MODEL:	bCooked = CookModel(job, entry);	break;
+				case CookJobType::SCENE:	bCooked = CookScene(job, entry);	break;
+			}
+
+			if (!bCooked)
+			{
+				LOG_ERROR("Failed to cook {0}!", job.strSourcePath);
+				return;
+			}
+
+			if (bKnown)
+				RemoveStaleOutputs(listEntries[i], entry);
+
+			listEntries[i] = std::move(entry);
+			listResults[i] = JobResult::COOKED;
+		});
+	};
+
+	for (size_t i = 0; i < listJobs.size(); i++)
+	{
+		if (listJobs[i].eType != CookJobType::SCENE)
+			EnqueueJob(i);
+	}
+
+	m_pWorkers->WaitIdle();
+
+	for (size_t i = 0; i < listJobs.size(); i++)
+	{
+		if (listJobs[i].eType == CookJobType::SCENE)
+			EnqueueJob(i);
+	}
+
+	m_pWorkers->WaitIdle();
+
+	// Sources that went away take their outputs with them!
+	std::map<std::string, ManifestEntry> mapManifest;
+	for (size_t i = 0; i < listJobs.size(); i++)
+	{
+		// Failed job keeps whatever it had, if anything, with a settings hash that never matches so it's tried again
+		if (listResults[i] == JobResult::FAILED)
+		{
+			auto it = m_MapManifest.find(listJobs[i].strOutputPath);
+			if (it != m_MapManifest.end())
+			{
+				mapManifest[it->first] = it->second;
+				mapManifest[it->first].uiSettingsHash = 0;
+			}
+
+			continue;
+		}
+
+		mapManifest[listJobs[i].strOutputPath] = std::move(listEntries[i]);
+	}
+
+	bool bRemoved = false;
+	for (const auto& entry : m_MapManifest)
+	{
+		if (mapManifest.count(entry.first) > 0)
+			continue;
+
+		LOG_INFO("{0} has no source anymore, removed", entry.first);
+		RemoveStaleOutputs(entry.second, ManifestEntry());
+		bRemoved = true;
+	}
+
+	m_MapManifest.swap(mapManifest);
+
+	if (!SaveManifest())
+		LOG_ERROR("Failed to write {0}, next run cooks everything again!", g_strManifestPath);
+
+	const size_t numCooked = std::count(listResults.begin(), listResults.end(), JobResult::COOKED);
+	const size_t numSkipped = std::count(listResults.begin(), listResults.end(), JobResult::SKIPPED);
+	const size_t numFailed = std::count(listResults.begin(), listResults.end(), JobResult::FAILED);
+
+	// Pack holds every output the manifest knows about, rebuilt only when one of them changed
+	bool bPacked = true;
+	if (numCooked > 0 || bRemoved || m_bForce || !PackBuilder::IsCurrent(Helper::g_strPackPath))
+	{
+		std::vector<std::string> listOutputs;
+		for (const auto& entry : m_MapManifest)
+			listOutputs.insert(listOutputs.end(), entry.second.listOutputs.begin(), entry.second.listOutputs.end());
+
+		bPacked = PackBuilder::Build(listOutputs, Helper::g_strPackPath, m_pWorkers);
+	}
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	LOG_INFO("Cook done in {0:.2f} ms: {1} cooked, {2} up to date, {3} failed", elapsedMs, numCooked, numSkipped, numFailed);
+
+	return numFailed == 0 && bPacked;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Sorted, so the manifest & the log come out the same every run!
+void AssetCooker::GatherJobs(std::vector<CookJob>& outListJobs) const
+{
+	std::error_code error;
+	for (auto it = std::filesystem::recursive_directory_iterator(Helper::g_strSourceRoot, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+	{
+		if (!it->is_regular_file())
+			continue;
+
+		const std::string extension = GetLowerExtension(it->path());
+		const std::string sourcePath = it->path().generic_string();
+
+		if (g_setTextureExtensions.count(extension) > 0)
+		{
+			outListJobs.push_back({ CookJobType::TEXTURE, sourcePath, Helper::GetCookedTexturePath(sourcePath) });
+		}
+		else if (g_setModelExtensions.count(extension) > 0)
+		{
+			outListJobs.push_back({ CookJobType::MODEL, sourcePath, Helper::GetCookedModelPath(sourcePath) });
+		}
+		else if (g_setSceneExtensions.count(extension) > 0)
+		{
+			outListJobs.push_back({ CookJobType::SCENE, sourcePath, Helper::GetCookedScenePath(sourcePath) });
+		}
+	}
+
+	if (error)
+		LOG_ERROR("Failed to walk {0}: {1}", Helper::g_strSourceRoot, error.message());
+
+	std::sort(outListJobs.begin(), outListJobs.end(), [](const CookJob& a, const CookJob& b) { return a.strSourcePath < b.strSourcePath; });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Size & write time first, they're cheap. Write time alone changing (checkout, copy) is settled by the content hash &
+// the new time is kept, so the file isn't hashed again next run!
+bool AssetCooker::IsUpToDate(const CookJob& job, ManifestEntry& entry) const
+{
+	if (entry.uiSettingsHash != GetSettingsHash(job.eType))
+		return false;
+
+	for (const std::string& output : entry.listOutputs)
+	{
+		if (!std::filesystem::exists(output))
+			return false;
+	}
+
+	for (Dependency& dependency : entry.listDependencies)
+	{
+		Dependency current;
+		current.strPath = dependency.strPath;
+
+		std::error_code error;
+		current.uiSize = std::filesystem::file_size(current.strPath, error);
+		if (error || current.uiSize != dependency.uiSize)
+			return false;
+
+		current.iWriteTime = std::filesystem::last_write_time(current.strPath, error).time_since_epoch().count();
+		if (error)
+			return false;
+
+		if (current.iWriteTime == dependency.iWriteTime)
+			continue;
+
+		if (!HashFile(current.strPath, current.uiContentHash) || current.uiContentHash != dependency.uiContentHash)
+			return false;
+
+		dependency.iWriteTime = current.iWriteTime;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AssetCooker::CookTexture(const CookJob& job, ManifestEntry& outEntry) const
+{
+	int width = 0;
+	int height = 0;
+
+	unsigned char* pPixels = ImageDecoder::DecodeFile(job.strSourcePath, &width, &height);
+	if (!pPixels)
+		return false;
+
+	bool bSaved = ImageDecoder::SaveCooked(job.strOutputPath, pPixels, width, height);
+	ImageDecoder::Free(pPixels);
+
+	Dependency source;
+	if (!bSaved || !MakeDependency(job.strSourcePath, source))
+		return false;
+
+	outEntry.uiSettingsHash = GetSettingsHash(job.eType);
+	outEntry.listOutputs.push_back(job.strOutputPath);
+	outEntry.listDependencies.push_back(source);
+
+	LOG_DEBUG("Cooked {0} ({1}x{2})", job.strOutputPath, width, height);
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Model's own packed textures are cooked with it, they depend on the model's materials. Import gets no workers, it's
+// already running on one & waiting on the pool from there would never return!
+bool AssetCooker::CookModel(const CookJob& job, ManifestEntry& outEntry) const
+{
+	CookedModel model;
+	std::vector<CookedPackedTexture> listPacked;
+	std::vector<std::string> listDependencies = { job.strSourcePath };
+
+	const std::string modelsRoot = Helper::g_strSourceRoot + "Models/";
+	if (job.strSourcePath.compare(0, modelsRoot.size(), modelsRoot) != 0)
+	{
+		LOG_ERROR("{0} isn't under {1}, skipped!", job.strSourcePath, modelsRoot);
+		return false;
+	}
+
+	const std::string modelPath = job.strSourcePath.substr(modelsRoot.size());
+	if (!ModelImporter::Import(modelPath, nullptr, m_bMeshProcessor, model, listPacked, listDependencies) || !model.Save(job.strOutputPath))
+		return false;
+
+	outEntry.listOutputs.push_back(job.strOutputPath);
+
+	for (const CookedPackedTexture& texture : listPacked)
+	{
+		int width = 0;
+		int height = 0;
+
+		unsigned char* pPixels = ImageDecoder::DecodePackedChannels(texture.packed, &width, &height);
+		if (!pPixels)
+			return false;
+
+		bool bSaved = ImageDecoder::SaveCooked(texture.strCookedPath, pPixels, width, height);
+		ImageDecoder::Free(pPixels);
+
+		if (!bSaved)
+			return false;
+
+		outEntry.listOutputs.push_back(texture.strCookedPath);
+	}
+
+	// Several packed textures may share a source map
+	std::sort(listDependencies.begin(), listDependencies.end());
+	listDependencies.erase(std::unique(listDependencies.begin(), listDependencies.end()), listDependencies.end());
+
+	for (const std::string& path : listDependencies)
+	{
+		Dependency dependency;
+		if (!MakeDependency(path, dependency))
+			return false;
+
+		outEntry.listDependencies.push_back(dependency);
+	}
+
+	outEntry.uiSettingsHash = GetSettingsHash(job.eType);
+
+	LOG_INFO("Cooked {0}: {1} meshes, {2} materials, {3:.2f} MB", job.strOutputPath, model.m_ListMeshes.size(), model.m_ListMaterials.size(),
+				model.m_ListPayload.size() / (1024.0f * 1024.0f));
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Scene is checked & written out again, runtime never parses a broken one. Models it names are cooked by their own jobs,
+// missing ones only warn: the runtime skips them & loads the rest! Snapshot next to it resolves the scene against the
+// cooked models, so they're dependencies too & any of them changing rebuilds it. Scenes with paged meshes get no
+// snapshot, the runtime streams the scene file instead.
+bool AssetCooker::CookScene(const CookJob& job, ManifestEntry& outEntry) const
+{
+	SceneFile scene;
+	if (!scene.LoadSource(job.strSourcePath) || !scene.Save(job.strOutputPath))
+		return false;
+
+	for (const SceneModel& model : scene.m_ListModels)
+	{
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(Helper::g_strSourceRoot + "Models/" + model.strModelPath, error))
+			LOG_WARNING("{0}: model {1} doesn't exist!", job.strSourcePath, model.strModelPath);
+	}
+
+	Dependency source;
+	if (!MakeDependency(job.strSourcePath, source))
+		return false;
+
+	outEntry.uiSettingsHash = GetSettingsHash(job.eType);
+	outEntry.listOutputs.push_back(job.strOutputPath);
+	outEntry.listDependencies.push_back(source);
+
+	// Nothing mounted, cooked models are read as loose files
+	VirtualFileSystem fileSystem;
+	SceneSnapshot snapshot;
+	std::vector<std::string> listModelPaths;
+
+	const std::string snapshotPath = Helper::GetCookedSnapshotPath(job.strSourcePath);
+	if (snapshot.Build(scene, &fileSystem, listModelPaths))
+	{
+		if (!snapshot.Save(snapshotPath))
+			return false;
+
+		outEntry.listOutputs.push_back(snapshotPath);
+	}
+	else if (!snapshot.HasPagedMeshes())
+	{
+		return false;
+	}
+
+	for (const std::string& modelPath : listModelPaths)
+	{
+		Dependency model;
+		if (!MakeDependency(modelPath, model))
+			return false;
+
+		outEntry.listDependencies.push_back(model);
+	}
+
+	LOG_DEBUG("Cooked {0}: {1} models, {2} instances, {3}", job.strOutputPath, scene.m_ListModels.size(), scene.GetNumInstances(),
+				snapshot.HasPagedMeshes() ? std::string("no snapshot") : snapshotPath);
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Outputs the old cook wrote but the new one doesn't, e.g. packed textures of a material that's gone
+void AssetCooker::RemoveStaleOutputs(const ManifestEntry& oldEntry, const ManifestEntry& newEntry) const
+{
+	for (const std::string& output : oldEntry.listOutputs)
+	{
+		if (std::find(newEntry.listOutputs.begin(), newEntry.listOutputs.end(), output) != newEntry.listOutputs.end())
+			continue;
+
+		std::error_code error;
+		std::filesystem::remove(output, error);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Plain text so it diffs & can be read when something isn't rebuilt as expected. Paths are quoted, they may have spaces!
+//
+//	CookManifest <version>
+//	entry "<primary output>" <settings hash>
+//	output "<path>"
+//	dependency "<path>" <size> <write time> <content hash>
+//	end
+bool AssetCooker::LoadManifest()
+{
+	std::ifstream file(g_strManifestPath);
+	if (!file)
+		return false;
+
+	std::string tag;
+	uint32_t version = 0;
+	if (!(file >> tag >> version) || tag != "CookManifest" || version != g_uiManifestVersion)
+		return false;
+
+	std::map<std::string, ManifestEntry> mapManifest;
+	std::string key;
+	ManifestEntry entry;
+
+	while (file >> tag)
+	{
+		if (tag == "entry")
+		{
+			entry = ManifestEntry();
+			file >> std::quoted(key) >> entry.uiSettingsHash;
+		}
+		else if (tag == "output")
+		{
+			std::string output;
+			file >> std::quoted(output);
+			entry.listOutputs.push_back(output);
+		}
+		else if (tag == "dependency")
+		{
+			Dependency dependency;
+			file >> std::quoted(dependency.strPath) >> dependency.uiSize >> dependency.iWriteTime >> dependency.uiContentHash;
+			entry.listDependencies.push_back(dependency);
+		}
+		else if (tag == "end")
+		{
+			mapManifest[key] = std::move(entry);
+		}
+		else
+		{
+			return false;
+		}
+
+		if (!file)
+			return false;
+	}
+
+	m_MapManifest.swap(mapManifest);
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AssetCooker::SaveManifest() const
+{
+	return Helper::WriteFileAtomic(g_strManifestPath, [&](std::ostream& stream)
+	{
+		stream << "CookManifest " << g_uiManifestVersion << "\n";
+
+		for (const auto& entry : m_MapManifest)
+		{
+			stream << "entry " << std::quoted(entry.first) << " " << entry.second.uiSettingsHash << "\n";
+
+			for (const std::string& output : entry.second.listOutputs)
+				stream << "output " << std::quoted(output) << "\n";
+
+			for (const Dependency& dependency : entry.second.listDependencies)
+			{
+				stream	<< "dependency " << std::quoted(dependency.strPath) << " " << dependency.uiSize << " "
+						<< dependency.iWriteTime << " " << dependency.uiContentHash << "\n";
+			}
+
+			stream << "end\n";
+		}
+
+		return static_cast<bool>(stream);
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Everything besides the source files that changes what gets cooked. Add new import settings here, or changing them
+// won't rebuild anything!
+uint64_t AssetCooker::GetSettingsHash(CookJobType eType) const
+{
+	uint64_t hash = Helper::HashBytes(&Helper::g_uiCookedVersion, sizeof(Helper::g_uiCookedVersion));
+	hash = Helper::HashBytes(&eType, sizeof(eType), hash);
+
+	if (eType == CookJobType::MODEL)
+	{
+		hash = Helper::HashBytes(&m_bMeshProcessor, sizeof(m_bMeshProcessor), hash);
+		hash = Helper::HashBytes(&Helper::g_bEnableStaticMeshMerging, sizeof(Helper::g_bEnableStaticMeshMerging), hash);
+		hash = Helper::HashBytes(&Helper::g_uiMaxMergedVertices, sizeof(Helper::g_uiMaxMergedVertices), hash);
+		hash = Helper::HashBytes(&Helper::g_uiMaxMeshLods, sizeof(Helper::g_uiMaxMeshLods), hash);
+		hash = Helper::HashBytes(&Helper::g_uiMinLodTriangles, sizeof(Helper::g_uiMinLodTriangles), hash);
+		hash = Helper::HashBytes(&Helper::g_fOverdrawThreshold, sizeof(Helper::g_fOverdrawThreshold), hash);
+		hash = Helper::HashBytes(&Helper::g_uiMeshletMaxVertices, sizeof(Helper::g_uiMeshletMaxVertices), hash);
+		hash = Helper::HashBytes(&Helper::g_uiMeshletMaxTriangles, sizeof(Helper::g_uiMeshletMaxTriangles), hash);
+		hash = Helper::HashBytes(&Helper::g_uiPagedMeshMinTriangles, sizeof(Helper::g_uiPagedMeshMinTriangles), hash);
+		hash = Helper::HashBytes(&Helper::g_uiClusterPageTriangles, sizeof(Helper::g_uiClusterPageTriangles), hash);
+		hash = Helper::HashBytes(&Helper::g_uiClusterPageVertices, sizeof(Helper::g_uiClusterPageVertices), hash);
+		hash = Helper::HashBytes(&Helper::g_uiClusterGroupPages, sizeof(Helper::g_uiClusterGroupPages), hash);
+
+		// Vertices are stored quantized, any attribute format or vertex layout change has to re-pack them
+		const VkFormat arrAttributeFormats[] = { Helper::AttributePosition::Format, Helper::AttributeNormal::Format, Helper::AttributeTangent::Format,
+													Helper::AttributeUV::Format };
+		hash = Helper::HashBytes(arrAttributeFormats, sizeof(arrAttributeFormats), hash);
+
+		for (uint32_t i = 0; i < Helper::g_uiVertexFormatCount; i++)
+		{
+			const uint32_t vertexSize = Helper::GetVertexSize(static_cast<Helper::EVertexFormat>(i));
+			hash = Helper::HashBytes(&vertexSize, sizeof(vertexSize), hash);
+		}
+	}
+
+	return hash;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AssetCooker::MakeDependency(const std::string& filePath, Dependency& outDependency)
+{
+	std::error_code error;
+
+	outDependency.strPath = filePath;
+	outDependency.uiSize = std::filesystem::file_size(filePath, error);
+	if (error)
+		return false;
+
+	outDependency.iWriteTime = std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+	if (error)
+		return false;
+
+	return HashFile(filePath, outDependency.uiContentHash);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AssetCooker::HashFile(const std::string& filePath, uint64_t& outHash)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<char> listBuffer(1 << 16);
+	outHash = Helper::g_uiHashSeed;
+
+	while (file)
+	{
+		file.read(listBuffer.data(), listBuffer.size());
+		outHash = Helper::HashBytes(listBuffer.data(), static_cast<size_t>(file.gcount()), outHash);
+	}
+
+	return file.eof();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+class ThreadPool;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Walks Assets/ & cooks every image, model & scene into Cooked/, see Helper::GetCookedPath(). A manifest remembers what each
+// output was cooked from: settings hash & every source file's size, write time & content hash. Jobs whose inputs still
+// match are skipped, so only what changed gets cooked again. Runs from the directory holding Assets/, just like the
+// runtime does!
+class AssetCooker
+{
+public:
+	AssetCooker(bool bForce, bool bMeshProcessor);
+	~AssetCooker();
+
+	// False if any job failed, its output stays as it was & the job runs again next time
+	bool								Run();
+
+private:
+	enum class CookJobType
+	{
+		TEXTURE,
+		MODEL,
+		SCENE
+	};
+
+	struct CookJob
+	{
+		CookJobType						eType;
+		std::string						strSourcePath;
+		std::string						strOutputPath;			// primary output, manifest key
+	};
+
+	struct Dependency
+	{
+		std::string						strPath;
+		uint64_t						uiSize;
+		int64_t							iWriteTime;
+		uint64_t						uiContentHash;
+	};
+
+	struct ManifestEntry
+	{
+		uint64_t						uiSettingsHash;
+		std::vector<std::string>		listOutputs;
+		std::vector<Dependency>			listDependencies;
+	};
+
+	void								GatherJobs(std::vector<CookJob>& outListJobs) const;
+	bool								IsUpToDate(const CookJob& job, ManifestEntry& entry) const;
+	bool								CookTexture(const CookJob& job, ManifestEntry& outEntry) const;
+	bool								CookModel(const CookJob& job, ManifestEntry& outEntry) const;
+	bool								CookScene(const CookJob& job, ManifestEntry& outEntry) const;
+	void								RemoveStaleOutputs(const ManifestEntry& oldEntry, const ManifestEntry& newEntry) const;
+
+	bool								LoadManifest();
+	bool								SaveManifest() const;
+
+	uint64_t							GetSettingsHash(CookJobType eType) const;
+	static bool							MakeDependency(const std::string& filePath, Dependency& outDependency);
+	static bool							HashFile(const std::string& filePath, uint64_t& outHash);
+
+private:
+	std::map<std::string, ManifestEntry>	m_MapManifest;
+	ThreadPool*								m_pWorkers;
+	bool									m_bForce;
+	bool									m_bMeshProcessor;		// see ModelImporter::Import()
+};
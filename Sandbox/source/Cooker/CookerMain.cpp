@@ -0,0 +1,44 @@
+#include "sandboxPCH.h"
+#include "AssetCooker.h"
+#include "Core/Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cooker [projectDir] [--force] [--assimp-processing]
+//	projectDir				directory holding Assets/, Cooked/ is written next to it. Current directory if not given!
+//	--force					ignore the manifest & cook everything again
+//	--assimp-processing		weld, normals & tangents by Assimp instead of MeshProcessor. Both log their throughput,
+//							models cooked either way are cooked again once it's flipped!
+int main(int argc, char** argv)
+{
+	bool bForce = false;
+	bool bMeshProcessor = true;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--force")
+		{
+			bForce = true;
+			continue;
+		}
+
+		if (arg == "--assimp-processing")
+		{
+			bMeshProcessor = false;
+			continue;
+		}
+
+		std::error_code error;
+		std::filesystem::current_path(arg, error);
+		if (error)
+		{
+			LOG_ERROR("Can't cook in {0}: {1}", arg, error.message());
+			return EXIT_FAILURE;
+		}
+	}
+
+	LOG_INFO("Cooking {0}...", std::filesystem::current_path().generic_string());
+
+	AssetCooker cooker(bForce, bMeshProcessor);
+	return cooker.Run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,228 @@
+#include "sandboxPCH.h"
+#include "PackBuilder.h"
+#include "Renderer/CookedFormat.h"
+#include "Core/LZCodec.h"
+#include "Core/ThreadPool.h"
+#include "Core/Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Paths go into the pack exactly as the runtime asks for them, e.g. "Cooked/Models/Sponza/Sponza.fbx.model"
+bool PackBuilder::Build(const std::vector<std::string>& listFiles, const std::string& packPath, ThreadPool* pWorkers)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::string> listPaths = listFiles;
+	std::sort(listPaths.begin(), listPaths.end());
+	listPaths.erase(std::unique(listPaths.begin(), listPaths.end()), listPaths.end());
+
+	std::vector<PackInput> listInputs(listPaths.size());
+	for (size_t i = 0; i < listPaths.size(); i++)
+	{
+		listInputs[i].strPath = listPaths[i];
+		pWorkers->Enqueue([&listInputs, i]() { PrepareInput(listInputs[i]); });
+	}
+
+	pWorkers->WaitIdle();
+
+	// Missing outputs only drop out of the pack, the runtime then looks for them as loose files & fails there
+	listInputs.erase(std::remove_if(listInputs.begin(), listInputs.end(), [](const PackInput& input) { return !input.bValid; }), listInputs.end());
+
+	// Layout: header, table of contents, chunk table, path strings, then every entry on its own alignment boundary
+	Helper::PackHeader header;
+	header.uiMagic = Helper::g_uiPackMagic;
+	header.uiVersion = Helper::g_uiPackVersion;
+	header.uiNumEntries = static_cast<uint32_t>(listInputs.size());
+	header.uiAlignment = Helper::g_uiPackAlignment;
+	header.uiChunkSize = Helper::g_uiPackChunkSize;
+	header.uiNumChunks = 0;
+	header.uiChunksOffset = sizeof(header) + listInputs.size() * sizeof(Helper::PackEntry);
+	header.uiNamesSize = 0;
+
+	std::vector<Helper::PackEntry> listEntries(listInputs.size());
+	for (size_t i = 0; i < listInputs.size(); i++)
+	{
+		Helper::PackEntry& entry = listEntries[i];
+		entry.uiNameOffset = header.uiNamesSize;
+		entry.uiNameLength = static_cast<uint32_t>(listInputs[i].strPath.size());
+		entry.eCompression = listInputs[i].listCompressed.empty() ? Helper::PackCompression::NONE : Helper::PackCompression::LZ;
+		entry.uiSize = listInputs[i].uiSize;
+		entry.uiStoredSize = listInputs[i].listCompressed.empty() ? listInputs[i].uiSize : listInputs[i].listCompressed.size();
+		entry.uiFirstChunk = header.uiNumChunks;
+		entry.uiNumChunks = static_cast<uint32_t>(listInputs[i].listChunks.size());
+
+		header.uiNamesSize += entry.uiNameLength;
+		header.uiNumChunks += entry.uiNumChunks;
+	}
+
+	header.uiNamesOffset = header.uiChunksOffset + static_cast<uint64_t>(header.uiNumChunks) * sizeof(Helper::PackChunk);
+
+	const uint64_t alignment = Helper::g_uiPackAlignment;
+	uint64_t dataOffset = header.uiNamesOffset + header.uiNamesSize;
+
+	uint64_t totalSize = 0;
+	for (Helper::PackEntry& entry : listEntries)
+	{
+		dataOffset = (dataOffset + alignment - 1) & ~(alignment - 1);
+		entry.uiDataOffset = dataOffset;
+		dataOffset += entry.uiStoredSize;
+		totalSize += entry.uiSize;
+	}
+
+	bool bWritten = Helper::WriteFileAtomic(packPath, [&](std::ostream& stream)
+	{
+		Helper::WritePod(stream, header);
+		stream.write(reinterpret_cast<const char*>(listEntries.data()), listEntries.size() * sizeof(Helper::PackEntry));
+
+		for (const PackInput& input : listInputs)
+			stream.write(reinterpret_cast<const char*>(input.listChunks.data()), input.listChunks.size() * sizeof(Helper::PackChunk));
+
+		for (const PackInput& input : listInputs)
+			stream.write(input.strPath.data(), input.strPath.size());
+
+		uint64_t position = header.uiNamesOffset + header.uiNamesSize;
+		for (size_t i = 0; i < listInputs.size() && stream; i++)
+		{
+			WritePadding(stream, listEntries[i].uiDataOffset - position);
+
+			// Stored entries are read again here rather than kept around, the whole cook output may not fit in memory
+			if (listInputs[i].listCompressed.empty())
+			{
+				if (!StreamFile(listInputs[i].strPath, listEntries[i].uiSize, stream))
+				{
+					LOG_ERROR("{0} changed while packing!", listInputs[i].strPath);
+					return false;
+				}
+			}
+			else
+			{
+				stream.write(reinterpret_cast<const char*>(listInputs[i].listCompressed.data()), listInputs[i].listCompressed.size());
+			}
+
+			position = listEntries[i].uiDataOffset + listEntries[i].uiStoredSize;
+		}
+
+		return static_cast<bool>(stream);
+	});
+
+	if (!bWritten)
+	{
+		LOG_ERROR("Failed to write {0}!", packPath);
+		return false;
+	}
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	LOG_INFO("Packed {0} files into {1} in {2:.2f} ms: {3:.2f} MB -> {4:.2f} MB", listEntries.size(), packPath, elapsedMs,
+			 totalSize / (1024.0f * 1024.0f), dataOffset / (1024.0f * 1024.0f));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool PackBuilder::IsCurrent(const std::string& packPath)
+{
+	std::ifstream file(packPath, std::ios::binary);
+
+	Helper::PackHeader header;
+	return file && Helper::ReadPod(file, header) && header.uiMagic == Helper::g_uiPackMagic && header.uiVersion == Helper::g_uiPackVersion;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void PackBuilder::PrepareInput(PackInput& input)
+{
+	input.bValid = false;
+	input.uiSize = 0;
+	input.listCompressed.clear();
+	input.listChunks.clear();
+
+	std::ifstream file(input.strPath, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		LOG_WARNING("{0} is missing, left out of the pack", input.strPath);
+		return;
+	}
+
+	input.uiSize = static_cast<uint64_t>(file.tellg());
+	input.bValid = true;
+
+	if (!Helper::g_bCompressPackEntries || input.uiSize == 0 || Helper::IsMappedAsset(input.strPath))
+		return;
+
+	std::vector<uint8_t> listData(static_cast<size_t>(input.uiSize));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(listData.data()), listData.size()))
+	{
+		input.bValid = false;
+		return;
+	}
+
+	// Chunks are compressed one by one, each only kept compressed when at least 1/8 of it is saved
+	const uint64_t numChunks = (input.uiSize + Helper::g_uiPackChunkSize - 1) / Helper::g_uiPackChunkSize;
+	input.listChunks.resize(static_cast<size_t>(numChunks));
+	input.listCompressed.resize(static_cast<size_t>(numChunks * LZCodec::GetMaxCompressedSize(Helper::g_uiPackChunkSize)));
+
+	uint64_t storedSize = 0;
+	bool bAnyCompressed = false;
+
+	for (uint64_t i = 0; i < numChunks; i++)
+	{
+		const uint64_t chunkOffset = i * Helper::g_uiPackChunkSize;
+		const uint64_t chunkSize = std::min<uint64_t>(Helper::g_uiPackChunkSize, input.uiSize - chunkOffset);
+
+		Helper::PackChunk& chunk = input.listChunks[i];
+		chunk.uiStoredOffset = storedSize;
+
+		uint64_t compressedSize = LZCodec::Compress(listData.data() + chunkOffset, chunkSize, input.listCompressed.data() + storedSize, chunkSize - chunkSize / 8);
+		if (compressedSize > 0)
+		{
+			chunk.uiStoredSize = static_cast<uint32_t>(compressedSize);
+			chunk.eCompression = Helper::PackCompression::LZ;
+			bAnyCompressed = true;
+		}
+		else
+		{
+			memcpy(input.listCompressed.data() + storedSize, listData.data() + chunkOffset, chunkSize);
+			chunk.uiStoredSize = static_cast<uint32_t>(chunkSize);
+			chunk.eCompression = Helper::PackCompression::NONE;
+		}
+
+		storedSize += chunk.uiStoredSize;
+	}
+
+	// Nothing gained, whole entry is stored as it is & can be read straight from the mapping
+	if (!bAnyCompressed || input.uiSize - storedSize < input.uiSize / 8)
+	{
+		input.listChunks.clear();
+		input.listCompressed.clear();
+	}
+
+	input.listCompressed.resize(static_cast<size_t>(input.listChunks.empty() ? 0 : storedSize));
+	input.listCompressed.shrink_to_fit();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool PackBuilder::StreamFile(const std::string& filePath, uint64_t size, std::ostream& stream)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<char> listBuffer(1 << 20);
+	while (size > 0)
+	{
+		const size_t chunkSize = static_cast<size_t>(std::min<uint64_t>(size, listBuffer.size()));
+		if (!file.read(listBuffer.data(), chunkSize))
+			return false;
+
+		stream.write(listBuffer.data(), chunkSize);
+		size -= chunkSize;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void PackBuilder::WritePadding(std::ostream& stream, uint64_t size)
+{
+	static const char zeros[Helper::g_uiPackAlignment] = {};
+	stream.write(zeros, size);
+}
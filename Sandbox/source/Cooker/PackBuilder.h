@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Renderer/CookedFormat.h"
+
+class ThreadPool;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Writes cooked files into one archive in the Helper::PackHeader layout, read back at runtime by VirtualFileSystem.
+// Entries are compressed in parallel on the pool, the pack itself is written in one go & replaces the old one only
+// once it's complete!
+class PackBuilder
+{
+public:
+	static bool							Build(const std::vector<std::string>& listFiles, const std::string& packPath, ThreadPool* pWorkers);
+
+	// False if there's no pack or it was written in an older layout
+	static bool							IsCurrent(const std::string& packPath);
+
+private:
+	struct PackInput
+	{
+		std::string						strPath;
+		uint64_t						uiSize;
+		std::vector<uint8_t>			listCompressed;			// every chunk back to back, empty if entry is stored as it is
+		std::vector<Helper::PackChunk>	listChunks;
+		bool							bValid;
+	};
+
+	static void							PrepareInput(PackInput& input);
+	static bool							StreamFile(const std::string& filePath, uint64_t size, std::ostream& stream);
+	static void							WritePadding(std::ostream& stream, uint64_t size);
+};
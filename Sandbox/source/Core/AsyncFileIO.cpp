@@ -0,0 +1,488 @@
+#include "sandboxPCH.h"
+#include "AsyncFileIO.h"
+#include "ThreadPool.h"
+#include "Renderer/Utility.h"
+#include "Core.h"
+
+#if defined(__linux__)
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------
+AsyncReadGroup::AsyncReadGroup()
+{
+	m_uiNumPending = 0;
+	m_bFailed = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void AsyncReadGroup::Add(uint32_t numReads)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_uiNumPending += numReads;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void AsyncReadGroup::Complete(bool bSucceeded)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_bFailed |= !bSucceeded;
+	if (--m_uiNumPending == 0)
+		m_cvDone.notify_all();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AsyncReadGroup::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_cvDone.wait(lock, [this]() { return m_uiNumPending == 0; });
+
+	return !m_bFailed;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+AsyncFileIO::AsyncFileIO()
+{
+	m_pUring = nullptr;
+	m_pReaders = nullptr;
+	m_uiNumInFlight = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+AsyncFileIO::~AsyncFileIO()
+{
+	WaitIdle();
+
+	ShutdownUring();
+	SAFE_DELETE(m_pReaders);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// io_uring may be missing or blocked (old kernel, containers, seccomp), reader threads always work!
+bool AsyncFileIO::Initialize()
+{
+	if (Helper::g_bEnableIoUring && InitializeUring())
+	{
+		LOG_INFO("Async file reads on io_uring, queue depth {0}", Helper::g_uiAsyncReadQueueDepth);
+		return true;
+	}
+
+	m_pReaders = new ThreadPool(Helper::g_uiAsyncReadQueueDepth);
+	LOG_INFO("Async file reads on {0} reader threads", Helper::g_uiAsyncReadQueueDepth);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void AsyncFileIO::Read(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst, ThreadPool* pCompletionWorkers, std::function<void(bool)> onComplete)
+{
+	ReadRequest* pRequest = new ReadRequest();
+	pRequest->strFilePath = filePath;
+	pRequest->uiOffset = offset;
+	pRequest->uiSize = size;
+	pRequest->uiDone = 0;
+	pRequest->pDst = static_cast<uint8_t*>(pDst);
+	pRequest->iFile = -1;
+	pRequest->pCompletionWorkers = pCompletionWorkers;
+	pRequest->onComplete = std::move(onComplete);
+
+	{
+		std::lock_guard<std::mutex> lock(m_MutexIdle);
+		++m_uiNumInFlight;
+	}
+
+	if (m_pUring)
+	{
+		SubmitUring(pRequest);
+		return;
+	}
+
+	m_pReaders->Enqueue([this, pRequest]() { Complete(pRequest, ReadBlocking(pRequest)); });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void AsyncFileIO::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_MutexIdle);
+	m_cvIdle.wait(lock, [this]() { return m_uiNumInFlight == 0; });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Callback is queued before the read stops counting as in flight, so WaitIdle() followed by the pool's WaitIdle()
+// sees every callback through!
+void AsyncFileIO::Complete(ReadRequest* pRequest, bool bSucceeded)
+{
+#if defined(__linux__)
+	if (pRequest->iFile >= 0)
+		close(pRequest->iFile);
+#endif
+
+	if (!bSucceeded)
+		LOG_ERROR("Failed to read {0} bytes at {1} from {2}", pRequest->uiSize, pRequest->uiOffset, pRequest->strFilePath);
+
+	if (pRequest->pCompletionWorkers)
+	{
+		pRequest->pCompletionWorkers->Enqueue([onComplete = std::move(pRequest->onComplete), bSucceeded]() { onComplete(bSucceeded); });
+	}
+	else
+	{
+		pRequest->onComplete(bSucceeded);
+	}
+
+	SAFE_DELETE(pRequest);
+
+	std::lock_guard<std::mutex> lock(m_MutexIdle);
+	if (--m_uiNumInFlight == 0)
+		m_cvIdle.notify_all();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AsyncFileIO::ReadBlocking(ReadRequest* pRequest)
+{
+	std::ifstream file(pRequest->strFilePath, std::ios::binary);
+	if (!file)
+		return false;
+
+	file.seekg(pRequest->uiOffset);
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(pRequest->pDst), pRequest->uiSize));
+}
+
+#if defined(__linux__)
+
+//---------------------------------------------------------------------------------------------------------------------
+// Rings are shared with the kernel: we own SQ tail & CQ head, kernel owns the other two. Submissions are serialized
+// by the mutex, a single completion thread reaps the CQ. Kernel never holds more than uiNumEntries of our reads, the
+// rest waits in the backlog!
+struct AsyncFileIO::UringState
+{
+	int									iRing;
+	uint32_t							uiNumEntries;
+
+	void*								pSqRing;
+	size_t								uiSqRingSize;
+	void*								pCqRing;
+	size_t								uiCqRingSize;
+	io_uring_sqe*						pSqes;
+	size_t								uiSqesSize;
+
+	uint32_t*							pSqHead;
+	uint32_t*							pSqTail;
+	uint32_t*							pSqMask;
+	uint32_t*							pSqArray;
+	uint32_t*							pCqHead;
+	uint32_t*							pCqTail;
+	uint32_t*							pCqMask;
+	io_uring_cqe*						pCqes;
+
+	std::mutex							mutexSubmit;
+	uint32_t							uiNumSubmitted;
+	std::deque<ReadRequest*>			queueBacklog;
+	std::thread							threadCompletion;
+};
+
+namespace
+{
+	// Single read is capped, rest of a larger one is simply submitted again like a short read
+	const uint64_t g_uiMaxUringReadSize = 1ull << 30;
+
+	// NOP with this user data wakes the completion thread up for shutdown
+	const uint64_t g_uiUringShutdownTag = 0;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	int UringEnter(int ring, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+	{
+		int result;
+		do
+		{
+			result = static_cast<int>(syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+		} while (result < 0 && errno == EINTR);
+
+		return result;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AsyncFileIO::InitializeUring()
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	int ring = static_cast<int>(syscall(__NR_io_uring_setup, Helper::g_uiAsyncReadQueueDepth, &params));
+	if (ring < 0)
+	{
+		LOG_WARNING("io_uring unavailable (errno {0}), falling back to reader threads", errno);
+		return false;
+	}
+
+	// Plain IORING_OP_READ came with 5.6, fast poll with 5.7 is the closest feature bit telling it's there
+	if (!(params.features & IORING_FEAT_FAST_POLL))
+	{
+		LOG_WARNING("io_uring too old for plain reads, falling back to reader threads");
+		close(ring);
+		return false;
+	}
+
+	UringState* pState = new UringState();
+	pState->iRing = ring;
+	pState->uiNumEntries = params.sq_entries;
+	pState->uiNumSubmitted = 0;
+
+	pState->uiSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	pState->uiCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	pState->uiSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+	// Newer kernels map both rings with a single mmap
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		pState->uiSqRingSize = pState->uiCqRingSize = std::max(pState->uiSqRingSize, pState->uiCqRingSize);
+
+	pState->pSqRing = mmap(nullptr, pState->uiSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+	pState->pCqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? pState->pSqRing :
+						mmap(nullptr, pState->uiCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+	void* pSqes = mmap(nullptr, pState->uiSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+
+	if (pState->pSqRing == MAP_FAILED || pState->pCqRing == MAP_FAILED || pSqes == MAP_FAILED)
+	{
+		LOG_WARNING("Failed to map io_uring rings, falling back to reader threads");
+
+		if (pSqes != MAP_FAILED)
+			munmap(pSqes, pState->uiSqesSize);
+		if (pState->pCqRing != MAP_FAILED && pState->pCqRing != pState->pSqRing)
+			munmap(pState->pCqRing, pState->uiCqRingSize);
+		if (pState->pSqRing != MAP_FAILED)
+			munmap(pState->pSqRing, pState->uiSqRingSize);
+
+		close(ring);
+		SAFE_DELETE(pState);
+		return false;
+	}
+
+	uint8_t* pSq = static_cast<uint8_t*>(pState->pSqRing);
+	uint8_t* pCq = static_cast<uint8_t*>(pState->pCqRing);
+
+	pState->pSqes = static_cast<io_uring_sqe*>(pSqes);
+	pState->pSqHead = reinterpret_cast<uint32_t*>(pSq + params.sq_off.head);
+	pState->pSqTail = reinterpret_cast<uint32_t*>(pSq + params.sq_off.tail);
+	pState->pSqMask = reinterpret_cast<uint32_t*>(pSq + params.sq_off.ring_mask);
+	pState->pSqArray = reinterpret_cast<uint32_t*>(pSq + params.sq_off.array);
+	pState->pCqHead = reinterpret_cast<uint32_t*>(pCq + params.cq_off.head);
+	pState->pCqTail = reinterpret_cast<uint32_t*>(pCq + params.cq_off.tail);
+	pState->pCqMask = reinterpret_cast<uint32_t*>(pCq + params.cq_off.ring_mask);
+	pState->pCqes = reinterpret_cast<io_uring_cqe*>(pCq + params.cq_off.cqes);
+
+	m_pUring = pState;
+	m_pUring->threadCompletion = std::thread(&AsyncFileIO::UringCompletionLoop, this);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Only called once nothing is in flight anymore!
+void AsyncFileIO::ShutdownUring()
+{
+	if (!m_pUring)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pUring->mutexSubmit);
+
+		const uint32_t tail = *m_pUring->pSqTail;
+		const uint32_t index = tail & *m_pUring->pSqMask;
+
+		io_uring_sqe* pSqe = &m_pUring->pSqes[index];
+		memset(pSqe, 0, sizeof(io_uring_sqe));
+		pSqe->opcode = IORING_OP_NOP;
+		pSqe->user_data = g_uiUringShutdownTag;
+
+		m_pUring->pSqArray[index] = index;
+		__atomic_store_n(m_pUring->pSqTail, tail + 1, __ATOMIC_RELEASE);
+
+		UringEnter(m_pUring->iRing, 1, 0, 0);
+	}
+
+	m_pUring->threadCompletion.join();
+
+	munmap(m_pUring->pSqes, m_pUring->uiSqesSize);
+	if (m_pUring->pCqRing != m_pUring->pSqRing)
+		munmap(m_pUring->pCqRing, m_pUring->uiCqRingSize);
+	munmap(m_pUring->pSqRing, m_pUring->uiSqRingSize);
+	close(m_pUring->iRing);
+
+	SAFE_DELETE(m_pUring);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// File is opened right here, reading it is what goes through the ring
+void AsyncFileIO::SubmitUring(ReadRequest* pRequest)
+{
+	pRequest->iFile = open(pRequest->strFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (pRequest->iFile < 0)
+	{
+		Complete(pRequest, false);
+		return;
+	}
+
+	if (pRequest->uiSize == 0)
+	{
+		Complete(pRequest, true);
+		return;
+	}
+
+	bool bPushed = false;
+	{
+		std::lock_guard<std::mutex> lock(m_pUring->mutexSubmit);
+
+		if (m_pUring->uiNumSubmitted < m_pUring->uiNumEntries)
+		{
+			bPushed = PushUring(pRequest);
+		}
+		else
+		{
+			m_pUring->queueBacklog.push_back(pRequest);
+			return;
+		}
+	}
+
+	if (!bPushed)
+		Complete(pRequest, false);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Caller holds the submit lock & made sure kernel has room for one more!
+bool AsyncFileIO::PushUring(ReadRequest* pRequest)
+{
+	const uint32_t tail = *m_pUring->pSqTail;
+	const uint32_t index = tail & *m_pUring->pSqMask;
+
+	io_uring_sqe* pSqe = &m_pUring->pSqes[index];
+	memset(pSqe, 0, sizeof(io_uring_sqe));
+	pSqe->opcode = IORING_OP_READ;
+	pSqe->fd = pRequest->iFile;
+	pSqe->addr = reinterpret_cast<uint64_t>(pRequest->pDst + pRequest->uiDone);
+	pSqe->len = static_cast<uint32_t>(std::min(pRequest->uiSize - pRequest->uiDone, g_uiMaxUringReadSize));
+	pSqe->off = pRequest->uiOffset + pRequest->uiDone;
+	pSqe->user_data = reinterpret_cast<uint64_t>(pRequest);
+
+	m_pUring->pSqArray[index] = index;
+	__atomic_store_n(m_pUring->pSqTail, tail + 1, __ATOMIC_RELEASE);
+
+	if (UringEnter(m_pUring->iRing, 1, 0, 0) < 0 && __atomic_load_n(m_pUring->pSqHead, __ATOMIC_ACQUIRE) == tail)
+	{
+		// Kernel never took it, take it back out or the next submit would send it anyway!
+		LOG_ERROR("io_uring_enter failed (errno {0})", errno);
+		__atomic_store_n(m_pUring->pSqTail, tail, __ATOMIC_RELEASE);
+		return false;
+	}
+
+	m_pUring->uiNumSubmitted++;
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Short reads are submitted again for the rest, finished ones go to Complete(). Every reaped completion frees a slot
+// in the kernel for the backlog!
+void AsyncFileIO::UringCompletionLoop()
+{
+	bool bShutdown = false;
+
+	while (!bShutdown)
+	{
+		if (UringEnter(m_pUring->iRing, 0, 1, IORING_ENTER_GETEVENTS) < 0)
+		{
+			LOG_CRITICAL("io_uring_enter failed waiting for completions (errno {0})", errno);
+			return;
+		}
+
+		std::vector<std::pair<ReadRequest*, int32_t>> listCompleted;
+
+		uint32_t head = *m_pUring->pCqHead;
+		const uint32_t tail = __atomic_load_n(m_pUring->pCqTail, __ATOMIC_ACQUIRE);
+
+		for (; head != tail; head++)
+		{
+			const io_uring_cqe& cqe = m_pUring->pCqes[head & *m_pUring->pCqMask];
+
+			if (cqe.user_data == g_uiUringShutdownTag)
+				bShutdown = true;
+			else
+				listCompleted.emplace_back(reinterpret_cast<ReadRequest*>(cqe.user_data), cqe.res);
+		}
+
+		__atomic_store_n(m_pUring->pCqHead, head, __ATOMIC_RELEASE);
+
+		// Frees the slots & pairs up with the submitter's unlock, so the requests it filled in are seen in full
+		{
+			std::lock_guard<std::mutex> lock(m_pUring->mutexSubmit);
+			m_pUring->uiNumSubmitted -= static_cast<uint32_t>(listCompleted.size());
+		}
+
+		std::vector<ReadRequest*> listResubmit;
+
+		for (const auto& completed : listCompleted)
+		{
+			ReadRequest* pRequest = completed.first;
+			const int32_t result = completed.second;
+
+			if (result == -EAGAIN || result == -EINTR)
+			{
+				listResubmit.push_back(pRequest);
+				continue;
+			}
+
+			// Error or end of file before the whole range was read
+			if (result <= 0)
+			{
+				Complete(pRequest, false);
+				continue;
+			}
+
+			pRequest->uiDone += static_cast<uint64_t>(result);
+			if (pRequest->uiDone < pRequest->uiSize)
+			{
+				listResubmit.push_back(pRequest);
+				continue;
+			}
+
+			Complete(pRequest, true);
+		}
+
+		std::vector<ReadRequest*> listFailed;
+		{
+			std::lock_guard<std::mutex> lock(m_pUring->mutexSubmit);
+
+			// Unfinished reads go first, they're holding their file open
+			for (auto iter = listResubmit.rbegin(); iter != listResubmit.rend(); ++iter)
+				m_pUring->queueBacklog.push_front(*iter);
+
+			while (!m_pUring->queueBacklog.empty() && m_pUring->uiNumSubmitted < m_pUring->uiNumEntries)
+			{
+				ReadRequest* pRequest = m_pUring->queueBacklog.front();
+				m_pUring->queueBacklog.pop_front();
+
+				if (!PushUring(pRequest))
+					listFailed.push_back(pRequest);
+			}
+		}
+
+		for (ReadRequest* pRequest : listFailed)
+			Complete(pRequest, false);
+	}
+}
+
+#else
+
+//---------------------------------------------------------------------------------------------------------------------
+struct AsyncFileIO::UringState {};
+
+bool AsyncFileIO::InitializeUring()						{ return false; }
+void AsyncFileIO::ShutdownUring()						{}
+void AsyncFileIO::SubmitUring(ReadRequest* pRequest)	{ Complete(pRequest, false); }
+bool AsyncFileIO::PushUring(ReadRequest* pRequest)		{ return false; }
+void AsyncFileIO::UringCompletionLoop()					{}
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+class ThreadPool;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Counts the reads of one batch, Wait() blocks till every one of them has completed. Safe from any thread!
+class AsyncReadGroup
+{
+public:
+	AsyncReadGroup();
+
+	void								Add(uint32_t numReads = 1);
+	void								Complete(bool bSucceeded);
+
+	// False if any read of the batch failed
+	bool								Wait();
+
+private:
+	std::mutex							m_Mutex;
+	std::condition_variable				m_cvDone;
+	uint32_t							m_uiNumPending;
+	bool								m_bFailed;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reads file ranges in the background, many at once. io_uring on Linux (see Helper::g_bEnableIoUring), anywhere else
+// a pool of blocking reader threads. Completion callback is handed to the given pool as a job of its own, so whatever
+// decodes the data overlaps with reads still in flight. Without a pool it runs on the I/O thread & must be quick!
+class AsyncFileIO
+{
+public:
+	AsyncFileIO();
+	~AsyncFileIO();
+
+	bool								Initialize();
+	void								Read(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst, ThreadPool* pCompletionWorkers,
+											std::function<void(bool)> onComplete);
+
+	// Every read issued so far has completed & its callback is queued or done
+	void								WaitIdle();
+
+	inline const char*					GetBackendName() const		{ return m_pUring ? "io_uring" : "reader threads"; }
+
+private:
+	AsyncFileIO(const AsyncFileIO&);
+	AsyncFileIO& operator=(const AsyncFileIO&);
+
+	struct ReadRequest
+	{
+		std::string						strFilePath;
+		uint64_t						uiOffset;
+		uint64_t						uiSize;
+		uint64_t						uiDone;
+		uint8_t*						pDst;
+		int								iFile;
+		ThreadPool*						pCompletionWorkers;
+		std::function<void(bool)>		onComplete;
+	};
+
+	struct UringState;
+
+	void								Complete(ReadRequest* pRequest, bool bSucceeded);
+	static bool							ReadBlocking(ReadRequest* pRequest);
+
+	bool								InitializeUring();
+	void								ShutdownUring();
+	void								SubmitUring(ReadRequest* pRequest);
+	bool								PushUring(ReadRequest* pRequest);
+	void								UringCompletionLoop();
+
+private:
+	UringState*							m_pUring;				// null when reader threads are used
+	ThreadPool*							m_pReaders;
+
+	std::mutex							m_MutexIdle;
+	std::condition_variable				m_cvIdle;
+	uint32_t							m_uiNumInFlight;
+};
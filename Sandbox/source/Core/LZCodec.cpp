@@ -0,0 +1,202 @@
+#include "sandboxPCH.h"
+#include "LZCodec.h"
+
+namespace
+{
+	const uint32_t g_uiHashBits = 14;
+	const uint32_t g_uiMinMatch = 4;
+	const uint32_t g_uiMaxOffset = 65535;
+	const uint32_t g_uiLastLiterals = 5;			// block always ends with literals...
+	const uint32_t g_uiMatchSafety = 12;			// ...& no match starts this close to the end
+
+	//-----------------------------------------------------------------------------------------------------------------
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	inline uint32_t Hash(uint32_t value)
+	{
+		return (value * 2654435761u) >> (32 - g_uiHashBits);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Lengths over 15 continue in bytes of 255 & one final byte below it
+	inline uint8_t* WriteLength(uint8_t* pOut, uint64_t length)
+	{
+		for (; length >= 255; length -= 255)
+			*pOut++ = 255;
+
+		*pOut++ = static_cast<uint8_t>(length);
+		return pOut;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	inline bool ReadLength(const uint8_t*& pIn, const uint8_t* pInEnd, uint64_t& length)
+	{
+		uint8_t byte = 255;
+		while (byte == 255)
+		{
+			if (pIn >= pInEnd)
+				return false;
+
+			byte = *pIn++;
+			length += byte;
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Literal run & the match after it, no match for the block's last sequence. Null if dst is full!
+	uint8_t* WriteSequence(uint8_t* pOut, const uint8_t* pOutEnd, const uint8_t* pLiterals, uint64_t numLiterals, uint32_t offset, uint64_t matchLength)
+	{
+		const uint64_t worstCase = 1 + numLiterals / 255 + 1 + numLiterals + 2 + matchLength / 255 + 1;
+		if (worstCase > static_cast<uint64_t>(pOutEnd - pOut))
+			return nullptr;
+
+		const uint64_t matchCode = matchLength > 0 ? matchLength - g_uiMinMatch : 0;
+
+		uint8_t* pToken = pOut++;
+		*pToken = static_cast<uint8_t>((std::min<uint64_t>(numLiterals, 15) << 4) | std::min<uint64_t>(matchCode, 15));
+
+		if (numLiterals >= 15)
+			pOut = WriteLength(pOut, numLiterals - 15);
+
+		if (numLiterals > 0)
+			memcpy(pOut, pLiterals, numLiterals);
+
+		pOut += numLiterals;
+
+		if (matchLength == 0)
+			return pOut;
+
+		*pOut++ = static_cast<uint8_t>(offset & 0xFF);
+		*pOut++ = static_cast<uint8_t>(offset >> 8);
+
+		if (matchCode >= 15)
+			pOut = WriteLength(pOut, matchCode - 15);
+
+		return pOut;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint64_t LZCodec::Compress(const uint8_t* pSrc, uint64_t srcSize, uint8_t* pDst, uint64_t dstCapacity)
+{
+	if (srcSize > std::numeric_limits<uint32_t>::max())
+		return 0;
+
+	std::vector<uint32_t> listTable(1u << g_uiHashBits, std::numeric_limits<uint32_t>::max());
+
+	const uint8_t* pIn = pSrc;
+	const uint8_t* pAnchor = pSrc;
+	const uint8_t* pEnd = pSrc + srcSize;
+	uint8_t* pOut = pDst;
+	const uint8_t* pOutEnd = pDst + dstCapacity;
+
+	if (srcSize > g_uiMatchSafety)
+	{
+		const uint8_t* pMatchLimit = pEnd - g_uiMatchSafety;
+
+		while (pIn < pMatchLimit)
+		{
+			const uint32_t hash = Hash(Read32(pIn));
+			const uint32_t candidate = listTable[hash];
+			listTable[hash] = static_cast<uint32_t>(pIn - pSrc);
+
+			const uint8_t* pMatch = pSrc + std::min<uint64_t>(candidate, srcSize);
+			if (candidate == std::numeric_limits<uint32_t>::max() || pIn - pMatch > g_uiMaxOffset || Read32(pMatch) != Read32(pIn))
+			{
+				++pIn;
+				continue;
+			}
+
+			uint64_t matchLength = g_uiMinMatch;
+			while (pIn + matchLength < pEnd - g_uiLastLiterals && pIn[matchLength] == pMatch[matchLength])
+				++matchLength;
+
+			pOut = WriteSequence(pOut, pOutEnd, pAnchor, pIn - pAnchor, static_cast<uint32_t>(pIn - pMatch), matchLength);
+			if (!pOut)
+				return 0;
+
+			pIn += matchLength;
+			pAnchor = pIn;
+		}
+	}
+
+	pOut = WriteSequence(pOut, pOutEnd, pAnchor, pEnd - pAnchor, 0, 0);
+	return pOut ? static_cast<uint64_t>(pOut - pDst) : 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every length & offset is checked against both buffers, corrupt input fails instead of writing out of bounds!
+bool LZCodec::Decompress(const uint8_t* pSrc, uint64_t srcSize, uint8_t* pDst, uint64_t dstSize)
+{
+	const uint8_t* pIn = pSrc;
+	const uint8_t* pInEnd = pSrc + srcSize;
+	uint8_t* pOut = pDst;
+	uint8_t* pOutEnd = pDst + dstSize;
+
+	while (pIn < pInEnd)
+	{
+		const uint8_t token = *pIn++;
+
+		uint64_t numLiterals = token >> 4;
+		if (numLiterals == 15 && !ReadLength(pIn, pInEnd, numLiterals))
+			return false;
+
+		if (numLiterals > static_cast<uint64_t>(pInEnd - pIn) || numLiterals > static_cast<uint64_t>(pOutEnd - pOut))
+			return false;
+
+		if (numLiterals > 0)
+			memcpy(pOut, pIn, numLiterals);
+
+		pIn += numLiterals;
+		pOut += numLiterals;
+
+		// Last sequence is literals only
+		if (pIn == pInEnd)
+			break;
+
+		if (pInEnd - pIn < 2)
+			return false;
+
+		const uint32_t offset = pIn[0] | (pIn[1] << 8);
+		pIn += 2;
+
+		uint64_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(pIn, pInEnd, matchLength))
+			return false;
+
+		matchLength += g_uiMinMatch;
+
+		if (offset == 0 || offset > static_cast<uint64_t>(pOut - pDst) || matchLength > static_cast<uint64_t>(pOutEnd - pOut))
+			return false;
+
+		// Overlapping match repeats the last offset bytes, copies can't be wider than the offset
+		const uint8_t* pMatch = pOut - offset;
+		uint64_t i = 0;
+
+		if (offset >= matchLength)
+		{
+			memcpy(pOut, pMatch, matchLength);
+			i = matchLength;
+		}
+		else if (offset >= 8)
+		{
+			for (; i + 8 <= matchLength; i += 8)
+				memcpy(pOut + i, pMatch + i, 8);
+		}
+
+		for (; i < matchLength; ++i)
+			pOut[i] = pMatch[i];
+
+		pOut += matchLength;
+	}
+
+	return pOut == pOutEnd;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+//---------------------------------------------------------------------------------------------------------------------
+// Byte oriented LZ77 in the LZ4 block layout: token, literals, 16 bit offset, match length. Greedy single hash table
+// match finder, fast enough for the cooker & decoding is little more than memcpy. Both sides are thread safe!
+class LZCodec
+{
+public:
+	static inline uint64_t		GetMaxCompressedSize(uint64_t size) { return size + size / 255 + 16; }
+
+	// Returns compressed size, 0 if it didn't fit in dstCapacity. Inputs over 4 GB aren't compressed either!
+	static uint64_t				Compress(const uint8_t* pSrc, uint64_t srcSize, uint8_t* pDst, uint64_t dstCapacity);
+
+	// Exactly dstSize bytes must come out, anything else is treated as corrupt data. Matches read back from pDst, so it
+	// shouldn't be uncached or write combined memory!
+	static bool					Decompress(const uint8_t* pSrc, uint64_t srcSize, uint8_t* pDst, uint64_t dstSize);
+};
@@ -0,0 +1,132 @@
+#include "sandboxPCH.h"
+#include "MappedFile.h"
+#include "Core.h"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile()
+{
+	m_pData = nullptr;
+	m_uiSize = 0;
+
+#if defined(_WIN32)
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+#else
+	m_iFile = -1;
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+#if defined(_WIN32)
+	m_hFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_pData = m_hMapping ? static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	m_uiSize = static_cast<uint64_t>(size.QuadPart);
+#else
+	m_iFile = open(filePath.c_str(), O_RDONLY);
+	if (m_iFile < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(m_iFile, &info) != 0 || info.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* pMapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_iFile, 0);
+	m_pData = pMapping != MAP_FAILED ? static_cast<const uint8_t*>(pMapping) : nullptr;
+	m_uiSize = static_cast<uint64_t>(info.st_size);
+#endif
+
+	if (!m_pData)
+	{
+		LOG_ERROR("Failed to map {0}", filePath);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+#else
+	if (m_pData)
+		munmap(const_cast<uint8_t*>(m_pData), static_cast<size_t>(m_uiSize));
+
+	if (m_iFile >= 0)
+		close(m_iFile);
+
+	m_iFile = -1;
+#endif
+
+	m_pData = nullptr;
+	m_uiSize = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Only a hint, returns right away & the range is read in the background
+void MappedFile::Prefetch(uint64_t offset, uint64_t size) const
+{
+	if (!m_pData || offset >= m_uiSize)
+		return;
+
+	size = std::min(size, m_uiSize - offset);
+
+#if defined(_WIN32)
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast<uint8_t*>(m_pData + offset);
+	range.NumberOfBytes = static_cast<SIZE_T>(size);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// madvise wants a page aligned start
+	const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	const uint64_t start = offset & ~(pageSize - 1);
+	madvise(const_cast<uint8_t*>(m_pData + start), static_cast<size_t>(size + offset - start), MADV_WILLNEED);
+#endif
+}
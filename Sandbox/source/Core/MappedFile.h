@@ -0,0 +1,33 @@
+#pragma once
+
+//---------------------------------------------------------------------------------------------------------------------
+// Whole file mapped read only. Pages come in on first touch, Prefetch() asks the OS to read a range ahead in big
+// sequential requests instead. Reading the mapping is safe from any thread!
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool								Open(const std::string& filePath);
+	void								Close();
+	void								Prefetch(uint64_t offset, uint64_t size) const;
+
+	inline const uint8_t*				GetData() const		{ return m_pData; }
+	inline uint64_t						GetSize() const		{ return m_uiSize; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+private:
+	const uint8_t*						m_pData;
+	uint64_t							m_uiSize;
+
+#if defined(_WIN32)
+	void*								m_hFile;
+	void*								m_hMapping;
+#else
+	int									m_iFile;
+#endif
+};
@@ -0,0 +1,92 @@
+#include "sandboxPCH.h"
+#include "RingAllocator.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+RingAllocator::RingAllocator()
+{
+	m_ListRegions.clear();
+	m_uiCapacity = 0;
+	m_uiAlignment = 1;
+	m_uiHead = 0;
+	m_uiTail = 0;
+	m_uiNextID = 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Alignment must be a power of two. Ids keep counting up, ones from before the reset are never handed out again!
+void RingAllocator::Reset(uint64_t capacity, uint64_t alignment)
+{
+	m_ListRegions.clear();
+	m_uiCapacity = capacity;
+	m_uiAlignment = alignment;
+	m_uiHead = 0;
+	m_uiTail = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Used space is [tail, head) or, once wrapped, [tail, end) + [0, head). Head never catches up with tail while anything
+// is in use, so head == tail always means empty!
+bool RingAllocator::Allocate(uint64_t size, uint64_t* pOutOffset, uint64_t* pOutID)
+{
+	size = (std::max(size, uint64_t(1)) + m_uiAlignment - 1) & ~(m_uiAlignment - 1);
+
+	const uint64_t aligned = (m_uiHead + m_uiAlignment - 1) & ~(m_uiAlignment - 1);
+	uint64_t offset = 0;
+
+	if (m_uiTail <= m_uiHead)
+	{
+		if (aligned + size <= m_uiCapacity)
+			offset = aligned;
+		else if (size < m_uiTail)
+			offset = 0;													// wrap, skipped bytes at the end belong to this region
+		else
+			return false;
+	}
+	else
+	{
+		if (aligned + size < m_uiTail)
+			offset = aligned;
+		else
+			return false;
+	}
+
+	Region region;
+	region.uiID = m_uiNextID++;
+	region.uiEnd = offset + size;
+	region.bReleased = false;
+
+	m_ListRegions.push_back(region);
+	m_uiHead = region.uiEnd;
+
+	*pOutOffset = offset;
+	*pOutID = region.uiID;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Unknown ids are ignored, releasing twice does nothing!
+void RingAllocator::Release(uint64_t uiID)
+{
+	for (Region& region : m_ListRegions)
+	{
+		if (region.uiID == uiID)
+		{
+			region.bReleased = true;
+			break;
+		}
+	}
+
+	// Tail can only move over the oldest regions, later ones released early just wait for them!
+	while (!m_ListRegions.empty() && m_ListRegions.front().bReleased)
+	{
+		m_uiTail = m_ListRegions.front().uiEnd;
+		m_ListRegions.pop_front();
+	}
+
+	if (m_ListRegions.empty())
+	{
+		m_uiHead = 0;
+		m_uiTail = 0;
+	}
+}
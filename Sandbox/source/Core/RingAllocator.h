@@ -0,0 +1,36 @@
+#pragma once
+
+//---------------------------------------------------------------------------------------------------------------------
+// Offsets only ring behind VulkanStagingRing: regions are handed out front to back & wrap around, space comes back in
+// allocation order once they're released. Regions released early wait for the older ones before them. Knows nothing
+// about memory & doesn't lock, caller does both!
+class RingAllocator
+{
+public:
+	RingAllocator();
+
+	void								Reset(uint64_t capacity, uint64_t alignment);
+
+	// Offset is aligned, region's size is rounded up to the alignment. Fails when there's no contiguous space left!
+	bool								Allocate(uint64_t size, uint64_t* pOutOffset, uint64_t* pOutID);
+	void								Release(uint64_t uiID);
+
+	inline uint64_t						GetCapacity() const		{ return m_uiCapacity; }
+	inline size_t						GetNumRegions() const	{ return m_ListRegions.size(); }
+
+private:
+	struct Region
+	{
+		uint64_t						uiID;
+		uint64_t						uiEnd;
+		bool							bReleased;
+	};
+
+private:
+	std::deque<Region>					m_ListRegions;			// oldest first
+	uint64_t							m_uiCapacity;
+	uint64_t							m_uiAlignment;
+	uint64_t							m_uiHead;
+	uint64_t							m_uiTail;
+	uint64_t							m_uiNextID;
+};
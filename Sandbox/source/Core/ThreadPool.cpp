@@ -0,0 +1,90 @@
+#include "sandboxPCH.h"
+#include "ThreadPool.h"
+#include "Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+ThreadPool::ThreadPool(uint32_t numThreads)
+{
+	m_uiActiveJobs = 0;
+	m_bShutdown = false;
+
+	// Always keep at least one worker, hardware_concurrency() is allowed to return 0!
+	numThreads = std::max(numThreads, 1u);
+
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		m_ListWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	LOG_DEBUG("Thread pool created with {0} workers", numThreads);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bShutdown = true;
+	}
+
+	m_cvJobAvailable.notify_all();
+
+	for (std::thread& worker : m_ListWorkers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+
+	m_ListWorkers.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ThreadPool::Enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_QueueJobs.push(std::move(job));
+	}
+
+	m_cvJobAvailable.notify_one();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Blocks the caller till queue is drained & no worker is busy!
+void ThreadPool::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_cvIdle.wait(lock, [this]() { return m_QueueJobs.empty() && m_uiActiveJobs == 0; });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_cvJobAvailable.wait(lock, [this]() { return m_bShutdown || !m_QueueJobs.empty(); });
+
+			// Drop whatever is still queued on shutdown, owners are expected to WaitIdle() if they care!
+			if (m_bShutdown)
+				return;
+
+			job = std::move(m_QueueJobs.front());
+			m_QueueJobs.pop();
+			++m_uiActiveJobs;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			--m_uiActiveJobs;
+
+			if (m_QueueJobs.empty() && m_uiActiveJobs == 0)
+				m_cvIdle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+//---------------------------------------------------------------------------------------------------------------------
+// Fixed set of worker threads pulling jobs from a single FIFO queue. Jobs must not touch the Vulkan queues, anything
+// that needs a command buffer is handed back to the main thread!
+class ThreadPool
+{
+public:
+	ThreadPool(uint32_t numThreads);
+	~ThreadPool();
+
+	void								Enqueue(std::function<void()> job);
+	void								WaitIdle();
+
+	inline uint32_t						GetNumThreads() const { return static_cast<uint32_t>(m_ListWorkers.size()); }
+
+private:
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	void								WorkerLoop();
+
+private:
+	std::vector<std::thread>			m_ListWorkers;
+	std::queue<std::function<void()>>	m_QueueJobs;
+
+	std::mutex							m_Mutex;
+	std::condition_variable				m_cvJobAvailable;
+	std::condition_variable				m_cvIdle;
+
+	uint32_t							m_uiActiveJobs;
+	bool								m_bShutdown;
+};
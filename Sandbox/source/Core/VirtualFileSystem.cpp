@@ -0,0 +1,416 @@
+#include "sandboxPCH.h"
+#include "VirtualFileSystem.h"
+#include "MappedFile.h"
+#include "LZCodec.h"
+#include "ThreadPool.h"
+#include "AsyncFileIO.h"
+#include "Core.h"
+
+namespace
+{
+	// Never 0, that's what a thread's decoded chunk starts with
+	std::atomic<uint64_t> g_uiNextMountId(1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VirtualFileSystem::VirtualFileSystem()
+{
+	m_pPack = nullptr;
+	m_uiMountId = 0;
+	m_pEntries = nullptr;
+	m_uiNumEntries = 0;
+	m_pChunks = nullptr;
+	m_uiChunkSize = 0;
+	m_pNames = nullptr;
+
+	m_pWorkers = nullptr;
+	m_pAsyncIO = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VirtualFileSystem::~VirtualFileSystem()
+{
+	Unmount();
+	SAFE_DELETE(m_pAsyncIO);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Whole table is validated here, so lookups & reads can trust every entry later on!
+bool VirtualFileSystem::Mount(const std::string& packPath)
+{
+	Unmount();
+
+	// Loose files are read through it too, so it's there even without a pack
+	if (!m_pAsyncIO)
+	{
+		m_pAsyncIO = new AsyncFileIO();
+		m_pAsyncIO->Initialize();
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	m_uiMountId = g_uiNextMountId++;
+	m_pPack = new MappedFile();
+	if (!m_pPack->Open(packPath))
+	{
+		LOG_INFO("No pack at {0}, reading loose cooked files", packPath);
+		SAFE_DELETE(m_pPack);
+		return true;
+	}
+
+	const uint8_t* pData = m_pPack->GetData();
+	const uint64_t packSize = m_pPack->GetSize();
+
+	Helper::PackHeader header;
+	bool bValid = packSize >= sizeof(header);
+
+	if (bValid)
+	{
+		memcpy(&header, pData, sizeof(header));
+
+		const uint64_t tocEnd = sizeof(header) + static_cast<uint64_t>(header.uiNumEntries) * sizeof(Helper::PackEntry);
+		const uint64_t chunksEnd = header.uiChunksOffset + static_cast<uint64_t>(header.uiNumChunks) * sizeof(Helper::PackChunk);
+		bValid =	header.uiMagic == Helper::g_uiPackMagic && header.uiVersion == Helper::g_uiPackVersion && header.uiChunkSize > 0 &&
+					header.uiChunksOffset >= tocEnd && header.uiNamesOffset >= chunksEnd && header.uiNamesOffset + header.uiNamesSize <= packSize;
+	}
+
+	bool bAnyCompressed = false;
+
+	if (bValid)
+	{
+		m_pEntries = reinterpret_cast<const Helper::PackEntry*>(pData + sizeof(header));
+		m_uiNumEntries = header.uiNumEntries;
+		m_pChunks = reinterpret_cast<const Helper::PackChunk*>(pData + header.uiChunksOffset);
+		m_uiChunkSize = header.uiChunkSize;
+		m_pNames = reinterpret_cast<const char*>(pData + header.uiNamesOffset);
+
+		for (uint32_t i = 0; bValid && i < m_uiNumEntries; i++)
+		{
+			const Helper::PackEntry& entry = m_pEntries[i];
+			bValid =	entry.uiNameOffset + entry.uiNameLength <= header.uiNamesSize &&
+						entry.uiDataOffset + entry.uiStoredSize <= packSize;
+
+			if (entry.eCompression == Helper::PackCompression::NONE)
+			{
+				bValid = bValid && entry.uiStoredSize == entry.uiSize;
+				continue;
+			}
+
+			bValid =	bValid && entry.eCompression == Helper::PackCompression::LZ &&
+						static_cast<uint64_t>(entry.uiFirstChunk) + entry.uiNumChunks <= header.uiNumChunks &&
+						entry.uiNumChunks == (entry.uiSize + m_uiChunkSize - 1) / m_uiChunkSize;
+
+			// Every chunk must stay within its entry & stored ones must hold their whole range
+			for (uint32_t c = 0; bValid && c < entry.uiNumChunks; c++)
+			{
+				const Helper::PackChunk& chunk = m_pChunks[entry.uiFirstChunk + c];
+				const uint64_t chunkSize = std::min<uint64_t>(m_uiChunkSize, entry.uiSize - static_cast<uint64_t>(c) * m_uiChunkSize);
+
+				bValid =	chunk.uiStoredOffset + chunk.uiStoredSize <= entry.uiStoredSize &&
+							(chunk.eCompression == Helper::PackCompression::LZ || (chunk.eCompression == Helper::PackCompression::NONE && chunk.uiStoredSize == chunkSize));
+			}
+
+			bAnyCompressed = true;
+		}
+	}
+
+	if (!bValid)
+	{
+		LOG_ERROR("Pack {0} is stale or corrupt, re-run the Cooker! Reading loose cooked files", packPath);
+		Unmount();
+		return false;
+	}
+
+	if (Helper::g_bPrefetchPack)
+		m_pPack->Prefetch(0, packSize);
+
+	m_strPackPath = packPath;
+
+	// Caller always decodes along, so leave it its core! Async reads without completion workers decode on these too, so
+	// they're there even when chunks aren't spread over them
+	if (bAnyCompressed)
+	{
+		uint32_t numCores = std::thread::hardware_concurrency();
+		m_pWorkers = new ThreadPool(numCores > 1 ? numCores - 1 : 1);
+	}
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	LOG_INFO("Mounted {0}: {1} entries, {2:.2f} MB in {3:.2f} ms", packPath, m_uiNumEntries, packSize / (1024.0f * 1024.0f), elapsedMs);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reads & workers go first, a late job may still be looking at the table!
+void VirtualFileSystem::Unmount()
+{
+	if (m_pAsyncIO)
+		m_pAsyncIO->WaitIdle();
+
+	SAFE_DELETE(m_pWorkers);
+
+	m_strPackPath.clear();
+
+	m_pEntries = nullptr;
+	m_uiNumEntries = 0;
+	m_pChunks = nullptr;
+	m_uiChunkSize = 0;
+	m_pNames = nullptr;
+
+	SAFE_DELETE(m_pPack);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VirtualFileSystem::GetFileSize(const std::string& filePath, uint64_t* pOutSize) const
+{
+	if (const Helper::PackEntry* pEntry = FindEntry(filePath))
+	{
+		*pOutSize = pEntry->uiSize;
+		return true;
+	}
+
+	std::error_code error;
+	*pOutSize = std::filesystem::file_size(filePath, error);
+
+	return !error;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VirtualFileSystem::Read(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst) const
+{
+	const Helper::PackEntry* pEntry = FindEntry(filePath);
+	if (!pEntry)
+		return ReadLoose(filePath, offset, size, pDst);
+
+	if (offset > pEntry->uiSize || size > pEntry->uiSize - offset)
+		return false;
+
+	if (size == 0)
+		return true;
+
+	if (pEntry->eCompression != Helper::PackCompression::NONE)
+		return ReadChunked(pEntry, m_pPack->GetData() + pEntry->uiDataOffset, 0, offset, size, pDst);
+
+	memcpy(pDst, m_pPack->GetData() + pEntry->uiDataOffset + offset, size);
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Stored bytes come in through AsyncFileIO, pack file is read like any other file instead of faulting in the mapping.
+// Compressed ranges are read as stored & decoded by the completion job itself, so decoding one read overlaps with the
+// I/O of the next ones!
+void VirtualFileSystem::ReadAsync(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst, ThreadPool* pCompletionWorkers,
+									std::function<void(bool)> onComplete) const
+{
+	// Reads which can't even start still report back the same way
+	auto CompleteNow = [pCompletionWorkers](std::function<void(bool)> onComplete, bool bSucceeded)
+	{
+		if (pCompletionWorkers)
+			pCompletionWorkers->Enqueue([onComplete, bSucceeded]() { onComplete(bSucceeded); });
+		else
+			onComplete(bSucceeded);
+	};
+
+	if (!m_pAsyncIO)
+	{
+		CompleteNow(std::move(onComplete), Read(filePath, offset, size, pDst));
+		return;
+	}
+
+	const Helper::PackEntry* pEntry = FindEntry(filePath);
+	if (!pEntry)
+	{
+		m_pAsyncIO->Read(filePath, offset, size, pDst, pCompletionWorkers, std::move(onComplete));
+		return;
+	}
+
+	if (offset > pEntry->uiSize || size > pEntry->uiSize - offset)
+	{
+		CompleteNow(std::move(onComplete), false);
+		return;
+	}
+
+	if (pEntry->eCompression == Helper::PackCompression::NONE || size == 0)
+	{
+		m_pAsyncIO->Read(m_strPackPath, pEntry->uiDataOffset + offset, size, pDst, pCompletionWorkers, std::move(onComplete));
+		return;
+	}
+
+	// Chunks are stored back to back, the ones this read touches are a single range of the pack
+	const Helper::PackChunk& firstChunk = m_pChunks[pEntry->uiFirstChunk + offset / m_uiChunkSize];
+	const Helper::PackChunk& lastChunk = m_pChunks[pEntry->uiFirstChunk + (offset + size - 1) / m_uiChunkSize];
+
+	const uint64_t storedBase = firstChunk.uiStoredOffset;
+	auto pListStored = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(lastChunk.uiStoredOffset + lastChunk.uiStoredSize - storedBase));
+
+	// Decoding is no job for the I/O thread, it goes to our own workers if the caller didn't name any
+	ThreadPool* pDecodeWorkers = pCompletionWorkers ? pCompletionWorkers : m_pWorkers;
+
+	m_pAsyncIO->Read(m_strPackPath, pEntry->uiDataOffset + storedBase, pListStored->size(), pListStored->data(), pDecodeWorkers,
+		[this, pEntry, pListStored, storedBase, offset, size, pDst, onComplete](bool bRead)
+		{
+			onComplete(bRead && ReadChunked(pEntry, pListStored->data(), storedBase, offset, size, pDst));
+		});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VirtualFileSystem::WaitAsyncIdle() const
+{
+	if (m_pAsyncIO)
+		m_pAsyncIO->WaitIdle();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const uint8_t* VirtualFileSystem::GetMappedData(const std::string& filePath, uint64_t* pOutSize) const
+{
+	const Helper::PackEntry* pEntry = FindEntry(filePath);
+	if (!pEntry || pEntry->eCompression != Helper::PackCompression::NONE)
+		return nullptr;
+
+	*pOutSize = pEntry->uiSize;
+	return m_pPack->GetData() + pEntry->uiDataOffset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Table is sorted by path, binary search straight over the mapping!
+const Helper::PackEntry* VirtualFileSystem::FindEntry(const std::string& filePath) const
+{
+	if (!m_pEntries)
+		return nullptr;
+
+	auto GetName = [this](const Helper::PackEntry& entry) { return std::string_view(m_pNames + entry.uiNameOffset, entry.uiNameLength); };
+
+	const Helper::PackEntry* pEnd = m_pEntries + m_uiNumEntries;
+	const Helper::PackEntry* pEntry = std::lower_bound(m_pEntries, pEnd, std::string_view(filePath),
+														[&](const Helper::PackEntry& entry, std::string_view path) { return GetName(entry) < path; });
+
+	return pEntry != pEnd && GetName(*pEntry) == filePath ? pEntry : nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Chunks the read touches are handed out one at a time to the caller & as many workers as there are chunks left. Caller
+// never just waits, so a read still finishes when every worker is busy or the caller is a worker itself!
+bool VirtualFileSystem::ReadChunked(const Helper::PackEntry* pEntry, const uint8_t* pStored, uint64_t storedBase, uint64_t offset, uint64_t size, void* pDst) const
+{
+	auto pRead = std::make_shared<ChunkedRead>();
+	pRead->pEntry = pEntry;
+	pRead->pStored = pStored;
+	pRead->uiStoredBase = storedBase;
+	pRead->uiOffset = offset;
+	pRead->uiSize = size;
+	pRead->pDst = static_cast<uint8_t*>(pDst);
+	pRead->uiFirstChunk = static_cast<uint32_t>(offset / m_uiChunkSize);
+	pRead->uiNumChunks = static_cast<uint32_t>((offset + size - 1) / m_uiChunkSize) + 1 - pRead->uiFirstChunk;
+	pRead->uiNextChunk = 0;
+	pRead->uiDoneChunks = 0;
+	pRead->bFailed = false;
+
+	if (m_pWorkers && Helper::g_bParallelPackDecode)
+	{
+		const uint32_t numHelpers = std::min(pRead->uiNumChunks - 1, m_pWorkers->GetNumThreads());
+		for (uint32_t i = 0; i < numHelpers; i++)
+		{
+			// Helper that starts after the read is done finds no chunk left & returns right away
+			m_pWorkers->Enqueue([this, pRead]() { DecodeChunks(pRead.get()); });
+		}
+	}
+
+	DecodeChunks(pRead.get());
+
+	{
+		std::unique_lock<std::mutex> lock(pRead->mutexDone);
+		pRead->cvDone.wait(lock, [&]() { return pRead->uiDoneChunks == pRead->uiNumChunks; });
+	}
+
+	if (pRead->bFailed)
+	{
+		LOG_ERROR("Corrupt pack entry {0}, re-run the Cooker!", std::string(m_pNames + pEntry->uiNameOffset, pEntry->uiNameLength));
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VirtualFileSystem::DecodeChunks(ChunkedRead* pRead) const
+{
+	while (true)
+	{
+		const uint32_t index = pRead->uiNextChunk++;
+		if (index >= pRead->uiNumChunks)
+			return;
+
+		if (!DecodeChunk(pRead, pRead->uiFirstChunk + index))
+			pRead->bFailed = true;
+
+		if (++pRead->uiDoneChunks == pRead->uiNumChunks)
+		{
+			std::lock_guard<std::mutex> lock(pRead->mutexDone);
+			pRead->cvDone.notify_all();
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every compressed chunk is decoded into a scratch buffer & copied out: pDst is often write combined staging memory,
+// which match copies reading back what they just wrote would crawl through! Scratch keeps the last chunk the thread
+// decoded, so small reads walking through a file front to back decode each chunk once, without a lock between threads.
+bool VirtualFileSystem::DecodeChunk(const ChunkedRead* pRead, uint32_t chunkIndex) const
+{
+	const Helper::PackEntry* pEntry = pRead->pEntry;
+	const uint64_t offset = pRead->uiOffset;
+	const uint64_t size = pRead->uiSize;
+	uint8_t* pDst = pRead->pDst;
+
+	const Helper::PackChunk& chunk = m_pChunks[pEntry->uiFirstChunk + chunkIndex];
+	const uint8_t* pStored = pRead->pStored + (chunk.uiStoredOffset - pRead->uiStoredBase);
+
+	const uint64_t chunkStart = static_cast<uint64_t>(chunkIndex) * m_uiChunkSize;
+	const uint64_t chunkSize = std::min<uint64_t>(m_uiChunkSize, pEntry->uiSize - chunkStart);
+
+	const uint64_t copyStart = std::max(offset, chunkStart);
+	const uint64_t copyEnd = std::min(offset + size, chunkStart + chunkSize);
+	uint8_t* pCopyDst = pDst + (copyStart - offset);
+
+	if (chunk.eCompression == Helper::PackCompression::NONE)
+	{
+		memcpy(pCopyDst, pStored + (copyStart - chunkStart), copyEnd - copyStart);
+		return true;
+	}
+
+	struct DecodedChunk
+	{
+		uint64_t					uiMountId = 0;
+		uint32_t					uiChunk = 0;				// into the pack's chunk table
+		std::vector<uint8_t>		listData;
+	};
+
+	thread_local DecodedChunk decoded;
+
+	const uint32_t packChunk = pEntry->uiFirstChunk + chunkIndex;
+	if (decoded.uiMountId != m_uiMountId || decoded.uiChunk != packChunk)
+	{
+		decoded.uiMountId = 0;
+		decoded.listData.resize(m_uiChunkSize);
+
+		if (!LZCodec::Decompress(pStored, chunk.uiStoredSize, decoded.listData.data(), chunkSize))
+			return false;
+
+		decoded.uiMountId = m_uiMountId;
+		decoded.uiChunk = packChunk;
+	}
+
+	memcpy(pCopyDst, decoded.listData.data() + (copyStart - chunkStart), copyEnd - copyStart);
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VirtualFileSystem::ReadLoose(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+		return false;
+
+	file.seekg(offset);
+	return static_cast<bool>(file.read(static_cast<char*>(pDst), size));
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Renderer/CookedFormat.h"
+
+class MappedFile;
+class ThreadPool;
+class AsyncFileIO;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Resolves cooked asset paths to pack entries (see Helper::PackHeader), anything not in the mounted pack is read as a
+// loose file, so freshly cooked assets work without repacking. Compressed entries are decoded chunk by chunk through a
+// per thread scratch buffer into the caller's memory, chunks of one read spread over the file system's own workers.
+// Scratch holds on to the last chunk it decoded, a thread reading on in the same chunk only copies.
+// Every read is safe from any thread, workers included!
+class VirtualFileSystem
+{
+public:
+	VirtualFileSystem();
+	~VirtualFileSystem();
+
+	// Missing pack isn't an error, every path then goes to loose files
+	bool								Mount(const std::string& packPath);
+	void								Unmount();
+
+	bool								GetFileSize(const std::string& filePath, uint64_t* pOutSize) const;
+	bool								Read(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst) const;
+
+	// Returns right away, callback runs as a job on pCompletionWorkers once pDst holds the data (see AsyncFileIO)
+	void								ReadAsync(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst, ThreadPool* pCompletionWorkers,
+													std::function<void(bool)> onComplete) const;
+	void								WaitAsyncIdle() const;
+
+	// Straight view into the mapping for uncompressed pack entries, null for anything else
+	const uint8_t*						GetMappedData(const std::string& filePath, uint64_t* pOutSize) const;
+
+private:
+	struct ChunkedRead
+	{
+		const Helper::PackEntry*		pEntry;
+		const uint8_t*					pStored;				// entry's stored bytes from uiStoredBase on
+		uint64_t						uiStoredBase;
+		uint64_t						uiOffset;
+		uint64_t						uiSize;
+		uint8_t*						pDst;
+		uint32_t						uiFirstChunk;			// of the entry's chunks, first one the read touches
+		uint32_t						uiNumChunks;
+
+		std::atomic<uint32_t>			uiNextChunk;
+		std::atomic<uint32_t>			uiDoneChunks;
+		std::atomic<bool>				bFailed;
+
+		std::mutex						mutexDone;
+		std::condition_variable			cvDone;
+	};
+
+	const Helper::PackEntry*			FindEntry(const std::string& filePath) const;
+	bool								ReadChunked(const Helper::PackEntry* pEntry, const uint8_t* pStored, uint64_t storedBase, uint64_t offset, uint64_t size, void* pDst) const;
+	void								DecodeChunks(ChunkedRead* pRead) const;
+	bool								DecodeChunk(const ChunkedRead* pRead, uint32_t chunkIndex) const;
+	static bool							ReadLoose(const std::string& filePath, uint64_t offset, uint64_t size, void* pDst);
+
+private:
+	MappedFile*							m_pPack;
+	uint64_t							m_uiMountId;			// unique per mount, tells threads' decoded chunks of other packs apart
+	std::string							m_strPackPath;
+	const Helper::PackEntry*			m_pEntries;
+	uint32_t							m_uiNumEntries;
+	const Helper::PackChunk*			m_pChunks;
+	uint32_t							m_uiChunkSize;
+	const char*							m_pNames;
+
+	ThreadPool*							m_pWorkers;				// only while a pack with compressed entries is mounted
+	AsyncFileIO*						m_pAsyncIO;
+};
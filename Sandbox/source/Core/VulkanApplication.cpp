@@ -59,6 +59,7 @@ void VulkanApplication::Render()
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanApplication::Cleanup()
 {
+	m_pVulkanRenderer->PreSceneCleanup(m_pScene);
 	m_pScene->Cleanup(m_pVulkanRenderer->GetVulkanContext());
 
 	m_pVulkanRenderer->Cleanup();
@@ -153,8 +154,25 @@ bool VulkanApplication::SetupDebugMessenger()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
+// Every shader is compiled to <name>.spv, except for the ones with variants below. Those are compiled once per variant
+// with its defines instead. Any shader failing to compile fails initialization!
 bool VulkanApplication::RunShaderCompiler(const std::string& directoryPath)
 {
+	struct ShaderVariant
+	{
+		std::string		strSource;
+		std::string		strOutput;
+		std::string		strDefines;
+	};
+
+	// One per Helper::EVertexFormat, inputs must match its Helper::VertexLayout exactly. See VulkanRenderer's pipelines!
+	const std::vector<ShaderVariant> listVariants =
+	{
+		{ "triangle.vert",	"triangle_pn.vert.spv",		"" },
+		{ "triangle.vert",	"triangle_pnu.vert.spv",	" -DHAS_UV" },
+		{ "triangle.vert",	"triangle.vert.spv",		" -DHAS_UV -DHAS_TANGENT" },
+	};
+
 	// First check if shader compiler exists at the path mentioned?
 	std::filesystem::path compilerPath(Helper::gShaderCompilerPath);
 
@@ -165,9 +183,29 @@ bool VulkanApplication::RunShaderCompiler(const std::string& directoryPath)
 			if (entry.is_regular_file() &&
 				(entry.path().extension().string() == ".vert" || entry.path().extension().string() == ".frag"))
 			{
-				std::string cmd = Helper::gShaderCompilerPath + " --target-env=vulkan1.3" + " -c" + " " + entry.path().string() + " -o " + entry.path().string() + ".spv";
-				LOG_DEBUG("Compiling shader " + entry.path().filename().string());
-				std::system(cmd.c_str());
+				const std::string fileName = entry.path().filename().string();
+
+				std::vector<std::pair<std::string, std::string>> listOutputs;
+				for (const ShaderVariant& variant : listVariants)
+				{
+					if (variant.strSource == fileName)
+						listOutputs.push_back({ (entry.path().parent_path() / variant.strOutput).string(), variant.strDefines });
+				}
+
+				if (listOutputs.empty())
+					listOutputs.push_back({ entry.path().string() + ".spv", "" });
+
+				for (const auto& output : listOutputs)
+				{
+					std::string cmd = Helper::gShaderCompilerPath + " --target-env=vulkan1.3" + output.second + " -c" + " " + entry.path().string() + " -o " + output.first;
+					LOG_DEBUG("Compiling shader " + fileName + output.second);
+
+					if (std::system(cmd.c_str()) != 0)
+					{
+						LOG_ERROR("Failed to compile shader {0}!", output.first);
+						return false;
+					}
+				}
 			}
 		}
 
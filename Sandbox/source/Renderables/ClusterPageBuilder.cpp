@@ -0,0 +1,432 @@
+#include "sandboxPCH.h"
+#include "ClusterPageBuilder.h"
+#include "MeshOptimizer.h"
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	inline glm::vec3 GetPosition(const float* pPositions, size_t positionStride, uint32_t index)
+	{
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pPositions) + index * positionStride);
+		return glm::vec3(p[0], p[1], p[2]);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Smallest sphere around both, grows the first one
+	void MergeSphere(glm::vec3& center, float& radius, const glm::vec3& otherCenter, float otherRadius)
+	{
+		const float distance = glm::length(otherCenter - center);
+
+		if (distance + otherRadius <= radius)
+			return;
+
+		if (distance + radius <= otherRadius)
+		{
+			center = otherCenter;
+			radius = otherRadius;
+			return;
+		}
+
+		const float newRadius = (distance + radius + otherRadius) * 0.5f;
+		center += (otherCenter - center) * ((newRadius - radius) / distance);
+		radius = newRadius;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Page is judged by the group it came out of, leaves by themselves. Group takes what its inputs are judged by, so its
+// sphere holds theirs & its error is never below theirs!
+void ClusterPageBuilder::Build(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+								std::vector<ClusterPage>& outListPages, std::vector<ClusterPageGroup>& outListGroups,
+								std::vector<uint32_t>& outListGroupParents, std::vector<std::vector<uint32_t>>& outListPageIndices)
+{
+	outListPages.clear();
+	outListGroups.clear();
+	outListGroupParents.clear();
+	outListPageIndices.clear();
+
+	std::vector<uint32_t> listStamps(vertexCount);
+	SplitIntoPages(listIndices, pPositions, positionStride, listStamps, outListPageIndices);
+
+	std::vector<uint32_t> listLevel(outListPageIndices.size());
+	outListPages.resize(outListPageIndices.size());
+
+	for (size_t i = 0; i < outListPages.size(); i++)
+	{
+		ComputePageBounds(outListPages[i], outListPageIndices[i], pPositions, positionStride);
+		listLevel[i] = static_cast<uint32_t>(i);
+	}
+
+	std::vector<std::vector<uint32_t>> listLevelGroups;
+	std::vector<std::vector<uint32_t>> listOutputs;
+	std::vector<uint32_t> listNextLevel;
+	std::vector<uint32_t> listUnion;
+	std::vector<uint32_t> listVertices;
+	std::vector<uint32_t> listLocalIndices;
+	std::vector<glm::vec3> listPositions;
+
+	while (listLevel.size() > 1)
+	{
+		GroupPages(listLevel, outListPageIndices, listLevelGroups);
+
+		const size_t numGroupsBefore = outListGroups.size();
+		listNextLevel.clear();
+
+		for (const std::vector<uint32_t>& listGroup : listLevelGroups)
+		{
+			ClusterPageGroup group = {};
+			listUnion.clear();
+
+			for (size_t i = 0; i < listGroup.size(); i++)
+			{
+				const ClusterPage& page = outListPages[listGroup[i]];
+				const bool bLeaf = page.uiSourceGroup == g_uiNoPageGroup;
+
+				const glm::vec3 center = bLeaf ? page.center : outListGroups[page.uiSourceGroup].center;
+				const float radius = bLeaf ? page.radius : outListGroups[page.uiSourceGroup].radius;
+				const float error = bLeaf ? 0.0f : outListGroups[page.uiSourceGroup].fError;
+
+				if (i == 0)
+				{
+					group.center = center;
+					group.radius = radius;
+				}
+
+				MergeSphere(group.center, group.radius, center, radius);
+				group.fError = glm::max(group.fError, error);
+
+				listUnion.insert(listUnion.end(), outListPageIndices[listGroup[i]].begin(), outListPageIndices[listGroup[i]].end());
+			}
+
+			// Edges shared with other groups are open in the union, so Simplify() keeps them where they are!
+			Localize(listUnion, listStamps, listVertices, listLocalIndices);
+
+			listPositions.resize(listVertices.size());
+			for (size_t i = 0; i < listVertices.size(); i++)
+			{
+				listPositions[i] = GetPosition(pPositions, positionStride, listVertices[i]);
+			}
+
+			float error = 0.0f;
+			std::vector<uint32_t> listSimplified = MeshOptimizer::Simplify(listLocalIndices, &listPositions[0].x, sizeof(glm::vec3), static_cast<uint32_t>(listVertices.size()),
+																			listLocalIndices.size() / 6 * 3, &error);
+
+			// Barely smaller isn't worth a level, pages wait for next level's groups which have other borders locked. Nothing
+			// left would leave the group without outputs to stand in for it, so it's kept as well!
+			if (listSimplified.empty() || listSimplified.size() * 4 > listLocalIndices.size() * 3)
+			{
+				listNextLevel.insert(listNextLevel.end(), listGroup.begin(), listGroup.end());
+				continue;
+			}
+
+			for (uint32_t& index : listSimplified)
+			{
+				index = listVertices[index];
+			}
+
+			const uint32_t groupIndex = static_cast<uint32_t>(outListGroups.size());
+			group.fError += error;
+			outListGroups.push_back(group);
+
+			for (uint32_t page : listGroup)
+			{
+				outListPages[page].uiParentGroup = groupIndex;
+			}
+
+			SplitIntoPages(listSimplified, pPositions, positionStride, listStamps, listOutputs);
+
+			for (std::vector<uint32_t>& listOutput : listOutputs)
+			{
+				ClusterPage page = {};
+				ComputePageBounds(page, listOutput, pPositions, positionStride);
+				page.uiSourceGroup = groupIndex;
+
+				listNextLevel.push_back(static_cast<uint32_t>(outListPages.size()));
+				outListPages.push_back(page);
+				outListPageIndices.push_back(std::move(listOutput));
+			}
+		}
+
+		// Nothing shrank, whatever is left are the roots
+		if (outListGroups.size() == numGroupsBefore)
+			break;
+
+		listLevel.swap(listNextLevel);
+	}
+
+	// Pages sorted by the group they're simplified in, so every group's inputs are contiguous. Roots go last!
+	std::vector<uint32_t> listOrder(outListPages.size());
+	for (size_t i = 0; i < listOrder.size(); i++)
+	{
+		listOrder[i] = static_cast<uint32_t>(i);
+	}
+
+	std::stable_sort(listOrder.begin(), listOrder.end(),
+						[&outListPages](uint32_t a, uint32_t b) { return outListPages[a].uiParentGroup < outListPages[b].uiParentGroup; });
+
+	std::vector<ClusterPage> listSortedPages(outListPages.size());
+	std::vector<std::vector<uint32_t>> listSortedIndices(outListPages.size());
+
+	for (size_t i = 0; i < listOrder.size(); i++)
+	{
+		listSortedPages[i] = outListPages[listOrder[i]];
+		listSortedIndices[i] = std::move(outListPageIndices[listOrder[i]]);
+
+		const uint32_t parent = listSortedPages[i].uiParentGroup;
+		if (parent == g_uiNoPageGroup)
+			continue;
+
+		if (outListGroups[parent].uiNumPages == 0)
+			outListGroups[parent].uiFirstPage = static_cast<uint32_t>(i);
+
+		outListGroups[parent].uiNumPages++;
+	}
+
+	outListPages.swap(listSortedPages);
+	outListPageIndices.swap(listSortedIndices);
+
+	// Groups a group's outputs are simplified in, always ones built after it
+	std::vector<std::vector<uint32_t>> listParents(outListGroups.size());
+	for (const ClusterPage& page : outListPages)
+	{
+		if (page.uiSourceGroup != g_uiNoPageGroup && page.uiParentGroup != g_uiNoPageGroup)
+			listParents[page.uiSourceGroup].push_back(page.uiParentGroup);
+	}
+
+	for (size_t i = 0; i < outListGroups.size(); i++)
+	{
+		std::sort(listParents[i].begin(), listParents[i].end());
+		listParents[i].erase(std::unique(listParents[i].begin(), listParents[i].end()), listParents[i].end());
+
+		outListGroups[i].uiFirstParent = static_cast<uint32_t>(outListGroupParents.size());
+		outListGroups[i].uiNumParents = static_cast<uint32_t>(listParents[i].size());
+		outListGroupParents.insert(outListGroupParents.end(), listParents[i].begin(), listParents[i].end());
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Sparse set, a vertex is known when the slot its stamp points at holds it. Stale stamps can't match, nothing to clear!
+void ClusterPageBuilder::Localize(const std::vector<uint32_t>& listIndices, std::vector<uint32_t>& listStamps, std::vector<uint32_t>& outListVertices,
+									std::vector<uint32_t>& outListLocalIndices)
+{
+	outListVertices.clear();
+	outListLocalIndices.resize(listIndices.size());
+
+	for (size_t i = 0; i < listIndices.size(); i++)
+	{
+		const uint32_t vertex = listIndices[i];
+		uint32_t local = listStamps[vertex];
+
+		if (local >= outListVertices.size() || outListVertices[local] != vertex)
+		{
+			local = static_cast<uint32_t>(outListVertices.size());
+			listStamps[vertex] = local;
+			outListVertices.push_back(vertex);
+		}
+
+		outListLocalIndices[i] = local;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ClusterPageBuilder::SplitIntoPages(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, std::vector<uint32_t>& listStamps,
+										std::vector<std::vector<uint32_t>>& outListPageIndices)
+{
+	const size_t numTriangles = listIndices.size() / 3;
+
+	std::vector<glm::vec3> listCenters(numTriangles);
+	std::vector<uint32_t> listTriangles(numTriangles);
+
+	for (size_t i = 0; i < numTriangles; i++)
+	{
+		listCenters[i] = (	GetPosition(pPositions, positionStride, listIndices[i * 3 + 0]) +
+							GetPosition(pPositions, positionStride, listIndices[i * 3 + 1]) +
+							GetPosition(pPositions, positionStride, listIndices[i * 3 + 2])) / 3.0f;
+		listTriangles[i] = static_cast<uint32_t>(i);
+	}
+
+	outListPageIndices.clear();
+
+	if (numTriangles > 0)
+		Split(listTriangles, 0, numTriangles, listCenters, listIndices, listStamps, outListPageIndices);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Median split, so pages come out about the same size however the triangles are spread. Triangles sharing a center
+// still end up on both sides, every split makes progress!
+void ClusterPageBuilder::Split(std::vector<uint32_t>& listTriangles, size_t begin, size_t end, const std::vector<glm::vec3>& listCenters,
+								const std::vector<uint32_t>& listIndices, std::vector<uint32_t>& listStamps, std::vector<std::vector<uint32_t>>& outListPageIndices)
+{
+	if (end - begin <= Helper::g_uiClusterPageTriangles)
+	{
+		std::vector<uint32_t> listPageIndices;
+		listPageIndices.reserve((end - begin) * 3);
+
+		for (size_t i = begin; i < end; i++)
+		{
+			listPageIndices.insert(listPageIndices.end(), listIndices.begin() + listTriangles[i] * 3, listIndices.begin() + listTriangles[i] * 3 + 3);
+		}
+
+		std::vector<uint32_t> listVertices;
+		std::vector<uint32_t> listLocalIndices;
+		Localize(listPageIndices, listStamps, listVertices, listLocalIndices);
+
+		if (listVertices.size() <= Helper::g_uiClusterPageVertices || end - begin == 1)
+		{
+			outListPageIndices.push_back(std::move(listPageIndices));
+			return;
+		}
+	}
+
+	glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (size_t i = begin; i < end; i++)
+	{
+		boundsMin = glm::min(boundsMin, listCenters[listTriangles[i]]);
+		boundsMax = glm::max(boundsMax, listCenters[listTriangles[i]]);
+	}
+
+	const glm::vec3 extent = boundsMax - boundsMin;
+	const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+	const size_t middle = begin + (end - begin) / 2;
+
+	std::nth_element(listTriangles.begin() + begin, listTriangles.begin() + middle, listTriangles.begin() + end,
+						[&listCenters, axis](uint32_t a, uint32_t b) { return listCenters[a][axis] < listCenters[b][axis]; });
+
+	Split(listTriangles, begin, middle, listCenters, listIndices, listStamps, outListPageIndices);
+	Split(listTriangles, middle, end, listCenters, listIndices, listStamps, outListPageIndices);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Greedy: each group grows from the first page left over, always by the neighbour sharing the most vertices with it.
+// Borders locked at the level before are full detail & so the longest ones, groups tend to form right across them!
+void ClusterPageBuilder::GroupPages(const std::vector<uint32_t>& listLevel, const std::vector<std::vector<uint32_t>>& listPageIndices,
+									std::vector<std::vector<uint32_t>>& outListGroups)
+{
+	const uint32_t numPages = static_cast<uint32_t>(listLevel.size());
+
+	// Every page's vertices, sorted by vertex so pages sharing one are next to each other
+	std::vector<std::pair<uint32_t, uint32_t>> listVertexPages;
+	for (uint32_t p = 0; p < numPages; p++)
+	{
+		for (uint32_t vertex : listPageIndices[listLevel[p]])
+		{
+			listVertexPages.push_back({ vertex, p });
+		}
+	}
+
+	std::sort(listVertexPages.begin(), listVertexPages.end());
+	listVertexPages.erase(std::unique(listVertexPages.begin(), listVertexPages.end()), listVertexPages.end());
+
+	// One entry per shared vertex & pair of pages, runs of the same pair then add up to its weight
+	std::vector<std::pair<uint32_t, uint32_t>> listShared;
+	for (size_t begin = 0, end = 0; begin < listVertexPages.size(); begin = end)
+	{
+		while (end < listVertexPages.size() && listVertexPages[end].first == listVertexPages[begin].first)
+			end++;
+
+		for (size_t a = begin; a < end; a++)
+		{
+			for (size_t b = begin; b < end; b++)
+			{
+				if (a != b)
+					listShared.push_back({ listVertexPages[a].second, listVertexPages[b].second });
+			}
+		}
+	}
+
+	std::sort(listShared.begin(), listShared.end());
+
+	std::vector<uint32_t> listFirstNeighbour(numPages + 1, 0);
+	std::vector<std::pair<uint32_t, uint32_t>> listNeighbours;			// page & weight
+
+	for (size_t begin = 0, end = 0; begin < listShared.size(); begin = end)
+	{
+		while (end < listShared.size() && listShared[end] == listShared[begin])
+			end++;
+
+		listNeighbours.push_back({ listShared[begin].second, static_cast<uint32_t>(end - begin) });
+		listFirstNeighbour[listShared[begin].first + 1]++;
+	}
+
+	for (uint32_t p = 0; p < numPages; p++)
+	{
+		listFirstNeighbour[p + 1] += listFirstNeighbour[p];
+	}
+
+	std::vector<bool> listAssigned(numPages, false);
+	std::vector<uint32_t> listWeights(numPages, 0);
+	std::vector<uint32_t> listTouched;
+
+	outListGroups.clear();
+
+	for (uint32_t seed = 0; seed < numPages; seed++)
+	{
+		if (listAssigned[seed])
+			continue;
+
+		std::vector<uint32_t> listGroup;
+		uint32_t page = seed;
+
+		while (true)
+		{
+			listAssigned[page] = true;
+			listGroup.push_back(listLevel[page]);
+
+			if (listGroup.size() >= Helper::g_uiClusterGroupPages)
+				break;
+
+			for (uint32_t n = listFirstNeighbour[page]; n < listFirstNeighbour[page + 1]; n++)
+			{
+				if (listWeights[listNeighbours[n].first] == 0)
+					listTouched.push_back(listNeighbours[n].first);
+
+				listWeights[listNeighbours[n].first] += listNeighbours[n].second;
+			}
+
+			uint32_t best = numPages;
+			for (uint32_t candidate : listTouched)
+			{
+				if (!listAssigned[candidate] && (best == numPages || listWeights[candidate] > listWeights[best]))
+					best = candidate;
+			}
+
+			if (best == numPages)
+				break;
+
+			page = best;
+		}
+
+		for (uint32_t touched : listTouched)
+		{
+			listWeights[touched] = 0;
+		}
+
+		listTouched.clear();
+		outListGroups.push_back(std::move(listGroup));
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ClusterPageBuilder::ComputePageBounds(ClusterPage& page, const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride)
+{
+	glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (uint32_t index : listIndices)
+	{
+		boundsMin = glm::min(boundsMin, GetPosition(pPositions, positionStride, index));
+		boundsMax = glm::max(boundsMax, GetPosition(pPositions, positionStride, index));
+	}
+
+	page.center = (boundsMin + boundsMax) * 0.5f;
+	page.radius = 0.0f;
+	page.uiSourceGroup = g_uiNoPageGroup;
+	page.uiParentGroup = g_uiNoPageGroup;
+
+	for (uint32_t index : listIndices)
+	{
+		page.radius = glm::max(page.radius, glm::length(GetPosition(pPositions, positionStride, index) - page.center));
+	}
+}
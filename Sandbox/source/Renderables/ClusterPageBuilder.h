@@ -0,0 +1,73 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "Renderer/Utility.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+const uint32_t g_uiNoPageGroup = 0xFFFFFFFF;
+
+//---------------------------------------------------------------------------------------------------------------------
+// One cluster of a paged mesh & the unit that streams. Leaves hold the full detail mesh split into spatially coherent
+// pieces, every other page is a piece of a simplified group (see ClusterPageGroup). Sphere only holds the page itself!
+struct ClusterPage
+{
+	glm::vec3							center;
+	float								radius;
+	uint32_t							uiSourceGroup;				// group it was simplified in, none for leaves
+	uint32_t							uiParentGroup;				// group it's simplified in, none for roots
+
+	// Vertices in the format's layout with 16 bit indices right after them, quantized to the mesh's grid at the page's
+	// offset. Offsets are into the model's payload, index data offset is from the page's data offset!
+	uint32_t							uiVertexCount;
+	uint32_t							uiIndexCount;
+	Helper::QuantizationBounds			quantization;
+	uint64_t							uiDataOffset;
+	uint64_t							uiDataSize;
+	uint64_t							uiIndexDataOffset;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pages of one level simplified together with only the group's outer border locked, then split into the coarser pages
+// that have it as source. Group is refined, i.e. its input pages drawn instead of its outputs, all at once or not at
+// all, so the borders between groups always match! Sphere holds everything under the group & error only grows towards
+// the roots. Groups are stored finest first, every group comes before the groups its outputs are simplified in.
+struct ClusterPageGroup
+{
+	glm::vec3							center;
+	float								radius;
+	float								fError;						// model units its outputs may be off from the full mesh
+	uint32_t							uiFirstPage;				// inputs are contiguous
+	uint32_t							uiNumPages;
+	uint32_t							uiFirstParent;				// into the mesh's list of group parents
+	uint32_t							uiNumParents;				// groups its outputs are simplified in, none for the top ones
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cook side. Splits a triangle list into leaves along the longest axis of their triangle centers till each fits the
+// page limits (see Helper::g_uiClusterPageTriangles). Then level by level, pages are grouped with the neighbours they
+// share the longest borders with, each group is simplified to about half & split into pages again. Groups of a level
+// don't line up with the ones before, so borders locked at one level end up inside a group at the next & get simplified
+// too! Stops at a single page, or once no group shrinks any more: whatever is left are the roots.
+class ClusterPageBuilder
+{
+public:
+	// outListPageIndices holds each page's triangles, indices into the caller's vertices. Geometry & data fields of the
+	// pages are left for the caller, who packs the vertices!
+	static void							Build(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+												std::vector<ClusterPage>& outListPages, std::vector<ClusterPageGroup>& outListGroups,
+												std::vector<uint32_t>& outListGroupParents, std::vector<std::vector<uint32_t>>& outListPageIndices);
+
+	// Unique vertices in first use order & the indices rewritten to them. listStamps is scratch of vertexCount entries,
+	// any values, so repeated calls don't clear it!
+	static void							Localize(const std::vector<uint32_t>& listIndices, std::vector<uint32_t>& listStamps, std::vector<uint32_t>& outListVertices,
+												std::vector<uint32_t>& outListLocalIndices);
+
+private:
+	static void							Split(std::vector<uint32_t>& listTriangles, size_t begin, size_t end, const std::vector<glm::vec3>& listCenters,
+												const std::vector<uint32_t>& listIndices, std::vector<uint32_t>& listStamps, std::vector<std::vector<uint32_t>>& outListPageIndices);
+	static void							SplitIntoPages(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, std::vector<uint32_t>& listStamps,
+												std::vector<std::vector<uint32_t>>& outListPageIndices);
+	static void							GroupPages(const std::vector<uint32_t>& listLevel, const std::vector<std::vector<uint32_t>>& listPageIndices,
+												std::vector<std::vector<uint32_t>>& outListGroups);
+	static void							ComputePageBounds(ClusterPage& page, const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride);
+};
@@ -0,0 +1,313 @@
+#include "sandboxPCH.h"
+#include "CookedModel.h"
+#include "Renderer/CookedFormat.h"
+#include "Core/VirtualFileSystem.h"
+#include "Core/Core.h"
+
+namespace
+{
+	const uint64_t g_uiPayloadAlignment = 16;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void WriteMesh(std::ostream& stream, const CookedMesh& mesh)
+	{
+		Helper::WriteString(stream, mesh.strName);
+		Helper::WritePod(stream, mesh.uiHash);
+		Helper::WritePod(stream, mesh.uiPayloadHash);
+		Helper::WritePod(stream, mesh.eVertexFormat);
+		Helper::WritePod(stream, mesh.uiVertexCount);
+		Helper::WritePod(stream, mesh.uiIndexCount);
+		Helper::WritePod(stream, mesh.vecBoundsMin);
+		Helper::WritePod(stream, mesh.vecBoundsMax);
+		Helper::WritePod(stream, mesh.quantization);
+
+		Helper::WritePod(stream, static_cast<uint32_t>(mesh.listLods.size()));
+		for (const MeshLod& lod : mesh.listLods)
+		{
+			Helper::WritePod(stream, lod.firstIndex);
+			Helper::WritePod(stream, lod.indexCount);
+			Helper::WritePod(stream, lod.fError);
+			Helper::WriteVector(stream, lod.listMeshlets);
+		}
+
+		Helper::WritePod(stream, mesh.uiVertexDataOffset);
+		Helper::WritePod(stream, mesh.uiVertexDataSize);
+		Helper::WritePod(stream, mesh.uiIndexDataOffset);
+		Helper::WritePod(stream, mesh.uiIndexDataSize);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	bool ReadMesh(std::istream& stream, CookedMesh& mesh)
+	{
+		uint32_t numLods = 0;
+
+		bool bRead =	Helper::ReadString(stream, mesh.strName) &&
+						Helper::ReadPod(stream, mesh.uiHash) &&
+						Helper::ReadPod(stream, mesh.uiPayloadHash) &&
+						Helper::ReadPod(stream, mesh.eVertexFormat) &&
+						Helper::ReadPod(stream, mesh.uiVertexCount) &&
+						Helper::ReadPod(stream, mesh.uiIndexCount) &&
+						Helper::ReadPod(stream, mesh.vecBoundsMin) &&
+						Helper::ReadPod(stream, mesh.vecBoundsMax) &&
+						Helper::ReadPod(stream, mesh.quantization) &&
+						Helper::ReadPod(stream, numLods);
+
+		mesh.listLods.resize(bRead ? numLods : 0);
+		for (MeshLod& lod : mesh.listLods)
+		{
+			bRead = bRead &&	Helper::ReadPod(stream, lod.firstIndex) &&
+								Helper::ReadPod(stream, lod.indexCount) &&
+								Helper::ReadPod(stream, lod.fError) &&
+								Helper::ReadVector(stream, lod.listMeshlets);
+		}
+
+		return	bRead &&
+				Helper::ReadPod(stream, mesh.uiVertexDataOffset) &&
+				Helper::ReadPod(stream, mesh.uiVertexDataSize) &&
+				Helper::ReadPod(stream, mesh.uiIndexDataOffset) &&
+				Helper::ReadPod(stream, mesh.uiIndexDataSize);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void WritePagedMesh(std::ostream& stream, const CookedPagedMesh& mesh)
+	{
+		Helper::WriteString(stream, mesh.strName);
+		Helper::WritePod(stream, mesh.eVertexFormat);
+		Helper::WritePod(stream, mesh.vecBoundsMin);
+		Helper::WritePod(stream, mesh.vecBoundsMax);
+		Helper::WritePod(stream, mesh.uiNumTriangles);
+		Helper::WriteVector(stream, mesh.listPages);
+		Helper::WriteVector(stream, mesh.listGroups);
+		Helper::WriteVector(stream, mesh.listGroupParents);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	bool ReadPagedMesh(std::istream& stream, CookedPagedMesh& mesh)
+	{
+		return	Helper::ReadString(stream, mesh.strName) &&
+				Helper::ReadPod(stream, mesh.eVertexFormat) &&
+				Helper::ReadPod(stream, mesh.vecBoundsMin) &&
+				Helper::ReadPod(stream, mesh.vecBoundsMax) &&
+				Helper::ReadPod(stream, mesh.uiNumTriangles) &&
+				Helper::ReadVector(stream, mesh.listPages) &&
+				Helper::ReadVector(stream, mesh.listGroups) &&
+				Helper::ReadVector(stream, mesh.listGroupParents);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void WriteMaterial(std::ostream& stream, const CookedMaterial& material)
+	{
+		for (const std::string& texture : material.arrTextures)
+		{
+			Helper::WriteString(stream, texture);
+		}
+
+		Helper::WritePod(stream, material.hasTextureAEN);
+		Helper::WritePod(stream, material.hasTextureRMO);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	bool ReadMaterial(std::istream& stream, CookedMaterial& material)
+	{
+		for (std::string& texture : material.arrTextures)
+		{
+			if (!Helper::ReadString(stream, texture))
+				return false;
+		}
+
+		return Helper::ReadPod(stream, material.hasTextureAEN) && Helper::ReadPod(stream, material.hasTextureRMO);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+CookedModel::CookedModel()
+{
+	m_uiNumSourceMeshes = 0;
+	m_vecBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+	m_vecBoundsMax = glm::vec3(-std::numeric_limits<float>::max());
+	m_pFileSystem = nullptr;
+	m_uiPayloadOffset = 0;
+	m_uiPayloadSize = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+CookedModel::~CookedModel()
+{
+	m_ListMeshes.clear();
+	m_ListPagedMeshes.clear();
+	m_ListMaterials.clear();
+	m_ListPayload.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Tables are built in memory first, their size decides where the payload starts!
+bool CookedModel::Save(const std::string& filePath) const
+{
+	std::ostringstream tables(std::ios::binary);
+
+	Helper::WriteString(tables, m_strName);
+	Helper::WritePod(tables, m_uiNumSourceMeshes);
+	Helper::WritePod(tables, m_vecBoundsMin);
+	Helper::WritePod(tables, m_vecBoundsMax);
+
+	Helper::WritePod(tables, static_cast<uint32_t>(m_ListMeshes.size()));
+	for (const CookedMesh& mesh : m_ListMeshes)
+	{
+		WriteMesh(tables, mesh);
+	}
+
+	Helper::WritePod(tables, static_cast<uint32_t>(m_ListPagedMeshes.size()));
+	for (const CookedPagedMesh& mesh : m_ListPagedMeshes)
+	{
+		WritePagedMesh(tables, mesh);
+	}
+
+	Helper::WritePod(tables, static_cast<uint32_t>(m_ListMaterials.size()));
+	for (const CookedMaterial& material : m_ListMaterials)
+	{
+		WriteMaterial(tables, material);
+	}
+
+	const std::string strTables = tables.str();
+
+	Helper::CookedModelHeader header;
+	header.uiMagic = Helper::g_uiCookedModelMagic;
+	header.uiVersion = Helper::g_uiCookedVersion;
+	header.uiPayloadOffset = (sizeof(header) + strTables.size() + g_uiPayloadAlignment - 1) & ~(g_uiPayloadAlignment - 1);
+	header.uiPayloadSize = m_ListPayload.size();
+
+	return Helper::WriteFileAtomic(filePath, [&](std::ostream& stream)
+	{
+		const char padding[g_uiPayloadAlignment] = {};
+
+		Helper::WritePod(stream, header);
+		stream.write(strTables.data(), strTables.size());
+		stream.write(padding, header.uiPayloadOffset - sizeof(header) - strTables.size());
+		stream.write(reinterpret_cast<const char*>(m_ListPayload.data()), m_ListPayload.size());
+
+		return static_cast<bool>(stream);
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Header & tables come in with two reads, parsed from memory. Payload stays wherever the file system has it till
+// ReadPayload() asks for it!
+bool CookedModel::Load(const VirtualFileSystem* pFileSystem, const std::string& filePath)
+{
+	m_pFileSystem = pFileSystem;
+	m_strFilePath = filePath;
+
+	uint64_t fileSize = 0;
+	Helper::CookedModelHeader header;
+	if (!pFileSystem->GetFileSize(filePath, &fileSize) || fileSize < sizeof(header) || !pFileSystem->Read(filePath, 0, sizeof(header), &header))
+	{
+		LOG_ERROR("Failed to open cooked Model {0}, is the Cooker run?", filePath);
+		return false;
+	}
+
+	if (header.uiMagic != Helper::g_uiCookedModelMagic || header.uiVersion != Helper::g_uiCookedVersion ||
+		header.uiPayloadOffset < sizeof(header) || header.uiPayloadOffset + header.uiPayloadSize > fileSize)
+	{
+		LOG_ERROR("Cooked Model {0} is stale or corrupt, re-run the Cooker!", filePath);
+		return false;
+	}
+
+	m_uiPayloadOffset = header.uiPayloadOffset;
+	m_uiPayloadSize = header.uiPayloadSize;
+
+	std::string strTables(static_cast<size_t>(header.uiPayloadOffset - sizeof(header)), '\0');
+	if (!pFileSystem->Read(filePath, sizeof(header), strTables.size(), &strTables[0]))
+	{
+		LOG_ERROR("Cooked Model {0} is truncated, re-run the Cooker!", filePath);
+		return false;
+	}
+
+	std::istringstream stream(std::move(strTables));
+
+	uint32_t numMeshes = 0;
+	uint32_t numPagedMeshes = 0;
+	uint32_t numMaterials = 0;
+
+	bool bRead =	Helper::ReadString(stream, m_strName) &&
+					Helper::ReadPod(stream, m_uiNumSourceMeshes) &&
+					Helper::ReadPod(stream, m_vecBoundsMin) &&
+					Helper::ReadPod(stream, m_vecBoundsMax) &&
+					Helper::ReadPod(stream, numMeshes);
+
+	m_ListMeshes.resize(bRead ? numMeshes : 0);
+	for (CookedMesh& mesh : m_ListMeshes)
+	{
+		bRead = bRead && ReadMesh(stream, mesh);
+	}
+
+	bRead = bRead && Helper::ReadPod(stream, numPagedMeshes);
+
+	m_ListPagedMeshes.resize(bRead ? numPagedMeshes : 0);
+	for (CookedPagedMesh& mesh : m_ListPagedMeshes)
+	{
+		bRead = bRead && ReadPagedMesh(stream, mesh);
+	}
+
+	bRead = bRead && Helper::ReadPod(stream, numMaterials);
+
+	m_ListMaterials.resize(bRead ? numMaterials : 0);
+	for (CookedMaterial& material : m_ListMaterials)
+	{
+		bRead = bRead && ReadMaterial(stream, material);
+	}
+
+	if (!bRead)
+	{
+		LOG_ERROR("Cooked Model {0} is truncated, re-run the Cooker!", filePath);
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool CookedModel::ReadPayload(uint64_t offset, uint64_t size, void* pDst)
+{
+	if (!m_pFileSystem || offset + size > m_uiPayloadSize)
+		return false;
+
+	return m_pFileSystem->Read(m_strFilePath, m_uiPayloadOffset + offset, size, pDst);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Model must outlive the read, see VirtualFileSystem::ReadAsync()
+void CookedModel::ReadPayloadAsync(uint64_t offset, uint64_t size, void* pDst, ThreadPool* pCompletionWorkers, std::function<void(bool)> onComplete)
+{
+	if (!m_pFileSystem || offset + size > m_uiPayloadSize)
+	{
+		onComplete(false);
+		return;
+	}
+
+	m_pFileSystem->ReadAsync(m_strFilePath, m_uiPayloadOffset + offset, size, pDst, pCompletionWorkers, std::move(onComplete));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint8_t* CookedModel::ReservePayload(uint64_t size, uint64_t* pOutOffset)
+{
+	*pOutOffset = (m_ListPayload.size() + g_uiPayloadAlignment - 1) & ~(g_uiPayloadAlignment - 1);
+	m_ListPayload.resize(*pOutOffset + size);
+
+	return m_ListPayload.data() + *pOutOffset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Upper bound, meshes which turn out to be shared (see VulkanMeshCache) are counted too!
+uint64_t CookedModel::GetStagingSize() const
+{
+	uint64_t size = 0;
+
+	for (const CookedMesh& mesh : m_ListMeshes)
+	{
+		// Each reservation may need up to 16 bytes of alignment padding!
+		size += mesh.uiVertexDataSize + 16;
+		size += mesh.uiIndexDataSize + 16;
+	}
+
+	return size;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "Renderer/VertexLayout.h"
+#include "MeshOptimizer.h"
+#include "ClusterPageBuilder.h"
+
+class VirtualFileSystem;
+class ThreadPool;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Texture slots of a cooked material, each one always names a cooked texture: material's own one or its default!
+enum class CookedTextureSlot : uint32_t
+{
+	ALBEDO = 0,
+	EMISSIVE,
+	NORMAL,
+	ORM,						// Occlusion | Roughness | Metalness, packed by the cooker
+	COUNT
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct CookedMaterial
+{
+	CookedMaterial() : hasTextureAEN(glm::vec3(0)), hasTextureRMO(glm::vec3(0)) {}
+
+	std::array<std::string, static_cast<size_t>(CookedTextureSlot::COUNT)>	arrTextures;
+	glm::vec3																hasTextureAEN;		// Albedo | Emissive | Normal
+	glm::vec3																hasTextureRMO;		// Roughness | Metallic | Occlusion
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Mesh after the whole import pipeline. Vertices are already packed in the format's layout & fetch order, indices in
+// their final index type with every LOD after LOD 0. Offsets are into the model's payload!
+struct CookedMesh
+{
+	CookedMesh() :	uiHash(0), uiPayloadHash(0), eVertexFormat(Helper::EVertexFormat::POSITION_NORMAL_TANGENT_UV), uiVertexCount(0), uiIndexCount(0),
+					uiVertexDataOffset(0), uiVertexDataSize(0), uiIndexDataOffset(0), uiIndexDataSize(0) {}
+
+	std::string						strName;
+	uint64_t						uiHash;							// mesh cache key, see VulkanMeshCache
+	uint64_t						uiPayloadHash;					// over the packed vertices & indices, checked along with it
+	Helper::EVertexFormat			eVertexFormat;
+	uint32_t						uiVertexCount;
+	uint32_t						uiIndexCount;
+	glm::vec3						vecBoundsMin;
+	glm::vec3						vecBoundsMax;
+	Helper::QuantizationBounds		quantization;
+	std::vector<MeshLod>			listLods;
+
+	uint64_t						uiVertexDataOffset;
+	uint64_t						uiVertexDataSize;
+	uint64_t						uiIndexDataOffset;
+	uint64_t						uiIndexDataSize;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Mesh too big to be loaded whole, cut into cluster pages which stream in on their own (see VulkanPagedMesh). It has
+// no vertex & index arrays, every page's data is a range of the model's payload!
+struct CookedPagedMesh
+{
+	CookedPagedMesh() : eVertexFormat(Helper::EVertexFormat::POSITION_NORMAL_TANGENT_UV), uiNumTriangles(0) {}
+
+	std::string						strName;
+	Helper::EVertexFormat			eVertexFormat;
+	glm::vec3						vecBoundsMin;
+	glm::vec3						vecBoundsMax;
+	uint32_t						uiNumTriangles;					// full detail, leaves together
+	std::vector<ClusterPage>		listPages;						// sorted by parent group, roots last
+	std::vector<ClusterPageGroup>	listGroups;						// finest first
+	std::vector<uint32_t>			listGroupParents;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runtime ready model as written by the cooker. Load() only reads the tables, mesh data stays in the file (or pack, see
+// VirtualFileSystem) till the loader reads it straight into staging memory with ReadPayload()!
+class CookedModel
+{
+public:
+	CookedModel();
+	~CookedModel();
+
+	bool								Save(const std::string& filePath) const;
+	bool								Load(const VirtualFileSystem* pFileSystem, const std::string& filePath);
+	bool								ReadPayload(uint64_t offset, uint64_t size, void* pDst);
+	void								ReadPayloadAsync(uint64_t offset, uint64_t size, void* pDst, ThreadPool* pCompletionWorkers, std::function<void(bool)> onComplete);
+
+	// Cook side, payload grows by size (16 byte aligned). Pointer is only good till the next call!
+	uint8_t*							ReservePayload(uint64_t size, uint64_t* pOutOffset);
+
+	// Enough for every mesh's vertices & indices including each reservation's alignment padding. Paged meshes don't
+	// count, their pages are read later
+	uint64_t							GetStagingSize() const;
+
+	// Where the payload is, for paged meshes reading their pages once the model itself is gone
+	inline const std::string&			GetFilePath() const			{ return m_strFilePath; }
+	inline uint64_t						GetPayloadOffset() const	{ return m_uiPayloadOffset; }
+	inline uint64_t						GetPayloadSize() const		{ return m_uiPayloadSize; }
+
+public:
+	std::string							m_strName;
+	uint32_t							m_uiNumSourceMeshes;			// node mesh references before merging
+	glm::vec3							m_vecBoundsMin;
+	glm::vec3							m_vecBoundsMax;
+
+	std::vector<CookedMesh>				m_ListMeshes;
+	std::vector<CookedPagedMesh>		m_ListPagedMeshes;
+	std::vector<CookedMaterial>			m_ListMaterials;
+	std::vector<uint8_t>				m_ListPayload;					// cook side only
+
+private:
+	const VirtualFileSystem*			m_pFileSystem;
+	std::string							m_strFilePath;
+	uint64_t							m_uiPayloadOffset;
+	uint64_t							m_uiPayloadSize;
+};
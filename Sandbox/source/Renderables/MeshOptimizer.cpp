@@ -0,0 +1,745 @@
+#include "sandboxPCH.h"
+#include "MeshOptimizer.h"
+#include "glm/glm.hpp"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Forsyth's scoring, see "Linear-Speed Vertex Cache Optimisation". Cache here is only for scoring, it's bigger than
+// what hardware has on purpose!
+namespace
+{
+	const uint32_t	kScoringCacheSize = 32;
+	const float		kCacheDecayPower = 1.5f;
+	const float		kLastTriangleScore = 0.75f;
+	const float		kValenceBoostScale = 2.0f;
+	const float		kValenceBoostPower = 0.5f;
+
+	float ScoreVertex(int32_t cachePosition, uint32_t remainingTriangles)
+	{
+		// No triangles left to use it, never pick it again!
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// Used by the last triangle, same score for all three so winding doesn't matter
+			if (cachePosition < 3)
+				score = kLastTriangleScore;
+			else
+				score = std::pow(1.0f - (cachePosition - 3) / static_cast<float>(kScoringCacheSize - 3), kCacheDecayPower);
+		}
+
+		// Low valence vertices get a boost so lone triangles don't get left behind
+		score += kValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+
+		return score;
+	}
+
+	//--- Symmetric 4x4 of summed plane equations, evaluates to the sum of squared distances to those planes
+	struct Quadric
+	{
+		float	a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+	};
+
+	void AddPlane(Quadric& q, const glm::vec3& n, float d)
+	{
+		q.a2 += n.x * n.x;	q.b2 += n.y * n.y;	q.c2 += n.z * n.z;	q.d2 += d * d;
+		q.ab += n.x * n.y;	q.ac += n.x * n.z;	q.ad += n.x * d;
+		q.bc += n.y * n.z;	q.bd += n.y * d;	q.cd += n.z * d;
+	}
+
+	Quadric AddQuadrics(const Quadric& q, const Quadric& r)
+	{
+		return {	q.a2 + r.a2, q.b2 + r.b2, q.c2 + r.c2, q.d2 + r.d2, q.ab + r.ab,
+					q.ac + r.ac, q.ad + r.ad, q.bc + r.bc, q.bd + r.bd, q.cd + r.cd };
+	}
+
+	float EvaluateQuadric(const Quadric& q, const glm::vec3& p)
+	{
+		float result =	q.a2 * p.x * p.x + q.b2 * p.y * p.y + q.c2 * p.z * p.z +
+						2.0f * (q.ab * p.x * p.y + q.ac * p.x * p.z + q.bc * p.y * p.z) +
+						2.0f * (q.ad * p.x + q.bd * p.y + q.cd * p.z) + q.d2;
+
+		// Rounding can take it slightly below zero
+		return result > 0.0f ? result : 0.0f;
+	}
+
+	struct Collapse
+	{
+		uint32_t	from;
+		uint32_t	to;
+		float		cost;
+	};
+
+	glm::vec3 GetPosition(const float* pPositions, size_t positionStride, uint32_t index)
+	{
+		const float* pPosition = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pPositions) + index * positionStride);
+		return glm::vec3(pPosition[0], pPosition[1], pPosition[2]);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& listIndices, uint32_t vertexCount)
+{
+	const size_t numTriangles = listIndices.size() / 3;
+	if (numTriangles == 0)
+		return;
+
+	// Vertex --> triangle adjacency, triangles not emitted yet are kept at the front of each vertex's range!
+	std::vector<uint32_t> listAdjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t index : listIndices)
+		listAdjacencyOffsets[index + 1]++;
+
+	for (uint32_t v = 0; v < vertexCount; v++)
+		listAdjacencyOffsets[v + 1] += listAdjacencyOffsets[v];
+
+	std::vector<uint32_t> listRemaining(vertexCount, 0);
+	std::vector<uint32_t> listAdjacency(listIndices.size());
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			const uint32_t v = listIndices[t * 3 + k];
+			listAdjacency[listAdjacencyOffsets[v] + listRemaining[v]++] = static_cast<uint32_t>(t);
+		}
+	}
+
+	std::vector<int32_t> listCachePosition(vertexCount, -1);
+	std::vector<float> listVertexScore(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+		listVertexScore[v] = ScoreVertex(-1, listRemaining[v]);
+
+	int64_t bestTriangle = -1;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		const float score = listVertexScore[listIndices[t * 3]] + listVertexScore[listIndices[t * 3 + 1]] + listVertexScore[listIndices[t * 3 + 2]];
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestTriangle = static_cast<int64_t>(t);
+		}
+	}
+
+	std::vector<bool> listEmitted(numTriangles, false);
+	std::vector<uint32_t> listResult;
+	listResult.reserve(listIndices.size());
+
+	std::vector<uint32_t> listCache, listNewCache;
+	listCache.reserve(kScoringCacheSize + 3);
+	listNewCache.reserve(kScoringCacheSize + 3);
+
+	size_t cursor = 0;
+	for (size_t emitted = 0; emitted < numTriangles; emitted++)
+	{
+		if (bestTriangle < 0)
+		{
+			// Nothing in cache has triangles left, carry on with the next one in input order
+			while (listEmitted[cursor])
+				cursor++;
+
+			bestTriangle = static_cast<int64_t>(cursor);
+		}
+
+		listEmitted[bestTriangle] = true;
+		listNewCache.clear();
+
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			const uint32_t v = listIndices[bestTriangle * 3 + k];
+			listResult.push_back(v);
+
+			// Swap emitted triangle out of the vertex's live range
+			uint32_t* pAdjacency = &listAdjacency[listAdjacencyOffsets[v]];
+			for (uint32_t a = 0; a < listRemaining[v]; a++)
+			{
+				if (pAdjacency[a] == static_cast<uint32_t>(bestTriangle))
+				{
+					std::swap(pAdjacency[a], pAdjacency[listRemaining[v] - 1]);
+					listRemaining[v]--;
+					break;
+				}
+			}
+
+			if (std::find(listNewCache.begin(), listNewCache.end(), v) == listNewCache.end())
+				listNewCache.push_back(v);
+		}
+
+		// Triangle's vertices go to the front, rest of the cache shifts back & the tail falls out
+		for (uint32_t v : listCache)
+		{
+			if (std::find(listNewCache.begin(), listNewCache.end(), v) == listNewCache.end())
+				listNewCache.push_back(v);
+		}
+
+		for (size_t c = 0; c < listNewCache.size(); c++)
+		{
+			const uint32_t v = listNewCache[c];
+			listCachePosition[v] = c < kScoringCacheSize ? static_cast<int32_t>(c) : -1;
+			listVertexScore[v] = ScoreVertex(listCachePosition[v], listRemaining[v]);
+		}
+
+		// Only triangles touching the cache are candidates for the next one
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for (size_t c = 0; c < listNewCache.size() && c < kScoringCacheSize; c++)
+		{
+			const uint32_t v = listNewCache[c];
+			const uint32_t* pAdjacency = &listAdjacency[listAdjacencyOffsets[v]];
+			for (uint32_t a = 0; a < listRemaining[v]; a++)
+			{
+				const uint32_t t = pAdjacency[a];
+				const float score = listVertexScore[listIndices[t * 3]] + listVertexScore[listIndices[t * 3 + 1]] + listVertexScore[listIndices[t * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+
+		if (listNewCache.size() > kScoringCacheSize)
+			listNewCache.resize(kScoringCacheSize);
+
+		std::swap(listCache, listNewCache);
+	}
+
+	listIndices.swap(listResult);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cache optimized order is split into clusters, first where the optimizer jumped to a new area (all three vertices
+// missed) & then further wherever the cluster's ACMR so far is already within threshold of the whole cluster. Clusters
+// are sorted so the ones facing away from the mesh center go first, they tend to occlude the rest.
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+										float fThreshold)
+{
+	const size_t numTriangles = listIndices.size() / 3;
+	if (numTriangles < 2)
+		return;
+
+	const uint32_t cacheSize = 16;
+	std::vector<uint32_t> listTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+
+	std::vector<size_t> listHardBoundaries;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		if (CountClusterMisses(&listIndices[t * 3], 1, listTimestamps, timestamp, cacheSize) == 3 || t == 0)
+			listHardBoundaries.push_back(t);
+	}
+
+	std::vector<size_t> listClusters;
+	for (size_t c = 0; c < listHardBoundaries.size(); c++)
+	{
+		const size_t start = listHardBoundaries[c];
+		const size_t end = c + 1 < listHardBoundaries.size() ? listHardBoundaries[c + 1] : numTriangles;
+
+		timestamp += cacheSize + 1;
+		const uint32_t clusterMisses = CountClusterMisses(&listIndices[start * 3], end - start, listTimestamps, timestamp, cacheSize);
+		const float clusterACMR = clusterMisses / static_cast<float>(end - start);
+
+		timestamp += cacheSize + 1;
+		listClusters.push_back(start);
+
+		size_t segmentStart = start;
+		uint32_t segmentMisses = 0;
+		for (size_t t = start; t < end; t++)
+		{
+			segmentMisses += CountClusterMisses(&listIndices[t * 3], 1, listTimestamps, timestamp, cacheSize);
+
+			if (t + 1 < end && segmentMisses / static_cast<float>(t + 1 - segmentStart) <= clusterACMR * fThreshold)
+			{
+				segmentStart = t + 1;
+				segmentMisses = 0;
+				timestamp += cacheSize + 1;
+				listClusters.push_back(segmentStart);
+			}
+		}
+	}
+
+	if (listClusters.size() < 2)
+		return;
+
+	// Mesh center from referenced vertices
+	glm::vec3 meshCenter(0.0f);
+	for (uint32_t index : listIndices)
+		meshCenter += GetPosition(pPositions, positionStride, index);
+
+	meshCenter /= static_cast<float>(listIndices.size());
+
+	std::vector<float> listSortKeys(listClusters.size());
+	for (size_t c = 0; c < listClusters.size(); c++)
+	{
+		const size_t start = listClusters[c];
+		const size_t end = c + 1 < listClusters.size() ? listClusters[c + 1] : numTriangles;
+
+		// Area weighted centroid & normal
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (size_t t = start; t < end; t++)
+		{
+			const glm::vec3 p0 = GetPosition(pPositions, positionStride, listIndices[t * 3]);
+			const glm::vec3 p1 = GetPosition(pPositions, positionStride, listIndices[t * 3 + 1]);
+			const glm::vec3 p2 = GetPosition(pPositions, positionStride, listIndices[t * 3 + 2]);
+
+			const glm::vec3 crossProduct = glm::cross(p1 - p0, p2 - p0);
+			const float triangleArea = glm::length(crossProduct);
+
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += crossProduct;
+			area += triangleArea;
+		}
+
+		const float normalLength = glm::length(normal);
+		centroid = area > 0.0f ? centroid / area : meshCenter;
+		normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+
+		listSortKeys[c] = glm::dot(centroid - meshCenter, normal);
+	}
+
+	std::vector<uint32_t> listOrder(listClusters.size());
+	for (uint32_t c = 0; c < static_cast<uint32_t>(listOrder.size()); c++)
+		listOrder[c] = c;
+
+	std::stable_sort(listOrder.begin(), listOrder.end(), [&](uint32_t a, uint32_t b) { return listSortKeys[a] > listSortKeys[b]; });
+
+	std::vector<uint32_t> listResult;
+	listResult.reserve(listIndices.size());
+
+	for (uint32_t c : listOrder)
+	{
+		const size_t start = listClusters[c];
+		const size_t end = c + 1 < listClusters.size() ? listClusters[c + 1] : numTriangles;
+
+		listResult.insert(listResult.end(), listIndices.begin() + start * 3, listIndices.begin() + end * 3);
+	}
+
+	listIndices.swap(listResult);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Greedy scan in index buffer order, new meshlet starts whenever the next triangle would break either limit. Input is
+// already cache & overdraw ordered, so consecutive triangles are close to each other anyway!
+std::vector<Meshlet> MeshOptimizer::BuildMeshlets(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+													uint32_t maxVertices, uint32_t maxTriangles)
+{
+	std::vector<Meshlet> listMeshlets;
+
+	const size_t numTriangles = listIndices.size() / 3;
+	if (numTriangles == 0)
+		return listMeshlets;
+
+	// Id of the meshlet each vertex was last counted for
+	std::vector<uint32_t> listVertexMeshlet(vertexCount, std::numeric_limits<uint32_t>::max());
+	uint32_t meshletId = 0;
+	uint32_t meshletVertices = 0;
+	uint32_t meshletTriangles = 0;
+	size_t meshletStart = 0;
+
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		const uint32_t a = listIndices[t * 3];
+		const uint32_t b = listIndices[t * 3 + 1];
+		const uint32_t c = listIndices[t * 3 + 2];
+
+		auto countNewVertices = [&]()
+		{
+			return	(listVertexMeshlet[a] != meshletId ? 1u : 0u) +
+					(listVertexMeshlet[b] != meshletId && b != a ? 1u : 0u) +
+					(listVertexMeshlet[c] != meshletId && c != a && c != b ? 1u : 0u);
+		};
+
+		uint32_t newVertices = countNewVertices();
+		if (meshletTriangles > 0 && (meshletVertices + newVertices > maxVertices || meshletTriangles + 1 > maxTriangles))
+		{
+			listMeshlets.push_back(ComputeMeshletBounds(listIndices, meshletStart, t, pPositions, positionStride));
+
+			meshletId++;
+			meshletVertices = 0;
+			meshletTriangles = 0;
+			meshletStart = t;
+			newVertices = countNewVertices();
+		}
+
+		listVertexMeshlet[a] = listVertexMeshlet[b] = listVertexMeshlet[c] = meshletId;
+		meshletVertices += newVertices;
+		meshletTriangles++;
+	}
+
+	listMeshlets.push_back(ComputeMeshletBounds(listIndices, meshletStart, numTriangles, pPositions, positionStride));
+
+	return listMeshlets;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Each pass collects every edge collapse, cheapest first, & applies as many as it can without two of them touching
+// the same triangles. Collapses that would flip a triangle are skipped. Vertices sharing a position with another one
+// (uv or normal seams) & vertices on open or non-manifold edges never move, so seams & borders don't crack!
+std::vector<uint32_t> MeshOptimizer::Simplify(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+												size_t targetIndexCount, float* pOutError)
+{
+	std::vector<uint32_t> listResult = listIndices;
+	*pOutError = 0.0f;
+
+	if (listResult.size() <= targetIndexCount)
+		return listResult;
+
+	// Group vertices by position, first vertex of each group is its id
+	std::vector<uint32_t> listSorted(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+		listSorted[v] = v;
+
+	std::sort(listSorted.begin(), listSorted.end(), [&](uint32_t a, uint32_t b)
+	{
+		const glm::vec3 pa = GetPosition(pPositions, positionStride, a);
+		const glm::vec3 pb = GetPosition(pPositions, positionStride, b);
+		return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z);
+	});
+
+	std::vector<uint32_t> listPositionId(vertexCount);
+	std::vector<bool> listLocked(vertexCount, false);
+
+	for (size_t i = 0; i < listSorted.size();)
+	{
+		const glm::vec3 position = GetPosition(pPositions, positionStride, listSorted[i]);
+
+		size_t end = i + 1;
+		while (end < listSorted.size() && GetPosition(pPositions, positionStride, listSorted[end]) == position)
+			end++;
+
+		for (size_t j = i; j < end; j++)
+		{
+			listPositionId[listSorted[j]] = listSorted[i];
+			listLocked[listSorted[j]] = end - i > 1;
+		}
+
+		i = end;
+	}
+
+	// Edges not shared by exactly two triangles are open or non-manifold
+	std::vector<uint64_t> listEdges;
+	listEdges.reserve(listResult.size());
+
+	for (size_t i = 0; i < listResult.size(); i += 3)
+	{
+		for (uint32_t e = 0; e < 3; e++)
+		{
+			const uint32_t a = listPositionId[listResult[i + e]];
+			const uint32_t b = listPositionId[listResult[i + (e + 1) % 3]];
+
+			if (a != b)
+				listEdges.push_back((static_cast<uint64_t>(glm::min(a, b)) << 32) | glm::max(a, b));
+		}
+	}
+
+	std::sort(listEdges.begin(), listEdges.end());
+
+	std::vector<bool> listLockedPosition(vertexCount, false);
+	for (size_t i = 0; i < listEdges.size();)
+	{
+		size_t end = i + 1;
+		while (end < listEdges.size() && listEdges[end] == listEdges[i])
+			end++;
+
+		if (end - i != 2)
+		{
+			listLockedPosition[static_cast<uint32_t>(listEdges[i] >> 32)] = true;
+			listLockedPosition[static_cast<uint32_t>(listEdges[i] & 0xFFFFFFFF)] = true;
+		}
+
+		i = end;
+	}
+
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		if (listLockedPosition[listPositionId[v]])
+			listLocked[v] = true;
+	}
+
+	std::vector<Quadric> listQuadrics(vertexCount, Quadric{});
+	for (size_t i = 0; i < listResult.size(); i += 3)
+	{
+		const glm::vec3 p0 = GetPosition(pPositions, positionStride, listResult[i]);
+		const glm::vec3 p1 = GetPosition(pPositions, positionStride, listResult[i + 1]);
+		const glm::vec3 p2 = GetPosition(pPositions, positionStride, listResult[i + 2]);
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const float normalLength = glm::length(normal);
+		if (normalLength <= 0.0f)
+			continue;
+
+		normal /= normalLength;
+		for (uint32_t k = 0; k < 3; k++)
+			AddPlane(listQuadrics[listResult[i + k]], normal, -glm::dot(normal, p0));
+	}
+
+	float maxError = 0.0f;
+	std::vector<uint32_t> listAdjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> listAdjacency;
+	std::vector<Collapse> listCollapses;
+	std::vector<uint32_t> listRemap(vertexCount);
+	std::vector<bool> listTouched(vertexCount);
+
+	while (listResult.size() > targetIndexCount)
+	{
+		// Vertex --> triangle adjacency of what's left
+		std::fill(listAdjacencyOffsets.begin(), listAdjacencyOffsets.end(), 0);
+		for (uint32_t index : listResult)
+			listAdjacencyOffsets[index + 1]++;
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+			listAdjacencyOffsets[v + 1] += listAdjacencyOffsets[v];
+
+		listAdjacency.resize(listResult.size());
+		std::vector<uint32_t> listFill(listAdjacencyOffsets.begin(), listAdjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < listResult.size(); i++)
+			listAdjacency[listFill[listResult[i]]++] = static_cast<uint32_t>(i / 3);
+
+		listCollapses.clear();
+		for (size_t i = 0; i < listResult.size(); i += 3)
+		{
+			for (uint32_t e = 0; e < 3; e++)
+			{
+				const uint32_t a = listResult[i + e];
+				const uint32_t b = listResult[i + (e + 1) % 3];
+
+				if (!listLocked[a])
+					listCollapses.push_back({ a, b, EvaluateQuadric(AddQuadrics(listQuadrics[a], listQuadrics[b]), GetPosition(pPositions, positionStride, b)) });
+
+				if (!listLocked[b])
+					listCollapses.push_back({ b, a, EvaluateQuadric(AddQuadrics(listQuadrics[b], listQuadrics[a]), GetPosition(pPositions, positionStride, a)) });
+			}
+		}
+
+		std::sort(listCollapses.begin(), listCollapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+			listRemap[v] = v;
+
+		std::fill(listTouched.begin(), listTouched.end(), false);
+
+		// Interior collapse removes two triangles
+		const size_t trianglesToRemove = (listResult.size() - targetIndexCount) / 3;
+		size_t trianglesRemoved = 0;
+
+		for (const Collapse& collapse : listCollapses)
+		{
+			if (trianglesRemoved >= trianglesToRemove)
+				break;
+
+			if (listTouched[collapse.from] || listTouched[collapse.to])
+				continue;
+
+			// Triangles around 'from' that stay must keep facing the same way
+			const glm::vec3 target = GetPosition(pPositions, positionStride, collapse.to);
+			bool bFlips = false;
+
+			for (uint32_t a = listAdjacencyOffsets[collapse.from]; a < listAdjacencyOffsets[collapse.from + 1] && !bFlips; a++)
+			{
+				const uint32_t* pTriangle = &listResult[listAdjacency[a] * 3];
+				if (pTriangle[0] == collapse.to || pTriangle[1] == collapse.to || pTriangle[2] == collapse.to)
+					continue;
+
+				glm::vec3 p[3], q[3];
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					p[k] = GetPosition(pPositions, positionStride, pTriangle[k]);
+					q[k] = pTriangle[k] == collapse.from ? target : p[k];
+				}
+
+				bFlips = glm::dot(glm::cross(p[1] - p[0], p[2] - p[0]), glm::cross(q[1] - q[0], q[2] - q[0])) <= 0.0f;
+			}
+
+			if (bFlips)
+				continue;
+
+			// Everything around 'from' is off limits for the rest of the pass, flip checks would be stale otherwise
+			for (uint32_t a = listAdjacencyOffsets[collapse.from]; a < listAdjacencyOffsets[collapse.from + 1]; a++)
+			{
+				const uint32_t* pTriangle = &listResult[listAdjacency[a] * 3];
+				listTouched[pTriangle[0]] = listTouched[pTriangle[1]] = listTouched[pTriangle[2]] = true;
+			}
+
+			listRemap[collapse.from] = collapse.to;
+			listQuadrics[collapse.to] = AddQuadrics(listQuadrics[collapse.to], listQuadrics[collapse.from]);
+			maxError = glm::max(maxError, collapse.cost);
+			trianglesRemoved += 2;
+		}
+
+		if (trianglesRemoved == 0)
+			break;
+
+		// Apply remap & drop triangles that collapsed
+		size_t write = 0;
+		for (size_t i = 0; i < listResult.size(); i += 3)
+		{
+			const uint32_t a = listRemap[listResult[i]];
+			const uint32_t b = listRemap[listResult[i + 1]];
+			const uint32_t c = listRemap[listResult[i + 2]];
+
+			if (a != b && b != c && a != c)
+			{
+				listResult[write++] = a;
+				listResult[write++] = b;
+				listResult[write++] = c;
+			}
+		}
+
+		listResult.resize(write);
+	}
+
+	*pOutError = glm::sqrt(maxError);
+
+	return listResult;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& listIndices, uint32_t vertexCount)
+{
+	const uint32_t kUnused = std::numeric_limits<uint32_t>::max();
+
+	std::vector<uint32_t> listRemap(vertexCount, kUnused);		// old --> new
+	std::vector<uint32_t> listVertexOrder;						// new --> old
+	listVertexOrder.reserve(vertexCount);
+
+	for (uint32_t& index : listIndices)
+	{
+		if (listRemap[index] == kUnused)
+		{
+			listRemap[index] = static_cast<uint32_t>(listVertexOrder.size());
+			listVertexOrder.push_back(index);
+		}
+
+		index = listRemap[index];
+	}
+
+	// Vertex count stays the same, anything never referenced just goes last
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		if (listRemap[v] == kUnused)
+		{
+			listRemap[v] = static_cast<uint32_t>(listVertexOrder.size());
+			listVertexOrder.push_back(v);
+		}
+	}
+
+	return listVertexOrder;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& listIndices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats = { 0.0f, 0.0f };
+
+	const size_t numTriangles = listIndices.size() / 3;
+	if (numTriangles == 0)
+		return stats;
+
+	std::vector<uint32_t> listTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+
+	const uint32_t misses = CountClusterMisses(listIndices.data(), numTriangles, listTimestamps, timestamp, cacheSize);
+
+	std::vector<bool> listReferenced(vertexCount, false);
+	uint32_t numReferenced = 0;
+	for (uint32_t index : listIndices)
+	{
+		if (!listReferenced[index])
+		{
+			listReferenced[index] = true;
+			numReferenced++;
+		}
+	}
+
+	stats.fACMR = misses / static_cast<float>(numTriangles);
+	stats.fATVR = misses / static_cast<float>(numReferenced);
+
+	return stats;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// FIFO cache simulation, a vertex is cached while fewer than cacheSize misses happened after its own. Bumping timestamp
+// by cacheSize + 1 between calls starts from a cold cache!
+uint32_t MeshOptimizer::CountClusterMisses(const uint32_t* pIndices, size_t numTriangles, std::vector<uint32_t>& listTimestamps, uint32_t& timestamp,
+											uint32_t cacheSize)
+{
+	uint32_t misses = 0;
+	for (size_t i = 0; i < numTriangles * 3; i++)
+	{
+		const uint32_t v = pIndices[i];
+		if (timestamp - listTimestamps[v] > cacheSize)
+		{
+			listTimestamps[v] = timestamp++;
+			misses++;
+		}
+	}
+
+	return misses;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Sphere around the AABB center, cone axis is the average triangle normal & cutoff comes from the widest one. See
+// Meshlet for how the cone is tested.
+Meshlet MeshOptimizer::ComputeMeshletBounds(const std::vector<uint32_t>& listIndices, size_t firstTriangle, size_t endTriangle, const float* pPositions,
+											size_t positionStride)
+{
+	Meshlet meshlet;
+	meshlet.firstIndex = static_cast<uint32_t>(firstTriangle * 3);
+	meshlet.indexCount = static_cast<uint32_t>((endTriangle - firstTriangle) * 3);
+
+	glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+	{
+		const glm::vec3 position = GetPosition(pPositions, positionStride, listIndices[i]);
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+
+	meshlet.center = (boundsMin + boundsMax) * 0.5f;
+	meshlet.radius = 0.0f;
+
+	glm::vec3 normalSum(0.0f);
+	std::vector<glm::vec3> listNormals;
+	listNormals.reserve(endTriangle - firstTriangle);
+
+	for (size_t t = firstTriangle; t < endTriangle; t++)
+	{
+		const glm::vec3 p0 = GetPosition(pPositions, positionStride, listIndices[t * 3]);
+		const glm::vec3 p1 = GetPosition(pPositions, positionStride, listIndices[t * 3 + 1]);
+		const glm::vec3 p2 = GetPosition(pPositions, positionStride, listIndices[t * 3 + 2]);
+
+		meshlet.radius = glm::max(meshlet.radius, glm::max(glm::length(p0 - meshlet.center), glm::max(glm::length(p1 - meshlet.center), glm::length(p2 - meshlet.center))));
+
+		const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const float normalLength = glm::length(normal);
+
+		// Degenerate triangles can face any way, they don't restrict the cone
+		if (normalLength > 0.0f)
+		{
+			listNormals.push_back(normal / normalLength);
+			normalSum += listNormals.back();
+		}
+	}
+
+	const float axisLength = glm::length(normalSum);
+	meshlet.coneAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+	meshlet.coneCutoff = 1.0f;
+
+	if (axisLength > 0.0f)
+	{
+		float minDot = 1.0f;
+		for (const glm::vec3& normal : listNormals)
+			minDot = glm::min(minDot, glm::dot(normal, meshlet.coneAxis));
+
+		// Normals spread close to a hemisphere or more, culling would hardly ever hit
+		if (minDot > 0.1f)
+			meshlet.coneCutoff = glm::sqrt(1.0f - minDot * minDot);
+	}
+
+	return meshlet;
+}
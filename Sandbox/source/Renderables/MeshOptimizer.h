@@ -0,0 +1,73 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Post transform cache numbers of an index buffer. ACMR is cache misses per triangle (0.5 best, 3 worst), ATVR is
+// cache misses per referenced vertex (1.0 means every vertex is transformed once)!
+struct VertexCacheStats
+{
+	float								fACMR;
+	float								fATVR;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Small contiguous run of triangles in the mesh's index buffer with model space bounds. Whole cluster faces away from
+// the camera when dot(center - camera, coneAxis) >= coneCutoff * length(center - camera) + radius. Cutoff of 1 never
+// culls, used when normals are spread too wide!
+struct Meshlet
+{
+	uint32_t							firstIndex;
+	uint32_t							indexCount;
+	glm::vec3							center;
+	float								radius;
+	glm::vec3							coneAxis;
+	float								coneCutoff;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// One level of detail, own index range in the mesh's index buffer over the shared vertices. Error is how far (model
+// units) its surface may be off from LOD 0!
+struct MeshLod
+{
+	uint32_t							firstIndex;
+	uint32_t							indexCount;
+	float								fError;
+	std::vector<Meshlet>				listMeshlets;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Import time index & vertex reordering. Passes are meant to run in this order:
+//	1. OptimizeVertexCache	- triangle order for post transform cache hits (Forsyth, linear speed)
+//	2. OptimizeOverdraw		- reorders clusters of (1) so outward facing ones come first, keeps ACMR within threshold
+//	3. BuildMeshlets		- splits final triangle order into meshlets, they're ranges so vertex fetch doesn't move them
+//	4. OptimizeVertexFetch	- vertex order by first use in the index buffer, caller reorders its vertices to match
+// Simplify builds LOD index lists on the same vertices, they're cache optimized & split into meshlets like above before
+// vertex fetch runs over all LODs together.
+// All of them work on triangle lists & expect every index to be less than vertexCount.
+class MeshOptimizer
+{
+public:
+	static void							OptimizeVertexCache(std::vector<uint32_t>& listIndices, uint32_t vertexCount);
+	static void							OptimizeOverdraw(std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+														float fThreshold = 1.05f);
+
+	static std::vector<Meshlet>			BuildMeshlets(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+														uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+	// Quadric edge collapse onto existing vertices. Seams & open borders stay locked, pOutError is the largest distance
+	// (model units) any surface moved by. Stops early when nothing is left to collapse!
+	static std::vector<uint32_t>		Simplify(const std::vector<uint32_t>& listIndices, const float* pPositions, size_t positionStride, uint32_t vertexCount,
+													size_t targetIndexCount, float* pOutError);
+
+	// Rewrites indices & returns new --> old vertex order, unreferenced vertices are kept at the end!
+	static std::vector<uint32_t>		OptimizeVertexFetch(std::vector<uint32_t>& listIndices, uint32_t vertexCount);
+
+	static VertexCacheStats				AnalyzeVertexCache(const std::vector<uint32_t>& listIndices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+private:
+	static Meshlet						ComputeMeshletBounds(const std::vector<uint32_t>& listIndices, size_t firstTriangle, size_t endTriangle, const float* pPositions,
+														size_t positionStride);
+	static uint32_t						CountClusterMisses(const uint32_t* pIndices, size_t numTriangles, std::vector<uint32_t>& listTimestamps, uint32_t& timestamp,
+														uint32_t cacheSize);
+};
@@ -0,0 +1,739 @@
+#include "sandboxPCH.h"
+#include "MeshProcessor.h"
+#include "Renderer/Utility.h"
+#include "Core/ThreadPool.h"
+#include "Core/Core.h"
+
+#include <immintrin.h>
+#include <unordered_set>
+
+namespace
+{
+	// Below this many elements a pass isn't worth the queue round trip & runs on the caller
+	const uint32_t g_uiMinBatchSize = 8192;
+
+	const uint32_t g_uiWeldShardBits = 6;
+	const uint32_t g_uiWeldShardCount = 1u << g_uiWeldShardBits;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Splits [0, count) into batches over workers & waits for them. Not reentrant, jobs must not call it themselves!
+	void ParallelFor(ThreadPool* pWorkers, uint32_t count, uint32_t minBatch, const std::function<void(uint32_t, uint32_t)>& func)
+	{
+		if (count == 0)
+			return;
+
+		if (pWorkers == nullptr || count <= minBatch)
+		{
+			func(0, count);
+			return;
+		}
+
+		const uint32_t numBatches = std::min((count + minBatch - 1) / minBatch, pWorkers->GetNumThreads() * 4);
+		const uint32_t batchSize = (count + numBatches - 1) / numBatches;
+
+		for (uint32_t first = 0; first < count; first += batchSize)
+		{
+			const uint32_t end = std::min(first + batchSize, count);
+			pWorkers->Enqueue([&func, first, end]() { func(first, end); });
+		}
+
+		pWorkers->WaitIdle();
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// -0 & +0 compare equal, so they must hash & weld the same too!
+	inline uint32_t FloatBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		return bits == 0x80000000u ? 0u : bits;
+	}
+
+	inline uint64_t MixHash(uint64_t hash, uint32_t value)
+	{
+		hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+
+	// Final avalanche, shards are picked from the top bits
+	inline uint64_t FinalizeHash(uint64_t hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ull;
+		hash ^= hash >> 33;
+
+		return hash;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// One corner of 4 consecutive triangles, pIndices points at first triangle's corner
+	inline __m128 Gather(const std::vector<float>& stream, const uint32_t* pIndices)
+	{
+		return _mm_setr_ps(stream[pIndices[0]], stream[pIndices[3]], stream[pIndices[6]], stream[pIndices[9]]);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Per vertex data Assimp keeps besides position, normal & first UV set, must match for vertices to weld
+	struct ExtraChannel
+	{
+		const uint8_t*	pData;
+		uint32_t		uiStride;
+	};
+
+	std::vector<ExtraChannel> GatherExtraChannels(const aiMesh* mesh)
+	{
+		std::vector<ExtraChannel> listChannels;
+
+		if (mesh->mTangents)
+			listChannels.push_back({ reinterpret_cast<const uint8_t*>(mesh->mTangents), sizeof(aiVector3D) });
+
+		if (mesh->mBitangents)
+			listChannels.push_back({ reinterpret_cast<const uint8_t*>(mesh->mBitangents), sizeof(aiVector3D) });
+
+		for (uint32_t c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++)
+		{
+			if (mesh->mColors[c])
+				listChannels.push_back({ reinterpret_cast<const uint8_t*>(mesh->mColors[c]), sizeof(aiColor4D) });
+		}
+
+		// Third UV component isn't in the SoA streams, so first set is compared whole here too
+		for (uint32_t c = 0; c < AI_MAX_NUMBER_OF_TEXTURECOORDS; c++)
+		{
+			if (mesh->mTextureCoords[c])
+				listChannels.push_back({ reinterpret_cast<const uint8_t*>(mesh->mTextureCoords[c]), sizeof(aiVector3D) });
+		}
+
+		return listChannels;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	template<typename T>
+	void RemapArray(T*& pArray, const std::vector<uint32_t>& listUnique)
+	{
+		if (pArray == nullptr)
+			return;
+
+		T* pRemapped = new T[listUnique.size()];
+		for (size_t i = 0; i < listUnique.size(); i++)
+		{
+			pRemapped[i] = pArray[listUnique[i]];
+		}
+
+		delete[] pArray;
+		pArray = pRemapped;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void WriteStream(aiVector3D*& pArray, const std::vector<glm::vec3>& listValues)
+	{
+		delete[] pArray;
+		pArray = new aiVector3D[listValues.size()];
+
+		for (size_t i = 0; i < listValues.size(); i++)
+		{
+			pArray[i] = aiVector3D(listValues[i].x, listValues[i].y, listValues[i].z);
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Any unit vector perpendicular to n, for vertices whose faces give no usable tangent
+	glm::vec3 AnyPerpendicular(const glm::vec3& n)
+	{
+		const glm::vec3 axis = glm::abs(n.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+		return glm::normalize(glm::cross(n, axis));
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void MeshProcessor::VertexStreams::Resize(size_t count, bool bNormals, bool bUVs)
+{
+	position.Resize(count);
+	normal.Resize(bNormals ? count : 0);
+	u.resize(bUVs ? count : 0);
+	v.resize(bUVs ? count : 0);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+MeshProcessStats MeshProcessor::Process(aiMesh* mesh, ThreadPool* pWorkers)
+{
+	MeshProcessStats stats;
+	stats.uiInputVertices = mesh->mNumVertices;
+	stats.uiOutputVertices = mesh->mNumVertices;
+
+	if (mesh->mNumVertices == 0 || mesh->mNumFaces == 0)
+		return stats;
+
+	const uint32_t inputCount = mesh->mNumVertices;
+	const bool bHasNormals = mesh->mNormals != nullptr;
+	const bool bHasUVs = mesh->mTextureCoords[0] != nullptr;
+
+	// AoS --> SoA
+	VertexStreams streams;
+	streams.Resize(inputCount, bHasNormals, bHasUVs);
+
+	ParallelFor(pWorkers, inputCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t i = first; i < end; i++)
+		{
+			streams.position.x[i] = mesh->mVertices[i].x;
+			streams.position.y[i] = mesh->mVertices[i].y;
+			streams.position.z[i] = mesh->mVertices[i].z;
+
+			if (bHasNormals)
+			{
+				streams.normal.x[i] = mesh->mNormals[i].x;
+				streams.normal.y[i] = mesh->mNormals[i].y;
+				streams.normal.z[i] = mesh->mNormals[i].z;
+			}
+
+			if (bHasUVs)
+			{
+				streams.u[i] = mesh->mTextureCoords[0][i].x;
+				streams.v[i] = mesh->mTextureCoords[0][i].y;
+			}
+		}
+	});
+
+	// Bone weights & morph targets refer to vertex indices, those meshes keep theirs!
+	const bool bCanWeld = mesh->mNumBones == 0 && mesh->mNumAnimMeshes == 0;
+
+	std::vector<uint32_t> listRemap;
+	std::vector<uint32_t> listUnique;
+	uint32_t vertexCount = inputCount;
+
+	if (bCanWeld)
+	{
+		vertexCount = Weld(streams, mesh, false, pWorkers, listRemap, listUnique);
+
+		if (vertexCount < inputCount)
+		{
+			VertexStreams welded;
+			welded.Resize(vertexCount, bHasNormals, bHasUVs);
+
+			ParallelFor(pWorkers, vertexCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+			{
+				for (uint32_t i = first; i < end; i++)
+				{
+					const uint32_t src = listUnique[i];
+
+					welded.position.x[i] = streams.position.x[src];
+					welded.position.y[i] = streams.position.y[src];
+					welded.position.z[i] = streams.position.z[src];
+
+					if (bHasNormals)
+					{
+						welded.normal.x[i] = streams.normal.x[src];
+						welded.normal.y[i] = streams.normal.y[src];
+						welded.normal.z[i] = streams.normal.z[src];
+					}
+
+					if (bHasUVs)
+					{
+						welded.u[i] = streams.u[src];
+						welded.v[i] = streams.v[src];
+					}
+				}
+			});
+
+			streams = std::move(welded);
+
+			ParallelFor(pWorkers, mesh->mNumFaces, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+			{
+				for (uint32_t f = first; f < end; f++)
+				{
+					aiFace& face = mesh->mFaces[f];
+					for (uint32_t n = 0; n < face.mNumIndices; n++)
+					{
+						face.mIndices[n] = listRemap[face.mIndices[n]];
+					}
+				}
+			});
+
+			RemapArray(mesh->mVertices, listUnique);
+			RemapArray(mesh->mNormals, listUnique);
+			RemapArray(mesh->mTangents, listUnique);
+			RemapArray(mesh->mBitangents, listUnique);
+
+			for (uint32_t c = 0; c < AI_MAX_NUMBER_OF_COLOR_SETS; c++)
+				RemapArray(mesh->mColors[c], listUnique);
+
+			for (uint32_t c = 0; c < AI_MAX_NUMBER_OF_TEXTURECOORDS; c++)
+				RemapArray(mesh->mTextureCoords[c], listUnique);
+
+			mesh->mNumVertices = vertexCount;
+		}
+	}
+
+	// Normals & tangents only come from triangles, points & lines are left as they are
+	std::vector<uint32_t> listTriangles;
+	listTriangles.reserve(mesh->mNumFaces * 3);
+
+	for (uint32_t f = 0; f < mesh->mNumFaces; f++)
+	{
+		const aiFace& face = mesh->mFaces[f];
+		if (face.mNumIndices == 3)
+			listTriangles.insert(listTriangles.end(), face.mIndices, face.mIndices + 3);
+	}
+
+	stats.uiOutputVertices = vertexCount;
+	stats.uiTriangles = static_cast<uint32_t>(listTriangles.size() / 3);
+
+	if (listTriangles.empty())
+		return stats;
+
+	if (!bHasNormals)
+	{
+		GenerateNormals(streams, vertexCount, listTriangles, pWorkers);
+
+		std::vector<glm::vec3> listNormals(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			listNormals[i] = streams.normal.Get(i);
+		}
+
+		WriteStream(mesh->mNormals, listNormals);
+	}
+
+	// Tangents the file came with are kept, same as Assimp did
+	if (bHasUVs && mesh->mTangents == nullptr)
+	{
+		std::vector<glm::vec3> listTangents;
+		std::vector<glm::vec3> listBitangents;
+		GenerateTangents(streams, vertexCount, listTriangles, pWorkers, listTangents, listBitangents);
+
+		WriteStream(mesh->mTangents, listTangents);
+		WriteStream(mesh->mBitangents, listBitangents);
+	}
+
+	return stats;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Bounds from aiMesh directly, 4 wide loads of a 12 byte vertex read one float into the next one which is ignored. Last
+// vertex is done on its own so nothing past the array is read!
+void MeshProcessor::ComputeBounds(const aiMesh* mesh, ThreadPool* pWorkers, glm::vec3& outMin, glm::vec3& outMax)
+{
+	outMin = glm::vec3(std::numeric_limits<float>::max());
+	outMax = glm::vec3(-std::numeric_limits<float>::max());
+
+	if (mesh->mNumVertices == 0)
+		return;
+
+	std::mutex mutex;
+	const float* pPositions = &mesh->mVertices[0].x;
+
+	ParallelFor(pWorkers, mesh->mNumVertices, g_uiMinBatchSize * 4, [&](uint32_t first, uint32_t end)
+	{
+		__m128 vMin = _mm_set1_ps(std::numeric_limits<float>::max());
+		__m128 vMax = _mm_set1_ps(-std::numeric_limits<float>::max());
+
+		const uint32_t simdEnd = std::min(end, mesh->mNumVertices - 1);
+		for (uint32_t i = first; i < simdEnd; i++)
+		{
+			const __m128 position = _mm_loadu_ps(pPositions + i * 3);
+			vMin = _mm_min_ps(vMin, position);
+			vMax = _mm_max_ps(vMax, position);
+		}
+
+		if (end == mesh->mNumVertices)
+		{
+			const aiVector3D& last = mesh->mVertices[end - 1];
+			const __m128 position = _mm_setr_ps(last.x, last.y, last.z, 0.0f);
+			vMin = _mm_min_ps(vMin, position);
+			vMax = _mm_max_ps(vMax, position);
+		}
+
+		alignas(16) float batchMin[4];
+		alignas(16) float batchMax[4];
+		_mm_store_ps(batchMin, vMin);
+		_mm_store_ps(batchMax, vMax);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		outMin = glm::min(outMin, glm::vec3(batchMin[0], batchMin[1], batchMin[2]));
+		outMax = glm::max(outMax, glm::vec3(batchMax[0], batchMax[1], batchMax[2]));
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every vertex is hashed in parallel, then bucketed into shards by top hash bits keeping vertex order. Each shard is
+// deduplicated on its own, so first vertex seen stays the representative & output order is the same as serial weld!
+uint32_t MeshProcessor::Weld(const VertexStreams& streams, const aiMesh* mesh, bool bPositionOnly, ThreadPool* pWorkers,
+								std::vector<uint32_t>& outRemap, std::vector<uint32_t>& outUnique)
+{
+	const uint32_t vertexCount = static_cast<uint32_t>(streams.position.x.size());
+	const bool bNormals = !bPositionOnly && !streams.normal.x.empty();
+	const bool bUVs = !bPositionOnly && !streams.u.empty();
+	const std::vector<ExtraChannel> listChannels = bPositionOnly ? std::vector<ExtraChannel>() : GatherExtraChannels(mesh);
+
+	std::vector<uint64_t> listHashes(vertexCount);
+	ParallelFor(pWorkers, vertexCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t i = first; i < end; i++)
+		{
+			uint64_t hash = Helper::g_uiHashSeed;
+			hash = MixHash(hash, FloatBits(streams.position.x[i]));
+			hash = MixHash(hash, FloatBits(streams.position.y[i]));
+			hash = MixHash(hash, FloatBits(streams.position.z[i]));
+
+			if (bNormals)
+			{
+				hash = MixHash(hash, FloatBits(streams.normal.x[i]));
+				hash = MixHash(hash, FloatBits(streams.normal.y[i]));
+				hash = MixHash(hash, FloatBits(streams.normal.z[i]));
+			}
+
+			if (bUVs)
+			{
+				hash = MixHash(hash, FloatBits(streams.u[i]));
+				hash = MixHash(hash, FloatBits(streams.v[i]));
+			}
+
+			// Rare enough that they're hashed as bytes, equality below catches the rest
+			for (const ExtraChannel& channel : listChannels)
+			{
+				hash = Helper::HashBytes(channel.pData + i * channel.uiStride, channel.uiStride, hash);
+			}
+
+			listHashes[i] = FinalizeHash(hash);
+		}
+	});
+
+	auto isEqual = [&](uint32_t a, uint32_t b)
+	{
+		if (FloatBits(streams.position.x[a]) != FloatBits(streams.position.x[b]) ||
+			FloatBits(streams.position.y[a]) != FloatBits(streams.position.y[b]) ||
+			FloatBits(streams.position.z[a]) != FloatBits(streams.position.z[b]))
+			return false;
+
+		if (bNormals && (FloatBits(streams.normal.x[a]) != FloatBits(streams.normal.x[b]) ||
+						 FloatBits(streams.normal.y[a]) != FloatBits(streams.normal.y[b]) ||
+						 FloatBits(streams.normal.z[a]) != FloatBits(streams.normal.z[b])))
+			return false;
+
+		if (bUVs && (FloatBits(streams.u[a]) != FloatBits(streams.u[b]) || FloatBits(streams.v[a]) != FloatBits(streams.v[b])))
+			return false;
+
+		for (const ExtraChannel& channel : listChannels)
+		{
+			if (memcmp(channel.pData + a * channel.uiStride, channel.pData + b * channel.uiStride, channel.uiStride) != 0)
+				return false;
+		}
+
+		return true;
+	};
+
+	auto getHash = [&](uint32_t index) { return static_cast<size_t>(listHashes[index]); };
+
+	// Counting sort into shards, stable so every shard lists its vertices in increasing order
+	std::vector<uint32_t> listShardOffsets(g_uiWeldShardCount + 1, 0);
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		listShardOffsets[(listHashes[i] >> (64 - g_uiWeldShardBits)) + 1]++;
+	}
+
+	for (uint32_t s = 0; s < g_uiWeldShardCount; s++)
+	{
+		listShardOffsets[s + 1] += listShardOffsets[s];
+	}
+
+	std::vector<uint32_t> listSharded(vertexCount);
+	std::vector<uint32_t> listCursor(listShardOffsets.begin(), listShardOffsets.end() - 1);
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		listSharded[listCursor[listHashes[i] >> (64 - g_uiWeldShardBits)]++] = i;
+	}
+
+	std::vector<uint32_t> listRepresentative(vertexCount);
+	ParallelFor(vertexCount >= g_uiMinBatchSize ? pWorkers : nullptr, g_uiWeldShardCount, 1, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t s = first; s < end; s++)
+		{
+			std::unordered_set<uint32_t, decltype(getHash), decltype(isEqual)> setVertices(0, getHash, isEqual);
+			setVertices.reserve(listShardOffsets[s + 1] - listShardOffsets[s]);
+
+			for (uint32_t n = listShardOffsets[s]; n < listShardOffsets[s + 1]; n++)
+			{
+				const uint32_t vertex = listSharded[n];
+				listRepresentative[vertex] = *setVertices.insert(vertex).first;
+			}
+		}
+	});
+
+	// Representative always comes before (or is) the vertex, so its new index is already known
+	outRemap.resize(vertexCount);
+	outUnique.clear();
+
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		if (listRepresentative[i] == i)
+		{
+			outRemap[i] = static_cast<uint32_t>(outUnique.size());
+			outUnique.push_back(i);
+		}
+		else
+		{
+			outRemap[i] = outRemap[listRepresentative[i]];
+		}
+	}
+
+	return static_cast<uint32_t>(outUnique.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Unnormalized cross product, so length is twice the area & bigger faces weigh more when summed
+void MeshProcessor::ComputeFaceNormals(const VertexStreams& streams, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers,
+										Stream3& outNormals)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(listTriangles.size() / 3);
+	outNormals.Resize(triangleCount);
+
+	const Stream3& p = streams.position;
+
+	ParallelFor(pWorkers, triangleCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+	{
+		uint32_t t = first;
+		for (; t + 4 <= end; t += 4)
+		{
+			const uint32_t* pIndices = &listTriangles[t * 3];
+
+			const __m128 x0 = Gather(p.x, pIndices),		y0 = Gather(p.y, pIndices),		z0 = Gather(p.z, pIndices);
+			const __m128 x1 = Gather(p.x, pIndices + 1),	y1 = Gather(p.y, pIndices + 1),	z1 = Gather(p.z, pIndices + 1);
+			const __m128 x2 = Gather(p.x, pIndices + 2),	y2 = Gather(p.y, pIndices + 2),	z2 = Gather(p.z, pIndices + 2);
+
+			const __m128 e1x = _mm_sub_ps(x1, x0), e1y = _mm_sub_ps(y1, y0), e1z = _mm_sub_ps(z1, z0);
+			const __m128 e2x = _mm_sub_ps(x2, x0), e2y = _mm_sub_ps(y2, y0), e2z = _mm_sub_ps(z2, z0);
+
+			_mm_storeu_ps(&outNormals.x[t], _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y)));
+			_mm_storeu_ps(&outNormals.y[t], _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z)));
+			_mm_storeu_ps(&outNormals.z[t], _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x)));
+		}
+
+		for (; t < end; t++)
+		{
+			const glm::vec3 p0 = p.Get(listTriangles[t * 3]);
+			const glm::vec3 normal = glm::cross(p.Get(listTriangles[t * 3 + 1]) - p0, p.Get(listTriangles[t * 3 + 2]) - p0);
+
+			outNormals.x[t] = normal.x;
+			outNormals.y[t] = normal.y;
+			outNormals.z[t] = normal.z;
+		}
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Same per face frame as MikkTSpace: scaled by sign of UV area instead of 1 / area, so stretched UVs don't blow up
+// the sum & mirrored UVs still point the right way. Faces with degenerate UVs give zero & are skipped later!
+void MeshProcessor::ComputeFaceTangents(const VertexStreams& streams, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers,
+										Stream3& outTangents, Stream3& outBitangents)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(listTriangles.size() / 3);
+	outTangents.Resize(triangleCount);
+	outBitangents.Resize(triangleCount);
+
+	const Stream3& p = streams.position;
+
+	ParallelFor(pWorkers, triangleCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 epsilon = _mm_set1_ps(1e-20f);
+
+		uint32_t t = first;
+		for (; t + 4 <= end; t += 4)
+		{
+			const uint32_t* pIndices = &listTriangles[t * 3];
+
+			const __m128 x0 = Gather(p.x, pIndices),		y0 = Gather(p.y, pIndices),		z0 = Gather(p.z, pIndices);
+			const __m128 x1 = Gather(p.x, pIndices + 1),	y1 = Gather(p.y, pIndices + 1),	z1 = Gather(p.z, pIndices + 1);
+			const __m128 x2 = Gather(p.x, pIndices + 2),	y2 = Gather(p.y, pIndices + 2),	z2 = Gather(p.z, pIndices + 2);
+
+			const __m128 u0 = Gather(streams.u, pIndices),	v0 = Gather(streams.v, pIndices);
+			const __m128 s1 = _mm_sub_ps(Gather(streams.u, pIndices + 1), u0), t1 = _mm_sub_ps(Gather(streams.v, pIndices + 1), v0);
+			const __m128 s2 = _mm_sub_ps(Gather(streams.u, pIndices + 2), u0), t2 = _mm_sub_ps(Gather(streams.v, pIndices + 2), v0);
+
+			const __m128 e1x = _mm_sub_ps(x1, x0), e1y = _mm_sub_ps(y1, y0), e1z = _mm_sub_ps(z1, z0);
+			const __m128 e2x = _mm_sub_ps(x2, x0), e2y = _mm_sub_ps(y2, y0), e2z = _mm_sub_ps(z2, z0);
+
+			// sign(det) where UV area is usable, 0 otherwise
+			const __m128 det = _mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(s2, t1));
+			const __m128 valid = _mm_cmpgt_ps(_mm_andnot_ps(signMask, det), epsilon);
+			const __m128 scale = _mm_and_ps(valid, _mm_or_ps(_mm_and_ps(det, signMask), one));
+
+			// T = (e1 * t2 - e2 * t1) * scale, B = (e2 * s1 - e1 * s2) * scale
+			_mm_storeu_ps(&outTangents.x[t], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1x, t2), _mm_mul_ps(e2x, t1)), scale));
+			_mm_storeu_ps(&outTangents.y[t], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1y, t2), _mm_mul_ps(e2y, t1)), scale));
+			_mm_storeu_ps(&outTangents.z[t], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1z, t2), _mm_mul_ps(e2z, t1)), scale));
+
+			_mm_storeu_ps(&outBitangents.x[t], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2x, s1), _mm_mul_ps(e1x, s2)), scale));
+			_mm_storeu_ps(&outBitangents.y[t], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2y, s1), _mm_mul_ps(e1y, s2)), scale));
+			_mm_storeu_ps(&outBitangents.z[t], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2z, s1), _mm_mul_ps(e1z, s2)), scale));
+		}
+
+		for (; t < end; t++)
+		{
+			const uint32_t i0 = listTriangles[t * 3], i1 = listTriangles[t * 3 + 1], i2 = listTriangles[t * 3 + 2];
+
+			const glm::vec3 e1 = p.Get(i1) - p.Get(i0);
+			const glm::vec3 e2 = p.Get(i2) - p.Get(i0);
+			const float s1 = streams.u[i1] - streams.u[i0], t1 = streams.v[i1] - streams.v[i0];
+			const float s2 = streams.u[i2] - streams.u[i0], t2 = streams.v[i2] - streams.v[i0];
+
+			const float det = s1 * t2 - s2 * t1;
+			const float scale = glm::abs(det) > 1e-20f ? (det < 0.0f ? -1.0f : 1.0f) : 0.0f;
+
+			const glm::vec3 tangent = (e1 * t2 - e2 * t1) * scale;
+			const glm::vec3 bitangent = (e2 * s1 - e1 * s2) * scale;
+
+			outTangents.x[t] = tangent.x;		outTangents.y[t] = tangent.y;		outTangents.z[t] = tangent.z;
+			outBitangents.x[t] = bitangent.x;	outBitangents.y[t] = bitangent.y;	outBitangents.z[t] = bitangent.z;
+		}
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void MeshProcessor::BuildCornerAdjacency(const std::vector<uint32_t>& listTriangles, const std::vector<uint32_t>& listGroups, uint32_t groupCount,
+											std::vector<uint32_t>& outOffsets, std::vector<uint32_t>& outCorners)
+{
+	auto getGroup = [&](uint32_t corner) { return listGroups.empty() ? listTriangles[corner] : listGroups[listTriangles[corner]]; };
+
+	const uint32_t cornerCount = static_cast<uint32_t>(listTriangles.size());
+
+	outOffsets.assign(groupCount + 1, 0);
+	for (uint32_t c = 0; c < cornerCount; c++)
+	{
+		outOffsets[getGroup(c) + 1]++;
+	}
+
+	for (uint32_t g = 0; g < groupCount; g++)
+	{
+		outOffsets[g + 1] += outOffsets[g];
+	}
+
+	outCorners.resize(cornerCount);
+	std::vector<uint32_t> listCursor(outOffsets.begin(), outOffsets.end() - 1);
+	for (uint32_t c = 0; c < cornerCount; c++)
+	{
+		outCorners[listCursor[getGroup(c)]++] = c;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Vertices are grouped by position only, so faces across UV seams still share one smooth normal!
+void MeshProcessor::GenerateNormals(VertexStreams& streams, uint32_t vertexCount, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers)
+{
+	std::vector<uint32_t> listGroups;
+	std::vector<uint32_t> listGroupFirst;
+	const uint32_t groupCount = Weld(streams, nullptr, true, pWorkers, listGroups, listGroupFirst);
+
+	Stream3 faceNormals;
+	ComputeFaceNormals(streams, listTriangles, pWorkers, faceNormals);
+
+	std::vector<uint32_t> listOffsets;
+	std::vector<uint32_t> listCorners;
+	BuildCornerAdjacency(listTriangles, listGroups, groupCount, listOffsets, listCorners);
+
+	std::vector<glm::vec3> listGroupNormals(groupCount);
+	ParallelFor(pWorkers, groupCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t g = first; g < end; g++)
+		{
+			glm::vec3 normal = glm::vec3(0);
+			for (uint32_t n = listOffsets[g]; n < listOffsets[g + 1]; n++)
+			{
+				normal += faceNormals.Get(listCorners[n] / 3);
+			}
+
+			const float length = glm::length(normal);
+			listGroupNormals[g] = length > 0.0f ? normal / length : glm::vec3(0, 0, 1);
+		}
+	});
+
+	streams.normal.Resize(vertexCount);
+	ParallelFor(pWorkers, vertexCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t i = first; i < end; i++)
+		{
+			const glm::vec3& normal = listGroupNormals[listGroups[i]];
+			streams.normal.x[i] = normal.x;
+			streams.normal.y[i] = normal.y;
+			streams.normal.z[i] = normal.z;
+		}
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Per vertex, every face's frame is projected on the vertex normal's plane, normalized & weighted by the corner angle.
+// Tangent is then made orthogonal to the normal, bitangent rebuilt as cross(N, T) with handedness of the summed ones!
+void MeshProcessor::GenerateTangents(const VertexStreams& streams, uint32_t vertexCount, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers,
+										std::vector<glm::vec3>& outTangents, std::vector<glm::vec3>& outBitangents)
+{
+	Stream3 faceTangents;
+	Stream3 faceBitangents;
+	ComputeFaceTangents(streams, listTriangles, pWorkers, faceTangents, faceBitangents);
+
+	std::vector<uint32_t> listOffsets;
+	std::vector<uint32_t> listCorners;
+	BuildCornerAdjacency(listTriangles, std::vector<uint32_t>(), vertexCount, listOffsets, listCorners);
+
+	outTangents.resize(vertexCount);
+	outBitangents.resize(vertexCount);
+
+	const Stream3& p = streams.position;
+
+	ParallelFor(pWorkers, vertexCount, g_uiMinBatchSize, [&](uint32_t first, uint32_t end)
+	{
+		for (uint32_t i = first; i < end; i++)
+		{
+			glm::vec3 normal = streams.normal.Get(i);
+			const float normalLength = glm::length(normal);
+			normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0, 0, 1);
+
+			glm::vec3 sumTangent = glm::vec3(0);
+			glm::vec3 sumBitangent = glm::vec3(0);
+
+			for (uint32_t n = listOffsets[i]; n < listOffsets[i + 1]; n++)
+			{
+				const uint32_t corner = listCorners[n];
+				const uint32_t triangle = corner / 3;
+				const uint32_t base = triangle * 3;
+
+				glm::vec3 tangent = faceTangents.Get(triangle);
+				glm::vec3 bitangent = faceBitangents.Get(triangle);
+
+				tangent -= normal * glm::dot(normal, tangent);
+				bitangent -= normal * glm::dot(normal, bitangent);
+
+				const float tangentLength = glm::length(tangent);
+				const float bitangentLength = glm::length(bitangent);
+				if (tangentLength < 1e-12f)
+					continue;
+
+				// Angle between both edges leaving this corner
+				const glm::vec3 edgeNext = p.Get(listTriangles[base + (corner + 1) % 3]) - p.Get(i);
+				const glm::vec3 edgePrev = p.Get(listTriangles[base + (corner + 2) % 3]) - p.Get(i);
+				const float edgeLengths = glm::length(edgeNext) * glm::length(edgePrev);
+				if (edgeLengths <= 0.0f)
+					continue;
+
+				const float angle = glm::acos(glm::clamp(glm::dot(edgeNext, edgePrev) / edgeLengths, -1.0f, 1.0f));
+
+				sumTangent += tangent * (angle / tangentLength);
+				if (bitangentLength > 1e-12f)
+					sumBitangent += bitangent * (angle / bitangentLength);
+			}
+
+			// Gram-Schmidt, vertices without a usable face get any tangent on the normal's plane
+			glm::vec3 tangent = sumTangent - normal * glm::dot(normal, sumTangent);
+			const float tangentLength = glm::length(tangent);
+			tangent = tangentLength > 1e-12f ? tangent / tangentLength : AnyPerpendicular(normal);
+
+			const float handedness = glm::dot(glm::cross(normal, tangent), sumBitangent) < 0.0f ? -1.0f : 1.0f;
+
+			outTangents[i] = tangent;
+			outBitangents[i] = glm::cross(normal, tangent) * handedness;
+		}
+	});
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "assimp/scene.h"
+
+class ThreadPool;
+
+//---------------------------------------------------------------------------------------------------------------------
+struct MeshProcessStats
+{
+	MeshProcessStats() : uiInputVertices(0), uiOutputVertices(0), uiTriangles(0) {}
+
+	uint32_t							uiInputVertices;
+	uint32_t							uiOutputVertices;
+	uint32_t							uiTriangles;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Replaces Assimp's JoinIdenticalVertices & CalcTangentSpace. Per mesh:
+//	1. Weld		- vertices with bit identical position, normal & UV become one. Hashed, then deduplicated in shards
+//	2. Normals	- only when file has none, area weighted & shared by everything at the same position
+//	3. Tangents	- when mesh has UVs. MikkTSpace style: per face tangent frame projected on each vertex normal, weighted
+//				  by the corner angle, Gram-Schmidt & handedness from the bitangent
+// Vertex data is split into SoA streams first, face & bounds passes run 4 wide with SSE. Every pass is spread over
+// workers in batches, small meshes just run on the caller. Results are written back into the aiMesh!
+class MeshProcessor
+{
+public:
+	static MeshProcessStats				Process(aiMesh* mesh, ThreadPool* pWorkers);
+	static void							ComputeBounds(const aiMesh* mesh, ThreadPool* pWorkers, glm::vec3& outMin, glm::vec3& outMax);
+
+private:
+	struct Stream3
+	{
+		void							Resize(size_t count)	{ x.resize(count); y.resize(count); z.resize(count); }
+		inline glm::vec3				Get(size_t i) const		{ return glm::vec3(x[i], y[i], z[i]); }
+
+		std::vector<float>				x, y, z;
+	};
+
+	struct VertexStreams
+	{
+		void							Resize(size_t count, bool bNormals, bool bUVs);
+
+		Stream3							position;
+		Stream3							normal;
+		std::vector<float>				u, v;
+	};
+
+	// Position only weld ignores every other attribute, otherwise mesh's remaining channels (colors, extra UVs, file
+	// tangents) must match too. Returns unique vertex count, outUnique holds first occurrence of each in vertex order
+	static uint32_t						Weld(const VertexStreams& streams, const aiMesh* mesh, bool bPositionOnly, ThreadPool* pWorkers,
+												std::vector<uint32_t>& outRemap, std::vector<uint32_t>& outUnique);
+	static void							ComputeFaceNormals(const VertexStreams& streams, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers,
+															Stream3& outNormals);
+	static void							ComputeFaceTangents(const VertexStreams& streams, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers,
+															Stream3& outTangents, Stream3& outBitangents);
+	// Corners (triangle * 3 + corner) bucketed by their vertex's group, empty listGroups means one group per vertex!
+	static void							BuildCornerAdjacency(const std::vector<uint32_t>& listTriangles, const std::vector<uint32_t>& listGroups, uint32_t groupCount,
+															std::vector<uint32_t>& outOffsets, std::vector<uint32_t>& outCorners);
+	static void							GenerateNormals(VertexStreams& streams, uint32_t vertexCount, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers);
+	static void							GenerateTangents(const VertexStreams& streams, uint32_t vertexCount, const std::vector<uint32_t>& listTriangles, ThreadPool* pWorkers,
+															std::vector<glm::vec3>& outTangents, std::vector<glm::vec3>& outBitangents);
+};
@@ -0,0 +1,566 @@
+#include "sandboxPCH.h"
+#include "ModelImporter.h"
+#include "Renderer/CookedFormat.h"
+#include "VulkanMesh.h"
+#include "MeshOptimizer.h"
+#include "ClusterPageBuilder.h"
+#include "StaticMeshMerger.h"
+#include "MeshProcessor.h"
+#include "Core/ThreadPool.h"
+#include "Core/Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+bool ModelImporter::Import(const std::string& filePath, ThreadPool* pWorkers, bool bMeshProcessor, CookedModel& outModel, std::vector<CookedPackedTexture>& outListPacked,
+							std::vector<std::string>& outListDependencies)
+{
+	std::string fileLoc = Helper::g_strSourceRoot + "Models/" + filePath;
+	LOG_DEBUG("Importing {0} Model...", fileLoc);
+
+	// cut off any directory information already present
+	int idx = filePath.find("/");
+	outModel.m_strName = filePath.substr(0, idx);
+
+	// Import Model scene
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(fileLoc, aiProcess_Triangulate | aiProcess_FixInfacingNormals | aiProcess_FlipUVs);
+	if (!scene)
+	{
+		LOG_ERROR("Failed to Assimp ReadFile {0} model! {1}", fileLoc, importer.GetErrorString());
+		return false;
+	}
+
+	// Importer frees the scene when post processing fails, nothing of it can be used after
+	scene = ProcessMeshes(&importer, scene, outModel.m_strName, pWorkers, bMeshProcessor);
+	if (!scene)
+	{
+		LOG_ERROR("Failed to process {0} model meshes! {1}", fileLoc, importer.GetErrorString());
+		return false;
+	}
+
+	// Meshes to cook, one per node reference or merged ones (see StaticMeshMerger). Either way node transforms below the
+	// root are baked into them, copies & merged meshes are freed once cooked
+	std::vector<aiMesh*> listSourceMeshes;
+	std::vector<aiMesh*> listMergedMeshes;
+	if (Helper::g_bEnableStaticMeshMerging)
+	{
+		outModel.m_uiNumSourceMeshes = StaticMeshMerger::Merge(scene, listSourceMeshes, listMergedMeshes);
+		LOG_INFO("{0}: {1} node meshes merged into {2} meshes", outModel.m_strName, outModel.m_uiNumSourceMeshes, listSourceMeshes.size());
+	}
+	else
+	{
+		GatherNodeMeshes(scene->mRootNode, scene, aiMatrix4x4(), listSourceMeshes, listMergedMeshes);
+		outModel.m_uiNumSourceMeshes = static_cast<uint32_t>(listSourceMeshes.size());
+	}
+
+	for (aiMesh* mesh : listSourceMeshes)
+	{
+		ImportMesh(mesh, scene, pWorkers, outModel);
+	}
+
+	for (aiMesh*& mesh : listMergedMeshes)
+	{
+		SAFE_DELETE(mesh);
+	}
+
+	for (uint32_t i = 0; i < scene->mNumMaterials; i++)
+	{
+		outModel.m_ListMaterials.push_back(ImportMaterial(scene->mMaterials[i], fileLoc, outModel.m_strName, outListPacked, outListDependencies));
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Vertex welding & tangent space, either by MeshProcessor or by Assimp's own steps. Only this part is timed, so both
+// paths log comparable triangles per second! Returns the scene to go on with, null once Assimp's steps failed.
+const aiScene* ModelImporter::ProcessMeshes(Assimp::Importer* pImporter, const aiScene* scene, const std::string& modelName, ThreadPool* pWorkers,
+											bool bMeshProcessor)
+{
+	uint64_t numTriangles = 0;
+	uint64_t numVerticesBefore = 0;
+	uint64_t numVerticesAfter = 0;
+
+	for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		numVerticesBefore += scene->mMeshes[i]->mNumVertices;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	if (bMeshProcessor)
+	{
+		for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+		{
+			numTriangles += MeshProcessor::Process(scene->mMeshes[i], pWorkers).uiTriangles;
+		}
+	}
+	else
+	{
+		scene = pImporter->ApplyPostProcessing(aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace);
+		if (!scene)
+			return nullptr;
+
+		for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+		{
+			for (uint32_t f = 0; f < scene->mMeshes[i]->mNumFaces; f++)
+				numTriangles += scene->mMeshes[i]->mFaces[f].mNumIndices == 3 ? 1 : 0;
+		}
+	}
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		numVerticesAfter += scene->mMeshes[i]->mNumVertices;
+	}
+
+	LOG_INFO("{0}: {1} processed {2} triangles in {3:.2f} ms, {4:.2f} M triangles/s, {5} --> {6} vertices", modelName,
+				bMeshProcessor ? "MeshProcessor" : "Assimp", numTriangles, elapsedMs,
+				elapsedMs > 0.0f ? numTriangles / (elapsedMs * 1000.0f) : 0.0f, numVerticesBefore, numVerticesAfter);
+
+	return scene;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Tangents only when material has a normal map, it's the only thing using them, & only with g_bCookTangents on. No
+// UVs means no textures either!
+Helper::EVertexFormat ModelImporter::ChooseVertexFormat(const aiMesh* mesh, const aiScene* scene)
+{
+	const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+	bool bHasNormalMap = material->GetTextureCount(aiTextureType_NORMAL_CAMERA) > 0 || material->GetTextureCount(aiTextureType_NORMALS) > 0;
+
+	return Helper::ChooseVertexFormat(mesh->mTextureCoords[0] != nullptr, Helper::g_bCookTangents && bHasNormalMap && mesh->mTangents != nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Everything that ends up in the mesh's buffers comes from these, import optimizations are deterministic so equal
+// source gives equal GPU data. Counts, attribute presence & vertex format go in first, so different layouts can't
+// hash alike!
+uint64_t ModelImporter::HashMeshPayload(const aiMesh* mesh, Helper::EVertexFormat format)
+{
+	const uint32_t header[] = {	mesh->mNumVertices,
+								mesh->mNumFaces,
+								(mesh->mNormals ? 1u : 0u) | (mesh->mTangents ? 2u : 0u) | (mesh->mBitangents ? 4u : 0u) | (mesh->mTextureCoords[0] ? 8u : 0u),
+								static_cast<uint32_t>(format) };
+
+	uint64_t hash = Helper::HashBytes(header, sizeof(header));
+	hash = Helper::HashBytes(mesh->mVertices, mesh->mNumVertices * sizeof(aiVector3D), hash);
+
+	if (mesh->mNormals)
+		hash = Helper::HashBytes(mesh->mNormals, mesh->mNumVertices * sizeof(aiVector3D), hash);
+
+	if (mesh->mTangents)
+		hash = Helper::HashBytes(mesh->mTangents, mesh->mNumVertices * sizeof(aiVector3D), hash);
+
+	if (mesh->mBitangents)
+		hash = Helper::HashBytes(mesh->mBitangents, mesh->mNumVertices * sizeof(aiVector3D), hash);
+
+	if (mesh->mTextureCoords[0])
+		hash = Helper::HashBytes(mesh->mTextureCoords[0], mesh->mNumVertices * sizeof(aiVector3D), hash);
+
+	for (uint64_t i = 0; i < mesh->mNumFaces; i++)
+	{
+		const aiFace& face = mesh->mFaces[i];
+		hash = Helper::HashBytes(&face.mNumIndices, sizeof(face.mNumIndices), hash);
+		hash = Helper::HashBytes(face.mIndices, face.mNumIndices * sizeof(uint32_t), hash);
+	}
+
+	return hash;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Without merging every node mesh reference becomes its own mesh. Node transform relative to the root is baked in like
+// StaticMeshMerger does it, so both paths put meshes in the same place!
+void ModelImporter::GatherNodeMeshes(const aiNode* node, const aiScene* scene, const aiMatrix4x4& transform, std::vector<aiMesh*>& outListMeshes,
+										std::vector<aiMesh*>& outListOwned)
+{
+	// Go through each mesh at this node & add it to the list
+	for (uint64_t i = 0; i < node->mNumMeshes; i++)
+	{
+		outListMeshes.push_back(StaticMeshMerger::ApplyTransform(scene->mMeshes[node->mMeshes[i]], transform, outListOwned));
+	}
+
+	// Go through each node attached to this node & gather its meshes too
+	for (uint64_t i = 0; i < node->mNumChildren; i++)
+	{
+		GatherNodeMeshes(node->mChildren[i], scene, transform * node->mChildren[i]->mTransformation, outListMeshes, outListOwned);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Indices are gathered & reordered first (see MeshOptimizer), vertices are then converted into the payload in the new
+// order, quantized to the mesh bounds. Result is exactly what the runtime copies into its GPU buffers!
+void ModelImporter::ImportMesh(aiMesh* mesh, const aiScene* scene, ThreadPool* pWorkers, CookedModel& outModel)
+{
+	CookedMesh cooked;
+	cooked.strName = mesh->mName.C_Str();
+
+	MeshProcessor::ComputeBounds(mesh, pWorkers, cooked.vecBoundsMin, cooked.vecBoundsMax);
+
+	outModel.m_vecBoundsMin = glm::min(outModel.m_vecBoundsMin, cooked.vecBoundsMin);
+	outModel.m_vecBoundsMax = glm::max(outModel.m_vecBoundsMax, cooked.vecBoundsMax);
+
+	const Helper::EVertexFormat format = ChooseVertexFormat(mesh, scene);
+	cooked.eVertexFormat = format;
+
+	// Runtime looks meshes up by it, same geometry already on the GPU is then shared instead of uploaded!
+	cooked.uiHash = HashMeshPayload(mesh, format);
+
+	std::vector<uint32_t> listIndices;
+	bool bTriangleList = true;
+
+	// iterate over indices thorough faces for index data...
+	for (uint64_t i = 0; i < mesh->mNumFaces; i++)
+	{
+		// Get a face
+		const aiFace& face = mesh->mFaces[i];
+		bTriangleList &= face.mNumIndices == 3;
+
+		// go through face's indices & add to the list
+		listIndices.insert(listIndices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+	}
+
+	// Too big to ever be loaded whole, it's cut into pages that stream on their own instead
+	if (bTriangleList && listIndices.size() / 3 >= Helper::g_uiPagedMeshMinTriangles)
+	{
+		ImportPagedMesh(mesh, format, listIndices, cooked, outModel);
+		return;
+	}
+
+	// Reorder for post transform cache, then overdraw, build LODs, then vertex fetch. Meshes with points or lines stay as
+	// they are!
+	std::vector<uint32_t> listVertexOrder;
+	if (bTriangleList)
+	{
+		const float* pPositions = &mesh->mVertices[0].x;
+
+		auto startTime = std::chrono::steady_clock::now();
+		const VertexCacheStats statsBefore = MeshOptimizer::AnalyzeVertexCache(listIndices, mesh->mNumVertices);
+
+		MeshOptimizer::OptimizeVertexCache(listIndices, mesh->mNumVertices);
+		MeshOptimizer::OptimizeOverdraw(listIndices, pPositions, sizeof(aiVector3D), mesh->mNumVertices, Helper::g_fOverdrawThreshold);
+
+		const VertexCacheStats statsAfter = MeshOptimizer::AnalyzeVertexCache(listIndices, mesh->mNumVertices);
+		cooked.listLods.push_back({ 0, static_cast<uint32_t>(listIndices.size()), 0.0f,
+									MeshOptimizer::BuildMeshlets(listIndices, pPositions, sizeof(aiVector3D), mesh->mNumVertices, Helper::g_uiMeshletMaxVertices,
+																	Helper::g_uiMeshletMaxTriangles) });
+
+		// Every next LOD is simplified from the one before to about half, errors add up so they're relative to LOD 0.
+		// Locked seams & borders can stop it early, LODs that don't get meaningfully smaller aren't worth keeping!
+		std::vector<uint32_t> listLodIndices = listIndices;
+		while (cooked.listLods.size() < Helper::g_uiMaxMeshLods && listLodIndices.size() >= 3 * Helper::g_uiMinLodTriangles)
+		{
+			float error = 0.0f;
+			std::vector<uint32_t> listSimplified = MeshOptimizer::Simplify(listLodIndices, pPositions, sizeof(aiVector3D), mesh->mNumVertices, listLodIndices.size() / 6 * 3, &error);
+
+			if (listSimplified.size() * 4 > listLodIndices.size() * 3)
+				break;
+
+			MeshOptimizer::OptimizeVertexCache(listSimplified, mesh->mNumVertices);
+
+			MeshLod lod = { static_cast<uint32_t>(listIndices.size()), static_cast<uint32_t>(listSimplified.size()), cooked.listLods.back().fError + error,
+							MeshOptimizer::BuildMeshlets(listSimplified, pPositions, sizeof(aiVector3D), mesh->mNumVertices, Helper::g_uiMeshletMaxVertices,
+															Helper::g_uiMeshletMaxTriangles) };
+
+			for (Meshlet& meshlet : lod.listMeshlets)
+				meshlet.firstIndex += lod.firstIndex;
+
+			listIndices.insert(listIndices.end(), listSimplified.begin(), listSimplified.end());
+			cooked.listLods.push_back(std::move(lod));
+			listLodIndices.swap(listSimplified);
+		}
+
+		// All LODs share vertices, LOD 0 comes first so it decides the fetch order
+		listVertexOrder = MeshOptimizer::OptimizeVertexFetch(listIndices, mesh->mNumVertices);
+
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		LOG_DEBUG("{0} optimized in {1:.2f} ms, ACMR {2:.3f} --> {3:.3f}, ATVR {4:.3f} --> {5:.3f}, {6} meshlets, {7} LODs", cooked.strName, elapsedMs,
+					statsBefore.fACMR, statsAfter.fACMR, statsBefore.fATVR, statsAfter.fATVR, cooked.listLods[0].listMeshlets.size(), cooked.listLods.size());
+
+		for (size_t i = 1; i < cooked.listLods.size(); i++)
+		{
+			LOG_DEBUG("    LOD {0}: {1} triangles, error {2:.5f}", i, cooked.listLods[i].indexCount / 3, cooked.listLods[i].fError);
+		}
+	}
+
+	cooked.uiVertexCount = mesh->mNumVertices;
+	cooked.uiIndexCount = static_cast<uint32_t>(listIndices.size());
+	cooked.quantization = Helper::MakeQuantizationBounds(cooked.vecBoundsMin, cooked.vecBoundsMax);
+
+	const VkIndexType indexType = VulkanMesh::ChooseIndexType(cooked.uiVertexCount);
+	cooked.uiVertexDataSize = cooked.uiVertexCount * Helper::GetVertexSize(format);
+	cooked.uiIndexDataSize = cooked.uiIndexCount * VulkanMesh::GetIndexSize(indexType);
+
+	// Only what the format's layout holds is gathered, tangents are skipped for meshes without normal maps
+	const bool bNeedsTangents = format == Helper::EVertexFormat::POSITION_NORMAL_TANGENT_UV;
+
+	// Position stream first, attribute stream after it. See VulkanMesh::GetAttributeStreamOffset()
+	void* pVertices = outModel.ReservePayload(cooked.uiVertexDataSize, &cooked.uiVertexDataOffset);
+	Helper::VisitVertexLayout(format, [&](auto layout)
+	{
+		// Loop through each vertex in fetch order...
+		for (uint32_t n = 0; n < mesh->mNumVertices; n++)
+		{
+			const uint32_t i = listVertexOrder.empty() ? n : listVertexOrder[n];
+			decltype(layout)::WriteVertex(pVertices, mesh->mNumVertices, n, GetVertex(mesh, i, bNeedsTangents), cooked.quantization);
+		}
+	});
+
+	cooked.uiPayloadHash = Helper::HashBytes(pVertices, static_cast<size_t>(cooked.uiVertexDataSize));
+
+	// Vertex pointer is no good after this!
+	void* pIndices = outModel.ReservePayload(cooked.uiIndexDataSize, &cooked.uiIndexDataOffset);
+	for (uint32_t i = 0; i < cooked.uiIndexCount; i++)
+	{
+		if (indexType == VK_INDEX_TYPE_UINT16)
+			static_cast<uint16_t*>(pIndices)[i] = static_cast<uint16_t>(listIndices[i]);
+		else
+			static_cast<uint32_t*>(pIndices)[i] = listIndices[i];
+	}
+
+	cooked.uiPayloadHash = Helper::HashBytes(pIndices, static_cast<size_t>(cooked.uiIndexDataSize), cooked.uiPayloadHash);
+
+	outModel.m_ListMeshes.push_back(std::move(cooked));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every page is a little mesh of its own: own vertices in cache & fetch order & 16 bit indices. Positions of all pages
+// sit on one grid, fine enough that the biggest page spans at most 65535 steps, & each page stores its offset on it.
+// Vertices pages share then decode to exactly the same position, whichever page draws them! Vertices of a page are
+// followed by its indices so a page is read with one request.
+void ModelImporter::ImportPagedMesh(const aiMesh* mesh, Helper::EVertexFormat format, const std::vector<uint32_t>& listIndices, const CookedMesh& cooked,
+									CookedModel& outModel)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	CookedPagedMesh paged;
+	paged.strName = cooked.strName;
+	paged.eVertexFormat = format;
+	paged.vecBoundsMin = cooked.vecBoundsMin;
+	paged.vecBoundsMax = cooked.vecBoundsMax;
+	paged.uiNumTriangles = static_cast<uint32_t>(listIndices.size() / 3);
+
+	std::vector<std::vector<uint32_t>> listPageIndices;
+	ClusterPageBuilder::Build(listIndices, &mesh->mVertices[0].x, sizeof(aiVector3D), mesh->mNumVertices, paged.listPages, paged.listGroups, paged.listGroupParents,
+								listPageIndices);
+
+	const bool bNeedsTangents = format == Helper::EVertexFormat::POSITION_NORMAL_TANGENT_UV;
+
+	// Biggest page decides the step. Slack of a few steps covers rounding, steps across the whole mesh must stay exact
+	// integers in a float (2^24)
+	glm::vec3 maxPageExtent = glm::vec3(0.0f);
+	for (const std::vector<uint32_t>& listPage : listPageIndices)
+	{
+		glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+
+		for (uint32_t vertex : listPage)
+		{
+			const glm::vec3 position = glm::vec3(mesh->mVertices[vertex].x, mesh->mVertices[vertex].y, mesh->mVertices[vertex].z);
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+
+		maxPageExtent = glm::max(maxPageExtent, boundsMax - boundsMin);
+	}
+
+	const glm::vec3 meshExtent = cooked.vecBoundsMax - cooked.vecBoundsMin;
+	const glm::vec3 gridExtent = glm::max(maxPageExtent * (65535.0f / 65531.0f), meshExtent * (65535.0f / 16777216.0f));
+	const Helper::QuantizationBounds grid = Helper::MakeQuantizationBounds(cooked.vecBoundsMin, cooked.vecBoundsMin + gridExtent);
+
+	std::vector<uint32_t> listStamps(mesh->mNumVertices);
+	std::vector<uint32_t> listVertices;
+	std::vector<uint32_t> listLocalIndices;
+	uint32_t numLeaves = 0;
+	uint32_t numRoots = 0;
+	float rootError = 0.0f;
+
+	for (size_t p = 0; p < paged.listPages.size(); p++)
+	{
+		ClusterPage& page = paged.listPages[p];
+		numLeaves += page.uiSourceGroup == g_uiNoPageGroup ? 1 : 0;
+		numRoots += page.uiParentGroup == g_uiNoPageGroup ? 1 : 0;
+
+		if (page.uiParentGroup == g_uiNoPageGroup && page.uiSourceGroup != g_uiNoPageGroup)
+			rootError = glm::max(rootError, paged.listGroups[page.uiSourceGroup].fError);
+
+		ClusterPageBuilder::Localize(listPageIndices[p], listStamps, listVertices, listLocalIndices);
+		const uint32_t vertexCount = static_cast<uint32_t>(listVertices.size());
+
+		MeshOptimizer::OptimizeVertexCache(listLocalIndices, vertexCount);
+		const std::vector<uint32_t> listVertexOrder = MeshOptimizer::OptimizeVertexFetch(listLocalIndices, vertexCount);
+
+		glm::vec3 gridMin = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 gridMax = glm::vec3(-std::numeric_limits<float>::max());
+
+		for (uint32_t vertex : listVertices)
+		{
+			const glm::vec3 steps = Helper::QuantizeToGrid(glm::vec3(mesh->mVertices[vertex].x, mesh->mVertices[vertex].y, mesh->mVertices[vertex].z), grid);
+			gridMin = glm::min(gridMin, steps);
+			gridMax = glm::max(gridMax, steps);
+		}
+
+		if (glm::any(glm::greaterThan(gridMax - gridMin, glm::vec3(65535.0f))))
+			LOG_WARNING("{0}: page {1} spans more than 65535 grid steps, its positions are clamped!", paged.strName, p);
+
+		page.quantization = grid;
+		page.quantization.gridOffset = glm::vec4(gridMin, 0.0f);
+		page.uiVertexCount = vertexCount;
+		page.uiIndexCount = static_cast<uint32_t>(listLocalIndices.size());
+
+		uint64_t vertexOffset = 0;
+		void* pVertices = outModel.ReservePayload(vertexCount * Helper::GetVertexSize(format), &vertexOffset);
+		Helper::VisitVertexLayout(format, [&](auto layout)
+		{
+			for (uint32_t n = 0; n < vertexCount; n++)
+			{
+				decltype(layout)::WriteVertex(pVertices, vertexCount, n, GetVertex(mesh, listVertices[listVertexOrder[n]], bNeedsTangents), page.quantization);
+			}
+		});
+
+		// Vertex pointer is no good after this!
+		uint64_t indexOffset = 0;
+		uint16_t* pIndices = reinterpret_cast<uint16_t*>(outModel.ReservePayload(page.uiIndexCount * sizeof(uint16_t), &indexOffset));
+		for (uint32_t i = 0; i < page.uiIndexCount; i++)
+		{
+			pIndices[i] = static_cast<uint16_t>(listLocalIndices[i]);
+		}
+
+		page.uiDataOffset = vertexOffset;
+		page.uiIndexDataOffset = indexOffset - vertexOffset;
+		page.uiDataSize = page.uiIndexDataOffset + page.uiIndexCount * sizeof(uint16_t);
+	}
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	LOG_INFO("{0}: {1} triangles cut into {2} pages in {3} groups in {4:.2f} ms, {5} leaves, {6} roots, root error {7:.5f}", paged.strName, paged.uiNumTriangles,
+				paged.listPages.size(), paged.listGroups.size(), elapsedMs, numLeaves, numRoots, rootError);
+
+	outModel.m_ListPagedMeshes.push_back(std::move(paged));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+Helper::VertexPNTBT ModelImporter::GetVertex(const aiMesh* mesh, uint32_t index, bool bNeedsTangents)
+{
+	Helper::VertexPNTBT vertex;
+
+	// Set position
+	vertex.Position = { mesh->mVertices[index].x, mesh->mVertices[index].y,  mesh->mVertices[index].z };
+
+	// Set Normals
+	vertex.Normal = { mesh->mNormals[index].x, mesh->mNormals[index].y, mesh->mNormals[index].z };
+
+	if (bNeedsTangents)
+	{
+		vertex.Tangent = { mesh->mTangents[index].x, mesh->mTangents[index].y, mesh->mTangents[index].z };
+		vertex.BiNormal = { mesh->mBitangents[index].x, mesh->mBitangents[index].y, mesh->mBitangents[index].z };
+	}
+
+	// Set texture coords (if they exists)
+	if (mesh->mTextureCoords[0])
+	{
+		vertex.UV = { mesh->mTextureCoords[0][index].x, mesh->mTextureCoords[0][index].y };
+	}
+
+	return vertex;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// if some texture is missing, we still load the default texture to maintain proper descriptor bindings in shader. In
+// shader, for now, we are using boolean flag to decide if we read from texture or use the color from Editor!
+CookedMaterial ModelImporter::ImportMaterial(aiMaterial* pMaterial, const std::string& sourcePath, const std::string& modelName, std::vector<CookedPackedTexture>& outListPacked,
+												std::vector<std::string>& outListDependencies)
+{
+	struct TextureSlot
+	{
+		aiTextureType		eType;
+		CookedTextureSlot	eSlot;
+		const char*			defaultPath;
+		float*				pHasTexture;
+	};
+
+	CookedMaterial material;
+
+	// We use Maya's Stingray PBS material for mapping following textures!
+	const TextureSlot arrSlots[] =
+	{
+		{ aiTextureType_DIFFUSE,		CookedTextureSlot::ALBEDO,		"Assets/Textures/Default/MissingAlbedo.png",	&material.hasTextureAEN.r },
+		{ aiTextureType_EMISSION_COLOR,	CookedTextureSlot::EMISSIVE,	"Assets/Textures/Default/MissingEmissive.png",	&material.hasTextureAEN.g },
+		{ aiTextureType_NORMAL_CAMERA,	CookedTextureSlot::NORMAL,		"Assets/Textures/Default/MissingNormal.png",	&material.hasTextureAEN.b },
+	};
+
+	for (const TextureSlot& slot : arrSlots)
+	{
+		std::string fileName = GetTextureFilePath(pMaterial, slot.eType, modelName);
+		*slot.pHasTexture = fileName.empty() ? 0.0f : 1.0f;
+
+		if (fileName.empty())
+		{
+			LOG_WARNING("{0}: texture not found, using default {1}!", modelName, slot.defaultPath);
+			fileName = slot.defaultPath;
+		}
+
+		material.arrTextures[static_cast<size_t>(slot.eSlot)] = Helper::GetCookedTexturePath(fileName);
+	}
+
+	// Roughness, metalness & AO maps are single channel, all three are packed into one ORM texture. Missing map's
+	// channel gets the same value Missing*.png textures used to provide!
+	CookedPackedTexture orm;
+	orm.packed.arrFiles = {	GetTextureFilePath(pMaterial, aiTextureType_AMBIENT_OCCLUSION, modelName),
+							GetTextureFilePath(pMaterial, aiTextureType_DIFFUSE_ROUGHNESS, modelName),
+							GetTextureFilePath(pMaterial, aiTextureType_METALNESS, modelName) };
+	orm.packed.arrDefaults = { 255, 128, 64 };
+
+	material.hasTextureRMO.r = orm.packed.arrFiles[1].empty() ? 0.0f : 1.0f;
+	material.hasTextureRMO.g = orm.packed.arrFiles[2].empty() ? 0.0f : 1.0f;
+	material.hasTextureRMO.b = orm.packed.arrFiles[0].empty() ? 0.0f : 1.0f;
+
+	for (const std::string& file : orm.packed.arrFiles)
+	{
+		if (!file.empty())
+			outListDependencies.push_back(file);
+	}
+
+	// Named after the model file & its inputs: materials of the model sharing maps share the packed texture, other models
+	// never write or remove it, even ones in the same folder cooking in parallel!
+	const std::string key = orm.packed.GetKey();
+	char name[32];
+	snprintf(name, sizeof(name), ".ORM_%016llx.tex", static_cast<unsigned long long>(Helper::HashBytes(key.data(), key.size())));
+
+	orm.strCookedPath = Helper::GetCookedPath(sourcePath, name);
+	material.arrTextures[static_cast<size_t>(CookedTextureSlot::ORM)] = orm.strCookedPath;
+
+	auto it = std::find_if(outListPacked.begin(), outListPacked.end(), [&](const CookedPackedTexture& t) { return t.strCookedPath == orm.strCookedPath; });
+	if (it == outListPacked.end())
+		outListPacked.push_back(std::move(orm));
+
+	return material;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Empty if material has no texture of this type, or names a file that isn't there!
+std::string ModelImporter::GetTextureFilePath(aiMaterial* pMaterial, aiTextureType eType, const std::string& modelName)
+{
+	aiString path;
+	if (pMaterial->GetTextureCount(eType) == 0 || pMaterial->GetTexture(eType, 0, &path) != AI_SUCCESS)
+		return std::string();
+
+	// cut off any directory information already present
+	std::string fileName = std::string(path.data);
+	fileName = fileName.substr(fileName.rfind("/") + 1);
+
+	// If due to some reasons, texture slot is assigned but no filename is mentioned, treat it as missing!
+	if (fileName.empty())
+		return std::string();
+
+	// Create filename with folder name which is Model name stored earlier...
+	std::string filePath = Helper::g_strSourceRoot + "Models/" + modelName + "/" + fileName;
+	if (!std::filesystem::exists(filePath))
+	{
+		LOG_WARNING("{0}: material refers to {1} which doesn't exist!", modelName, filePath);
+		return std::string();
+	}
+
+	return filePath;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Renderer/ImageDecoder.h"
+#include "CookedModel.h"
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "assimp/scene.h"
+
+class ThreadPool;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Packed texture the model refers to, cooker decodes & writes it once the model itself is imported!
+struct CookedPackedTexture
+{
+	std::string						strCookedPath;
+	PackedChannels					packed;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Whole CPU side of model loading, used by the cooker only: Assimp import, welding & tangents, static mesh merging,
+// vertex format choice, index optimization, LODs, meshlets & vertex packing. Missing textures are resolved to their
+// defaults here too, so cooked materials always name a texture for every slot!
+class ModelImporter
+{
+public:
+	// filePath is relative to Assets/Models, just like it used to be for VulkanModel::LoadModel(). Source files the cooked
+	// model depends on besides filePath itself are added to outListDependencies. Welding, normals & tangents are done by
+	// MeshProcessor, or by Assimp's own steps with bMeshProcessor off!
+	static bool							Import(const std::string& filePath, ThreadPool* pWorkers, bool bMeshProcessor, CookedModel& outModel,
+												std::vector<CookedPackedTexture>& outListPacked, std::vector<std::string>& outListDependencies);
+
+private:
+	static const aiScene*				ProcessMeshes(Assimp::Importer* pImporter, const aiScene* scene, const std::string& modelName, ThreadPool* pWorkers,
+														bool bMeshProcessor);
+	static Helper::EVertexFormat		ChooseVertexFormat(const aiMesh* mesh, const aiScene* scene);
+	static uint64_t						HashMeshPayload(const aiMesh* mesh, Helper::EVertexFormat format);
+	static void							GatherNodeMeshes(const aiNode* node, const aiScene* scene, const aiMatrix4x4& transform, std::vector<aiMesh*>& outListMeshes,
+														std::vector<aiMesh*>& outListOwned);
+	static void							ImportMesh(aiMesh* mesh, const aiScene* scene, ThreadPool* pWorkers, CookedModel& outModel);
+	static void							ImportPagedMesh(const aiMesh* mesh, Helper::EVertexFormat format, const std::vector<uint32_t>& listIndices, const CookedMesh& cooked,
+														CookedModel& outModel);
+	static Helper::VertexPNTBT			GetVertex(const aiMesh* mesh, uint32_t index, bool bNeedsTangents);
+	static CookedMaterial				ImportMaterial(aiMaterial* pMaterial, const std::string& sourcePath, const std::string& modelName,
+														std::vector<CookedPackedTexture>& outListPacked, std::vector<std::string>& outListDependencies);
+	static std::string					GetTextureFilePath(aiMaterial* pMaterial, aiTextureType eType, const std::string& modelName);
+};
@@ -0,0 +1,217 @@
+#include "sandboxPCH.h"
+#include "StaticMeshMerger.h"
+#include "Renderer/Utility.h"
+#include "Core/Core.h"
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	// Normals, tangents & bitangents stay unit length after scaling, degenerate ones are kept as they are!
+	aiVector3D TransformDirection(const aiMatrix3x3& mat, const aiVector3D& dir)
+	{
+		aiVector3D result = mat * dir;
+		float length = result.Length();
+
+		return length > 0.0f ? result / length : dir;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t StaticMeshMerger::Merge(const aiScene* scene, std::vector<aiMesh*>& outListMeshes, std::vector<aiMesh*>& outListOwned)
+{
+	// Anything an animation channel moves can't be baked, same goes for everything below it
+	std::set<std::string> setAnimatedNodes;
+	for (uint32_t i = 0; i < scene->mNumAnimations; i++)
+	{
+		for (uint32_t c = 0; c < scene->mAnimations[i]->mNumChannels; c++)
+		{
+			setAnimatedNodes.insert(scene->mAnimations[i]->mChannels[c]->mNodeName.C_Str());
+		}
+	}
+
+	// Transforms are relative to the root, its own one (often just unit conversion) isn't baked like it wasn't before
+	std::vector<MeshInstance> listStatic;
+	uint32_t numReferences = 0;
+	CollectInstances(scene->mRootNode, scene, aiMatrix4x4(), false, setAnimatedNodes, listStatic, outListMeshes, outListOwned, numReferences);
+
+	// Ordered map, so merged meshes come out the same on every import
+	std::map<uint64_t, std::vector<MeshInstance>> mapGroups;
+	for (const MeshInstance& instance : listStatic)
+	{
+		mapGroups[GetMergeKey(instance.mesh)].push_back(instance);
+	}
+
+	for (const auto& group : mapGroups)
+	{
+		const std::vector<MeshInstance>& listInstances = group.second;
+		uint32_t batchIndex = 0;
+
+		// Greedy batches under vertex cap, a mesh already over it gets a batch of its own
+		size_t first = 0;
+		while (first < listInstances.size())
+		{
+			size_t end = first;
+			uint64_t numVertices = 0;
+			while (end < listInstances.size() && (end == first || numVertices + listInstances[end].mesh->mNumVertices <= Helper::g_uiMaxMergedVertices))
+			{
+				numVertices += listInstances[end].mesh->mNumVertices;
+				end++;
+			}
+
+			if (end - first == 1 && listInstances[first].transform.IsIdentity())
+			{
+				outListMeshes.push_back(listInstances[first].mesh);
+			}
+			else
+			{
+				aiMesh* pMerged = BuildMergedMesh(listInstances, first, end, batchIndex++);
+				outListMeshes.push_back(pMerged);
+				outListOwned.push_back(pMerged);
+			}
+
+			first = end;
+		}
+	}
+
+	return numReferences;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void StaticMeshMerger::CollectInstances(const aiNode* node, const aiScene* scene, const aiMatrix4x4& transform, bool bAnimated,
+										const std::set<std::string>& setAnimatedNodes, std::vector<MeshInstance>& outListStatic,
+										std::vector<aiMesh*>& outListMeshes, std::vector<aiMesh*>& outListOwned, uint32_t& outNumReferences)
+{
+	bAnimated |= setAnimatedNodes.count(node->mName.C_Str()) > 0;
+
+	for (uint32_t i = 0; i < node->mNumMeshes; i++)
+	{
+		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+		outNumReferences++;
+
+		if (bAnimated || mesh->mNumBones > 0 || mesh->mNumAnimMeshes > 0)
+			outListMeshes.push_back(ApplyTransform(mesh, transform, outListOwned));
+		else
+			outListStatic.push_back({ mesh, transform });
+	}
+
+	for (uint32_t i = 0; i < node->mNumChildren; i++)
+	{
+		CollectInstances(node->mChildren[i], scene, transform * node->mChildren[i]->mTransformation, bAnimated, setAnimatedNodes, outListStatic,
+							outListMeshes, outListOwned, outNumReferences);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Same as a batch of one, copy keeps the mesh's own name though!
+aiMesh* StaticMeshMerger::ApplyTransform(aiMesh* mesh, const aiMatrix4x4& transform, std::vector<aiMesh*>& outListOwned)
+{
+	if (transform.IsIdentity())
+		return mesh;
+
+	aiMesh* pTransformed = BuildMergedMesh({ { mesh, transform } }, 0, 1, 0);
+	pTransformed->mName = mesh->mName;
+
+	outListOwned.push_back(pTransformed);
+	return pTransformed;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Only meshes with same material, primitive types & vertex attributes can end up in one mesh!
+uint64_t StaticMeshMerger::GetMergeKey(const aiMesh* mesh)
+{
+	uint64_t attributes = (mesh->mNormals ? 1u : 0u) | (mesh->mTangents ? 2u : 0u) | (mesh->mBitangents ? 4u : 0u) | (mesh->mTextureCoords[0] ? 8u : 0u);
+
+	return static_cast<uint64_t>(mesh->mMaterialIndex) | (static_cast<uint64_t>(mesh->mPrimitiveTypes) << 32) | (attributes << 48);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+aiMesh* StaticMeshMerger::BuildMergedMesh(const std::vector<MeshInstance>& listInstances, size_t first, size_t end, uint32_t batchIndex)
+{
+	const aiMesh* pFirst = listInstances[first].mesh;
+
+	uint32_t numVertices = 0;
+	uint32_t numFaces = 0;
+	for (size_t i = first; i < end; i++)
+	{
+		numVertices += listInstances[i].mesh->mNumVertices;
+		numFaces += listInstances[i].mesh->mNumFaces;
+	}
+
+	// aiMesh frees all of these itself when deleted
+	aiMesh* pMerged = new aiMesh();
+	pMerged->mName = aiString("merged_" + std::to_string(pFirst->mMaterialIndex) + "_" + std::to_string(batchIndex));
+	pMerged->mMaterialIndex = pFirst->mMaterialIndex;
+	pMerged->mPrimitiveTypes = pFirst->mPrimitiveTypes;
+	pMerged->mNumVertices = numVertices;
+	pMerged->mNumFaces = numFaces;
+
+	pMerged->mVertices = new aiVector3D[numVertices];
+	pMerged->mFaces = new aiFace[numFaces];
+
+	if (pFirst->mNormals)
+		pMerged->mNormals = new aiVector3D[numVertices];
+
+	if (pFirst->mTangents)
+		pMerged->mTangents = new aiVector3D[numVertices];
+
+	if (pFirst->mBitangents)
+		pMerged->mBitangents = new aiVector3D[numVertices];
+
+	if (pFirst->mTextureCoords[0])
+	{
+		pMerged->mTextureCoords[0] = new aiVector3D[numVertices];
+		pMerged->mNumUVComponents[0] = pFirst->mNumUVComponents[0];
+	}
+
+	uint32_t baseVertex = 0;
+	uint32_t baseFace = 0;
+	for (size_t i = first; i < end; i++)
+	{
+		const aiMesh* mesh = listInstances[i].mesh;
+		const aiMatrix4x4& transform = listInstances[i].transform;
+
+		// Normals need inverse transpose so non uniform scale doesn't skew them, tangents follow the surface itself
+		const aiMatrix3x3 matTangent = aiMatrix3x3(transform);
+		const aiMatrix3x3 matNormal = aiMatrix3x3(transform).Inverse().Transpose();
+
+		// Mirroring transforms flip winding, faces are reversed so they stay front facing!
+		const bool bMirrored = transform.Determinant() < 0.0f;
+
+		for (uint32_t v = 0; v < mesh->mNumVertices; v++)
+		{
+			pMerged->mVertices[baseVertex + v] = transform * mesh->mVertices[v];
+
+			if (pMerged->mNormals)
+				pMerged->mNormals[baseVertex + v] = TransformDirection(matNormal, mesh->mNormals[v]);
+
+			if (pMerged->mTangents)
+				pMerged->mTangents[baseVertex + v] = TransformDirection(matTangent, mesh->mTangents[v]);
+
+			if (pMerged->mBitangents)
+				pMerged->mBitangents[baseVertex + v] = TransformDirection(matTangent, mesh->mBitangents[v]);
+
+			if (pMerged->mTextureCoords[0])
+				pMerged->mTextureCoords[0][baseVertex + v] = mesh->mTextureCoords[0][v];
+		}
+
+		for (uint32_t f = 0; f < mesh->mNumFaces; f++)
+		{
+			const aiFace& srcFace = mesh->mFaces[f];
+			aiFace& dstFace = pMerged->mFaces[baseFace + f];
+
+			dstFace.mNumIndices = srcFace.mNumIndices;
+			dstFace.mIndices = new unsigned int[srcFace.mNumIndices];
+
+			for (uint32_t n = 0; n < srcFace.mNumIndices; n++)
+			{
+				uint32_t src = bMirrored ? srcFace.mNumIndices - 1 - n : n;
+				dstFace.mIndices[n] = baseVertex + srcFace.mIndices[src];
+			}
+		}
+
+		baseVertex += mesh->mNumVertices;
+		baseFace += mesh->mNumFaces;
+	}
+
+	return pMerged;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "assimp/scene.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Import pass merging many small aiMeshes into few big ones, so each one isn't its own VulkanMesh & draw call.
+// Static meshes (no bones, no morph targets, no animated node above them) are grouped by material & vertex layout,
+// their node transforms relative to the root are baked into vertices & each group is cut into batches under
+// Helper::g_uiMaxMergedVertices. Culling inside a merged mesh is left to its meshlets, which keep their own bounds.
+// Animated meshes aren't merged, runtime doesn't animate so they're drawn in their node's pose: with its transform baked
+// into a copy of their own. Batches of one untransformed mesh are passed through as they are!
+class StaticMeshMerger
+{
+public:
+	// Fills outListMeshes with what to load, merged meshes are also put in outListOwned & must be deleted by the caller.
+	// Returns number of node mesh references walked, i.e. how many meshes there'd be without merging!
+	static uint32_t						Merge(const aiScene* scene, std::vector<aiMesh*>& outListMeshes, std::vector<aiMesh*>& outListOwned);
+
+	// Mesh as it is when transform is identity, otherwise a copy with it baked in that's also put in outListOwned
+	static aiMesh*						ApplyTransform(aiMesh* mesh, const aiMatrix4x4& transform, std::vector<aiMesh*>& outListOwned);
+
+private:
+	struct MeshInstance
+	{
+		aiMesh*							mesh;
+		aiMatrix4x4						transform;
+	};
+
+	static void							CollectInstances(const aiNode* node, const aiScene* scene, const aiMatrix4x4& parentTransform, bool bAnimated,
+															const std::set<std::string>& setAnimatedNodes, std::vector<MeshInstance>& outListStatic,
+															std::vector<aiMesh*>& outListMeshes, std::vector<aiMesh*>& outListOwned, uint32_t& outNumReferences);
+	static uint64_t						GetMergeKey(const aiMesh* mesh);
+	static aiMesh*						BuildMergedMesh(const std::vector<MeshInstance>& listInstances, size_t first, size_t end, uint32_t batchIndex);
+};
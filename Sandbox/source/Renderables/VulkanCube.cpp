@@ -4,6 +4,7 @@
 #include "Renderer/VulkanMaterial.h"
 #include "Renderer/VulkanTexture.h"
 #include "Renderer/Utility.h"
+#include "Renderer/CookedFormat.h"
 
 //---------------------------------------------------------------------------------------------------------------------
 VulkanCube::VulkanCube()
@@ -111,10 +112,10 @@ VulkanCube::~VulkanCube()
 //---------------------------------------------------------------------------------------------------------------------
 bool VulkanCube::InitCube(const VulkanContext* pContext)
 {
-	m_pMesh = new VulkanMesh(pContext, m_ListVertices, m_ListIndices);
+	m_pMesh = new VulkanMesh(pContext, m_ListVertices, m_ListIndices, Helper::EVertexFormat::POSITION_NORMAL_UV);
 
 	m_pMaterial = new VulkanMaterial();
-	m_pMaterial->LoadTexture(pContext, "Assets/Textures/Cube/Default.png", TextureType::TEXTURE_ALBEDO);
+	m_pMaterial->LoadTexture(pContext, Helper::GetCookedTexturePath("Assets/Textures/Cube/Default.png"), TextureType::TEXTURE_ALBEDO);
 	
 	CHECK(SetupDescriptors(pContext));
 
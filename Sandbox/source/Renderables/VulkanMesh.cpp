@@ -1,6 +1,8 @@
 #include "sandboxPCH.h"
 #include "VulkanMesh.h"
 #include "Renderer/VulkanContext.h"
+#include "Renderer/VulkanUploadBatch.h"
+#include "VulkanMeshCache.h"
 
 //-----------------------------------------------------------------------------------------------------------------------
 VulkanMesh::~VulkanMesh()
@@ -9,17 +11,224 @@ VulkanMesh::~VulkanMesh()
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-VulkanMesh::VulkanMesh(const VulkanContext* pContext, const std::vector<Helper::VertexPNTBT>& vertices, const std::vector<uint32_t>& indices)
+VulkanMesh::VulkanMesh(const VulkanContext* pContext, const std::vector<Helper::VertexPNTBT>& vertices, const std::vector<uint32_t>& indices, Helper::EVertexFormat format)
 {
 	m_uiVertexCount = vertices.size();
 	m_uiIndexCount = indices.size();
+	m_vkIndexType = ChooseIndexType(m_uiVertexCount);
+	m_eVertexFormat = format;
+	m_vkVertexBufferOffset = 0;
+	m_vkIndexBufferOffset = 0;
+	m_pSharedLods = nullptr;
+	m_uiNumSharedLods = 0;
 
-	CreateVertexBuffer(pContext, vertices);
-	CreateIndexBuffer(pContext, indices);
+	glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (const Helper::VertexPNTBT& vertex : vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.Position);
+		boundsMax = glm::max(boundsMax, vertex.Position);
+	}
+
+	m_QuantizationBounds = Helper::MakeQuantizationBounds(boundsMin, boundsMax);
+
+	// Single LOD & no meshlets, always drawn whole
+	m_uiCurrentLod = 0;
+	m_uiVisibleIndexCount = m_uiIndexCount;
+	m_ListLods.push_back({ 0, m_uiIndexCount, 0.0f, {} });
+	m_ListVisibleRanges.push_back({ 0, m_uiIndexCount });
+
+	CreateVertexBuffer(pContext);
+	CreateIndexBuffer(pContext);
+
+	VkDeviceSize vertexSize = GetVertexBufferSize();
+	VkDeviceSize indexSize = m_uiIndexCount * GetIndexSize(m_vkIndexType);
+
+	// Both buffers go in one staging buffer & one submit!
+	VulkanUploadBatch batch;
+	if (batch.Begin(pContext, vertexSize + indexSize + 16))
+	{
+		VkDeviceSize vertexOffset = 0;
+		void* pVertices = batch.Reserve(vertexSize, &vertexOffset);
+
+		Helper::VisitVertexLayout(m_eVertexFormat, [&](auto layout)
+		{
+			for (uint32_t i = 0; pVertices && i < m_uiVertexCount; ++i)
+			{
+				decltype(layout)::WriteVertex(pVertices, m_uiVertexCount, i, vertices[i], m_QuantizationBounds);
+			}
+		});
+
+		VkDeviceSize indexOffset = 0;
+		void* pIndices = batch.Reserve(indexSize, &indexOffset);
+
+		for (uint32_t i = 0; pIndices && i < m_uiIndexCount; ++i)
+		{
+			if (m_vkIndexType == VK_INDEX_TYPE_UINT16)
+				static_cast<uint16_t*>(pIndices)[i] = static_cast<uint16_t>(indices[i]);
+			else
+				static_cast<uint32_t*>(pIndices)[i] = indices[i];
+		}
+
+		RecordUpload(&batch, vertexOffset, indexOffset);
+		batch.Submit(pContext);
+	}
+	else
+	{
+		LOG_ERROR("Staging ring is full, mesh buffers stay empty!");
+	}
+
+	batch.Cleanup(pContext);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+VulkanMesh::VulkanMesh(const VulkanContext* pContext, uint32_t vertexCount, uint32_t indexCount, const Helper::QuantizationBounds& bounds, Helper::EVertexFormat format)
+{
+	m_uiVertexCount = vertexCount;
+	m_uiIndexCount = indexCount;
+	m_vkIndexType = ChooseIndexType(vertexCount);
+	m_eVertexFormat = format;
+	m_QuantizationBounds = bounds;
+	m_vkVertexBufferOffset = 0;
+	m_vkIndexBufferOffset = 0;
+	m_pSharedLods = nullptr;
+	m_uiNumSharedLods = 0;
+
+	// Drawn whole till first visibility update, or for good if caller doesn't build LODs & meshlets
+	m_uiCurrentLod = 0;
+	m_uiVisibleIndexCount = indexCount;
+	m_ListLods.push_back({ 0, indexCount, 0.0f, {} });
+	m_ListVisibleRanges.push_back({ 0, indexCount });
+
+	CreateVertexBuffer(pContext);
+	CreateIndexBuffer(pContext);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+void VulkanMesh::RecordUpload(VulkanUploadBatch* pBatch, VkDeviceSize vertexOffset, VkDeviceSize indexOffset) const
+{
+	pBatch->AddBufferCopy(m_vkVertexBuffer, vertexOffset, GetVertexBufferSize());
+	pBatch->AddBufferCopy(m_vkIndexBuffer, indexOffset, m_uiIndexCount * GetIndexSize(m_vkIndexType));
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+// Memory handles are left null, nothing here ever destroys the prototype's buffers by itself!
+void VulkanMesh::ShareGeometry(const VulkanMesh& prototype)
+{
+	m_uiVertexCount = prototype.m_uiVertexCount;
+	m_uiIndexCount = prototype.m_uiIndexCount;
+	m_vkIndexType = prototype.m_vkIndexType;
+	m_eVertexFormat = prototype.m_eVertexFormat;
+	m_QuantizationBounds = prototype.m_QuantizationBounds;
+
+	m_vkVertexBuffer = prototype.m_vkVertexBuffer;
+	m_vkIndexBuffer = prototype.m_vkIndexBuffer;
+	m_vkVertexBufferMemory = VK_NULL_HANDLE;
+	m_vkIndexBufferMemory = VK_NULL_HANDLE;
+	m_vkVertexBufferOffset = prototype.m_vkVertexBufferOffset;
+	m_vkIndexBufferOffset = prototype.m_vkIndexBufferOffset;
+
+	m_ListLods.clear();
+	m_pSharedLods = prototype.GetLods();
+	m_uiNumSharedLods = prototype.GetNumLods();
+
+	// Drawn whole till first visibility update
+	m_uiCurrentLod = 0;
+	m_uiVisibleIndexCount = m_pSharedLods[0].indexCount;
+	m_ListVisibleRanges.assign(1, { m_pSharedLods[0].firstIndex, m_pSharedLods[0].indexCount });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+// Frustum & camera are in model space, so LOD errors & meshlet bounds are tested as they are. fPixelsPerUnit is how
+// many pixels one unit covers at distance one!
+void VulkanMesh::UpdateVisibility(const Helper::Frustum& frustum, const glm::vec3& cameraPosition, float fPixelsPerUnit)
+{
+	SelectLod(cameraPosition, fPixelsPerUnit);
+
+	const MeshLod& lod = GetLods()[m_uiCurrentLod];
+	if (Helper::g_bEnableMeshletCulling && !lod.listMeshlets.empty())
+	{
+		CullMeshlets(frustum, cameraPosition);
+	}
+	else
+	{
+		m_ListVisibleRanges.clear();
+		m_ListVisibleRanges.push_back({ lod.firstIndex, lod.indexCount });
+		m_uiVisibleIndexCount = lod.indexCount;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+// LOD errors only grow along the chain, so the coarsest acceptable one is found walking from the top. Finer LOD is
+// taken right away, coarser one only once it's below the threshold by the hysteresis margin.
+void VulkanMesh::SelectLod(const glm::vec3& cameraPosition, float fPixelsPerUnit)
+{
+	const MeshLod* pLods = GetLods();
+	const uint32_t numLods = GetNumLods();
+	if (numLods < 2)
+		return;
+
+	// Distance to the bounds rather than their center, big meshes keep detail right in front of the camera
+	const glm::vec3 extent = glm::vec3(m_QuantizationBounds.boundsExtent);
+	const glm::vec3 center = glm::vec3(m_QuantizationBounds.boundsMin) + extent * 0.5f;
+	const float distance = glm::length(cameraPosition - center) - glm::length(extent) * 0.5f;
+
+	if (distance <= 0.0f)
+	{
+		m_uiCurrentLod = 0;
+		return;
+	}
+
+	auto projectedError = [&](uint32_t lod) { return pLods[lod].fError / distance * fPixelsPerUnit; };
+
+	uint32_t desiredLod = 0;
+	while (desiredLod + 1 < numLods && projectedError(desiredLod + 1) <= Helper::g_fLodPixelError)
+		desiredLod++;
+
+	while (desiredLod > m_uiCurrentLod && projectedError(desiredLod) > Helper::g_fLodPixelError * (1.0f - Helper::g_fLodHysteresis))
+		desiredLod--;
+
+	m_uiCurrentLod = desiredLod;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+// See Meshlet for the cone test.
+void VulkanMesh::CullMeshlets(const Helper::Frustum& frustum, const glm::vec3& cameraPosition)
+{
+	m_ListVisibleRanges.clear();
+	m_uiVisibleIndexCount = 0;
+
+	for (const Meshlet& meshlet : GetLods()[m_uiCurrentLod].listMeshlets)
+	{
+		if (!Helper::IsSphereInFrustum(frustum, meshlet.center, meshlet.radius))
+			continue;
+
+		glm::vec3 toCenter = meshlet.center - cameraPosition;
+		if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius)
+			continue;
+
+		// Meshlets are consecutive in index buffer, extend previous draw if it ends right here!
+		if (!m_ListVisibleRanges.empty() && m_ListVisibleRanges.back().firstIndex + m_ListVisibleRanges.back().indexCount == meshlet.firstIndex)
+			m_ListVisibleRanges.back().indexCount += meshlet.indexCount;
+		else
+			m_ListVisibleRanges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+
+		m_uiVisibleIndexCount += meshlet.indexCount;
+	}
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
 void VulkanMesh::Cleanup(VulkanContext* pContext)
+{
+	if (pContext->pMeshCache && pContext->pMeshCache->Release(pContext, *this))
+		return;
+
+	DestroyBuffers(pContext);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+void VulkanMesh::DestroyBuffers(const VulkanContext* pContext)
 {
 	vkDestroyBuffer(pContext->vkDevice, m_vkIndexBuffer, nullptr);
 	vkFreeMemory(pContext->vkDevice, m_vkIndexBufferMemory, nullptr);
@@ -29,64 +238,25 @@ void VulkanMesh::Cleanup(VulkanContext* pContext)
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanMesh::CreateVertexBuffer(const VulkanContext* pContext, const std::vector<Helper::VertexPNTBT>& vertices)
+void VulkanMesh::CreateVertexBuffer(const VulkanContext* pContext)
 {
-	// Get the size of buffer needed for vertices
-	VkDeviceSize bufferSize = m_uiVertexCount * sizeof(Helper::VertexPNTBT);
+	// Get the size of buffer needed for vertices, position stream first & attribute stream right after it
+	VkDeviceSize bufferSize = GetVertexBufferSize();
 
-	// Temp buffer to "stage" vertex data before transferring to GPU memory!
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	// Create buffer & allocate memory to it!
-	pContext->CreateBuffer(	bufferSize,
-							VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-							VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-							&stagingBuffer, &stagingBufferMemory);
-
-	// Map memory to Vertex buffer
-	void* data;
-	vkMapMemory(pContext->vkDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-	vkUnmapMemory(pContext->vkDevice, stagingBufferMemory);
-
-	// Now, Create buffer with TRANSFER_DST_BIT to make as recipient of data (also VERTEX_BUFFER_BIT)
-	// this time, buffer memory is set to DEVICE_LOCAL which means, it's on the GPU. 
+	// Create buffer with TRANSFER_DST_BIT to make as recipient of data (also VERTEX_BUFFER_BIT)
+	// buffer memory is set to DEVICE_LOCAL which means, it's on the GPU. Data comes later through upload batch!
 	pContext->CreateBuffer(	bufferSize,
 							VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 							VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 							&m_vkVertexBuffer,
 							&m_vkVertexBufferMemory);
-
-	// Copy staging buffer data to vertex buffer on GPUP using Command buffer!
-	pContext->CopyBuffer(stagingBuffer, m_vkVertexBuffer, bufferSize);
-
-	// Clean up staging buffers
-	vkDestroyBuffer(pContext->vkDevice, stagingBuffer, nullptr);
-	vkFreeMemory(pContext->vkDevice, stagingBufferMemory, nullptr);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanMesh::CreateIndexBuffer(const VulkanContext* pContext, const std::vector<uint32_t>& indices)
+void VulkanMesh::CreateIndexBuffer(const VulkanContext* pContext)
 {
-	// Get size of buffer needed for indices
-	VkDeviceSize bufferSize = m_uiIndexCount * sizeof(uint32_t);
-
-	// Temporary buffer to "stage" index data before transferring to GPU
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	pContext->CreateBuffer(	bufferSize,
-							VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-							VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-							&stagingBuffer,
-							&stagingBufferMemory);
-
-	// Map memory to Index buffer
-	void* data;
-	vkMapMemory(pContext->vkDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, indices.data(), (size_t)bufferSize);
-	vkUnmapMemory(pContext->vkDevice, stagingBufferMemory);
+	// Get size of buffer needed for indices, 16 or 32 bit each
+	VkDeviceSize bufferSize = m_uiIndexCount * GetIndexSize(m_vkIndexType);
 
 	// Create buffer for index data on GPU access only area
 	pContext->CreateBuffer(	bufferSize,
@@ -94,16 +264,5 @@ void VulkanMesh::CreateIndexBuffer(const VulkanContext* pContext, const std::vec
 							VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 							&m_vkIndexBuffer,
 							&m_vkIndexBufferMemory);
-
-	// Copy from staging buffer to GPU access buffer
-	pContext->CopyBuffer(stagingBuffer, m_vkIndexBuffer, bufferSize);
-
-	// Clean up staging buffers
-	vkDestroyBuffer(pContext->vkDevice, stagingBuffer, nullptr);
-	vkFreeMemory(pContext->vkDevice, stagingBufferMemory, nullptr);
 }
 
-
-
-
-
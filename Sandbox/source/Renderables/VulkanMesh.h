@@ -2,8 +2,18 @@
 
 #include "vulkan/vulkan.h"
 #include "Renderer/Utility.h"
+#include "Renderer/VertexLayout.h"
+#include "MeshOptimizer.h"
 
 class VulkanContext;
+class VulkanUploadBatch;
+
+//---------------------------------------------------------------------------------------------------------------------
+struct DrawRange
+{
+	uint32_t						firstIndex;
+	uint32_t						indexCount;
+};
 
 //---------------------------------------------------------------------------------------------------------------------
 class VulkanMesh
@@ -12,20 +22,78 @@ public:
 	VulkanMesh() : 
 		m_uiVertexCount(0), 
 		m_uiIndexCount(0),
+		m_uiVisibleIndexCount(0),
+		m_uiCurrentLod(0),
+		m_vkIndexType(VK_INDEX_TYPE_UINT32),
+		m_eVertexFormat(Helper::EVertexFormat::POSITION_NORMAL_TANGENT_UV),
 		m_vkVertexBuffer(VK_NULL_HANDLE), 
 		m_vkIndexBuffer(VK_NULL_HANDLE),
 		m_vkVertexBufferMemory(VK_NULL_HANDLE),
-		m_vkIndexBufferMemory(VK_NULL_HANDLE) {}
+		m_vkIndexBufferMemory(VK_NULL_HANDLE),
+		m_vkVertexBufferOffset(0),
+		m_vkIndexBufferOffset(0),
+		m_pSharedLods(nullptr),
+		m_uiNumSharedLods(0) {}
+
+	VulkanMesh(const VulkanContext* pRC, const std::vector<Helper::VertexPNTBT>& vertices, const std::vector<uint32_t>& indices, Helper::EVertexFormat format);
+
+	// Only creates device buffers, caller writes vertices in format's layout & indices into batch staging & records the upload!
+	VulkanMesh(const VulkanContext* pContext, uint32_t vertexCount, uint32_t indexCount, const Helper::QuantizationBounds& bounds, Helper::EVertexFormat format);
+
+	void							RecordUpload(VulkanUploadBatch* pBatch, VkDeviceSize vertexOffset, VkDeviceSize indexOffset) const;
+
+	// Draws prototype's buffers & LODs without copying them, only culling state is this mesh's own. Prototype has to
+	// outlive it & owns the buffers, see VulkanSceneSnapshot!
+	void							ShareGeometry(const VulkanMesh& prototype);
+
+	inline const MeshLod*			GetLods() const							{ return m_pSharedLods ? m_pSharedLods : m_ListLods.data(); }
+	inline uint32_t					GetNumLods() const						{ return m_pSharedLods ? m_uiNumSharedLods : static_cast<uint32_t>(m_ListLods.size()); }
+
+	// 16 bit indices whenever every vertex can be addressed with them!
+	static inline VkIndexType		ChooseIndexType(uint32_t vertexCount)	{ return vertexCount <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32; }
+	static inline VkDeviceSize		GetIndexSize(VkIndexType indexType)		{ return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
 
-	VulkanMesh(const VulkanContext* pRC, const std::vector<Helper::VertexPNTBT>& vertices, const std::vector<uint32_t>& indices);
+	// Vertex buffer holds all positions, then all attributes. Depth only passes bind just the first stream!
+	inline VkDeviceSize				GetAttributeStreamOffset() const		{ return m_uiVertexCount * sizeof(Helper::AttributePosition); }
+	inline VkDeviceSize				GetVertexBufferSize() const				{ return m_uiVertexCount * Helper::GetVertexSize(m_eVertexFormat); }
 
+	// LODs are only kept with at most 3/4 of the previous one's indices, so the whole chain fits in this!
+	static inline VkDeviceSize		GetMaxLodChainIndexCount(VkDeviceSize baseIndexCount)
+	{
+		VkDeviceSize total = 0;
+		for (uint32_t i = 0; i < Helper::g_uiMaxMeshLods; i++, baseIndexCount = baseIndexCount * 3 / 4)
+			total += baseIndexCount;
+
+		return total;
+	}
+
+	// Picks LOD & culls its meshlets. Safe to run from worker threads, only touches this mesh's LOD & visible ranges!
+	void							UpdateVisibility(const Helper::Frustum& frustum, const glm::vec3& cameraPosition, float fPixelsPerUnit);
+
+	// GPU bytes behind this mesh, both streams & whole LOD chain!
+	inline VkDeviceSize				GetGeometrySize() const					{ return GetVertexBufferSize() + m_uiIndexCount * GetIndexSize(m_vkIndexType); }
+
+	// Shared meshes only drop their reference here, buffers go away with the mesh cache's last user!
 	void							Cleanup(VulkanContext* pContext);
+	void							DestroyBuffers(const VulkanContext* pContext);
 
 	~VulkanMesh();
 
 public:
 	uint32_t						m_uiVertexCount;
 	uint32_t						m_uiIndexCount;
+	uint32_t						m_uiVisibleIndexCount;			// LOD 0 triangles are GetLods()[0].indexCount!
+	VkIndexType						m_vkIndexType;
+	Helper::EVertexFormat			m_eVertexFormat;				// picks forward pipeline too, see VulkanContext
+
+	// Vertex positions are quantized to these, pushed before drawing the mesh!
+	Helper::QuantizationBounds		m_QuantizationBounds;
+
+	// LOD 0 first. Culling turns current LOD's meshlets into index ranges to draw, neighbouring visible ones are merged!
+	// Meshes sharing a prototype's geometry leave their own list empty, read them through GetLods()
+	std::vector<MeshLod>			m_ListLods;
+	uint32_t						m_uiCurrentLod;
+	std::vector<DrawRange>			m_ListVisibleRanges;
 
 	VkBuffer						m_vkVertexBuffer;
 	VkDeviceMemory					m_vkVertexBufferMemory;
@@ -33,8 +101,18 @@ public:
 	VkBuffer						m_vkIndexBuffer;
 	VkDeviceMemory					m_vkIndexBufferMemory;
 
+	// Where the mesh starts in its buffers. Non zero only for ranges of a scene wide buffer, see VulkanSceneSnapshot
+	VkDeviceSize					m_vkVertexBufferOffset;
+	VkDeviceSize					m_vkIndexBufferOffset;
+
+private:
+	const MeshLod*					m_pSharedLods;					// prototype's, see ShareGeometry()
+	uint32_t						m_uiNumSharedLods;
+
 private:
-	void							CreateVertexBuffer(const VulkanContext* pContext, const std::vector<Helper::VertexPNTBT>& vertices);
-	void							CreateIndexBuffer(const VulkanContext* pContext, const std::vector<uint32_t>& indices);
+	void							SelectLod(const glm::vec3& cameraPosition, float fPixelsPerUnit);
+	void							CullMeshlets(const Helper::Frustum& frustum, const glm::vec3& cameraPosition);
+	void							CreateVertexBuffer(const VulkanContext* pContext);
+	void							CreateIndexBuffer(const VulkanContext* pContext);
 };
 
@@ -0,0 +1,96 @@
+#include "sandboxPCH.h"
+#include "VulkanMeshCache.h"
+#include "Renderer/VulkanContext.h"
+#include "Core/Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMeshCache::VulkanMeshCache()
+{
+	m_MapMeshes.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMeshCache::~VulkanMeshCache()
+{
+	m_MapMeshes.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Copy starts at LOD 0 drawn whole, whatever the prototype was doing doesn't matter!
+bool VulkanMeshCache::Acquire(const MeshCacheKey& key, VulkanMesh* pOutMesh)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto itr = m_MapMeshes.find(key.uiHash);
+	if (itr == m_MapMeshes.end())
+		return false;
+
+	if (!(itr->second.key == key))
+	{
+		LOG_WARNING("Mesh cache hash {0:016x} collides with different geometry, mesh gets its own buffers", key.uiHash);
+		return false;
+	}
+
+	++itr->second.uiRefCount;
+
+	*pOutMesh = itr->second.mesh;
+	pOutMesh->m_uiCurrentLod = 0;
+	pOutMesh->m_uiVisibleIndexCount = pOutMesh->GetLods()[0].indexCount;
+	pOutMesh->m_ListVisibleRanges.assign(1, { pOutMesh->GetLods()[0].firstIndex, pOutMesh->GetLods()[0].indexCount });
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshCache::Add(const MeshCacheKey& key, const VulkanMesh& mesh)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto result = m_MapMeshes.emplace(key.uiHash, SharedMeshEntry());
+	if (!result.second)
+		return;
+
+	SharedMeshEntry& entry = result.first->second;
+	entry.key = key;
+	entry.mesh = mesh;
+	entry.uiRefCount = 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// False if mesh never came through the cache, caller destroys its buffers itself then!
+bool VulkanMeshCache::Release(const VulkanContext* pContext, const VulkanMesh& mesh)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (auto itr = m_MapMeshes.begin(); itr != m_MapMeshes.end(); ++itr)
+	{
+		if (itr->second.mesh.m_vkVertexBuffer != mesh.m_vkVertexBuffer)
+			continue;
+
+		if (--itr->second.uiRefCount == 0)
+		{
+			itr->second.mesh.DestroyBuffers(pContext);
+			m_MapMeshes.erase(itr);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshCache::Cleanup(const VulkanContext* pContext)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (!m_MapMeshes.empty())
+		LOG_WARNING("{0} shared meshes still referenced at shutdown, destroying them anyway!", m_MapMeshes.size());
+
+	for (auto& entry : m_MapMeshes)
+	{
+		entry.second.mesh.DestroyBuffers(pContext);
+	}
+
+	m_MapMeshes.clear();
+}
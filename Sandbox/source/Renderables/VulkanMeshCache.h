@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Renderables/VulkanMesh.h"
+
+class VulkanContext;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Source hash finds the entry, sizes & a second hash over the packed GPU data have to match it too. One colliding hash
+// alone never hands out someone else's geometry, payload isn't read to compare since skipping that read is the point!
+struct MeshCacheKey
+{
+	inline bool							operator==(const MeshCacheKey& other) const
+	{
+		return	uiHash == other.uiHash && uiPayloadHash == other.uiPayloadHash && eVertexFormat == other.eVertexFormat &&
+				uiVertexCount == other.uiVertexCount && uiIndexCount == other.uiIndexCount;
+	}
+
+	uint64_t							uiHash;
+	uint64_t							uiPayloadHash;
+	Helper::EVertexFormat				eVertexFormat;
+	uint32_t							uiVertexCount;
+	uint32_t							uiIndexCount;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct SharedMeshEntry
+{
+	SharedMeshEntry() : uiRefCount(0) {}
+
+	MeshCacheKey						key;
+	VulkanMesh							mesh;							// prototype every user copies, owns the buffers
+	uint32_t							uiRefCount;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Meshes with identical source payload (same key) share one set of GPU buffers, across nodes & across models. Users
+// hold a copy of the prototype VulkanMesh, so per instance state (LOD, visible ranges) stays their own. Buffers are
+// destroyed once the last user releases them! Thread safe, scene loader workers acquire & add while main thread releases.
+class VulkanMeshCache
+{
+public:
+	VulkanMeshCache();
+	~VulkanMeshCache();
+
+	bool								Acquire(const MeshCacheKey& key, VulkanMesh* pOutMesh);
+
+	// Mesh stays its owner's own when the hash is taken already, Release() then leaves its buffers to the owner!
+	void								Add(const MeshCacheKey& key, const VulkanMesh& mesh);
+	bool								Release(const VulkanContext* pContext, const VulkanMesh& mesh);
+	void								Cleanup(const VulkanContext* pContext);
+
+private:
+	VulkanMeshCache(const VulkanMeshCache&);
+	VulkanMeshCache& operator=(const VulkanMeshCache&);
+
+private:
+	std::mutex							m_Mutex;
+	std::map<uint64_t, SharedMeshEntry>	m_MapMeshes;
+};
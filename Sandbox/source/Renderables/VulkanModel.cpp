@@ -3,23 +3,48 @@
 #include "Renderer/VulkanTexture.h"
 #include "Renderer/VulkanContext.h"
 #include "Renderer/VulkanMaterial.h"
+#include "Renderer/VulkanUploadBatch.h"
 #include "VulkanMesh.h"
+#include "VulkanPagedMesh.h"
+#include "VulkanMeshCache.h"
+#include "CookedModel.h"
+#include "Renderer/CookedFormat.h"
 #include "World/Camera.h"
+#include "World/SceneFile.h"
+#include "Core/ThreadPool.h"
+#include "Core/AsyncFileIO.h"
 #include "Core/Core.h"
 
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	MeshCacheKey GetMeshCacheKey(const CookedMesh& mesh)
+	{
+		return { mesh.uiHash, mesh.uiPayloadHash, mesh.eVertexFormat, mesh.uiVertexCount, mesh.uiIndexCount };
+	}
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 VulkanModel::VulkanModel()
 {
 	m_pShaderDataBuffer = nullptr;
 	m_vkDescriptorPool = VK_NULL_HANDLE;
-	m_vkDescriptorSetLayout = VK_NULL_HANDLE;
 	
 	m_ListDescriptorSets.clear();
+	m_ListDescriptorResidency.clear();
 	m_ListMeshes.clear();
+	m_ListPagedMeshes.clear();
 
 	m_pMaterial = nullptr;
+	m_pPendingLoad = nullptr;
+	m_bSharedResources = false;
+	m_pSharedMaterial = nullptr;
 
 	m_strModelName.clear();
+	m_vecBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+	m_vecBoundsMax = glm::vec3(-std::numeric_limits<float>::max());
+	m_uiNumSharedMeshes = 0;
+	m_vkSharedGeometryBytes = 0;
 	m_vecPosition = glm::vec3(0);
 	m_vecRotationAxis = glm::vec3(0, 1, 0);
 	m_vecScale = glm::vec3(1.0f);
@@ -31,289 +56,398 @@ VulkanModel::VulkanModel()
 //---------------------------------------------------------------------------------------------------------------------
 VulkanModel::~VulkanModel()
 {
+	// Borrowed material goes away with its owner!
+	if (m_bSharedResources || m_pSharedMaterial)
+		m_pMaterial = nullptr;
+
 	SAFE_DELETE(m_pShaderDataBuffer);
 	SAFE_DELETE(m_pMaterial);
+	SAFE_DELETE(m_pPendingLoad);
 
 	m_vkDescriptorPool = VK_NULL_HANDLE;
-	m_vkDescriptorSetLayout = VK_NULL_HANDLE;
+
+	for (VulkanPagedMesh* pPagedMesh : m_ListPagedMeshes)
+	{
+		SAFE_DELETE(pPagedMesh);
+	}
 
 	m_ListDescriptorSets.clear();
 	m_ListMeshes.clear();
+	m_ListPagedMeshes.clear();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanModel::LoadModel(const VulkanContext* pContext, const std::string& filePath)
+// Mesh whose vertices & indices are still on their way into staging memory
+struct VulkanModel::PendingMesh
 {
-	std::string fileLoc = "Assets/Models/" + filePath;
-	LOG_DEBUG("Loading {0} Model...", fileLoc);
+	PendingMesh() : bShared(false), bReserved(false), bFailed(false), vkVertexOffset(0), vkIndexOffset(0) {}
 
-	// cut off any directory information already present
-	int idx = filePath.find("/");
-	m_strModelName = filePath.substr(0, idx);
+	VulkanMesh							sharedMesh;
+	bool								bShared;
+	bool								bReserved;
+	std::atomic<bool>					bFailed;
+	VkDeviceSize						vkVertexOffset;
+	VkDeviceSize						vkIndexOffset;
+};
 
-	// Import Model scene
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(fileLoc, aiProcess_Triangulate | aiProcess_FixInfacingNormals | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace);
-	if (!scene)
-		LOG_CRITICAL("Failed to Assimp ReadFile {0} model!", fileLoc);
+//---------------------------------------------------------------------------------------------------------------------
+// Cooked model whose meshes have been read into the batch, waiting for CreateModel()
+struct VulkanModel::PendingLoad
+{
+	PendingLoad(CookedModel* pCookedModel) : pCooked(pCookedModel), listMeshes(pCookedModel->m_ListMeshes.size()) {}
+	~PendingLoad() { SAFE_DELETE(pCooked); }
 
-	// Initialize Material & Shader buffers before loading texture data!
-	m_pMaterial = new VulkanMaterial();
+	CookedModel*						pCooked;
+	std::vector<PendingMesh>			listMeshes;
+};
 
-	m_pShaderDataBuffer = new UniformDataBuffer();
-	m_pShaderDataBuffer->CreateUniformDataBuffers(pContext);
-
-	LoadNode(pContext, scene->mRootNode, scene);
+//---------------------------------------------------------------------------------------------------------------------
+// Everything CPU heavy already happened in the cooker (see ModelImporter), meshes are read from the cooked file straight
+// into staging memory!
+bool VulkanModel::LoadModel(const VulkanContext* pContext, const std::string& filePath)
+{
+	bool bCreated = false;
 
-	// Get list o::vector<VulkanMesh> f textures based on materials!
-	LoadTextures(pContext, scene);
+	VulkanUploadBatch batch;
+	if (ReadModel(pContext, filePath, &batch))
+	{
+		// Submitted even when creation failed, meshes it added to the cache are shared from now on!
+		bCreated = CreateModel(pContext, &batch);
+		batch.Submit(pContext);
+	}
 
-	if (!SetupDescriptors(pContext))
-		LOG_CRITICAL("Failed to setup Model {0} Descriptors!!!", fileLoc);
+	batch.Cleanup(pContext);
+	return bCreated;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanModel::LoadNode(const VulkanContext* pContext, aiNode* node, const aiScene* scene)
+// All meshes of the model are read straight into one staging buffer & uploaded with a single submit! Every read is
+// issued up front so they're all in flight together, returns once the data has landed. Safe on any thread, only
+// workers should wait for staging ring space though, main thread is the one giving it back.
+bool VulkanModel::ReadModel(const VulkanContext* pContext, const std::string& filePath, VulkanUploadBatch* pBatch, bool bWaitForSpace)
 {
-	// Go through each mesh at this node & create it, then add it to our mesh list
-	for (uint64_t i = 0; i < node->mNumMeshes; i++)
+	std::string fileLoc = Helper::GetCookedModelPath(Helper::g_strSourceRoot + "Models/" + filePath);
+	LOG_DEBUG("Loading {0} Model...", fileLoc);
+
+	CookedModel* pCooked = new CookedModel();
+	if (!pCooked->Load(pContext->pFileSystem, fileLoc))
 	{
-		m_ListMeshes.push_back(LoadMesh(pContext, scene->mMeshes[node->mMeshes[i]], scene));
+		LOG_CRITICAL("Failed to load cooked {0} model, run the Cooker!", fileLoc);
+		SAFE_DELETE(pCooked);
+		return false;
 	}
 
-	// Go through each node attached to this node & load it, then append their meshes to this node's mesh list
-	for (uint64_t i = 0; i < node->mNumChildren; i++)
+	m_strModelName = pCooked->m_strName;
+	m_vecBoundsMin = pCooked->m_vecBoundsMin;
+	m_vecBoundsMax = pCooked->m_vecBoundsMax;
+
+	if (pCooked->m_uiNumSourceMeshes != pCooked->m_ListMeshes.size())
+		LOG_INFO("{0}: {1} node meshes merged into {2} meshes", m_strModelName, pCooked->m_uiNumSourceMeshes, pCooked->m_ListMeshes.size());
+
+	SAFE_DELETE(m_pPendingLoad);
+	m_pPendingLoad = new PendingLoad(pCooked);
+
+	if (!pBatch->Begin(pContext, pCooked->GetStagingSize(), bWaitForSpace))
 	{
-		LoadNode(pContext, node->mChildren[i], scene);
-		//m_vecMeshes.insert(m_vecMeshes.end(), newList.begin(), newList.end());
+		LOG_ERROR("Staging ring is full, can't read {0}!", fileLoc);
+		SAFE_DELETE(m_pPendingLoad);
+		return false;
 	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	AsyncReadGroup group;
+	for (size_t i = 0; i < pCooked->m_ListMeshes.size(); i++)
+	{
+		ReadMesh(pContext, pBatch, pCooked->m_ListMeshes[i], pCooked, &group, m_pPendingLoad->listMeshes[i]);
+	}
+
+	group.Wait();
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	LOG_DEBUG("{0}: read {1} meshes in {2:.2f} ms", m_strModelName, pCooked->m_ListMeshes.size(), elapsedMs);
+
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanModel::LoadTextures(const VulkanContext* pContext, const aiScene* scene)
+// Records the mesh uploads into the batch ReadModel() filled, requests textures & sets up descriptors. Safe on any
+// thread, but meshes it shares with earlier models are only valid once their batches are submitted before this one!
+// Batch has to be submitted whether this fails or not. Instances of one model pass the same shared material, the
+// first one fills it & they're all created on the same thread.
+bool VulkanModel::CreateModel(const VulkanContext* pContext, VulkanUploadBatch* pBatch, SharedModelMaterial* pSharedMaterial)
 {
-	// Go through each material and copy its texture file name
-	for (uint32_t i = 0; i < scene->mNumMaterials; i++)
+	if (!m_pPendingLoad)
+		return false;
+
+	const CookedModel* pCooked = m_pPendingLoad->pCooked;
+
+	// Initialize Material & Shader buffers before loading texture data!
+	bool bRequestTextures = true;
+	if (pSharedMaterial)
 	{
-		// Get the material
-		aiMaterial* material = scene->mMaterials[i];
+		m_pSharedMaterial = pSharedMaterial;
+		++m_pSharedMaterial->uiRefCount;
+
+		bRequestTextures = !m_pSharedMaterial->pMaterial;
+		if (bRequestTextures)
+			m_pSharedMaterial->pMaterial = new VulkanMaterial();
 
-		// We use Maya's Stingray PBS material for mapping following textures!
-		ExtractTextureFromMaterial(pContext, material, aiTextureType_DIFFUSE);
-		ExtractTextureFromMaterial(pContext, material, aiTextureType_NORMAL_CAMERA);
-		ExtractTextureFromMaterial(pContext, material, aiTextureType_EMISSION_COLOR);
-		ExtractTextureFromMaterial(pContext, material, aiTextureType_METALNESS);
-		ExtractTextureFromMaterial(pContext, material, aiTextureType_DIFFUSE_ROUGHNESS);
-		ExtractTextureFromMaterial(pContext, material, aiTextureType_AMBIENT_OCCLUSION);
+		m_pMaterial = m_pSharedMaterial->pMaterial;
+	}
+	else
+	{
+		m_pMaterial = new VulkanMaterial();
 	}
-}
 
-//---------------------------------------------------------------------------------------------------------------------
-void VulkanModel::SetDefaultValues(const VulkanContext* pContext, aiTextureType eType)
-{
-	// if some texture is missing, we still allow to load the default texture to maintain proper descriptor bindings
-	// in shader. Else we would need to manage that dynamically. In shader, for now, we are using boolean flag to decide
-	// if we read from texture or use the color from Editor! 
-	switch (eType)
+	m_pShaderDataBuffer = new UniformDataBuffer();
+	m_pShaderDataBuffer->CreateUniformDataBuffers(pContext);
+
+	for (size_t i = 0; i < pCooked->m_ListMeshes.size(); i++)
 	{
-		case aiTextureType_DIFFUSE:
-		{
-			m_pShaderDataBuffer->shaderData.hasTextureAEN.r = 0.0f;
-			m_pMaterial->LoadTexture(pContext, "Assets/Textures/Default/MissingAlbedo.png", TextureType::TEXTURE_ALBEDO);
-			LOG_WARNING("BaseColor texture not found, using default texture!");
-			break;
-		}
+		m_ListMeshes.push_back(CreateMesh(pContext, pBatch, pCooked->m_ListMeshes[i], m_pPendingLoad->listMeshes[i]));
+	}
 
-		case aiTextureType_EMISSION_COLOR:
+	// Nothing to read for these now, their pages stream in once they're seen
+	for (const CookedPagedMesh& mesh : pCooked->m_ListPagedMeshes)
+	{
+		VulkanPagedMesh* pPagedMesh = new VulkanPagedMesh();
+		if (pPagedMesh->Create(pContext, *pCooked, mesh))
 		{
-			m_pShaderDataBuffer->shaderData.hasTextureAEN.g = 0.0f;
-			m_pMaterial->LoadTexture(pContext, "Assets/Textures/Default/MissingEmissive.png", TextureType::TEXTURE_EMISSIVE);
-			LOG_WARNING("Emissive texture not found, using default texture!");
-			break;
+			m_ListPagedMeshes.push_back(pPagedMesh);
+			continue;
 		}
 
-		case aiTextureType_NORMAL_CAMERA:
-		{
-			m_pShaderDataBuffer->shaderData.hasTextureAEN.b = 0.0f;
-			m_pMaterial->LoadTexture(pContext, "Assets/Textures/Default/MissingNormal.png", TextureType::TEXTURE_NORMAL);
-			LOG_WARNING("Normal texture not found, using default texture!");
-			break;
-		}
+		LOG_ERROR("Failed to create {0} paged mesh {1}", m_strModelName, mesh.strName);
+		SAFE_DELETE(pPagedMesh);
+	}
 
-		case aiTextureType_DIFFUSE_ROUGHNESS:
-		{
-			m_pShaderDataBuffer->shaderData.hasTextureRMO.r = 0.0f;
-			m_pMaterial->LoadTexture(pContext, "Assets/Textures/Default/MissingRoughness.png", TextureType::TEXTURE_ROUGHNESS);
-			LOG_WARNING("Roughness texture not found, using default texture!");
-			break;
-		}
+	// Grouped by vertex format, so each forward pipeline is bound once per model
+	std::stable_sort(m_ListMeshes.begin(), m_ListMeshes.end(), [](const VulkanMesh& a, const VulkanMesh& b) { return a.m_eVertexFormat < b.m_eVertexFormat; });
+	std::stable_sort(m_ListPagedMeshes.begin(), m_ListPagedMeshes.end(),
+						[](const VulkanPagedMesh* a, const VulkanPagedMesh* b) { return a->GetVertexFormat() < b->GetVertexFormat(); });
 
-		case aiTextureType_METALNESS:
-		{
-			m_pShaderDataBuffer->shaderData.hasTextureRMO.g = 0.0f;
-			m_pMaterial->LoadTexture(pContext, "Assets/Textures/Default/MissingMetalness.png", TextureType::TEXTURE_METALNESS);
-			LOG_WARNING("Metalness texture not found, using default texture!");
-			break;
-		}
+	if (m_uiNumSharedMeshes > 0)
+	{
+		LOG_INFO("{0}: {1} meshes share geometry already loaded, {2:.2f} MB VRAM saved", m_strModelName, m_uiNumSharedMeshes,
+					m_vkSharedGeometryBytes / (1024.0f * 1024.0f));
+	}
 
-		case aiTextureType_AMBIENT_OCCLUSION:
-		{
-			m_pShaderDataBuffer->shaderData.hasTextureRMO.b = 0.0f;
-			m_pMaterial->LoadTexture(pContext, "Assets/Textures/Default/MissingAO.png", TextureType::TEXTURE_AO);
-			LOG_WARNING("AO texture not found, using default texture!");
-			break;
-		}
+	// Get list of textures based on materials!
+	bool bTexturesLoaded = LoadTextures(pContext, pCooked->m_ListMaterials, bRequestTextures);
+
+	if (m_pSharedMaterial)
+	{
+		if (bRequestTextures)
+			m_pSharedMaterial->bFailed = !bTexturesLoaded;
+
+		bTexturesLoaded = !m_pSharedMaterial->bFailed;
+	}
+
+	SAFE_DELETE(m_pPendingLoad);
+
+	if (!bTexturesLoaded)
+	{
+		LOG_CRITICAL("Failed to request Model {0} Textures!!!", m_strModelName);
+		return false;
+	}
+
+	if (!SetupDescriptors(pContext))
+	{
+		LOG_CRITICAL("Failed to setup Model {0} Descriptors!!!", m_strModelName);
+		return false;
 	}
+
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanModel::ExtractTextureFromMaterial(const VulkanContext* pContext, aiMaterial* pMaterial, aiTextureType eType)
+// Meshes draw the prototypes' buffers & LODs, only culling state is per model. Uniforms are written straight into the
+// shared mapping, sets are written by the owner for all of its models at once, see RecordDescriptorSetWrites()!
+void VulkanModel::CreateShared(const VulkanContext* pContext, const SharedModelResources& resources)
 {
-	unsigned int nCount = pMaterial->GetTextureCount(eType);
+	m_bSharedResources = true;
 
-	if (pMaterial->GetTextureCount(eType))
+	m_strModelName = resources.strName;
+	m_vecBoundsMin = resources.vecBoundsMin;
+	m_vecBoundsMax = resources.vecBoundsMax;
+	m_ListMeshes.resize(resources.uiNumMeshes);
+	for (uint32_t i = 0; i < resources.uiNumMeshes; i++)
 	{
-		// get the path of the texture file
-		aiString path;
-		if (pMaterial->GetTexture(eType, 0, &path) == AI_SUCCESS)
-		{
-			// cut off any directory information already present
-			int idx = std::string(path.data).rfind("/");
-			std::string fileName = std::string(path.data).substr(idx + 1);
-
-			// Create filename with folder name which is Model name stored earlier...
-			fileName = "Assets/Models/" + m_strModelName + "/" + fileName;
-
-			// Inside shader, if texture is available then we sample texture to get color values else use Color values
-			// provided. For roughness, metalness & AO property, we simply multiply texture color * editor value! 
-			if (!fileName.empty())
-			{
-				switch (eType)
-				{
-					case aiTextureType_DIFFUSE:
-					{
-						m_pShaderDataBuffer->shaderData.hasTextureAEN.r = 1.0f; 
-						CHECK(m_pMaterial->LoadTexture(pContext, fileName, TextureType::TEXTURE_ALBEDO));
-						break;
-					}
-
-					case aiTextureType_EMISSION_COLOR:
-					{
-						m_pShaderDataBuffer->shaderData.hasTextureAEN.g = 1.0f;
-						CHECK(m_pMaterial->LoadTexture(pContext, fileName, TextureType::TEXTURE_EMISSIVE));
-						break;
-					}
-
-					case aiTextureType_NORMAL_CAMERA:
-					{
-						m_pShaderDataBuffer->shaderData.hasTextureAEN.b = 1.0f;
-						CHECK(m_pMaterial->LoadTexture(pContext, fileName, TextureType::TEXTURE_NORMAL));
-						break;
-					}
-
-					case aiTextureType_DIFFUSE_ROUGHNESS:
-					{
-						m_pShaderDataBuffer->shaderData.hasTextureRMO.r = 1.0f;
-						CHECK(m_pMaterial->LoadTexture(pContext, fileName, TextureType::TEXTURE_ROUGHNESS));
-						break;
-					}
-
-					case aiTextureType_METALNESS:
-					{
-						m_pShaderDataBuffer->shaderData.hasTextureRMO.g = 1.0f;
-						CHECK(m_pMaterial->LoadTexture(pContext, fileName, TextureType::TEXTURE_METALNESS));
-						break;
-					}
-
-					case aiTextureType_AMBIENT_OCCLUSION:
-					{
-						m_pShaderDataBuffer->shaderData.hasTextureRMO.b = 1.0f;
-						CHECK(m_pMaterial->LoadTexture(pContext, fileName, TextureType::TEXTURE_AO));
-						break;
-					}
-				}
-			}
-			else
-			{
-				// If due to some reasons, texture slot is assigned but no filename is mentioned, load default!
-				SetDefaultValues(pContext, eType);
-			}
-		}
+		m_ListMeshes[i].ShareGeometry(resources.pMeshes[i]);
 	}
-	else
+
+	m_pMaterial = resources.pMaterial;
+
+	m_pShaderDataBuffer = new UniformDataBuffer();
+	m_pShaderDataBuffer->vkOffset = resources.vkUniformOffset;
+	m_pShaderDataBuffer->listBuffers.assign(resources.pUniformBuffers, resources.pUniformBuffers + pContext->uiNumSwapchainImages);
+
+	for (uint32_t i = 0; i < pContext->uiNumSwapchainImages; i++)
 	{
-		// if particular type texture is not available, load default!
-		SetDefaultValues(pContext, eType);
+		m_pShaderDataBuffer->listMappedData.push_back(resources.ppUniformData[i] + resources.vkUniformOffset);
 	}
+
+	SetDefaultMaterial();
+
+	m_ListDescriptorSets.assign(resources.pDescriptorSets, resources.pDescriptorSets + pContext->uiNumSwapchainImages);
+	m_ListDescriptorResidency.resize(pContext->uiNumSwapchainImages);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-VulkanMesh VulkanModel::LoadMesh(const VulkanContext* pContext, aiMesh* mesh, const aiScene* scene)
+void VulkanModel::ApplyMaterialOverrides(const SceneMaterial& material)
 {
-	std::vector<Helper::VertexPNTBT>	vertices;
-	std::vector<uint32_t>				indices;
-	std::vector<uint32_t>				textureIDs;
+	UniformData& shaderData = m_pShaderDataBuffer->shaderData;
 
-	vertices.resize(mesh->mNumVertices);
+	if (material.uiOverrides & OVERRIDE_ALBEDO)		shaderData.albedoColor = material.albedoColor;
+	if (material.uiOverrides & OVERRIDE_EMISSION)	shaderData.emissionColor = material.emissionColor;
+	if (material.uiOverrides & OVERRIDE_ROUGHNESS)	shaderData.roughness = material.roughness;
+	if (material.uiOverrides & OVERRIDE_METALNESS)	shaderData.metalness = material.metalness;
+	if (material.uiOverrides & OVERRIDE_OCCLUSION)	shaderData.occlusion = material.occlusion;
+}
 
-	// Loop through each vertex...
-	for (uint64_t i = 0; i < mesh->mNumVertices; i++)
+//---------------------------------------------------------------------------------------------------------------------
+// Cooked materials name a texture for every slot, defaults included. Flags tell the shader whether it's a real one: if
+// texture is available we sample it to get color values else use Color values provided. For roughness, metalness & AO
+// property, we simply multiply texture color * editor value! Instances sharing a material only take the flags.
+bool VulkanModel::LoadTextures(const VulkanContext* pContext, const std::vector<CookedMaterial>& listMaterials, bool bRequest)
+{
+	for (const CookedMaterial& material : listMaterials)
 	{
-		// Set position
-		vertices[i].Position = { mesh->mVertices[i].x, mesh->mVertices[i].y,  mesh->mVertices[i].z };
+		m_pShaderDataBuffer->shaderData.hasTextureAEN = material.hasTextureAEN;
+		m_pShaderDataBuffer->shaderData.hasTextureRMO = material.hasTextureRMO;
 
-		// Set Normals
-		vertices[i].Normal = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
+		if (!bRequest)
+			continue;
 
-		if (mesh->mTangents || mesh->mBitangents)
-		{
-			vertices[i].Tangent = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
-			vertices[i].BiNormal = { mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
-		}
+		CHECK(m_pMaterial->LoadTexture(pContext, material.arrTextures[static_cast<size_t>(CookedTextureSlot::ALBEDO)], TextureType::TEXTURE_ALBEDO, &m_StreamingBounds));
+		CHECK(m_pMaterial->LoadTexture(pContext, material.arrTextures[static_cast<size_t>(CookedTextureSlot::NORMAL)], TextureType::TEXTURE_NORMAL, &m_StreamingBounds));
+		CHECK(m_pMaterial->LoadTexture(pContext, material.arrTextures[static_cast<size_t>(CookedTextureSlot::EMISSIVE)], TextureType::TEXTURE_EMISSIVE, &m_StreamingBounds));
+		CHECK(m_pMaterial->LoadTexture(pContext, material.arrTextures[static_cast<size_t>(CookedTextureSlot::ORM)], TextureType::TEXTURE_ORM, &m_StreamingBounds));
+	}
 
-		// Set texture coords (if they exists)
-		if (mesh->mTextureCoords[0])
-		{
-			vertices[i].UV = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
-		}
-		else
-		{
-			vertices[i].UV = { 0.0f, 0.0f };
-		}
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cooked vertices & indices are already in their GPU layout, they're read from the file right into mapped staging
+// memory & nothing touches them on the way! Returns once both reads are issued.
+void VulkanModel::ReadMesh(const VulkanContext* pContext, VulkanUploadBatch* pBatch, const CookedMesh& mesh, CookedModel* pCooked, AsyncReadGroup* pGroup, PendingMesh& outPending)
+{
+	// Same geometry already on the GPU, from another model? Then nothing to read or upload!
+	if (pContext->pMeshCache->Acquire(GetMeshCacheKey(mesh), &outPending.sharedMesh))
+	{
+		outPending.bShared = true;
+		return;
 	}
 
-	// iterate over indices thorough faces for index data...
-	for (uint64_t i = 0; i < mesh->mNumFaces; i++)
+	void* pVertices = pBatch->Reserve(mesh.uiVertexDataSize, &outPending.vkVertexOffset);
+	void* pIndices = pBatch->Reserve(mesh.uiIndexDataSize, &outPending.vkIndexOffset);
+
+	if (!pVertices || !pIndices)
 	{
-		// Get a face
-		aiFace face = mesh->mFaces[i];
+		LOG_ERROR("Not enough staging memory for {0} mesh {1}", m_strModelName, mesh.strName);
+		return;
+	}
 
-		// go through face's indices & add to the list
-		for (uint16_t j = 0; j < face.mNumIndices; j++)
-		{
-			indices.push_back(face.mIndices[j]);
-		}
+	outPending.bReserved = true;
+
+	// Completions only flag the mesh, but compressed pack data is decoded before they run. Streamer's workers take both,
+	// loader's own workers may all be waiting in ReadModel() for their reads!
+	PendingMesh* pPending = &outPending;
+	auto OnRead = [pPending, pGroup](bool bSucceeded)
+	{
+		if (!bSucceeded)
+			pPending->bFailed = true;
+
+		pGroup->Complete(bSucceeded);
+	};
+
+	pGroup->Add(2);
+	ThreadPool* pCompletionWorkers = pContext->pTextureStreamer->GetWorkers();
+	pCooked->ReadPayloadAsync(mesh.uiVertexDataOffset, mesh.uiVertexDataSize, pVertices, pCompletionWorkers, OnRead);
+	pCooked->ReadPayloadAsync(mesh.uiIndexDataOffset, mesh.uiIndexDataSize, pIndices, pCompletionWorkers, OnRead);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Identical meshes within the model were both read, only the first one gets uploaded & the others share it!
+VulkanMesh VulkanModel::CreateMesh(const VulkanContext* pContext, VulkanUploadBatch* pBatch, const CookedMesh& mesh, PendingMesh& pending)
+{
+	if (!pending.bShared && pContext->pMeshCache->Acquire(GetMeshCacheKey(mesh), &pending.sharedMesh))
+		pending.bShared = true;
+
+	if (pending.bShared)
+	{
+		m_uiNumSharedMeshes++;
+		m_vkSharedGeometryBytes += pending.sharedMesh.GetGeometrySize();
+		return pending.sharedMesh;
+	}
+
+	if (!pending.bReserved)
+		return VulkanMesh();
+
+	if (pending.bFailed)
+	{
+		LOG_ERROR("Failed to read {0} mesh {1} from cooked file, re-run the Cooker!", m_strModelName, mesh.strName);
+		return VulkanMesh();
 	}
 
 	// Create new mesh with details & return it!
-	VulkanMesh newMesh(pContext, vertices, indices);
+	VulkanMesh newMesh(pContext, mesh.uiVertexCount, mesh.uiIndexCount, mesh.quantization, mesh.eVertexFormat);
+	newMesh.RecordUpload(pBatch, pending.vkVertexOffset, pending.vkIndexOffset);
+	if (!mesh.listLods.empty())
+		newMesh.m_ListLods = mesh.listLods;
+
+	pContext->pMeshCache->Add(GetMeshCacheKey(mesh), newMesh);
+
 	return newMesh;
 }
 
-
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanModel::Render(const VulkanContext* pContext, uint32_t index)
 {
+	DrawMeshes(pContext, index, false);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runs before Render() in the same command buffer!
+void VulkanModel::RenderDepth(const VulkanContext* pContext, uint32_t index)
+{
+	DrawMeshes(pContext, index, true);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Depth only pipeline is bound by the caller & takes every format. Forward pipelines depend on the mesh's vertex format,
+// meshes are sorted by it so that's one bind per format!
+void VulkanModel::DrawMeshes(const VulkanContext* pContext, uint32_t index, bool bPositionsOnly)
+{
+	Helper::EVertexFormat boundFormat = Helper::EVertexFormat::COUNT;
+
 	for (int i = 0; i < m_ListMeshes.size(); ++i)
 	{
+		if (!bPositionsOnly && m_ListMeshes[i].m_eVertexFormat != boundFormat)
+		{
+			boundFormat = m_ListMeshes[i].m_eVertexFormat;
+			vkCmdBindPipeline(pContext->vkListGraphicsCommandBuffers[index], VK_PIPELINE_BIND_POINT_GRAPHICS, pContext->vkListForwardRenderingPipelines[static_cast<uint32_t>(boundFormat)]);
+		}
 
-		VkBuffer vertexBuffers[] = { m_ListMeshes[i].m_vkVertexBuffer };											// Buffers to bind
+		// Position & attribute streams live in the same buffer, depth only pipeline just reads the first one
+		VkBuffer vertexBuffers[] = { m_ListMeshes[i].m_vkVertexBuffer, m_ListMeshes[i].m_vkVertexBuffer };			// Buffers to bind
 		VkBuffer indexBuffer = m_ListMeshes[i].m_vkIndexBuffer;
-		VkDeviceSize offsets[] = { 0 };																				// offsets into buffers being bound
-		vkCmdBindVertexBuffers(pContext->vkListGraphicsCommandBuffers[index], 0, 1, vertexBuffers, offsets);		// Command to bind vertex buffer before drawing with them
+		VkDeviceSize vertexOffset = m_ListMeshes[i].m_vkVertexBufferOffset;
+		VkDeviceSize offsets[] = { vertexOffset, vertexOffset + m_ListMeshes[i].GetAttributeStreamOffset() };		// offsets into buffers being bound
+		vkCmdBindVertexBuffers(pContext->vkListGraphicsCommandBuffers[index], 0, bPositionsOnly ? 1 : Helper::g_uiMaxVertexStreams, vertexBuffers, offsets);
 
-		// bind mesh index buffer, with zero offset & using uint32_t type
-		vkCmdBindIndexBuffer(pContext->vkListGraphicsCommandBuffers[index], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		// bind mesh index buffer, from where the mesh starts in it & with the mesh's own index type
+		vkCmdBindIndexBuffer(pContext->vkListGraphicsCommandBuffers[index], indexBuffer, m_ListMeshes[i].m_vkIndexBufferOffset, m_ListMeshes[i].m_vkIndexType);
+
+		// Vertex shader needs mesh bounds to dequantize positions
+		vkCmdPushConstants(	pContext->vkListGraphicsCommandBuffers[index],
+							pContext->vkForwardRenderingPipelineLayout,
+							VK_SHADER_STAGE_VERTEX_BIT,
+							0,
+							sizeof(Helper::QuantizationBounds),
+							&(m_ListMeshes[i].m_QuantizationBounds));
 
 		// bind descriptor sets
 		vkCmdBindDescriptorSets(pContext->vkListGraphicsCommandBuffers[index],
@@ -325,9 +459,92 @@ void VulkanModel::Render(const VulkanContext* pContext, uint32_t index)
 								0,
 								nullptr);
 
-		// Execute pipeline
-		vkCmdDrawIndexed(pContext->vkListGraphicsCommandBuffers[index], m_ListMeshes[i].m_uiIndexCount, 1, 0, 0, 0);
+		// Execute pipeline, one draw per run of visible meshlets
+		for (const DrawRange& range : m_ListMeshes[i].m_ListVisibleRanges)
+		{
+			vkCmdDrawIndexed(pContext->vkListGraphicsCommandBuffers[index], range.indexCount, 1, range.firstIndex, 0, 0);
+		}
+	}
+
+	// Paged meshes bind their own streams & bounds per page
+	for (const VulkanPagedMesh* pPagedMesh : m_ListPagedMeshes)
+	{
+		if (!bPositionsOnly && pPagedMesh->GetVertexFormat() != boundFormat)
+		{
+			boundFormat = pPagedMesh->GetVertexFormat();
+			vkCmdBindPipeline(pContext->vkListGraphicsCommandBuffers[index], VK_PIPELINE_BIND_POINT_GRAPHICS, pContext->vkListForwardRenderingPipelines[static_cast<uint32_t>(boundFormat)]);
+		}
+
+		vkCmdBindDescriptorSets(pContext->vkListGraphicsCommandBuffers[index],
+								VK_PIPELINE_BIND_POINT_GRAPHICS,
+								pContext->vkForwardRenderingPipelineLayout,
+								0,
+								1,
+								&(m_ListDescriptorSets[index]),
+								0,
+								nullptr);
+
+		pPagedMesh->RecordDraws(pContext, pContext->vkListGraphicsCommandBuffers[index], bPositionsOnly);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// One job per mesh, caller waits on the pool before recording. Frustum & camera go to model space once here so jobs
+// don't transform any meshlet or LOD error!
+void VulkanModel::UpdateVisibility(const Camera* pCamera, ThreadPool* pWorkers)
+{
+	const glm::mat4& matWorld = m_pShaderDataBuffer->shaderData.matWorld;
+
+	Helper::Frustum frustum = Helper::ExtractFrustum(pCamera->m_matProjection * pCamera->m_matView * matWorld);
+	glm::vec3 cameraPosition = glm::vec3(glm::inverse(matWorld) * glm::vec4(pCamera->m_vecCameraPosition, 1.0f));
+
+	// Pixels covered by one unit at distance one, uniform scale cancels out between LOD error & distance
+	float pixelsPerUnit = pCamera->m_matProjection[1][1] * gWindowHeight * 0.5f;
+
+	for (VulkanMesh& mesh : m_ListMeshes)
+	{
+		VulkanMesh* pMesh = &mesh;
+		pWorkers->Enqueue([pMesh, frustum, cameraPosition, pixelsPerUnit]() { pMesh->UpdateVisibility(frustum, cameraPosition, pixelsPerUnit); });
+	}
+
+	for (VulkanPagedMesh* pPagedMesh : m_ListPagedMeshes)
+	{
+		pWorkers->Enqueue([pPagedMesh, frustum, cameraPosition, pixelsPerUnit]() { pPagedMesh->UpdateVisibility(frustum, cameraPosition, pixelsPerUnit); });
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanModel::GetTriangleCounts(uint32_t& outSubmitted, uint32_t& outTotal) const
+{
+	for (const VulkanMesh& mesh : m_ListMeshes)
+	{
+		outSubmitted += mesh.m_uiVisibleIndexCount / 3;
+		outTotal += mesh.GetNumLods() == 0 ? 0 : mesh.GetLods()[0].indexCount / 3;
+	}
+
+	for (const VulkanPagedMesh* pPagedMesh : m_ListPagedMeshes)
+	{
+		outSubmitted += pPagedMesh->GetNumVisibleTriangles();
+		outTotal += pPagedMesh->GetNumTriangles();
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Per pass, depth prepass issues the same ones again!
+uint32_t VulkanModel::GetDrawCallCount() const
+{
+	uint32_t count = 0;
+	for (const VulkanMesh& mesh : m_ListMeshes)
+	{
+		count += static_cast<uint32_t>(mesh.m_ListVisibleRanges.size());
+	}
+
+	for (const VulkanPagedMesh* pPagedMesh : m_ListPagedMeshes)
+	{
+		count += pPagedMesh->GetNumVisiblePages();
 	}
+
+	return count;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -346,6 +563,14 @@ void VulkanModel::Update(const Camera* pCamera, float dt)
 	m_pShaderDataBuffer->shaderData.matWorld = glm::rotate(m_pShaderDataBuffer->shaderData.matWorld, m_fRotation, m_vecRotationAxis);
 	m_pShaderDataBuffer->shaderData.matWorld = glm::scale(m_pShaderDataBuffer->shaderData.matWorld, m_vecScale);
 
+	// World space bounding sphere for texture streaming priority
+	glm::vec3 boundsCenter = (m_vecBoundsMin + m_vecBoundsMax) * 0.5f;
+	glm::vec3 boundsExtent = (m_vecBoundsMax - m_vecBoundsMin) * 0.5f;
+	float maxScale = glm::max(glm::abs(m_vecScale.x), glm::max(glm::abs(m_vecScale.y), glm::abs(m_vecScale.z)));
+
+	m_StreamingBounds.center = glm::vec3(m_pShaderDataBuffer->shaderData.matWorld * glm::vec4(boundsCenter, 1.0f));
+	m_StreamingBounds.radius = glm::length(boundsExtent) * maxScale;
+
 	float aspect = (float)gWindowWidht/ (float)gWindowHeight;
 	m_pShaderDataBuffer->shaderData.matProjection = pCamera->m_matProjection;// glm::perspective(glm::radians(45.0f), aspect, 0.1f, 1000.0f);
 	m_pShaderDataBuffer->shaderData.matProjection[1][1] *= -1.0f;
@@ -356,6 +581,13 @@ void VulkanModel::Update(const Camera* pCamera, float dt)
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanModel::UpdateUniforms(const VulkanContext* pContext, uint32_t imageIndex)
 {
+	// Shared buffers stay mapped, several models live in the same memory!
+	if (!m_pShaderDataBuffer->listMappedData.empty())
+	{
+		memcpy(m_pShaderDataBuffer->listMappedData[imageIndex], &(m_pShaderDataBuffer->shaderData), sizeof(UniformData));
+		return;
+	}
+
 	void* data;
 	vkMapMemory(pContext->vkDevice, m_pShaderDataBuffer->listDeviceMemory[imageIndex], 0, sizeof(UniformData), 0, &data);
 	memcpy(data, &(m_pShaderDataBuffer->shaderData), sizeof(UniformData));
@@ -365,8 +597,10 @@ void VulkanModel::UpdateUniforms(const VulkanContext* pContext, uint32_t imageIn
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanModel::Cleanup(VulkanContext* pContext)
 {
+	if (m_bSharedResources)
+		return;
+
 	m_pShaderDataBuffer->Cleanup(pContext);
-	m_pMaterial->Cleanup(pContext);
 
 	std::vector<VulkanMesh>::iterator iter = m_ListMeshes.begin();
 	for (; iter != m_ListMeshes.end(); iter++)
@@ -374,8 +608,47 @@ void VulkanModel::Cleanup(VulkanContext* pContext)
 		(*iter).Cleanup(pContext);
 	}
 
-	vkDestroyDescriptorPool(pContext->vkDevice, m_vkDescriptorPool, nullptr);
-	vkDestroyDescriptorSetLayout(pContext->vkDevice, m_vkDescriptorSetLayout, nullptr);
+	for (VulkanPagedMesh* pPagedMesh : m_ListPagedMeshes)
+	{
+		pPagedMesh->Cleanup(pContext);
+	}
+
+	// Sets go with the pool, a shared one once its last instance is gone
+	if (m_pSharedMaterial)
+	{
+		if (m_pSharedMaterial->Release(pContext))
+			SAFE_DELETE(m_pSharedMaterial);
+
+		m_pSharedMaterial = nullptr;
+		m_pMaterial = nullptr;
+	}
+	else
+	{
+		m_pMaterial->Cleanup(pContext);
+		vkDestroyDescriptorPool(pContext->vkDevice, m_vkDescriptorPool, nullptr);
+	}
+
+	m_vkDescriptorPool = VK_NULL_HANDLE;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Main thread, like VulkanModel::Cleanup(). No frame in flight may still use the sets or textures once the last goes!
+bool SharedModelMaterial::Release(const VulkanContext* pContext)
+{
+	if (--uiRefCount > 0)
+		return false;
+
+	if (pMaterial)
+	{
+		pMaterial->Cleanup(pContext);
+		SAFE_DELETE(pMaterial);
+	}
+
+	if (vkDescriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(pContext->vkDevice, vkDescriptorPool, nullptr);
+
+	vkDescriptorPool = VK_NULL_HANDLE;
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -386,20 +659,20 @@ void VulkanModel::CleanupOnWindowsResize(VulkanContext* pContext)
 //---------------------------------------------------------------------------------------------------------------------
 bool VulkanModel::SetupDescriptors(const VulkanContext* pContext)
 {
-	// Set default material info!
-	m_pShaderDataBuffer->shaderData.albedoColor = glm::vec4(1);
-	m_pShaderDataBuffer->shaderData.emissionColor = glm::vec4(1);
-	m_pShaderDataBuffer->shaderData.hasTextureAEN = glm::vec3(1, 0, 0);
-	m_pShaderDataBuffer->shaderData.hasTextureRMO = glm::vec3(0);
-	m_pShaderDataBuffer->shaderData.metalness = 0.0f;
-	m_pShaderDataBuffer->shaderData.occlusion = 1.0f;
-	m_pShaderDataBuffer->shaderData.roughness = 1.0f;
+	SetDefaultMaterial();
 
-	// Descriptor Pool
-	CHECK(CreateDescriptorPool(pContext));
+	// Descriptor Pool, shared one is created with the first instance & has room for all of them
+	if (!m_pSharedMaterial)
+	{
+		CHECK(CreateDescriptorPool(pContext, 1, &m_vkDescriptorPool));
+	}
+	else
+	{
+		if (m_pSharedMaterial->vkDescriptorPool == VK_NULL_HANDLE)
+			CHECK(CreateDescriptorPool(pContext, m_pSharedMaterial->uiNumInstances, &m_pSharedMaterial->vkDescriptorPool));
 
-	// Descriptor Set Layout
-	CHECK(CreateDescriptorSetLayout(pContext));
+		m_vkDescriptorPool = m_pSharedMaterial->vkDescriptorPool;
+	}
 
 	// Descriptor Sets
 	CHECK(CreateDescriptorSets(pContext));
@@ -408,34 +681,47 @@ bool VulkanModel::SetupDescriptors(const VulkanContext* pContext)
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanModel::CreateDescriptorPool(const VulkanContext* pContext)
+void VulkanModel::SetDefaultMaterial()
+{
+	m_pShaderDataBuffer->shaderData.albedoColor = glm::vec4(1);
+	m_pShaderDataBuffer->shaderData.emissionColor = glm::vec4(1);
+	m_pShaderDataBuffer->shaderData.hasTextureAEN = glm::vec3(1, 0, 0);
+	m_pShaderDataBuffer->shaderData.hasTextureRMO = glm::vec3(0);
+	m_pShaderDataBuffer->shaderData.metalness = 0.0f;
+	m_pShaderDataBuffer->shaderData.occlusion = 1.0f;
+	m_pShaderDataBuffer->shaderData.roughness = 1.0f;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Room for the sets of numModels models using this model's material
+bool VulkanModel::CreateDescriptorPool(const VulkanContext* pContext, uint32_t numModels, VkDescriptorPool* pOutPool)
 {
 	std::array<VkDescriptorPoolSize, 2> arrDescriptorPoolSize = {};
 
 	//-- Uniform buffers
 	arrDescriptorPoolSize[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	arrDescriptorPoolSize[0].descriptorCount = pContext->uiNumSwapchainImages;
+	arrDescriptorPoolSize[0].descriptorCount = pContext->uiNumSwapchainImages * numModels;
 
-	//-- Texture samplers
+	//-- Texture samplers, every set binds all of them!
 	arrDescriptorPoolSize[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	arrDescriptorPoolSize[1].descriptorCount = m_pMaterial->m_uiNumTextures;
+	arrDescriptorPoolSize[1].descriptorCount = m_pMaterial->m_uiNumTextures * pContext->uiNumSwapchainImages * numModels;
 
 	VkDescriptorPoolCreateInfo poolCreateInfo = {};
 	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolCreateInfo.maxSets = pContext->uiNumSwapchainImages + m_pMaterial->m_uiNumTextures;
+	poolCreateInfo.maxSets = (pContext->uiNumSwapchainImages + m_pMaterial->m_uiNumTextures) * numModels;
 	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(arrDescriptorPoolSize.size());
 	poolCreateInfo.pPoolSizes = arrDescriptorPoolSize.data();
 
 	// Create Descriptor Pool!
-	VK_CHECK(vkCreateDescriptorPool(pContext->vkDevice, &poolCreateInfo, nullptr, &m_vkDescriptorPool));
+	VK_CHECK(vkCreateDescriptorPool(pContext->vkDevice, &poolCreateInfo, nullptr, pOutPool));
 
 	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanModel::CreateDescriptorSetLayout(const VulkanContext* pContext)
+bool VulkanModel::CreateDescriptorSetLayout(const VulkanContext* pContext, VkDescriptorSetLayout* pOutLayout)
 {
-	std::array<VkDescriptorSetLayoutBinding, 7> layoutBindings;
+	std::array<VkDescriptorSetLayoutBinding, 5> layoutBindings;
 
 	// Uniform buffer
 	layoutBindings[0].binding = 0;
@@ -451,7 +737,7 @@ bool VulkanModel::CreateDescriptorSetLayout(const VulkanContext* pContext)
 	layoutBindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindings[1].pImmutableSamplers = nullptr;
 
-	// Metalness texture
+	// Occlusion | Roughness | Metalness texture
 	layoutBindings[2].binding = 2;
 	layoutBindings[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindings[2].descriptorCount = 1;
@@ -465,33 +751,19 @@ bool VulkanModel::CreateDescriptorSetLayout(const VulkanContext* pContext)
 	layoutBindings[3].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindings[3].pImmutableSamplers = nullptr;
 
-	// Roughness texture
+	// Emission texture
 	layoutBindings[4].binding = 4;
 	layoutBindings[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindings[4].descriptorCount = 1;
 	layoutBindings[4].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindings[4].pImmutableSamplers = nullptr;
 
-	// Occlusion texture
-	layoutBindings[5].binding = 5;
-	layoutBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	layoutBindings[5].descriptorCount = 1;
-	layoutBindings[5].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindings[5].pImmutableSamplers = nullptr;
-
-	// Emission texture
-	layoutBindings[6].binding = 6;
-	layoutBindings[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	layoutBindings[6].descriptorCount = 1;
-	layoutBindings[6].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindings[6].pImmutableSamplers = nullptr;
-
 	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
 	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutCreateInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
 	layoutCreateInfo.pBindings = layoutBindings.data();
 
-	VK_CHECK(vkCreateDescriptorSetLayout(pContext->vkDevice, &layoutCreateInfo, nullptr, &m_vkDescriptorSetLayout));
+	VK_CHECK(vkCreateDescriptorSetLayout(pContext->vkDevice, &layoutCreateInfo, nullptr, pOutLayout));
 
 	return true;
 }
@@ -503,7 +775,7 @@ bool VulkanModel::CreateDescriptorSets(const VulkanContext* pContext)
 	m_ListDescriptorSets.resize(pContext->uiNumSwapchainImages);
 
 	// create copy of descriptor set layout for each swap chain image!
-	std::vector<VkDescriptorSetLayout> listSetLayouts(pContext->uiNumSwapchainImages, m_vkDescriptorSetLayout);
+	std::vector<VkDescriptorSetLayout> listSetLayouts(pContext->uiNumSwapchainImages, pContext->vkModelDescriptorSetLayout);
 
 	VkDescriptorSetAllocateInfo setAllocInfo = {};
 	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -513,125 +785,138 @@ bool VulkanModel::CreateDescriptorSets(const VulkanContext* pContext)
 
 	VK_CHECK(vkAllocateDescriptorSets(pContext->vkDevice, &setAllocInfo, m_ListDescriptorSets.data()));
 
+	m_ListDescriptorResidency.resize(pContext->uiNumSwapchainImages);
+
 	//-- Update all the descriptor set bindings!
 	for (uint16_t i = 0; i < pContext->uiNumSwapchainImages; i++)
 	{
-		//-- Uniform buffer
-		VkDescriptorBufferInfo ubBufferInfo = {};
-		ubBufferInfo.buffer = m_pShaderDataBuffer->listBuffers[i];
-		ubBufferInfo.offset = 0;
-		ubBufferInfo.range = sizeof(UniformData);
-
-		VkWriteDescriptorSet ubWriteSet = {};
-		ubWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		ubWriteSet.descriptorCount = 1;
-		ubWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		ubWriteSet.dstArrayElement = 0;
-		ubWriteSet.dstBinding = 0;
-		ubWriteSet.dstSet = m_ListDescriptorSets[i];
-		ubWriteSet.pBufferInfo = &ubBufferInfo;
-
-		//-- Albedo Texture
-		VkDescriptorImageInfo albedoImageInfo = {};
-		albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		albedoImageInfo.imageView = m_pMaterial->m_pTextureAlbedo->getVkImageView();
-		albedoImageInfo.sampler = m_pMaterial->m_pTextureAlbedo->getVkSampler();
-
-		VkWriteDescriptorSet albedoWriteSet = {};
-		albedoWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		albedoWriteSet.dstSet = m_ListDescriptorSets[i];
-		albedoWriteSet.dstBinding = 1;
-		albedoWriteSet.dstArrayElement = 0;
-		albedoWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		albedoWriteSet.descriptorCount = 1;
-		albedoWriteSet.pImageInfo = &albedoImageInfo;
-
-		//-- Metalness Texture
-		VkDescriptorImageInfo metallicImageInfo = {};
-		metallicImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		metallicImageInfo.imageView = m_pMaterial->m_pTextureMetalness->getVkImageView();
-		metallicImageInfo.sampler = m_pMaterial->m_pTextureMetalness->getVkSampler();
-
-		VkWriteDescriptorSet metallicWriteSet = {};
-		metallicWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		metallicWriteSet.dstSet = m_ListDescriptorSets[i];
-		metallicWriteSet.dstBinding = 2;
-		metallicWriteSet.dstArrayElement = 0;
-		metallicWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		metallicWriteSet.descriptorCount = 1;
-		metallicWriteSet.pImageInfo = &metallicImageInfo;
-
-		//-- Normal Texture
-		VkDescriptorImageInfo normalImageInfo = {};
-		normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		normalImageInfo.imageView = m_pMaterial->m_pTextureNormal->getVkImageView();
-		normalImageInfo.sampler = m_pMaterial->m_pTextureNormal->getVkSampler();
-
-		VkWriteDescriptorSet normalWriteSet = {};
-		normalWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		normalWriteSet.dstSet = m_ListDescriptorSets[i];
-		normalWriteSet.dstBinding = 3;
-		normalWriteSet.dstArrayElement = 0;
-		normalWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		normalWriteSet.descriptorCount = 1;
-		normalWriteSet.pImageInfo = &normalImageInfo;
-
-		//-- Roughness Texture
-		VkDescriptorImageInfo roughnessImageInfo = {};
-		roughnessImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		roughnessImageInfo.imageView = m_pMaterial->m_pTextureRoughness->getVkImageView();
-		roughnessImageInfo.sampler = m_pMaterial->m_pTextureRoughness->getVkSampler();
-
-		VkWriteDescriptorSet roughnessWriteSet = {};
-		roughnessWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		roughnessWriteSet.dstSet = m_ListDescriptorSets[i];
-		roughnessWriteSet.dstBinding = 4;
-		roughnessWriteSet.dstArrayElement = 0;
-		roughnessWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		roughnessWriteSet.descriptorCount = 1;
-		roughnessWriteSet.pImageInfo = &roughnessImageInfo;
-
-		//-- Occlusion Texture
-		VkDescriptorImageInfo occlusionImageInfo = {};
-		occlusionImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		occlusionImageInfo.imageView = m_pMaterial->m_pTextureOcclusion->getVkImageView();
-		occlusionImageInfo.sampler = m_pMaterial->m_pTextureOcclusion->getVkSampler();
-
-		VkWriteDescriptorSet occlusionWriteSet = {};
-		occlusionWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		occlusionWriteSet.dstSet = m_ListDescriptorSets[i];
-		occlusionWriteSet.dstBinding = 5;
-		occlusionWriteSet.dstArrayElement = 0;
-		occlusionWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		occlusionWriteSet.descriptorCount = 1;
-		occlusionWriteSet.pImageInfo = &occlusionImageInfo;
-
-		//-- Emission Texture
-		VkDescriptorImageInfo emissionImageInfo = {};
-		emissionImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		emissionImageInfo.imageView = m_pMaterial->m_pTextureEmission->getVkImageView();
-		emissionImageInfo.sampler = m_pMaterial->m_pTextureEmission->getVkSampler();
-
-		VkWriteDescriptorSet emissionWriteSet = {};
-		emissionWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		emissionWriteSet.dstSet = m_ListDescriptorSets[i];
-		emissionWriteSet.dstBinding = 6;
-		emissionWriteSet.dstArrayElement = 0;
-		emissionWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		emissionWriteSet.descriptorCount = 1;
-		emissionWriteSet.pImageInfo = &emissionImageInfo;
-
-		// List of all Descriptor set writes!
-		std::vector<VkWriteDescriptorSet> listWriteSets = { ubWriteSet, albedoWriteSet, metallicWriteSet, normalWriteSet, 
-															roughnessWriteSet, occlusionWriteSet, emissionWriteSet };
-
-		// Update the descriptor sets with buffers/binding info
-		vkUpdateDescriptorSets(pContext->vkDevice, static_cast<uint32_t>(listWriteSets.size()), listWriteSets.data(), 0, nullptr);
+		WriteDescriptorSet(pContext, i);
 	}
 
 	return true;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanModel::WriteDescriptorSet(const VulkanContext* pContext, uint32_t index)
+{
+	DescriptorSetWrites writes;
+	RecordDescriptorSetWrites(index, writes);
+
+	// Update the descriptor sets with buffers/binding info
+	vkUpdateDescriptorSets(pContext->vkDevice, static_cast<uint32_t>(writes.arrWrites.size()), writes.arrWrites.data(), 0, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanModel::RecordDescriptorSetWrites(uint32_t index, DescriptorSetWrites& outWrites)
+{
+	// Remember which textures were resident, so we know when to re-write set with streamed in textures!
+	m_ListDescriptorResidency[index] = GetTextureResidencyMask();
+
+	//-- Uniform buffer
+	outWrites.bufferInfo = {};
+	outWrites.bufferInfo.buffer = m_pShaderDataBuffer->listBuffers[index];
+	outWrites.bufferInfo.offset = m_pShaderDataBuffer->vkOffset;
+	outWrites.bufferInfo.range = sizeof(UniformData);
+
+	VkWriteDescriptorSet& ubWriteSet = outWrites.arrWrites[0];
+	ubWriteSet = {};
+	ubWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	ubWriteSet.descriptorCount = 1;
+	ubWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	ubWriteSet.dstArrayElement = 0;
+	ubWriteSet.dstBinding = 0;
+	ubWriteSet.dstSet = m_ListDescriptorSets[index];
+	ubWriteSet.pBufferInfo = &outWrites.bufferInfo;
+
+	//-- Albedo, Occlusion | Roughness | Metalness, Normal & Emission textures, bindings 1 to 4!
+	const VulkanTexture* arrTextures[] = { m_pMaterial->m_pTextureAlbedo, m_pMaterial->m_pTextureORM, m_pMaterial->m_pTextureNormal, m_pMaterial->m_pTextureEmission };
+
+	for (uint32_t i = 0; i < outWrites.arrImageInfos.size(); i++)
+	{
+		VkDescriptorImageInfo& imageInfo = outWrites.arrImageInfos[i];
+		imageInfo = {};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = arrTextures[i]->getVkImageView();
+		imageInfo.sampler = arrTextures[i]->getVkSampler();
+
+		VkWriteDescriptorSet& imageWriteSet = outWrites.arrWrites[i + 1];
+		imageWriteSet = {};
+		imageWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		imageWriteSet.dstSet = m_ListDescriptorSets[index];
+		imageWriteSet.dstBinding = i + 1;
+		imageWriteSet.dstArrayElement = 0;
+		imageWriteSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		imageWriteSet.descriptorCount = 1;
+		imageWriteSet.pImageInfo = &imageInfo;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Textures stream in over several frames. Once residency changes, set for this swapchain image is re-written in one
+// go, so all bindings switch from placeholders at the same time. Runs once per frame before recording starts, a set
+// can't be written any more once a command buffer being recorded has it bound!
+void VulkanModel::RefreshTextureDescriptors(const VulkanContext* pContext, uint32_t index)
+{
+	if (m_ListDescriptorResidency[index] != GetTextureResidencyMask())
+	{
+		WriteDescriptorSet(pContext, index);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanModel::IsStreaming() const
+{
+	const VulkanTexture* arrTextures[] = { m_pMaterial->m_pTextureAlbedo, m_pMaterial->m_pTextureORM, m_pMaterial->m_pTextureNormal, m_pMaterial->m_pTextureEmission };
+
+	return std::any_of(std::begin(arrTextures), std::end(arrTextures), [](const VulkanTexture* pTexture) { return pTexture && pTexture->IsStreaming(); });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VkDeviceSize VulkanModel::GetResidentSize(CountedResources& counted) const
+{
+	VkDeviceSize size = 0;
+
+	for (const VulkanMesh& mesh : m_ListMeshes)
+	{
+		if (counted.setBuffers.insert(mesh.m_vkVertexBuffer).second)
+			size += mesh.GetGeometrySize();
+	}
+
+	// Pages resident in the shared pool right now
+	for (const VulkanPagedMesh* pPagedMesh : m_ListPagedMeshes)
+	{
+		size += pPagedMesh->GetResidentSize();
+	}
+
+	const VulkanTexture* arrTextures[] = { m_pMaterial->m_pTextureAlbedo, m_pMaterial->m_pTextureORM, m_pMaterial->m_pTextureNormal, m_pMaterial->m_pTextureEmission };
+	for (const VulkanTexture* pTexture : arrTextures)
+	{
+		if (pTexture && pTexture->IsResident() && counted.setTextures.insert(pTexture).second)
+			size += pTexture->GetDeviceSize();
+	}
+
+	return size;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanModel::GetTextureResidencyMask() const
+{
+	uint32_t mask = 0;
+
+	mask |= m_pMaterial->m_pTextureAlbedo->IsResident()		? (1 << 0) : 0;
+	mask |= m_pMaterial->m_pTextureORM->IsResident()		? (1 << 1) : 0;
+	mask |= m_pMaterial->m_pTextureNormal->IsResident()		? (1 << 2) : 0;
+	mask |= m_pMaterial->m_pTextureEmission->IsResident()	? (1 << 3) : 0;
+
+	// Tail's view is swapped for the full chain's once the finer mips are in
+	mask |= m_pMaterial->m_pTextureAlbedo->IsFullyResident()	? (1 << 4) : 0;
+	mask |= m_pMaterial->m_pTextureORM->IsFullyResident()		? (1 << 5) : 0;
+	mask |= m_pMaterial->m_pTextureNormal->IsFullyResident()	? (1 << 6) : 0;
+	mask |= m_pMaterial->m_pTextureEmission->IsFullyResident()	? (1 << 7) : 0;
+
+	return mask;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void UniformDataBuffer::CreateUniformDataBuffers(const VulkanContext* pContext)
 {
@@ -652,7 +937,8 @@ void UniformDataBuffer::CreateUniformDataBuffers(const VulkanContext* pContext)
 //---------------------------------------------------------------------------------------------------------------------
 void UniformDataBuffer::Cleanup(const VulkanContext* pContext)
 {
-	for (uint16_t i = 0; i < pContext->uiNumSwapchainImages; i++)
+	// Nothing to destroy for shared ones!
+	for (size_t i = 0; i < listDeviceMemory.size(); i++)
 	{
 		vkDestroyBuffer(pContext->vkDevice, listBuffers[i], nullptr);
 		vkFreeMemory(pContext->vkDevice, listDeviceMemory[i], nullptr);
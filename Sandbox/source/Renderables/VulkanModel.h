@@ -2,14 +2,22 @@
 
 #include "glm/glm.hpp"
 #include "Renderer/Utility.h"
-#include "assimp/Importer.hpp"
-#include "assimp/postprocess.h"
-#include "assimp/scene.h"
+#include "Renderer/VertexLayout.h"
+#include "Renderer/VulkanTextureStreamer.h"
 
 class VulkanContext;
 class VulkanMaterial;
+class VulkanTexture;
 class VulkanMesh;
+class VulkanPagedMesh;
+class VulkanUploadBatch;
 class Camera;
+class ThreadPool;
+class CookedModel;
+class AsyncReadGroup;
+struct CookedMesh;
+struct CookedMaterial;
+struct SceneMaterial;
 
 //---------------------------------------------------------------------------------------------------------------------
 struct UniformData
@@ -43,6 +51,8 @@ struct UniformDataBuffer
 	{
 		listBuffers.clear();
 		listDeviceMemory.clear();
+		listMappedData.clear();
+		vkOffset = 0;
 	}
 
 	void						CreateUniformDataBuffers(const VulkanContext* pContext);
@@ -53,6 +63,65 @@ struct UniformDataBuffer
 
 	std::vector<VkBuffer>		listBuffers;
 	std::vector<VkDeviceMemory>	listDeviceMemory;
+
+	// Shared ones are a slice of someone else's persistently mapped buffers & own no memory, see VulkanSceneSnapshot
+	std::vector<uint8_t*>		listMappedData;					// already offset
+	VkDeviceSize				vkOffset;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Everything a model borrows instead of creating its own, see VulkanModel::CreateShared(). Owner keeps all of it alive,
+// writes the sets & destroys it all once the model is gone!
+struct SharedModelResources
+{
+	std::string							strName;
+	glm::vec3							vecBoundsMin;
+	glm::vec3							vecBoundsMax;
+	const VulkanMesh*					pMeshes;					// prototypes, model draws their geometry
+	uint32_t							uiNumMeshes;
+	VulkanMaterial*						pMaterial;
+	const VkBuffer*						pUniformBuffers;			// one per swapchain image
+	uint8_t* const*						ppUniformData;				// their mappings, not offset yet
+	VkDeviceSize						vkUniformOffset;			// model's slice, same in every one of them
+	const VkDescriptorSet*				pDescriptorSets;			// one per swapchain image
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Writes of one model's set for one swapchain image. They point at the infos next to them, so it can't move once it's
+// filled. Lets whoever owns many models' sets write all of them in one vkUpdateDescriptorSets(), see VulkanSceneSnapshot
+struct DescriptorSetWrites
+{
+	VkDescriptorBufferInfo					bufferInfo;
+	std::array<VkDescriptorImageInfo, 4>	arrImageInfos;			// albedo, ORM, normal & emission
+	std::array<VkWriteDescriptorSet, 5>		arrWrites;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Textures & descriptor pool the streamed instances of one scene model share, see SceneLoader. First instance to be
+// created requests the textures with its bounds & creates the pool, every instance only adds its own uniform buffers &
+// sets. Loader & each instance hold a reference, whoever lets go last destroys it!
+struct SharedModelMaterial
+{
+	SharedModelMaterial(uint32_t numInstances) : pMaterial(nullptr), vkDescriptorPool(VK_NULL_HANDLE), uiNumInstances(numInstances), uiRefCount(1), bFailed(false) {}
+
+	// True once the last reference is gone & everything is destroyed, caller deletes it then
+	bool								Release(const VulkanContext* pContext);
+
+	VulkanMaterial*						pMaterial;
+	VkDescriptorPool					vkDescriptorPool;			// room for every instance's sets, they're never freed one by one
+	uint32_t							uiNumInstances;
+	std::atomic<uint32_t>				uiRefCount;
+	bool								bFailed;					// first instance couldn't request the textures, the rest fail too
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// What GetResidentSize() already counted. Models pass the same one, so meshes & textures they share count once!
+struct CountedResources
+{
+	inline void							Clear()		{ setBuffers.clear(); setTextures.clear(); }
+
+	std::set<VkBuffer>					setBuffers;					// vertex buffers, see VulkanMeshCache
+	std::set<const VulkanTexture*>		setTextures;
 };
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -62,35 +131,85 @@ public:
 	VulkanModel();
 	~VulkanModel();
 
-	void								LoadModel(const VulkanContext* pContext, const std::string& filePath);
+	bool								LoadModel(const VulkanContext* pContext, const std::string& filePath);
+
+	// LoadModel() in two steps for streaming loaders, see SceneLoader: caller owns the batch & submits it after
+	bool								ReadModel(const VulkanContext* pContext, const std::string& filePath, VulkanUploadBatch* pBatch, bool bWaitForSpace = false);
+	bool								CreateModel(const VulkanContext* pContext, VulkanUploadBatch* pBatch, SharedModelMaterial* pSharedMaterial = nullptr);
+
+	// Nothing is allocated on the GPU, model only uses what it's handed. Cleanup() leaves all of it alone!
+	void								CreateShared(const VulkanContext* pContext, const SharedModelResources& resources);
+
+	// Set of one swapchain image as it should be written now, caller submits it. Shared models' sets are first written so!
+	void								RecordDescriptorSetWrites(uint32_t index, DescriptorSetWrites& outWrites);
+
+	// Scene's material overrides, after the model is created since that writes the defaults
+	void								ApplyMaterialOverrides(const SceneMaterial& material);
+
 	bool								SetupDescriptors(const VulkanContext* pContext);
+
+	// Once per frame, before this image's command buffer is recorded. Re-writes the set if textures streamed in since
+	void								RefreshTextureDescriptors(const VulkanContext* pContext, uint32_t index);
+
 	void								Render(const VulkanContext* pContext, uint32_t index);
+	void								RenderDepth(const VulkanContext* pContext, uint32_t index);
 	void								Update(const Camera* pCamera, float dt);
+	void								UpdateVisibility(const Camera* pCamera, ThreadPool* pWorkers);
+	void								GetTriangleCounts(uint32_t& outSubmitted, uint32_t& outTotal) const;
+	uint32_t							GetDrawCallCount() const;
 	void								UpdateUniforms(const VulkanContext* pContext, uint32_t imageIndex);
 	void								Cleanup(VulkanContext* pContext);
 	void								CleanupOnWindowsResize(VulkanContext* pContext);
 
+	// Every model's sets share one layout, renderer creates it for the pipeline layout
+	static bool							CreateDescriptorSetLayout(const VulkanContext* pContext, VkDescriptorSetLayout* pOutLayout);
+
+	inline const StreamingBounds*		GetStreamingBounds() const { return &m_StreamingBounds; }
+
+	// Streamer may still write into its textures while this is true, model can't be destroyed before. See WorldPartition!
+	bool								IsStreaming() const;
+
+	// GPU bytes behind the model: geometry & whatever textures are resident so far, unless someone already counted them
+	VkDeviceSize						GetResidentSize(CountedResources& counted) const;
+
 private:
-	void								LoadNode(const VulkanContext* pContext, aiNode* node, const aiScene* scene);
-	void								SetDefaultValues(const VulkanContext* pContext, aiTextureType eType);
-	bool								ExtractTextureFromMaterial(const VulkanContext* pContext, aiMaterial* pMaterial, aiTextureType eType);
-	void								LoadTextures(const VulkanContext* pContext, const aiScene* scene);
-	VulkanMesh							LoadMesh(const VulkanContext* pContext, aiMesh* mesh, const aiScene* scene);
-	bool								CreateDescriptorPool(const VulkanContext* pContext);
-	bool								CreateDescriptorSetLayout(const VulkanContext* pContext);
+	struct PendingMesh;
+	struct PendingLoad;
+
+	bool								LoadTextures(const VulkanContext* pContext, const std::vector<CookedMaterial>& listMaterials, bool bRequest);
+	void								ReadMesh(const VulkanContext* pContext, VulkanUploadBatch* pBatch, const CookedMesh& mesh, CookedModel* pCooked, AsyncReadGroup* pGroup, PendingMesh& outPending);
+	VulkanMesh							CreateMesh(const VulkanContext* pContext, VulkanUploadBatch* pBatch, const CookedMesh& mesh, PendingMesh& pending);
+	void								SetDefaultMaterial();
+	bool								CreateDescriptorPool(const VulkanContext* pContext, uint32_t numModels, VkDescriptorPool* pOutPool);
 	bool								CreateDescriptorSets(const VulkanContext* pContext);
+	void								WriteDescriptorSet(const VulkanContext* pContext, uint32_t index);
+	void								DrawMeshes(const VulkanContext* pContext, uint32_t index, bool bPositionsOnly);
+	uint32_t							GetTextureResidencyMask() const;
 
 public:
 	UniformDataBuffer*					m_pShaderDataBuffer;
 	VkDescriptorPool					m_vkDescriptorPool;
-	VkDescriptorSetLayout				m_vkDescriptorSetLayout;
 	std::vector<VkDescriptorSet>		m_ListDescriptorSets;
+	std::vector<uint32_t>				m_ListDescriptorResidency;		// Texture residency each set was last written with
 
 private:
 	std::vector<VulkanMesh>				m_ListMeshes;
+	std::vector<VulkanPagedMesh*>		m_ListPagedMeshes;				// registered with the page streamer, see VulkanPageStreamer
 	VulkanMaterial*						m_pMaterial;
+	PendingLoad*						m_pPendingLoad;					// between ReadModel() & CreateModel() only
+	bool								m_bSharedResources;				// see CreateShared()
+	SharedModelMaterial*				m_pSharedMaterial;				// material & descriptor pool are borrowed from it
 
 	std::string							m_strModelName;
+
+	// Model space bounds & their world space sphere, used to prioritize texture streaming!
+	glm::vec3							m_vecBoundsMin;
+	glm::vec3							m_vecBoundsMax;
+	StreamingBounds						m_StreamingBounds;
+
+	// Meshes taken from the mesh cache instead of uploaded, & the GPU memory that saved!
+	uint32_t							m_uiNumSharedMeshes;
+	VkDeviceSize						m_vkSharedGeometryBytes;
 	
 public:
 	// Transformations!
@@ -0,0 +1,268 @@
+#include "sandboxPCH.h"
+#include "VulkanPagedMesh.h"
+#include "CookedModel.h"
+#include "Renderer/VulkanContext.h"
+#include "Renderer/VulkanPageStreamer.h"
+#include "Core/Core.h"
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	inline bool IsRange(uint64_t first, uint64_t count, uint64_t total)
+	{
+		return first <= total && count <= total - first;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanPagedMesh::VulkanPagedMesh()
+{
+	m_pStreamer = nullptr;
+	m_strName.clear();
+	m_strFilePath.clear();
+	m_uiPayloadOffset = 0;
+	m_eVertexFormat = Helper::EVertexFormat::POSITION_NORMAL_TANGENT_UV;
+	m_uiNumTriangles = 0;
+	m_uiNumVisibleTriangles = 0;
+	m_vkResidentBytes = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanPagedMesh::~VulkanPagedMesh()
+{
+	m_pStreamer = nullptr;
+
+	m_ListPages.clear();
+	m_ListGroups.clear();
+	m_ListGroupParents.clear();
+	m_ListResidency.clear();
+	m_ListRoots.clear();
+	m_ListVisiblePages.clear();
+	m_ListRequests.clear();
+	m_ListRefined.clear();
+	m_ListRefinedGroups.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Tables come straight from the file, so every page is checked against the pool's slot size & the payload & every group
+// against the pages here. Nothing after this has to!
+bool VulkanPagedMesh::Create(const VulkanContext* pContext, const CookedModel& cooked, const CookedPagedMesh& mesh)
+{
+	if (!pContext->pPageStreamer || mesh.listPages.empty())
+		return false;
+
+	const uint64_t vertexSize = Helper::GetVertexSize(mesh.eVertexFormat);
+	const uint64_t numGroups = mesh.listGroups.size();
+
+	bool bValid = true;
+	uint64_t numInputs = 0;
+
+	for (size_t i = 0; bValid && i < mesh.listPages.size(); i++)
+	{
+		const ClusterPage& page = mesh.listPages[i];
+
+		bValid =	(page.uiSourceGroup == g_uiNoPageGroup || page.uiSourceGroup < numGroups) &&
+					(page.uiParentGroup == g_uiNoPageGroup || page.uiParentGroup < numGroups) &&
+					page.uiVertexCount > 0 && page.uiVertexCount <= Helper::g_uiClusterPageVertices &&
+					page.uiIndexCount > 0 && page.uiIndexCount % 3 == 0 && page.uiIndexCount <= Helper::g_uiClusterPageTriangles * 3 &&
+					page.uiIndexDataOffset >= page.uiVertexCount * vertexSize &&
+					IsRange(page.uiIndexDataOffset, page.uiIndexCount * sizeof(uint16_t), page.uiDataSize) &&
+					IsRange(page.uiDataOffset, page.uiDataSize, cooked.GetPayloadSize());
+
+		numInputs += page.uiParentGroup != g_uiNoPageGroup ? 1 : 0;
+	}
+
+	// Inputs are exactly the pages naming the group as parent, parents come after the group so walking back can't loop
+	for (size_t i = 0; bValid && i < numGroups; i++)
+	{
+		const ClusterPageGroup& group = mesh.listGroups[i];
+
+		bValid =	group.uiNumPages > 0 && IsRange(group.uiFirstPage, group.uiNumPages, mesh.listPages.size()) &&
+					IsRange(group.uiFirstParent, group.uiNumParents, mesh.listGroupParents.size());
+
+		for (uint32_t page = group.uiFirstPage; bValid && page < group.uiFirstPage + group.uiNumPages; page++)
+			bValid = mesh.listPages[page].uiParentGroup == i;
+
+		for (uint32_t parent = group.uiFirstParent; bValid && parent < group.uiFirstParent + group.uiNumParents; parent++)
+			bValid = mesh.listGroupParents[parent] > i && mesh.listGroupParents[parent] < numGroups;
+
+		numInputs -= bValid ? group.uiNumPages : 0;
+	}
+
+	if (!bValid || numInputs != 0)
+	{
+		LOG_ERROR("{0}: paged mesh {1} is corrupt, re-run the Cooker!", cooked.m_strName, mesh.strName);
+		return false;
+	}
+
+	m_strName = mesh.strName;
+	m_strFilePath = cooked.GetFilePath();
+	m_uiPayloadOffset = cooked.GetPayloadOffset();
+	m_eVertexFormat = mesh.eVertexFormat;
+	m_uiNumTriangles = mesh.uiNumTriangles;
+
+	m_ListPages = mesh.listPages;
+	m_ListGroups = mesh.listGroups;
+	m_ListGroupParents = mesh.listGroupParents;
+	m_ListResidency.assign(m_ListPages.size(), PageResidency());
+	m_ListRefined.assign(m_ListGroups.size(), 0);
+
+	FindRoots();
+
+	if (!pContext->pPageStreamer->RegisterMesh(pContext, this))
+		return false;
+
+	m_pStreamer = pContext->pPageStreamer;
+
+	LOG_DEBUG("{0}: paged mesh {1}, {2} triangles in {3} pages & {4} groups, {5} roots", cooked.m_strName, m_strName, m_uiNumTriangles, m_ListPages.size(),
+				m_ListGroups.size(), m_ListRoots.size());
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Roots are never evicted, they're what's drawn when nothing else is resident
+void VulkanPagedMesh::FindRoots()
+{
+	m_ListRoots.clear();
+
+	for (uint32_t i = 0; i < m_ListPages.size(); i++)
+	{
+		if (m_ListPages[i].uiParentGroup != g_uiNoPageGroup)
+			continue;
+
+		m_ListResidency[i].bPinned = true;
+		m_ListRoots.push_back(i);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Group's error is against the full mesh & only grows towards the roots, its sphere holds all of its inputs. So groups
+// are walked coarsest first & a group is only looked at once every group its outputs go into is refined: refining it
+// then swaps its outputs for its inputs without any crack. Projected error is the request's priority, biggest visible
+// error gets fixed first!
+void VulkanPagedMesh::UpdateVisibility(const Helper::Frustum& frustum, const glm::vec3& cameraPosition, float fPixelsPerUnit)
+{
+	m_ListVisiblePages.clear();
+	m_ListRequests.clear();
+	m_ListRefinedGroups.clear();
+	m_uiNumVisibleTriangles = 0;
+
+	const uint64_t frame = m_pStreamer->GetFrame();
+
+	// Wanted whether they're seen or not, they stand in for everything under them
+	for (uint32_t root : m_ListRoots)
+	{
+		if (m_ListResidency[root].eState == PageState::NOT_RESIDENT)
+			m_ListRequests.push_back({ root, std::numeric_limits<float>::max() });
+	}
+
+	std::fill(m_ListRefined.begin(), m_ListRefined.end(), 0);
+
+	for (size_t g = m_ListGroups.size(); g-- > 0;)
+	{
+		const ClusterPageGroup& group = m_ListGroups[g];
+
+		bool bParentsRefined = true;
+		for (uint32_t parent = group.uiFirstParent; bParentsRefined && parent < group.uiFirstParent + group.uiNumParents; parent++)
+			bParentsRefined = m_ListRefined[m_ListGroupParents[parent]] != 0;
+
+		if (!bParentsRefined || !Helper::IsSphereInFrustum(frustum, group.center, group.radius))
+			continue;
+
+		// Distance to the sphere rather than its center, like VulkanMesh::SelectLod() does with the mesh bounds
+		const float distance = glm::length(cameraPosition - group.center) - group.radius;
+		const float projectedError = distance > 0.0f ? group.fError / distance * fPixelsPerUnit : std::numeric_limits<float>::max();
+
+		if (projectedError <= Helper::g_fLodPixelError)
+			continue;
+
+		// Inputs replace the outputs only all together, resident ones are kept meanwhile so they aren't evicted while
+		// the others are still loading! Failed one never becomes resident, outputs stand in for good.
+		bool bResident = true;
+		for (uint32_t page = group.uiFirstPage; page < group.uiFirstPage + group.uiNumPages; page++)
+		{
+			PageResidency& residency = m_ListResidency[page];
+			if (residency.eState == PageState::RESIDENT)
+				residency.uiLastUsed = frame;
+			else if (residency.eState == PageState::NOT_RESIDENT)
+				m_ListRequests.push_back({ page, projectedError });
+
+			bResident &= residency.eState == PageState::RESIDENT;
+		}
+
+		if (bResident)
+		{
+			m_ListRefined[g] = 1;
+			m_ListRefinedGroups.push_back(static_cast<uint32_t>(g));
+		}
+	}
+
+	// Drawn pages are the roots & inputs of refined groups, unless the group they came out of is refined as well
+	for (uint32_t root : m_ListRoots)
+	{
+		AddVisiblePage(frustum, root, frame);
+	}
+
+	for (uint32_t g : m_ListRefinedGroups)
+	{
+		const ClusterPageGroup& group = m_ListGroups[g];
+		for (uint32_t page = group.uiFirstPage; page < group.uiFirstPage + group.uiNumPages; page++)
+		{
+			AddVisiblePage(frustum, page, frame);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanPagedMesh::AddVisiblePage(const Helper::Frustum& frustum, uint32_t index, uint64_t frame)
+{
+	const ClusterPage& page = m_ListPages[index];
+	if (page.uiSourceGroup != g_uiNoPageGroup && m_ListRefined[page.uiSourceGroup])
+		return;
+
+	PageResidency& residency = m_ListResidency[index];
+	if (residency.eState != PageState::RESIDENT || !Helper::IsSphereInFrustum(frustum, page.center, page.radius))
+		return;
+
+	residency.uiLastUsed = frame;
+
+	m_ListVisiblePages.push_back(index);
+	m_uiNumVisibleTriangles += page.uiIndexCount / 3;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Index buffer is the pool's, first index & vertex stream offsets pick the page's slot in it
+void VulkanPagedMesh::RecordDraws(const VulkanContext* pContext, VkCommandBuffer cmdBuffer, bool bPositionsOnly) const
+{
+	if (m_ListVisiblePages.empty())
+		return;
+
+	const VkBuffer vertexBuffer = m_pStreamer->GetVertexBuffer();
+	vkCmdBindIndexBuffer(cmdBuffer, m_pStreamer->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT16);
+
+	for (uint32_t index : m_ListVisiblePages)
+	{
+		const ClusterPage& page = m_ListPages[index];
+		const uint32_t slot = m_ListResidency[index].uiSlot;
+
+		VkBuffer vertexBuffers[] = { vertexBuffer, vertexBuffer };
+		VkDeviceSize offsets[] = { m_pStreamer->GetPositionsOffset(slot), m_pStreamer->GetAttributesOffset(slot) };
+		vkCmdBindVertexBuffers(cmdBuffer, 0, bPositionsOnly ? 1 : Helper::g_uiMaxVertexStreams, vertexBuffers, offsets);
+
+		// Every page has bounds of its own
+		vkCmdPushConstants(cmdBuffer, pContext->vkForwardRenderingPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Helper::QuantizationBounds), &page.quantization);
+
+		vkCmdDrawIndexed(cmdBuffer, page.uiIndexCount, 1, m_pStreamer->GetFirstIndex(slot), 0, 0);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanPagedMesh::Cleanup(VulkanContext* pContext)
+{
+	if (m_pStreamer)
+		m_pStreamer->UnregisterMesh(this);
+
+	m_pStreamer = nullptr;
+	m_ListVisiblePages.clear();
+}
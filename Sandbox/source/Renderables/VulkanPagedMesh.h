@@ -0,0 +1,100 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "Renderer/Utility.h"
+#include "Renderer/VertexLayout.h"
+#include "ClusterPageBuilder.h"
+
+class VulkanContext;
+class VulkanPageStreamer;
+class CookedModel;
+struct CookedPagedMesh;
+
+//---------------------------------------------------------------------------------------------------------------------
+enum class PageState : uint8_t
+{
+	NOT_RESIDENT,
+	LOADING,							// read & upload in flight, see VulkanPageStreamer
+	RESIDENT,
+	FAILED								// never asked for again, its parent group is never refined
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct PageResidency
+{
+	PageResidency() : eState(PageState::NOT_RESIDENT), uiSlot(0), uiLastUsed(0), bPinned(false) {}
+
+	PageState							eState;
+	uint32_t							uiSlot;							// in the streamer's pool, while loading or resident
+	uint64_t							uiLastUsed;						// streamer frame it was last visited in
+	bool								bPinned;						// root, never evicted
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct PageRequest
+{
+	uint32_t							uiPage;
+	float								fPriority;						// projected error of the group it refines, in pixels
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runtime side of a cooked paged mesh. Only the page & group tables live on the CPU, page geometry streams into the page
+// pool on demand. Every frame groups are walked from the coarsest: a group too coarse for the screen is refined once all
+// of its input pages are resident & every group its outputs go into is refined too, till then its outputs are drawn &
+// its inputs are requested. Whole groups switch at once, so whatever is resident gives a crack free cut & the mesh never
+// has holes. Roots are pinned, so at least the coarsest cut is always there!
+class VulkanPagedMesh
+{
+	friend class VulkanPageStreamer;
+
+public:
+	VulkanPagedMesh();
+	~VulkanPagedMesh();
+
+	// Keeps the tables & where the payload is, cooked model isn't needed after this. Registers with the streamer, fails
+	// when the pool can't hold the roots next to the ones already pinned!
+	bool								Create(const VulkanContext* pContext, const CookedModel& cooked, const CookedPagedMesh& mesh);
+
+	// Picks the pages to draw & requests missing ones. Safe to run from worker threads, only touches this mesh!
+	void								UpdateVisibility(const Helper::Frustum& frustum, const glm::vec3& cameraPosition, float fPixelsPerUnit);
+
+	// Caller binds the pipeline & descriptor set, pages only differ in their pool slot & quantization bounds
+	void								RecordDraws(const VulkanContext* pContext, VkCommandBuffer cmdBuffer, bool bPositionsOnly) const;
+
+	// Resident pages go back to the pool right away, no frame in flight may still draw the mesh!
+	void								Cleanup(VulkanContext* pContext);
+
+	inline Helper::EVertexFormat		GetVertexFormat() const			{ return m_eVertexFormat; }
+	inline uint32_t						GetNumTriangles() const			{ return m_uiNumTriangles; }
+	inline uint32_t						GetNumVisibleTriangles() const	{ return m_uiNumVisibleTriangles; }
+	inline uint32_t						GetNumVisiblePages() const		{ return static_cast<uint32_t>(m_ListVisiblePages.size()); }
+	inline VkDeviceSize					GetResidentSize() const			{ return m_vkResidentBytes; }
+	inline uint32_t						GetNumRoots() const				{ return static_cast<uint32_t>(m_ListRoots.size()); }
+
+private:
+	void								FindRoots();
+	void								AddVisiblePage(const Helper::Frustum& frustum, uint32_t index, uint64_t frame);
+
+private:
+	VulkanPageStreamer*					m_pStreamer;
+	std::string							m_strName;
+	std::string							m_strFilePath;
+	uint64_t							m_uiPayloadOffset;
+	Helper::EVertexFormat				m_eVertexFormat;
+	uint32_t							m_uiNumTriangles;
+
+	std::vector<ClusterPage>			m_ListPages;
+	std::vector<ClusterPageGroup>		m_ListGroups;
+	std::vector<uint32_t>				m_ListGroupParents;
+	std::vector<PageResidency>			m_ListResidency;				// main thread only, see VulkanPageStreamer
+	std::vector<uint32_t>				m_ListRoots;					// pages simplified in no group
+
+	// Written by UpdateVisibility(), read by the streamer & the draws after it
+	std::vector<uint32_t>				m_ListVisiblePages;
+	std::vector<PageRequest>			m_ListRequests;
+	std::vector<uint8_t>				m_ListRefined;					// per group, scratch
+	std::vector<uint32_t>				m_ListRefinedGroups;			// scratch
+	uint32_t							m_uiNumVisibleTriangles;
+
+	VkDeviceSize						m_vkResidentBytes;
+};
@@ -0,0 +1,323 @@
+#include "sandboxPCH.h"
+#include "VulkanSceneSnapshot.h"
+#include "VulkanModel.h"
+#include "Renderer/VulkanContext.h"
+#include "Renderer/VulkanMaterial.h"
+#include "Renderer/VulkanUploadBatch.h"
+#include "World/SceneSnapshot.h"
+#include "Core/Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanSceneSnapshot::VulkanSceneSnapshot()
+{
+	m_vkVertexBuffer = VK_NULL_HANDLE;
+	m_vkVertexBufferMemory = VK_NULL_HANDLE;
+	m_vkIndexBuffer = VK_NULL_HANDLE;
+	m_vkIndexBufferMemory = VK_NULL_HANDLE;
+	m_ListMeshes.clear();
+	m_ListMaterials.clear();
+	m_ListUniformBuffers.clear();
+	m_ListUniformMemory.clear();
+	m_ListUniformData.clear();
+	m_vkUniformStride = 0;
+	m_vkDescriptorPool = VK_NULL_HANDLE;
+	m_ListDescriptorSets.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanSceneSnapshot::~VulkanSceneSnapshot()
+{
+	for (VulkanMaterial* pMaterial : m_ListMaterials)
+	{
+		SAFE_DELETE(pMaterial);
+	}
+
+	m_ListMaterials.clear();
+	m_ListMeshes.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanSceneSnapshot::Create(const VulkanContext* pContext, const SceneSnapshot& snapshot, std::vector<VulkanModel*>& outListModels)
+{
+	const Helper::SceneSnapshotHeader& header = snapshot.GetHeader();
+	if (header.uiNumInstances == 0)
+	{
+		LOG_WARNING("Scene snapshot has no instances, nothing to load");
+		return true;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	CHECK(CreateGeometry(pContext, snapshot));
+	CHECK(CreateUniformBuffers(pContext, header.uiNumInstances));
+	CHECK(CreateDescriptorSets(pContext, header.uiNumInstances));
+	CHECK(CreateModels(pContext, snapshot, outListModels));
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	LOG_INFO("Scene snapshot: {0} instances, {1} meshes, {2:.2f} MB geometry in {3:.2f} ms", header.uiNumInstances, header.uiNumMeshes,
+				(header.uiVertexDataSize + header.uiIndexDataSize) / (1024.0f * 1024.0f), elapsedMs);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Vertex & index blocks go into their buffers as they are, one copy each. Meshes only point into them!
+bool VulkanSceneSnapshot::CreateGeometry(const VulkanContext* pContext, const SceneSnapshot& snapshot)
+{
+	const Helper::SceneSnapshotHeader& header = snapshot.GetHeader();
+	if (header.uiNumMeshes == 0)
+		return true;
+
+	const VkDeviceSize vertexSize = header.uiVertexDataSize;
+	const VkDeviceSize indexSize = header.uiIndexDataSize;
+
+	CHECK(pContext->CreateBuffer(vertexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+									&m_vkVertexBuffer, &m_vkVertexBufferMemory));
+	CHECK(pContext->CreateBuffer(indexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+									&m_vkIndexBuffer, &m_vkIndexBufferMemory));
+
+	// Both blocks straight from the mapping into one staging allocation & one submit!
+	VulkanUploadBatch batch;
+	bool bUploaded = batch.Begin(pContext, vertexSize + indexSize + 32);
+	if (bUploaded)
+	{
+		VkDeviceSize vertexOffset = 0;
+		VkDeviceSize indexOffset = 0;
+		void* pVertices = batch.Reserve(vertexSize, &vertexOffset);
+		void* pIndices = batch.Reserve(indexSize, &indexOffset);
+
+		bUploaded = pVertices && pIndices;
+		if (bUploaded)
+		{
+			memcpy(pVertices, snapshot.GetVertexData(), static_cast<size_t>(vertexSize));
+			memcpy(pIndices, snapshot.GetIndexData(), static_cast<size_t>(indexSize));
+
+			batch.AddBufferCopy(m_vkVertexBuffer, vertexOffset, vertexSize);
+			batch.AddBufferCopy(m_vkIndexBuffer, indexOffset, indexSize);
+			bUploaded = batch.Submit(pContext);
+		}
+	}
+
+	batch.Cleanup(pContext);
+
+	if (!bUploaded)
+	{
+		LOG_ERROR("Failed to upload scene snapshot geometry!");
+		return false;
+	}
+
+	const SnapshotMesh* pMeshes = snapshot.GetMeshes();
+	const SnapshotLod* pLods = snapshot.GetLods();
+	const Meshlet* pMeshlets = snapshot.GetMeshlets();
+
+	m_ListMeshes.resize(header.uiNumMeshes);
+	for (uint32_t i = 0; i < header.uiNumMeshes; i++)
+	{
+		const SnapshotMesh& source = pMeshes[i];
+		VulkanMesh& mesh = m_ListMeshes[i];
+
+		mesh.m_uiVertexCount = source.uiVertexCount;
+		mesh.m_uiIndexCount = source.uiIndexCount;
+		mesh.m_vkIndexType = VulkanMesh::ChooseIndexType(source.uiVertexCount);
+		mesh.m_eVertexFormat = source.eVertexFormat;
+		mesh.m_QuantizationBounds = source.quantization;
+
+		mesh.m_vkVertexBuffer = m_vkVertexBuffer;
+		mesh.m_vkIndexBuffer = m_vkIndexBuffer;
+		mesh.m_vkVertexBufferOffset = source.uiVertexOffset;
+		mesh.m_vkIndexBufferOffset = source.uiIndexOffset;
+
+		for (uint32_t j = source.uiFirstLod; j < source.uiFirstLod + source.uiNumLods; j++)
+		{
+			const SnapshotLod& lod = pLods[j];
+			mesh.m_ListLods.push_back({ lod.uiFirstIndex, lod.uiIndexCount, lod.fError, std::vector<Meshlet>(pMeshlets + lod.uiFirstMeshlet, pMeshlets + lod.uiFirstMeshlet + lod.uiNumMeshlets) });
+		}
+
+		// Drawn whole till first visibility update
+		mesh.m_uiCurrentLod = 0;
+		mesh.m_uiVisibleIndexCount = mesh.m_ListLods[0].indexCount;
+		mesh.m_ListVisibleRanges.assign(1, { mesh.m_ListLods[0].firstIndex, mesh.m_ListLods[0].indexCount });
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Instance i's uniforms start at i * stride in every swapchain image's buffer, stride keeps each one bindable!
+bool VulkanSceneSnapshot::CreateUniformBuffers(const VulkanContext* pContext, uint32_t numInstances)
+{
+	VkPhysicalDeviceProperties deviceProps;
+	vkGetPhysicalDeviceProperties(pContext->vkPhysicalDevice, &deviceProps);
+
+	const VkDeviceSize alignment = std::max<VkDeviceSize>(deviceProps.limits.minUniformBufferOffsetAlignment, 1);
+	m_vkUniformStride = (sizeof(UniformData) + alignment - 1) / alignment * alignment;
+
+	m_ListUniformBuffers.resize(pContext->uiNumSwapchainImages, VK_NULL_HANDLE);
+	m_ListUniformMemory.resize(pContext->uiNumSwapchainImages, VK_NULL_HANDLE);
+	m_ListUniformData.resize(pContext->uiNumSwapchainImages, nullptr);
+
+	for (uint32_t i = 0; i < pContext->uiNumSwapchainImages; i++)
+	{
+		CHECK(pContext->CreateBuffer(	m_vkUniformStride * numInstances, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+										VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+										&m_ListUniformBuffers[i], &m_ListUniformMemory[i]));
+
+		void* pData = nullptr;
+		VK_CHECK(vkMapMemory(pContext->vkDevice, m_ListUniformMemory[i], 0, VK_WHOLE_SIZE, 0, &pData));
+		m_ListUniformData[i] = static_cast<uint8_t*>(pData);
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every set of every instance in one allocation, instead of a pool & an allocation per model!
+bool VulkanSceneSnapshot::CreateDescriptorSets(const VulkanContext* pContext, uint32_t numInstances)
+{
+	const uint32_t numSets = numInstances * pContext->uiNumSwapchainImages;
+
+	std::array<VkDescriptorPoolSize, 2> arrDescriptorPoolSize = {};
+
+	//-- Uniform buffers
+	arrDescriptorPoolSize[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	arrDescriptorPoolSize[0].descriptorCount = numSets;
+
+	//-- Albedo, ORM, normal & emission textures
+	arrDescriptorPoolSize[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	arrDescriptorPoolSize[1].descriptorCount = numSets * 4;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = numSets;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(arrDescriptorPoolSize.size());
+	poolCreateInfo.pPoolSizes = arrDescriptorPoolSize.data();
+
+	VK_CHECK(vkCreateDescriptorPool(pContext->vkDevice, &poolCreateInfo, nullptr, &m_vkDescriptorPool));
+
+	std::vector<VkDescriptorSetLayout> listSetLayouts(numSets, pContext->vkModelDescriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo setAllocInfo = {};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = m_vkDescriptorPool;
+	setAllocInfo.descriptorSetCount = numSets;
+	setAllocInfo.pSetLayouts = listSetLayouts.data();
+
+	m_ListDescriptorSets.resize(numSets);
+	VK_CHECK(vkAllocateDescriptorSets(pContext->vkDevice, &setAllocInfo, m_ListDescriptorSets.data()));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Material's textures are requested by its first instance, streaming priority follows that one. Models only point at
+// the prototype meshes, their LODs & meshlets aren't copied per instance!
+bool VulkanSceneSnapshot::CreateModels(const VulkanContext* pContext, const SceneSnapshot& snapshot, std::vector<VulkanModel*>& outListModels)
+{
+	const Helper::SceneSnapshotHeader& header = snapshot.GetHeader();
+	const SnapshotInstance* pInstances = snapshot.GetInstances();
+	const SnapshotModel* pModels = snapshot.GetModels();
+	const SnapshotMaterial* pMaterials = snapshot.GetMaterials();
+
+	m_ListMaterials.assign(header.uiNumMaterials, nullptr);
+
+	for (uint32_t i = 0; i < header.uiNumInstances; i++)
+	{
+		const SnapshotInstance& instance = pInstances[i];
+		const SnapshotModel& model = pModels[instance.uiModel];
+		const SnapshotMaterial& material = pMaterials[instance.uiMaterial];
+
+		VulkanModel* pModel = new VulkanModel();
+		pModel->m_vecPosition = instance.position;
+		pModel->m_vecRotationAxis = instance.rotationAxis;
+		pModel->m_fRotation = instance.rotation;
+		pModel->m_fCurrentAngle = instance.rotation;
+		pModel->m_vecScale = instance.scale;
+		pModel->m_bUpdate = instance.uiSpin != 0;
+
+		outListModels.push_back(pModel);
+
+		VulkanMaterial*& pMaterial = m_ListMaterials[instance.uiMaterial];
+		if (!pMaterial)
+		{
+			pMaterial = new VulkanMaterial();
+
+			auto GetTexture = [&](CookedTextureSlot slot) { return snapshot.GetString(material.arrTextures[static_cast<size_t>(slot)]); };
+
+			CHECK(pMaterial->LoadTexture(pContext, GetTexture(CookedTextureSlot::ALBEDO), TextureType::TEXTURE_ALBEDO, pModel->GetStreamingBounds()));
+			CHECK(pMaterial->LoadTexture(pContext, GetTexture(CookedTextureSlot::NORMAL), TextureType::TEXTURE_NORMAL, pModel->GetStreamingBounds()));
+			CHECK(pMaterial->LoadTexture(pContext, GetTexture(CookedTextureSlot::EMISSIVE), TextureType::TEXTURE_EMISSIVE, pModel->GetStreamingBounds()));
+			CHECK(pMaterial->LoadTexture(pContext, GetTexture(CookedTextureSlot::ORM), TextureType::TEXTURE_ORM, pModel->GetStreamingBounds()));
+		}
+
+		SharedModelResources resources;
+		resources.strName = snapshot.GetString(model.name);
+		resources.vecBoundsMin = model.vecBoundsMin;
+		resources.vecBoundsMax = model.vecBoundsMax;
+		resources.pMeshes = m_ListMeshes.data() + model.uiFirstMesh;
+		resources.uiNumMeshes = model.uiNumMeshes;
+		resources.pMaterial = pMaterial;
+		resources.pUniformBuffers = m_ListUniformBuffers.data();
+		resources.ppUniformData = m_ListUniformData.data();
+		resources.vkUniformOffset = m_vkUniformStride * i;
+		resources.pDescriptorSets = m_ListDescriptorSets.data() + i * pContext->uiNumSwapchainImages;
+
+		pModel->CreateShared(pContext, resources);
+		pModel->ApplyMaterialOverrides(material.overrides);
+	}
+
+	// Every set of every instance in one update, instead of one per model & swapchain image!
+	const size_t firstModel = outListModels.size() - header.uiNumInstances;
+	std::vector<DescriptorSetWrites> listSetWrites(m_ListDescriptorSets.size());
+	std::vector<VkWriteDescriptorSet> listWriteSets;
+	listWriteSets.reserve(listSetWrites.size() * listSetWrites[0].arrWrites.size());
+
+	for (uint32_t i = 0; i < header.uiNumInstances; i++)
+	{
+		for (uint32_t j = 0; j < pContext->uiNumSwapchainImages; j++)
+		{
+			DescriptorSetWrites& setWrites = listSetWrites[i * pContext->uiNumSwapchainImages + j];
+			outListModels[firstModel + i]->RecordDescriptorSetWrites(j, setWrites);
+			listWriteSets.insert(listWriteSets.end(), setWrites.arrWrites.begin(), setWrites.arrWrites.end());
+		}
+	}
+
+	vkUpdateDescriptorSets(pContext->vkDevice, static_cast<uint32_t>(listWriteSets.size()), listWriteSets.data(), 0, nullptr);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Sets go with the pool, mapped memory is unmapped when it's freed!
+void VulkanSceneSnapshot::Cleanup(const VulkanContext* pContext)
+{
+	for (VulkanMaterial* pMaterial : m_ListMaterials)
+	{
+		if (pMaterial)
+			pMaterial->Cleanup(pContext);
+	}
+
+	vkDestroyDescriptorPool(pContext->vkDevice, m_vkDescriptorPool, nullptr);
+	m_vkDescriptorPool = VK_NULL_HANDLE;
+	m_ListDescriptorSets.clear();
+
+	for (size_t i = 0; i < m_ListUniformBuffers.size(); i++)
+	{
+		vkDestroyBuffer(pContext->vkDevice, m_ListUniformBuffers[i], nullptr);
+		vkFreeMemory(pContext->vkDevice, m_ListUniformMemory[i], nullptr);
+	}
+
+	m_ListUniformBuffers.clear();
+	m_ListUniformMemory.clear();
+	m_ListUniformData.clear();
+
+	vkDestroyBuffer(pContext->vkDevice, m_vkVertexBuffer, nullptr);
+	vkFreeMemory(pContext->vkDevice, m_vkVertexBufferMemory, nullptr);
+	vkDestroyBuffer(pContext->vkDevice, m_vkIndexBuffer, nullptr);
+	vkFreeMemory(pContext->vkDevice, m_vkIndexBufferMemory, nullptr);
+
+	m_vkVertexBuffer = VK_NULL_HANDLE;
+	m_vkVertexBufferMemory = VK_NULL_HANDLE;
+	m_vkIndexBuffer = VK_NULL_HANDLE;
+	m_vkIndexBufferMemory = VK_NULL_HANDLE;
+	m_ListMeshes.clear();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Renderer/Utility.h"
+#include "Renderables/VulkanMesh.h"
+
+class VulkanContext;
+class VulkanModel;
+class VulkanMaterial;
+class SceneSnapshot;
+
+//---------------------------------------------------------------------------------------------------------------------
+// GPU side of a SceneSnapshot. Geometry of the whole scene goes into one vertex & one index buffer with one copy each,
+// uniforms of every instance live in one persistently mapped buffer per swapchain image & all descriptor sets come out
+// of one pool in one allocation. Materials are created once & shared by all of their instances. Models it creates only
+// borrow all of that (see VulkanModel::CreateShared()), Cleanup() once the GPU is done with them!
+class VulkanSceneSnapshot
+{
+public:
+	VulkanSceneSnapshot();
+	~VulkanSceneSnapshot();
+
+	// Blocks till geometry is on the GPU, snapshot's mapping isn't needed after. Appends one model per instance!
+	bool								Create(const VulkanContext* pContext, const SceneSnapshot& snapshot, std::vector<VulkanModel*>& outListModels);
+	void								Cleanup(const VulkanContext* pContext);
+
+private:
+	bool								CreateGeometry(const VulkanContext* pContext, const SceneSnapshot& snapshot);
+	bool								CreateUniformBuffers(const VulkanContext* pContext, uint32_t numInstances);
+	bool								CreateDescriptorSets(const VulkanContext* pContext, uint32_t numInstances);
+	bool								CreateModels(const VulkanContext* pContext, const SceneSnapshot& snapshot, std::vector<VulkanModel*>& outListModels);
+
+private:
+	VkBuffer							m_vkVertexBuffer;
+	VkDeviceMemory						m_vkVertexBufferMemory;
+	VkBuffer							m_vkIndexBuffer;
+	VkDeviceMemory						m_vkIndexBufferMemory;
+	std::vector<VulkanMesh>				m_ListMeshes;					// prototypes, ranges of the buffers above
+
+	std::vector<VulkanMaterial*>		m_ListMaterials;				// null till an instance uses it
+
+	std::vector<VkBuffer>				m_ListUniformBuffers;			// one per swapchain image
+	std::vector<VkDeviceMemory>			m_ListUniformMemory;
+	std::vector<uint8_t*>				m_ListUniformData;
+	VkDeviceSize						m_vkUniformStride;
+
+	VkDescriptorPool					m_vkDescriptorPool;
+	std::vector<VkDescriptorSet>		m_ListDescriptorSets;			// swapchain images of instance 0, then of instance 1...
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "Utility.h"
+
+namespace Helper
+{
+	//-----------------------------------------------------------------------------------------------------------------------
+	// COOKED ASSETS
+	//--- Cooker converts everything under Assets/ into runtime ready files under Cooked/, same relative path plus an
+	//--- extension per kind. Runtime only ever opens the cooked ones, bump the version whenever a layout changes!
+
+	const std::string g_strSourceRoot = "Assets/";
+	const std::string g_strCookedRoot = "Cooked/";
+
+	const uint32_t g_uiCookedVersion = 8;
+	const uint32_t g_uiCookedModelMagic = 0x4C444D53;		// "SMDL"
+	const uint32_t g_uiCookedTextureMagic = 0x58455453;		// "STEX"
+	const uint32_t g_uiSceneSnapshotMagic = 0x504E5353;		// "SSNP"
+
+	inline std::string GetCookedPath(const std::string& sourcePath, const char* extension)
+	{
+		std::string path = sourcePath;
+		if (path.compare(0, g_strSourceRoot.size(), g_strSourceRoot) == 0)
+			path = g_strCookedRoot + path.substr(g_strSourceRoot.size());
+
+		return path + extension;
+	}
+
+	inline std::string GetCookedModelPath(const std::string& sourcePath)	{ return GetCookedPath(sourcePath, ".model"); }
+	inline std::string GetCookedTexturePath(const std::string& sourcePath)	{ return GetCookedPath(sourcePath, ".tex"); }
+	inline std::string GetCookedScenePath(const std::string& sourcePath)	{ return GetCookedPath(sourcePath, ".scn"); }
+	inline std::string GetCookedSnapshotPath(const std::string& sourcePath)	{ return GetCookedPath(sourcePath, ".snap"); }
+
+	//--- Used right out of their mapping, so the pack stores them as they are
+	inline bool IsMappedAsset(const std::string& cookedPath)
+	{
+		const std::string extension = ".snap";
+		return cookedPath.size() >= extension.size() && cookedPath.compare(cookedPath.size() - extension.size(), extension.size(), extension) == 0;
+	}
+
+	//--- Scene the runtime opens at startup, see SceneFile
+	const std::string g_strDefaultScenePath = g_strSourceRoot + "Scenes/Default.scene";
+
+	//--- Tables (see CookedModel) follow the header, vertex & index data of all meshes come after them in one payload
+	//--- block, 16 byte aligned in the file so it can be read into staging as it is
+	struct CookedModelHeader
+	{
+		uint32_t	uiMagic;
+		uint32_t	uiVersion;
+		uint64_t	uiPayloadOffset;
+		uint64_t	uiPayloadSize;
+	};
+
+	//--- RGBA8 texels of the whole mip chain follow the header, smallest mip first. Coarse tail a texture shows first is
+	//--- one read right after the header & the finer mips follow it in one more. Rows tightly packed & top row first
+	struct CookedTextureHeader
+	{
+		uint32_t	uiMagic;
+		uint32_t	uiVersion;
+		uint32_t	uiWidth;
+		uint32_t	uiHeight;
+		uint32_t	uiNumMips;
+		uint32_t	uiReserved;					// zero, keeps data size 8 byte aligned
+		uint64_t	uiDataSize;					// all mips
+	};
+
+	inline uint32_t GetMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t numMips = 1;
+		for (uint32_t extent = std::max(width, height); extent > 1; extent >>= 1)
+			numMips++;
+
+		return numMips;
+	}
+
+	inline uint32_t GetMipExtent(uint32_t extent, uint32_t mip)			{ return std::max(extent >> mip, 1u); }
+	inline uint64_t GetMipSize(uint32_t width, uint32_t height, uint32_t mip)	{ return static_cast<uint64_t>(GetMipExtent(width, mip)) * GetMipExtent(height, mip) * 4; }
+
+	//--- Bytes of mips [firstMip, endMip), which are stored back to back. Mip m of such a block starts at
+	//--- GetMipRangeSize(width, height, m + 1, endMip), whole block starts at GetMipRangeSize(width, height, endMip, numMips)
+	//--- after the header!
+	inline uint64_t GetMipRangeSize(uint32_t width, uint32_t height, uint32_t firstMip, uint32_t endMip)
+	{
+		uint64_t size = 0;
+		for (uint32_t mip = firstMip; mip < endMip; mip++)
+			size += GetMipSize(width, height, mip);
+
+		return size;
+	}
+
+	//--- Resolved scene, see SceneSnapshot. Instance, model, mesh, LOD, meshlet & material tables follow the header, then
+	//--- the string block, then vertex & index data of every distinct mesh. Offsets are from the start of the file & each
+	//--- block starts 16 byte aligned, so everything is used right where it's mapped
+	struct SceneSnapshotHeader
+	{
+		uint32_t	uiMagic;
+		uint32_t	uiVersion;
+		uint32_t	uiNumInstances;
+		uint32_t	uiNumModels;
+		uint32_t	uiNumMeshes;
+		uint32_t	uiNumLods;
+		uint32_t	uiNumMeshlets;
+		uint32_t	uiNumMaterials;
+		uint64_t	uiInstancesOffset;
+		uint64_t	uiModelsOffset;
+		uint64_t	uiMeshesOffset;
+		uint64_t	uiLodsOffset;
+		uint64_t	uiMeshletsOffset;
+		uint64_t	uiMaterialsOffset;
+		uint64_t	uiStringsOffset;
+		uint64_t	uiStringsSize;
+		uint64_t	uiVertexDataOffset;
+		uint64_t	uiVertexDataSize;
+		uint64_t	uiIndexDataOffset;
+		uint64_t	uiIndexDataSize;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------
+	// PACK FILE
+	//--- Cooker packs every cooked file into one archive, runtime maps it & resolves cooked paths through it (see
+	//--- VirtualFileSystem). Header, then table of contents sorted by path, then chunk table, then the path strings, then
+	//--- entry data, each entry starting on its own alignment boundary. Paths not in the pack are still read as loose files!
+
+	const std::string g_strPackPath = g_strCookedRoot + "Assets.pak";
+
+	const uint32_t g_uiPackMagic = 0x4B415053;				// "SPAK"
+	const uint32_t g_uiPackVersion = 2;
+	const uint32_t g_uiPackAlignment = 4096;				// page aligned, entries can be mapped & prefetched on their own
+
+	//--- Compressed entries are split into chunks of this size, each one compressed on its own so any range of an entry
+	//--- can be decoded without the rest & chunks decode in parallel
+	const uint32_t g_uiPackChunkSize = 128 * 1024;
+
+	//--- Entries & chunks only stay compressed when it saves at least 1/8 of their size, decoding isn't free
+	const bool g_bCompressPackEntries = true;
+
+	//--- Chunks of one read are decoded on the file system's workers, caller decodes along. Off decodes each read on the
+	//--- thread that asked for it, compare the streamer's load times! Async reads are never decoded on the I/O thread.
+	const bool g_bParallelPackDecode = true;
+
+	//--- Whole pack is prefetched when mounted, cold start then reads it in a few big sequential requests instead of
+	//--- page faulting one entry at a time
+	const bool g_bPrefetchPack = true;
+
+	enum class PackCompression : uint32_t
+	{
+		NONE = 0,
+		LZ											// see LZCodec, entries are chunked
+	};
+
+	struct PackHeader
+	{
+		uint32_t			uiMagic;
+		uint32_t			uiVersion;
+		uint32_t			uiNumEntries;
+		uint32_t			uiAlignment;
+		uint32_t			uiChunkSize;
+		uint32_t			uiNumChunks;
+		uint64_t			uiChunksOffset;
+		uint64_t			uiNamesOffset;
+		uint64_t			uiNamesSize;
+	};
+
+	//--- Table of contents follows the header right away
+	struct PackEntry
+	{
+		uint64_t			uiNameOffset;				// into the path strings, not null terminated
+		uint32_t			uiNameLength;
+		PackCompression		eCompression;
+		uint64_t			uiDataOffset;				// from the start of the pack
+		uint64_t			uiStoredSize;
+		uint64_t			uiSize;						// once decompressed
+		uint32_t			uiFirstChunk;				// compressed entries only, chunk i holds bytes from i * uiChunkSize
+		uint32_t			uiNumChunks;
+	};
+
+	//--- Chunk that doesn't compress well is stored as it is, rest of its entry may still be compressed
+	struct PackChunk
+	{
+		uint64_t			uiStoredOffset;				// from the entry's data offset
+		uint32_t			uiStoredSize;
+		PackCompression		eCompression;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------
+	// BINARY STREAMS
+	//--- Little helpers so cooked tables are written & read field by field, PODs & vectors of PODs go as raw bytes!
+
+	template<typename T>
+	inline void WritePod(std::ostream& stream, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written as raw bytes!");
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	inline bool ReadPod(std::istream& stream, T& outValue)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read as raw bytes!");
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(&outValue), sizeof(T)));
+	}
+
+	inline void WriteString(std::ostream& stream, const std::string& value)
+	{
+		WritePod(stream, static_cast<uint32_t>(value.size()));
+		stream.write(value.data(), value.size());
+	}
+
+	inline bool ReadString(std::istream& stream, std::string& outValue)
+	{
+		uint32_t size = 0;
+		if (!ReadPod(stream, size))
+			return false;
+
+		outValue.resize(size);
+		return size == 0 || static_cast<bool>(stream.read(&outValue[0], size));
+	}
+
+	template<typename T>
+	inline void WriteVector(std::ostream& stream, const std::vector<T>& values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written as raw bytes!");
+		WritePod(stream, static_cast<uint32_t>(values.size()));
+		stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+	}
+
+	template<typename T>
+	inline bool ReadVector(std::istream& stream, std::vector<T>& outValues)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read as raw bytes!");
+
+		uint32_t count = 0;
+		if (!ReadPod(stream, count))
+			return false;
+
+		outValues.resize(count);
+		return count == 0 || static_cast<bool>(stream.read(reinterpret_cast<char*>(outValues.data()), count * sizeof(T)));
+	}
+
+	//--- Written next to the target first & renamed over it, so an interrupted cook never leaves a half written file
+	//--- that looks valid!
+	inline bool WriteFileAtomic(const std::string& filePath, const std::function<bool(std::ostream&)>& writer)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(filePath).parent_path(), error);
+
+		const std::string tempPath = filePath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file || !writer(file) || !file.flush())
+				return false;
+		}
+
+		std::filesystem::rename(tempPath, filePath, error);
+		return !error;
+	}
+}
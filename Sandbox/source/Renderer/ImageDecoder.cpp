@@ -0,0 +1,160 @@
+#include "sandboxPCH.h"
+#include "ImageDecoder.h"
+#include "CookedFormat.h"
+#include "Core/Core.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	// 2x2 box filter, odd edges repeat their last row or column. Stored values are averaged as they are, so sRGB albedo
+	// comes out a bit darker in its smaller mips than a linear filter would make it!
+	void DownsampleMip(const unsigned char* pSrc, uint32_t srcWidth, uint32_t srcHeight, unsigned char* pDst, uint32_t dstWidth, uint32_t dstHeight)
+	{
+		for (uint32_t y = 0; y < dstHeight; ++y)
+		{
+			const uint32_t y0 = std::min(y * 2, srcHeight - 1);
+			const uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+
+			for (uint32_t x = 0; x < dstWidth; ++x)
+			{
+				const uint32_t x0 = std::min(x * 2, srcWidth - 1);
+				const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+				const unsigned char* arrTexels[4] =	{	pSrc + (static_cast<size_t>(y0) * srcWidth + x0) * 4, pSrc + (static_cast<size_t>(y0) * srcWidth + x1) * 4,
+														pSrc + (static_cast<size_t>(y1) * srcWidth + x0) * 4, pSrc + (static_cast<size_t>(y1) * srcWidth + x1) * 4 };
+
+				unsigned char* pTexel = pDst + (static_cast<size_t>(y) * dstWidth + x) * 4;
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					pTexel[c] = static_cast<unsigned char>((arrTexels[0][c] + arrTexels[1][c] + arrTexels[2][c] + arrTexels[3][c] + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+unsigned char* ImageDecoder::DecodeFile(const std::string& filename, int* pWidth, int* pHeight)
+{
+	int channels = 0;
+
+	unsigned char* imageData = stbi_load(filename.c_str(), pWidth, pHeight, &channels, STBI_rgb_alpha);
+	if (!imageData)
+	{
+		LOG_ERROR("Failed to decode a Texture file! ({0}) : {1}", filename, stbi_failure_reason());
+	}
+
+	return imageData;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Red channel of every source goes into its own channel of the result, alpha is unused. Sources may come at different
+// resolutions, smaller ones are point sampled up to the largest. Result is malloc'd just like stb_image's own!
+
+unsigned char* ImageDecoder::DecodePackedChannels(const PackedChannels& packed, int* pWidth, int* pHeight)
+{
+	std::array<unsigned char*, 3> arrSources = { nullptr, nullptr, nullptr };
+	std::array<int, 3> arrWidths = { 0, 0, 0 };
+	std::array<int, 3> arrHeights = { 0, 0, 0 };
+
+	// All channels constant, a single texel is enough!
+	*pWidth = 1;
+	*pHeight = 1;
+
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		if (packed.arrFiles[c].empty())
+			continue;
+
+		// Failed decode falls back to channel default, error is already logged!
+		arrSources[c] = DecodeFile(packed.arrFiles[c], &arrWidths[c], &arrHeights[c]);
+		if (arrSources[c])
+		{
+			*pWidth = std::max(*pWidth, arrWidths[c]);
+			*pHeight = std::max(*pHeight, arrHeights[c]);
+		}
+	}
+
+	const int width = *pWidth;
+	const int height = *pHeight;
+
+	unsigned char* pPacked = static_cast<unsigned char*>(malloc(static_cast<size_t>(width) * height * 4));
+
+	for (int y = 0; pPacked && y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			unsigned char* pTexel = pPacked + (static_cast<size_t>(y) * width + x) * 4;
+
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				if (!arrSources[c])
+				{
+					pTexel[c] = packed.arrDefaults[c];
+					continue;
+				}
+
+				int srcX = (x * arrWidths[c]) / width;
+				int srcY = (y * arrHeights[c]) / height;
+				pTexel[c] = arrSources[c][(static_cast<size_t>(srcY) * arrWidths[c] + srcX) * 4];
+			}
+
+			pTexel[3] = 255;
+		}
+	}
+
+	for (unsigned char* pSource : arrSources)
+	{
+		if (pSource)
+			stbi_image_free(pSource);
+	}
+
+	return pPacked;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ImageDecoder::Free(unsigned char* pPixels)
+{
+	stbi_image_free(pPixels);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Full mip chain is built here, each mip from the one above it, & written smallest first (see CookedTextureHeader)!
+bool ImageDecoder::SaveCooked(const std::string& filePath, const unsigned char* pPixels, int width, int height)
+{
+	Helper::CookedTextureHeader header;
+	header.uiMagic = Helper::g_uiCookedTextureMagic;
+	header.uiVersion = Helper::g_uiCookedVersion;
+	header.uiWidth = static_cast<uint32_t>(width);
+	header.uiHeight = static_cast<uint32_t>(height);
+	header.uiNumMips = Helper::GetMipCount(header.uiWidth, header.uiHeight);
+	header.uiReserved = 0;
+	header.uiDataSize = Helper::GetMipRangeSize(header.uiWidth, header.uiHeight, 0, header.uiNumMips);
+
+	// Mip 0 is the source itself
+	std::vector<std::vector<unsigned char>> listMips(header.uiNumMips);
+	for (uint32_t mip = 1; mip < header.uiNumMips; ++mip)
+	{
+		const unsigned char* pSrc = (mip == 1) ? pPixels : listMips[mip - 1].data();
+
+		listMips[mip].resize(static_cast<size_t>(Helper::GetMipSize(header.uiWidth, header.uiHeight, mip)));
+		DownsampleMip(pSrc, Helper::GetMipExtent(header.uiWidth, mip - 1), Helper::GetMipExtent(header.uiHeight, mip - 1),
+						listMips[mip].data(), Helper::GetMipExtent(header.uiWidth, mip), Helper::GetMipExtent(header.uiHeight, mip));
+	}
+
+	return Helper::WriteFileAtomic(filePath, [&](std::ostream& stream)
+	{
+		Helper::WritePod(stream, header);
+
+		for (uint32_t mip = header.uiNumMips; mip-- > 0;)
+		{
+			const unsigned char* pMip = (mip == 0) ? pPixels : listMips[mip].data();
+			stream.write(reinterpret_cast<const char*>(pMip), Helper::GetMipSize(header.uiWidth, header.uiHeight, mip));
+		}
+
+		return static_cast<bool>(stream);
+	});
+}
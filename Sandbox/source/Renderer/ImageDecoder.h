@@ -0,0 +1,32 @@
+#pragma once
+
+//---------------------------------------------------------------------------------------------------------------------
+// Single channel maps packed into R, G & B of one texture at import. Channel without a file gets its constant default!
+struct PackedChannels
+{
+	PackedChannels() : arrDefaults({ 0, 0, 0 }) {}
+
+	// Used to merge requests, defaults are part of it since they end up in the texels too!
+	std::string					GetKey() const
+	{
+		return	"packed:" + arrFiles[0] + "|" + arrFiles[1] + "|" + arrFiles[2] + "|" +
+				std::to_string(arrDefaults[0]) + "," + std::to_string(arrDefaults[1]) + "," + std::to_string(arrDefaults[2]);
+	}
+
+	std::array<std::string, 3>	arrFiles;
+	std::array<uint8_t, 3>		arrDefaults;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Source image decoding, only the cooker does it. Runtime reads the cooked result (see Helper::CookedTextureHeader)
+// straight into staging memory. Everything here is safe to call from worker threads!
+class ImageDecoder
+{
+public:
+	// Returned pixels are RGBA8 & must be released with Free!
+	static unsigned char*		DecodeFile(const std::string& filename, int* pWidth, int* pHeight);
+	static unsigned char*		DecodePackedChannels(const PackedChannels& packed, int* pWidth, int* pHeight);
+	static void					Free(unsigned char* pPixels);
+
+	static bool					SaveCooked(const std::string& filePath, const unsigned char* pPixels, int width, int height);
+};
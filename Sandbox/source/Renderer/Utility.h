@@ -5,6 +5,7 @@
 
 #include "glm/glm.hpp"
 #include "glm/gtx/transform.hpp"
+#include "glm/gtc/packing.hpp"
 #include "vulkan/vulkan.h"
 
 namespace Helper
@@ -16,6 +17,7 @@ namespace Helper
 
 	enum ePipeline
 	{
+		DEPTH_PREPASS,
 		FORWARD,
 		DEFERRED,
 		RT
@@ -40,6 +42,84 @@ namespace Helper
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
 
+	//--- Optional, streamed textures are written straight from worker threads when device supports it. Only the default,
+	//--- VulkanContext::bUseHostImageCopy flips it at runtime (Stats window) to compare against staging path, both log
+	//--- their upload timings! See Benchmark for both of them side by side
+	const bool g_bEnableHostImageCopy = true;
+
+	//--- Streamed textures come in twice: their mips up to this size first, the finer ones once every texture waiting
+	//--- has its tail. Until then they sample the tail alone, see VulkanTextureStreamer
+	const uint32_t g_uiTextureTailSize = 128;
+
+	//--- Meshlets outside the frustum or facing away from the camera are skipped, flip it to compare triangle counts!
+	const bool g_bEnableMeshletCulling = true;
+
+	//--- Depth only pass first over the position stream, forward pass then shades each pixel once
+	const bool g_bEnableDepthPrepass = true;
+
+	//--- Meshes get up to this many LODs at import. Each frame picks the coarsest one whose error stays under the pixel
+	//--- threshold, going coarser needs some margin below it so LODs don't flip back & forth at the boundary!
+	const uint32_t g_uiMaxMeshLods = 5;
+	const float g_fLodPixelError = 1.0f;
+	const float g_fLodHysteresis = 0.25f;
+
+	//--- Import time index optimization, see MeshOptimizer. Overdraw order may cost this much ACMR over the vertex cache
+	//--- order, meshlets stay within these limits & LODs stop once one would have fewer than g_uiMinLodTriangles
+	const float g_fOverdrawThreshold = 1.05f;
+	const uint32_t g_uiMeshletMaxVertices = 64;
+	const uint32_t g_uiMeshletMaxTriangles = 124;
+	const uint32_t g_uiMinLodTriangles = 128;
+
+	//--- Normal mapped meshes get tangents in their vertex format only when this is on. Nothing shades with a normal map
+	//--- yet, so they'd be uploaded & never read: those meshes are cooked as position, normal & UV instead. Cooked models
+	//--- don't change on their own once it's flipped, bump g_uiCookedVersion with it!
+	const bool g_bCookTangents = false;
+
+	//--- Static submeshes sharing a material are merged into one pre-transformed mesh at import, cut into several once
+	//--- they'd go over this many vertices so merged meshes stay on 16 bit indices!
+	const bool g_bEnableStaticMeshMerging = true;
+	const uint32_t g_uiMaxMergedVertices = 65536;
+
+	//--- Asset reads go through io_uring on Linux with up to this many in flight. Off, or wherever io_uring isn't there,
+	//--- that many blocking reader threads take them instead. Streamer logs its load timings for both!
+	const bool g_bEnableIoUring = true;
+	const uint32_t g_uiAsyncReadQueueDepth = 64;
+
+	//--- Scene models stream in on this many loader threads while frames render, first frame doesn't wait on any of
+	//--- them. Off loads the whole scene before the first frame, compare the scene loader's timings!
+	const bool g_bStreamSceneLoad = true;
+	const uint32_t g_uiSceneLoadThreads = 2;
+
+	//--- Cooked scene's snapshot is loaded instead when there is one: mapped, uploaded in one go & ready before the first
+	//--- frame. Off streams the scene file's models, compare the scene loader's timings! Only for whole scene loads, it's
+	//--- never used while g_bEnableWorldPartition is on
+	const bool g_bLoadSceneSnapshot = true;
+
+	//--- World is split into square cells on XZ. Cells within the load radius of the camera stream in, nearest first &
+	//--- at most this many at a time, ones past the unload radius go away. Everything resident stays under the budget,
+	//--- farther cells are evicted for nearer ones. Off loads the whole scene once & keeps it, see WorldPartition.
+	//--- Mutually exclusive with g_bLoadSceneSnapshot: cells always stream from the scene file, snapshot holds the whole
+	//--- scene at once. Off by default, so default scene keeps loading from its snapshot. Whole scene is loaded instead
+	//--- when the partition can't be built!
+	const bool g_bEnableWorldPartition = false;
+	const float g_fWorldCellSize = 64.0f;
+	const float g_fCellLoadRadius = 128.0f;
+	const float g_fCellUnloadRadius = 192.0f;				// past the load radius, so cells on the edge don't flip every frame
+	const uint32_t g_uiMaxLoadingCells = 4;
+	const VkDeviceSize g_vkWorldPartitionBudget = 512 * 1024 * 1024;
+
+	//--- Meshes with at least this many triangles are cooked into cluster pages instead of one vertex & index array, see
+	//--- ClusterPageBuilder. No page goes over the page limits, coarser pages stand in for finer ones till those stream
+	//--- into the fixed page pool. Which pages are wanted follows visibility & g_fLodPixelError, see VulkanPageStreamer.
+	//--- Pages are simplified in groups of up to g_uiClusterGroupPages neighbours. Pool is only allocated once the first
+	//--- paged mesh is loaded
+	const uint32_t g_uiPagedMeshMinTriangles = 1024 * 1024;
+	const uint32_t g_uiClusterPageTriangles = 4096;
+	const uint32_t g_uiClusterPageVertices = 4096;
+	const uint32_t g_uiClusterGroupPages = 4;
+	const VkDeviceSize g_vkPagePoolSize = 256 * 1024 * 1024;
+	const uint32_t g_uiMaxPageUploadsPerFrame = 64;
+
 	//--- Default Swapchain attachments
 	struct SwapchainAttachment
 	{
@@ -54,6 +134,17 @@ namespace Helper
 		VkDeviceMemory	deviceMemory;
 	};
 
+	//--- Host visible buffer which stays mapped for its whole lifetime, loaders write straight into it!
+	struct StagingBuffer
+	{
+		StagingBuffer() : buffer(VK_NULL_HANDLE), deviceMemory(VK_NULL_HANDLE), pMappedData(nullptr), size(0) {}
+
+		VkBuffer		buffer;
+		VkDeviceMemory	deviceMemory;
+		uint8_t*		pMappedData;
+		VkDeviceSize	size;
+	};
+
 	//-----------------------------------------------------------------------------------------------------------------------
 	// VERTEX STRUCTURES
 
@@ -91,6 +182,113 @@ namespace Helper
 		glm::vec3 BiNormal;
 		glm::vec2 UV;
 	};
+
+	//--- Per mesh dequantization, pushed as push constant before each draw. Positions sit on a grid of 65535 steps across
+	//--- boundsExtent, Position = boundsMin + (unorm * 65535 + gridOffset) * boundsExtent / 65535. Offset is 0 for whole
+	//--- meshes, pages of a paged mesh share the grid & only differ in it, so vertices they share decode the same!
+	struct QuantizationBounds
+	{
+		QuantizationBounds() : boundsMin(glm::vec4(0)), boundsExtent(glm::vec4(1)), gridOffset(glm::vec4(0)) {}
+
+		glm::vec4 boundsMin;
+		glm::vec4 boundsExtent;
+		glm::vec4 gridOffset;						// whole steps
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------
+	// VERTEX QUANTIZATION
+
+	inline int16_t PackSnorm16(float value)		{ return static_cast<int16_t>(glm::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f)); }
+	inline uint16_t PackUnorm16(float value)	{ return static_cast<uint16_t>(glm::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f)); }
+
+	// Unit vector projected on octahedron & unfolded into [-1, 1] square. Degenerate vectors end up as +Z!
+	inline glm::vec2 OctahedralEncode(const glm::vec3& v)
+	{
+		float sum = glm::abs(v.x) + glm::abs(v.y) + glm::abs(v.z);
+		if (sum < 1e-8f)
+			return glm::vec2(0.0f);
+
+		glm::vec3 n = v / sum;
+		if (n.z >= 0.0f)
+			return glm::vec2(n.x, n.y);
+
+		glm::vec2 signs = glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+		return (glm::vec2(1.0f) - glm::abs(glm::vec2(n.y, n.x))) * signs;
+	}
+
+	// Degenerate axes get unit extent, so quantization never divides by zero!
+	inline QuantizationBounds MakeQuantizationBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec3 extent = boundsMax - boundsMin;
+
+		QuantizationBounds bounds;
+		bounds.boundsMin = glm::vec4(boundsMin, 0.0f);
+		bounds.boundsExtent = glm::vec4(extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f, 0.0f);
+
+		return bounds;
+	}
+
+	// Whole steps from boundsMin, same on every page of the grid. Offset isn't applied!
+	inline glm::vec3 QuantizeToGrid(const glm::vec3& position, const QuantizationBounds& bounds)
+	{
+		return glm::round((position - glm::vec3(bounds.boundsMin)) / glm::vec3(bounds.boundsExtent) * 65535.0f);
+	}
+
+	//--- Planes point inside, xyz normal & w distance. Extracted from a world view projection they're in model space!
+	struct Frustum
+	{
+		glm::vec4	planes[6];
+	};
+
+	// Gribb & Hartmann, near plane is the -w..w one so it stays conservative for 0..1 depth too
+	inline Frustum ExtractFrustum(const glm::mat4& mat)
+	{
+		glm::vec4 row0 = glm::vec4(mat[0][0], mat[1][0], mat[2][0], mat[3][0]);
+		glm::vec4 row1 = glm::vec4(mat[0][1], mat[1][1], mat[2][1], mat[3][1]);
+		glm::vec4 row2 = glm::vec4(mat[0][2], mat[1][2], mat[2][2], mat[3][2]);
+		glm::vec4 row3 = glm::vec4(mat[0][3], mat[1][3], mat[2][3], mat[3][3]);
+
+		Frustum frustum;
+		frustum.planes[0] = row3 + row0;
+		frustum.planes[1] = row3 - row0;
+		frustum.planes[2] = row3 + row1;
+		frustum.planes[3] = row3 - row1;
+		frustum.planes[4] = row3 + row2;
+		frustum.planes[5] = row3 - row2;
+
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		return frustum;
+	}
+
+	inline bool IsSphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius)
+	{
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	// FNV-1a 64, pass previous result as hash to continue over several blocks!
+	const uint64_t g_uiHashSeed = 14695981039346656037ull;
+
+	inline uint64_t HashBytes(const void* pData, size_t size, uint64_t hash = g_uiHashSeed)
+	{
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "Utility.h"
+
+namespace Helper
+{
+	//-----------------------------------------------------------------------------------------------------------------------
+	// VERTEX ATTRIBUTES
+	//--- Each one is its packed storage, shader location, stream & format. Stream 0 holds positions only so depth passes
+	//--- fetch just those, everything else goes to stream 1. Pack() quantizes from VertexPNTBT, decoded in vertex shader!
+
+	const uint32_t g_uiMaxVertexStreams = 2;
+
+	struct AttributePosition
+	{
+		static constexpr uint32_t	Location = 0;
+		static constexpr uint32_t	Stream = 0;
+		static constexpr VkFormat	Format = VK_FORMAT_R16G16B16A16_UNORM;
+
+		uint16_t Position[4];		// xyz: unorm16 steps on the mesh's grid past its offset, w: tangent handedness (0 --> -1, 65535 --> +1)
+
+		static void Pack(AttributePosition& out, const VertexPNTBT& vertex, const QuantizationBounds& bounds)
+		{
+			glm::vec3 position = glm::clamp(QuantizeToGrid(vertex.Position, bounds) - glm::vec3(bounds.gridOffset), glm::vec3(0.0f), glm::vec3(65535.0f));
+			float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.BiNormal) < 0.0f ? 0.0f : 1.0f;
+
+			out.Position[0] = static_cast<uint16_t>(position.x);
+			out.Position[1] = static_cast<uint16_t>(position.y);
+			out.Position[2] = static_cast<uint16_t>(position.z);
+			out.Position[3] = PackUnorm16(handedness);
+		}
+	};
+
+	struct AttributeNormal
+	{
+		static constexpr uint32_t	Location = 1;
+		static constexpr uint32_t	Stream = 1;
+		static constexpr VkFormat	Format = VK_FORMAT_R16G16_SNORM;
+
+		int16_t Normal[2];			// octahedral, snorm16
+
+		static void Pack(AttributeNormal& out, const VertexPNTBT& vertex, const QuantizationBounds& bounds)
+		{
+			glm::vec2 normal = OctahedralEncode(vertex.Normal);
+			out.Normal[0] = PackSnorm16(normal.x);
+			out.Normal[1] = PackSnorm16(normal.y);
+		}
+	};
+
+	struct AttributeTangent
+	{
+		static constexpr uint32_t	Location = 2;
+		static constexpr uint32_t	Stream = 1;
+		static constexpr VkFormat	Format = VK_FORMAT_R16G16_SNORM;
+
+		int16_t Tangent[2];			// octahedral, snorm16. Binormal = cross(N, T) * handedness
+
+		static void Pack(AttributeTangent& out, const VertexPNTBT& vertex, const QuantizationBounds& bounds)
+		{
+			glm::vec2 tangent = OctahedralEncode(vertex.Tangent);
+			out.Tangent[0] = PackSnorm16(tangent.x);
+			out.Tangent[1] = PackSnorm16(tangent.y);
+		}
+	};
+
+	struct AttributeUV
+	{
+		static constexpr uint32_t	Location = 3;
+		static constexpr uint32_t	Stream = 1;
+		static constexpr VkFormat	Format = VK_FORMAT_R16G16_SFLOAT;
+
+		uint16_t UV[2];				// half float
+
+		static void Pack(AttributeUV& out, const VertexPNTBT& vertex, const QuantizationBounds& bounds)
+		{
+			out.UV[0] = glm::packHalf1x16(vertex.UV.x);
+			out.UV[1] = glm::packHalf1x16(vertex.UV.y);
+		}
+	};
+
+	static_assert(sizeof(AttributePosition) == 8, "Position stream must stay 8 bytes, depth only passes rely on it!");
+
+	//-----------------------------------------------------------------------------------------------------------------------
+	// VERTEX LAYOUTS
+
+	namespace Detail
+	{
+		template<typename... Attributes>
+		constexpr std::array<uint32_t, g_uiMaxVertexStreams> ComputeStrides()
+		{
+			std::array<uint32_t, g_uiMaxVertexStreams> strides = {};
+			((strides[Attributes::Stream] += static_cast<uint32_t>(sizeof(Attributes))), ...);
+
+			return strides;
+		}
+
+		// Attributes are tightly packed in the order they're listed, each within its own stream
+		template<typename... Attributes>
+		constexpr std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> ComputeAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> descriptions = {};
+			std::array<uint32_t, g_uiMaxVertexStreams> offsets = {};
+			size_t index = 0;
+
+			((descriptions[index++] = { Attributes::Location, Attributes::Stream, Attributes::Format, offsets[Attributes::Stream] },
+				offsets[Attributes::Stream] += static_cast<uint32_t>(sizeof(Attributes))), ...);
+
+			return descriptions;
+		}
+
+		template<size_t Count>
+		constexpr std::array<VkVertexInputBindingDescription, Count> ComputeBindingDescriptions(const std::array<uint32_t, g_uiMaxVertexStreams>& strides)
+		{
+			std::array<VkVertexInputBindingDescription, Count> descriptions = {};
+			size_t index = 0;
+
+			for (uint32_t stream = 0; stream < g_uiMaxVertexStreams; stream++)
+			{
+				if (strides[stream] > 0)
+					descriptions[index++] = { stream, strides[stream], VK_VERTEX_INPUT_RATE_VERTEX };
+			}
+
+			return descriptions;
+		}
+
+		constexpr uint32_t CountStreams(const std::array<uint32_t, g_uiMaxVertexStreams>& strides)
+		{
+			uint32_t count = 0;
+			for (uint32_t stride : strides)
+				count += stride > 0 ? 1 : 0;
+
+			return count;
+		}
+	}
+
+	//--- Vertex layout from a list of attributes. Binding & attribute descriptions are built at compile time, the same
+	//--- list packs vertices into streams, so pipeline & vertex buffer can't disagree. Stream 0 must come first!
+	template<typename... Attributes>
+	struct VertexLayout
+	{
+		static constexpr std::array<uint32_t, g_uiMaxVertexStreams> Strides = Detail::ComputeStrides<Attributes...>();
+		static constexpr uint32_t VertexSize = (static_cast<uint32_t>(sizeof(Attributes)) + ...);
+		static constexpr uint32_t StreamCount = Detail::CountStreams(Strides);
+
+		static constexpr std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> AttributeDescriptions = Detail::ComputeAttributeDescriptions<Attributes...>();
+		static constexpr std::array<VkVertexInputBindingDescription, StreamCount> BindingDescriptions = Detail::ComputeBindingDescriptions<StreamCount>(Strides);
+
+		static_assert(Strides[0] > 0, "Every vertex layout needs the position stream!");
+
+		static VkPipelineVertexInputStateCreateInfo GetInputState()
+		{
+			VkPipelineVertexInputStateCreateInfo inputState = {};
+			inputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			inputState.vertexBindingDescriptionCount = static_cast<uint32_t>(BindingDescriptions.size());
+			inputState.pVertexBindingDescriptions = BindingDescriptions.data();
+			inputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(AttributeDescriptions.size());
+			inputState.pVertexAttributeDescriptions = AttributeDescriptions.data();
+
+			return inputState;
+		}
+
+		// Streams are laid out one after another for vertexCount vertices, position stream first
+		static VkDeviceSize GetStreamOffset(uint32_t stream, uint32_t vertexCount)
+		{
+			VkDeviceSize offset = 0;
+			for (uint32_t i = 0; i < stream; i++)
+				offset += Strides[i] * vertexCount;
+
+			return offset;
+		}
+
+		// Each vertex is packed locally & copied out attribute by attribute, streams are still written front to back
+		static void WriteVertex(void* pVertices, uint32_t vertexCount, uint32_t index, const VertexPNTBT& vertex, const QuantizationBounds& bounds)
+		{
+			(WriteAttribute<Attributes>(static_cast<uint8_t*>(pVertices), vertexCount, index, vertex, bounds), ...);
+		}
+
+	private:
+		template<typename Attribute>
+		static void WriteAttribute(uint8_t* pVertices, uint32_t vertexCount, uint32_t index, const VertexPNTBT& vertex, const QuantizationBounds& bounds)
+		{
+			Attribute packed;
+			Attribute::Pack(packed, vertex, bounds);
+
+			uint8_t* pDst = pVertices + GetStreamOffset(Attribute::Stream, vertexCount) + index * Strides[Attribute::Stream] + GetAttributeOffset(Attribute::Location);
+			memcpy(pDst, &packed, sizeof(Attribute));
+		}
+
+		static constexpr uint32_t GetAttributeOffset(uint32_t location)
+		{
+			for (const VkVertexInputAttributeDescription& description : AttributeDescriptions)
+			{
+				if (description.location == location)
+					return description.offset;
+			}
+
+			return 0;
+		}
+	};
+
+	using VertexLayoutP		= VertexLayout<AttributePosition>;													// depth only passes
+	using VertexLayoutPN	= VertexLayout<AttributePosition, AttributeNormal>;
+	using VertexLayoutPNU	= VertexLayout<AttributePosition, AttributeNormal, AttributeUV>;
+	using VertexLayoutPNTU	= VertexLayout<AttributePosition, AttributeNormal, AttributeTangent, AttributeUV>;
+
+	//--- Per mesh vertex format, smallest layout that has everything the mesh's material uses. Tangents are only there
+	//--- for normal mapping, which needs UVs too, so there's no tangent without UV format!
+	enum class EVertexFormat : uint32_t
+	{
+		POSITION_NORMAL = 0,
+		POSITION_NORMAL_UV,
+		POSITION_NORMAL_TANGENT_UV,
+		COUNT
+	};
+
+	const uint32_t g_uiVertexFormatCount = static_cast<uint32_t>(EVertexFormat::COUNT);
+
+	inline EVertexFormat ChooseVertexFormat(bool bHasUVs, bool bNeedsTangents)
+	{
+		if (!bHasUVs)
+			return EVertexFormat::POSITION_NORMAL;
+
+		return bNeedsTangents ? EVertexFormat::POSITION_NORMAL_TANGENT_UV : EVertexFormat::POSITION_NORMAL_UV;
+	}
+
+	//--- Runtime format --> compile time layout. func gets a default constructed layout, use decltype() on it!
+	template<typename Func>
+	inline decltype(auto) VisitVertexLayout(EVertexFormat format, Func&& func)
+	{
+		switch (format)
+		{
+			case EVertexFormat::POSITION_NORMAL:	return func(VertexLayoutPN());
+			case EVertexFormat::POSITION_NORMAL_UV:	return func(VertexLayoutPNU());
+			default:								return func(VertexLayoutPNTU());
+		}
+	}
+
+	inline uint32_t GetVertexSize(EVertexFormat format)
+	{
+		return VisitVertexLayout(format, [](auto layout) { return decltype(layout)::VertexSize; });
+	}
+}
@@ -1,5 +1,6 @@
 #include "sandboxPCH.h"
 #include "VulkanContext.h"
+#include "Core/VirtualFileSystem.h"
 
 //---------------------------------------------------------------------------------------------------------------------
 VulkanContext::VulkanContext()
@@ -15,12 +16,33 @@ VulkanContext::VulkanContext()
 
 	vkQueueGraphics = VK_NULL_HANDLE;
 	vkQueuePresent = VK_NULL_HANDLE;
-
-	vkForwardRenderingPipeline = VK_NULL_HANDLE;
+	vkQueueTransfer = VK_NULL_HANDLE;
+	uiGraphicsQueueFamily = 0;
+	uiTransferQueueFamily = 0;
+
+	bHostImageCopy = false;
+	bUseHostImageCopy = Helper::g_bEnableHostImageCopy;
+#ifdef VK_EXT_host_image_copy
+	pfnCopyMemoryToImage = nullptr;
+	pfnTransitionImageLayout = nullptr;
+#endif
+
+	vkGraphicsCommandPool = VK_NULL_HANDLE;
+	vkTransferCommandPool = VK_NULL_HANDLE;
+
+	vkListForwardRenderingPipelines.clear();
+	vkDepthPrepassPipeline = VK_NULL_HANDLE;
 	vkForwardRenderingPipelineLayout = VK_NULL_HANDLE;
+	vkModelDescriptorSetLayout = VK_NULL_HANDLE;
 	vkForwardRenderingRenderPass = VK_NULL_HANDLE;
 
 	vkListFramebuffers.clear();
+
+	pFileSystem = nullptr;
+	pStagingRing = nullptr;
+	pTextureStreamer = nullptr;
+	pMeshCache = nullptr;
+	pPageStreamer = nullptr;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -37,18 +59,32 @@ VulkanContext::~VulkanContext()
 
 	vkQueueGraphics = VK_NULL_HANDLE;
 	vkQueuePresent = VK_NULL_HANDLE;
+	vkQueueTransfer = VK_NULL_HANDLE;
 
-	vkForwardRenderingPipeline = VK_NULL_HANDLE;
+	vkListForwardRenderingPipelines.clear();
+	vkDepthPrepassPipeline = VK_NULL_HANDLE;
 	vkForwardRenderingPipelineLayout = VK_NULL_HANDLE;
 	vkForwardRenderingRenderPass = VK_NULL_HANDLE;
 
 	vkListFramebuffers.clear();
+
+	pFileSystem = nullptr;
+	pStagingRing = nullptr;
+	pTextureStreamer = nullptr;
+	pMeshCache = nullptr;
+	pPageStreamer = nullptr;
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
 void VulkanContext::CleanupOnWindowsResize()
 {
-	vkDestroyPipeline(vkDevice, vkForwardRenderingPipeline, nullptr);
+	for (VkPipeline pipeline : vkListForwardRenderingPipelines)
+	{
+		vkDestroyPipeline(vkDevice, pipeline, nullptr);
+	}
+
+	vkListForwardRenderingPipelines.clear();
+	vkDestroyPipeline(vkDevice, vkDepthPrepassPipeline, nullptr);
 	vkDestroyPipelineLayout(vkDevice, vkForwardRenderingPipelineLayout, nullptr);
 	vkDestroyRenderPass(vkDevice, vkForwardRenderingRenderPass, nullptr);
 
@@ -81,7 +117,7 @@ VkFormat VulkanContext::ChooseSupportedFormat(const std::vector<VkFormat>& forma
 
 //-----------------------------------------------------------------------------------------------------------------------
 bool VulkanContext::CreateImage2D(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags, 
-									VkMemoryPropertyFlags memoryPropertyFlags, VkImage* pImage, VkDeviceMemory* pDeviceMemory) const
+									VkMemoryPropertyFlags memoryPropertyFlags, VkImage* pImage, VkDeviceMemory* pDeviceMemory, uint32_t mipLevels) const
 {
 	// Image creation info!
 	VkImageCreateInfo imageInfo = {};
@@ -90,7 +126,7 @@ bool VulkanContext::CreateImage2D(uint32_t width, uint32_t height, VkFormat form
 	imageInfo.extent.width = width;
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = mipLevels;
 	imageInfo.arrayLayers = 1;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
@@ -122,7 +158,8 @@ bool VulkanContext::CreateImage2D(uint32_t width, uint32_t height, VkFormat form
 
 //-----------------------------------------------------------------------------------------------------------------------
 //--- Create Image View
-bool VulkanContext::CreateImageView2D(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView* imageView) const
+bool VulkanContext::CreateImageView2D(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView* imageView, uint32_t baseMipLevel,
+										uint32_t mipLevels) const
 {
 	VkImageViewCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -135,8 +172,8 @@ bool VulkanContext::CreateImageView2D(VkImage image, VkFormat format, VkImageAsp
 	createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
 
 	createInfo.subresourceRange.aspectMask = aspectFlags;
-	createInfo.subresourceRange.baseMipLevel = 0;
-	createInfo.subresourceRange.levelCount = 1;
+	createInfo.subresourceRange.baseMipLevel = baseMipLevel;
+	createInfo.subresourceRange.levelCount = mipLevels;
 	createInfo.subresourceRange.baseArrayLayer = 0;
 	createInfo.subresourceRange.layerCount = 1;
 
@@ -147,6 +184,79 @@ bool VulkanContext::CreateImageView2D(VkImage image, VkFormat format, VkImageAsp
 	return true;
 }
 
+//-----------------------------------------------------------------------------------------------------------------------
+bool VulkanContext::SupportsHostImageCopy(VkFormat format) const
+{
+	if (!bHostImageCopy)
+		return false;
+
+#ifdef VK_EXT_host_image_copy
+	VkFormatProperties3 formatProps3 = {};
+	formatProps3.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3;
+
+	VkFormatProperties2 formatProps2 = {};
+	formatProps2.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2;
+	formatProps2.pNext = &formatProps3;
+
+	vkGetPhysicalDeviceFormatProperties2(vkPhysicalDevice, format, &formatProps2);
+
+	return (formatProps3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) != 0;
+#else
+	return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+// No command buffer, no queue. Image must be created with HOST_TRANSFER usage & the mip not be in use by the GPU, it
+// ends up in SHADER_READ_ONLY layout & is visible to anything submitted afterwards. Width & height are the mip's own.
+// Safe to call from worker threads!
+
+bool VulkanContext::CopyMemoryToImage(const void* pPixels, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel) const
+{
+#ifdef VK_EXT_host_image_copy
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = mipLevel;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	VkHostImageLayoutTransitionInfoEXT transitionInfo = {};
+	transitionInfo.sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT;
+	transitionInfo.image = image;
+	transitionInfo.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	transitionInfo.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	transitionInfo.subresourceRange = subresourceRange;
+
+	VK_CHECK(pfnTransitionImageLayout(vkDevice, 1, &transitionInfo));
+
+	VkMemoryToImageCopyEXT region = {};
+	region.sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+	region.pHostPointer = pPixels;
+	region.memoryRowLength = 0;
+	region.memoryImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = mipLevel;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { width, height, 1 };
+
+	VkCopyMemoryToImageInfoEXT copyInfo = {};
+	copyInfo.sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT;
+	copyInfo.dstImage = image;
+	copyInfo.dstImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	copyInfo.regionCount = 1;
+	copyInfo.pRegions = &region;
+
+	VK_CHECK(pfnCopyMemoryToImage(vkDevice, &copyInfo));
+
+	return true;
+#else
+	return false;
+#endif
+}
+
 //-----------------------------------------------------------------------------------------------------------------------
 bool VulkanContext::CopyImageBuffer(VkBuffer srcBuffer, VkImage dstImage, uint32_t width, uint32_t height) const
 {
@@ -389,7 +499,38 @@ bool VulkanContext::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceS
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-VkCommandBuffer VulkanContext::BeginCommandBuffer() const
+// Safe to call from worker threads, it only creates new objects!
+bool VulkanContext::CreateStagingBuffer(VkDeviceSize bufferSize, Helper::StagingBuffer* outStaging) const
+{
+	CHECK(CreateBuffer(	bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+						VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+						&(outStaging->buffer), &(outStaging->deviceMemory)));
+
+	// Map once, stays mapped till it's destroyed!
+	void* pData = nullptr;
+	VK_CHECK(vkMapMemory(vkDevice, outStaging->deviceMemory, 0, bufferSize, 0, &pData));
+
+	outStaging->pMappedData = static_cast<uint8_t*>(pData);
+	outStaging->size = bufferSize;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+void VulkanContext::DestroyStagingBuffer(Helper::StagingBuffer* pStaging) const
+{
+	if (pStaging->pMappedData)
+		vkUnmapMemory(vkDevice, pStaging->deviceMemory);
+
+	vkDestroyBuffer(vkDevice, pStaging->buffer, nullptr);
+	vkFreeMemory(vkDevice, pStaging->deviceMemory, nullptr);
+
+	*pStaging = Helper::StagingBuffer();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+// Allocates from graphics pool unless told otherwise!
+VkCommandBuffer VulkanContext::BeginCommandBuffer(VkCommandPool commandPool) const
 {
 	// Command buffer to hold transfer command
 	VkCommandBuffer commandBuffer;
@@ -398,7 +539,7 @@ VkCommandBuffer VulkanContext::BeginCommandBuffer() const
 	VkCommandBufferAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = vkGraphicsCommandPool;
+	allocInfo.commandPool = (commandPool != VK_NULL_HANDLE) ? commandPool : vkGraphicsCommandPool;
 	allocInfo.commandBufferCount = 1;
 
 	// Allocate command buffer from pool
@@ -453,40 +594,35 @@ uint32_t VulkanContext::FindMemoryTypeIndex(uint32_t allowedTypeIndex, VkMemoryP
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-//--- Create Shader Module
-VkShaderModule VulkanContext::CreateShaderModule(const std::string& fileName) const
+//--- Create Shader Module, fails when the SPIR-V file isn't there or can't be read! Read goes through the file system
+//--- like every other asset read, shaders aren't cooked so it ends up a loose read. Blocking on purpose: pipelines are
+//--- only created during init, before the first frame, & can't be created without the code anyway
+bool VulkanContext::CreateShaderModule(const std::string& fileName, VkShaderModule* pShaderModule) const
 {
-	// start reading at the end & in binary mode.
-	// Advantage of reading file from the end is we can use read position to determine
-	// size of the file & allocate buffer accordingly!
-	std::ifstream file(fileName, std::ios::ate | std::ios::binary);
-
-	if (!file.is_open())
-		LOG_ERROR("Failed to open Shader file!");
-
-	// get the file size & allocate buffer memory!
-	size_t fileSize = (size_t)file.tellg();
-	std::vector<char> buffer(fileSize);
-
-	// now seek back to the beginning of the file & read all bytes at once!
-	file.seekg(0);
-	file.read(buffer.data(), fileSize);
+	uint64_t fileSize = 0;
+	if (!pFileSystem->GetFileSize(fileName, &fileSize))
+	{
+		LOG_ERROR("Failed to open Shader file {0}!", fileName);
+		return false;
+	}
 
-	// close the file!
-	file.close();
+	// SPIR-V is a stream of 32 bit words, anything else is a broken file
+	std::vector<uint32_t> listCode(static_cast<size_t>(fileSize / sizeof(uint32_t)));
+	if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0 || !pFileSystem->Read(fileName, 0, fileSize, listCode.data()))
+	{
+		LOG_ERROR("Failed to read Shader file {0}!", fileName);
+		return false;
+	}
 
 	// Create Shader Module
 	VkShaderModuleCreateInfo shaderModuleInfo;
-	shaderModuleInfo.codeSize = buffer.size();
+	shaderModuleInfo.codeSize = static_cast<size_t>(fileSize);
 	shaderModuleInfo.flags = 0;
-	shaderModuleInfo.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
+	shaderModuleInfo.pCode = listCode.data();
 	shaderModuleInfo.pNext = nullptr;
 	shaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 
-	VkShaderModule shaderModule;
-	std::string shaderModuleName = fileName;
+	VK_CHECK(vkCreateShaderModule(vkDevice, &shaderModuleInfo, nullptr, pShaderModule));
 
-	vkCreateShaderModule(vkDevice, &shaderModuleInfo, nullptr, &shaderModule);
-
-	return shaderModule;
+	return true;
 }
\ No newline at end of file
@@ -5,6 +5,12 @@
 #include "Utility.h"
 #include "GLFW/glfw3.h"
 
+class VulkanTextureStreamer;
+class VulkanStagingRing;
+class VulkanMeshCache;
+class VulkanPageStreamer;
+class VirtualFileSystem;
+
 //---------------------------------------------------------------------------------------------------------------------
 enum class ERenderer
 {
@@ -24,13 +30,16 @@ public:
 	void								CleanupOnWindowsResize();
 
 	//-- Shader Modules
-	VkShaderModule						CreateShaderModule(const std::string& fileName) const;
+	bool								CreateShaderModule(const std::string& fileName, VkShaderModule* pShaderModule) const;
 
 	//-- Images
 	VkFormat							ChooseSupportedFormat(const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags) const;
 	bool								CreateImage2D(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags,
-													VkMemoryPropertyFlags memoryPropertyFlags, VkImage* pImage, VkDeviceMemory* pDeviceMemory) const;
-	bool								CreateImageView2D(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView* imageView) const;
+													VkMemoryPropertyFlags memoryPropertyFlags, VkImage* pImage, VkDeviceMemory* pDeviceMemory, uint32_t mipLevels = 1) const;
+	bool								CreateImageView2D(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView* imageView, uint32_t baseMipLevel = 0,
+														uint32_t mipLevels = 1) const;
+	bool								SupportsHostImageCopy(VkFormat format) const;
+	bool								CopyMemoryToImage(const void* pPixels, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel = 0) const;
 	bool								CopyImageBuffer(VkBuffer srcBuffer, VkImage image, uint32_t width, uint32_t height) const;
 	void								TransitionImageLayout(VkImage srcImage, VkImageLayout oldLayout, VkImageLayout newLayout, VkCommandBuffer cmdBuffer = VK_NULL_HANDLE) const;
 
@@ -38,7 +47,9 @@ public:
 	uint32_t							FindMemoryTypeIndex(uint32_t allowedTypeIndex, VkMemoryPropertyFlags props) const;
 	bool								CreateBuffer(VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memFlags, VkBuffer* outBuffer, VkDeviceMemory* outMemory) const;
 	bool								CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize) const;
-	VkCommandBuffer						BeginCommandBuffer() const;
+	bool								CreateStagingBuffer(VkDeviceSize bufferSize, Helper::StagingBuffer* outStaging) const;
+	void								DestroyStagingBuffer(Helper::StagingBuffer* pStaging) const;
+	VkCommandBuffer						BeginCommandBuffer(VkCommandPool commandPool = VK_NULL_HANDLE) const;
 	bool								EndAndSubmitCommandBuffer(VkCommandBuffer commandBuffer) const;
 
 public:
@@ -59,14 +70,33 @@ public:
 
 	VkQueue								vkQueueGraphics;
 	VkQueue								vkQueuePresent;
+	VkQueue								vkQueueTransfer;				// same as graphics queue if GPU has no dedicated one!
+	uint32_t							uiGraphicsQueueFamily;
+	uint32_t							uiTransferQueueFamily;
+
+	bool								bHostImageCopy;					// VK_EXT_host_image_copy enabled, images can be written from CPU!
+	std::atomic<bool>					bUseHostImageCopy;				// whether streamer does, for textures requested from now on
+#ifdef VK_EXT_host_image_copy
+	PFN_vkCopyMemoryToImageEXT			pfnCopyMemoryToImage;
+	PFN_vkTransitionImageLayoutEXT		pfnTransitionImageLayout;
+#endif
 
 	VkCommandPool						vkGraphicsCommandPool;
+	VkCommandPool						vkTransferCommandPool;
 	std::vector<VkCommandBuffer>		vkListGraphicsCommandBuffers;
 
-	VkPipeline							vkForwardRenderingPipeline;
+	std::vector<VkPipeline>				vkListForwardRenderingPipelines;	// one per Helper::EVertexFormat
+	VkPipeline							vkDepthPrepassPipeline;			// position stream only, shares forward layout & render pass
 	VkPipelineLayout					vkForwardRenderingPipelineLayout;
+	VkDescriptorSetLayout				vkModelDescriptorSetLayout;		// every model's sets, see VulkanModel::CreateDescriptorSetLayout()
 	VkRenderPass						vkForwardRenderingRenderPass;
 
 	std::vector<VkFramebuffer>			vkListFramebuffers;
+
+	VirtualFileSystem*					pFileSystem;
+	VulkanStagingRing*					pStagingRing;
+	VulkanTextureStreamer*				pTextureStreamer;
+	VulkanMeshCache*					pMeshCache;
+	VulkanPageStreamer*					pPageStreamer;
 };
 
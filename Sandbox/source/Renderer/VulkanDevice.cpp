@@ -38,6 +38,14 @@ bool VulkanDevice::CreateCommandPool(VulkanContext* pContext)
 
 	LOG_DEBUG("Graphics Command Pool created!");
 
+	// Streaming uploads allocate short lived command buffers from their own pool on the transfer family!
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = pContext->uiTransferQueueFamily;
+
+	VK_CHECK(vkCreateCommandPool(pContext->vkDevice, &poolInfo, nullptr, &(pContext->vkTransferCommandPool)));
+
+	LOG_DEBUG("Transfer Command Pool created!");
+
 	return true;
 }
 
@@ -159,9 +167,12 @@ bool VulkanDevice::CreateLogicalDevice(VulkanContext* pContext)
 		m_QueueFamilyIndices.presentFamily.value()
 	};
 
+	if (m_QueueFamilyIndices.transferFamily.has_value())
+		uniqueQueueFamilies.insert(m_QueueFamilyIndices.transferFamily.value());
+
 	float queuePriority = 1.0f;
 
-	for (uint32_t queueFamily = 0; queueFamily < uniqueQueueFamilies.size(); ++queueFamily)
+	for (uint32_t queueFamily : uniqueQueueFamilies)
 	{
 		// Queue the logical device needs to create & the info to do so!
 		VkDeviceQueueCreateInfo queueCreateInfo = {};
@@ -178,8 +189,26 @@ bool VulkanDevice::CreateLogicalDevice(VulkanContext* pContext)
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
-	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(Helper::g_strDeviceExtensions.size());
-	deviceCreateInfo.ppEnabledExtensionNames = Helper::g_strDeviceExtensions.data();
+	
+	// Required extensions + optional ones this GPU happens to support!
+	std::vector<const char*> enabledExtensions = Helper::g_strDeviceExtensions;
+
+#ifdef VK_EXT_host_image_copy
+	VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {};
+	hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+
+	// Enabled whenever it's there, bUseHostImageCopy decides whether it's used!
+	if (QueryHostImageCopySupport(pContext->vkPhysicalDevice))
+	{
+		enabledExtensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+		hostImageCopyFeatures.hostImageCopy = VK_TRUE;
+		deviceCreateInfo.pNext = &hostImageCopyFeatures;
+		pContext->bHostImageCopy = true;
+	}
+#endif
+
+	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+	deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 	
 	// Physical device features that logical device will use...
 	VkPhysicalDeviceFeatures deviceFeatures = {};
@@ -196,6 +225,28 @@ bool VulkanDevice::CreateLogicalDevice(VulkanContext* pContext)
 	vkGetDeviceQueue(pContext->vkDevice, m_QueueFamilyIndices.graphicsFamily.value(), 0, &(pContext->vkQueueGraphics));
 	vkGetDeviceQueue(pContext->vkDevice, m_QueueFamilyIndices.presentFamily.value(), 0, &(pContext->vkQueuePresent));
 
+	// Without a dedicated transfer family, uploads simply go through graphics queue like before!
+	pContext->uiGraphicsQueueFamily = m_QueueFamilyIndices.graphicsFamily.value();
+	pContext->uiTransferQueueFamily = m_QueueFamilyIndices.transferFamily.value_or(pContext->uiGraphicsQueueFamily);
+	vkGetDeviceQueue(pContext->vkDevice, pContext->uiTransferQueueFamily, 0, &(pContext->vkQueueTransfer));
+
+	if (m_QueueFamilyIndices.transferFamily.has_value())
+	{
+		LOG_DEBUG("Dedicated transfer queue found, family {0}", pContext->uiTransferQueueFamily);
+	}
+
+#ifdef VK_EXT_host_image_copy
+	if (pContext->bHostImageCopy)
+	{
+		pContext->pfnCopyMemoryToImage = reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(vkGetDeviceProcAddr(pContext->vkDevice, "vkCopyMemoryToImageEXT"));
+		pContext->pfnTransitionImageLayout = reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(vkGetDeviceProcAddr(pContext->vkDevice, "vkTransitionImageLayoutEXT"));
+
+		pContext->bHostImageCopy = pContext->pfnCopyMemoryToImage && pContext->pfnTransitionImageLayout;
+	}
+#endif
+
+	LOG_INFO("Host image copy: {0}", !pContext->bHostImageCopy ? "not available, using staging uploads" : (pContext->bUseHostImageCopy ? "enabled" : "available, off"));
+
 	return true;
 }
 
@@ -206,6 +257,7 @@ void VulkanDevice::Cleanup(VulkanContext* pContext)
 						static_cast<uint32_t>(pContext->vkListGraphicsCommandBuffers.size()),
 						pContext->vkListGraphicsCommandBuffers.data());
 	vkDestroyCommandPool(pContext->vkDevice, pContext->vkGraphicsCommandPool, nullptr);
+	vkDestroyCommandPool(pContext->vkDevice, pContext->vkTransferCommandPool, nullptr);
 	m_pSwapchain->Cleanup(pContext);
 	vkDestroyDevice(pContext->vkDevice, nullptr);
 }
@@ -231,9 +283,14 @@ void VulkanDevice::HandleWindowsResize(VulkanContext* pContext)
 
 //---------------------------------------------------------------------------------------------------------------------
 // For a given physical device, checks if it has Queue families which support Graphics & Present family queues!
+// Also looks for a transfer family without graphics. Transfer only one is usually the DMA engine & preferred, any
+// other non graphics family (async compute) can copy too & still takes uploads off the graphics queue.
 
 void VulkanDevice::FetchQueueFamilies(VkPhysicalDevice physicalDevice, const VulkanContext* pContext)
 {
+	// Might have been filled by previously rejected device!
+	m_QueueFamilyIndices = QueueFamilyIndices();
+
 	// Get all queue families & their properties supported by physical device!
 	uint32_t queueFamilyCount = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
@@ -241,10 +298,14 @@ void VulkanDevice::FetchQueueFamilies(VkPhysicalDevice physicalDevice, const Vul
 	std::vector<VkQueueFamilyProperties> vecQueueFamilies(queueFamilyCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, vecQueueFamilies.data());
 
+	std::optional<uint32_t> anyTransferFamily;
+
 	// Go through queue families and check if it supports graphics & present family queue!
 	for (int i = 0; i < queueFamilyCount; ++i)
 	{
-		if (vecQueueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		const VkQueueFlags queueFlags = vecQueueFamilies[i].queueFlags;
+
+		if ((queueFlags & VK_QUEUE_GRAPHICS_BIT) && !m_QueueFamilyIndices.graphicsFamily.has_value())
 		{
 			m_QueueFamilyIndices.graphicsFamily = i;
 		}
@@ -254,13 +315,28 @@ void VulkanDevice::FetchQueueFamilies(VkPhysicalDevice physicalDevice, const Vul
 		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, pContext->vkSurface, &bPresentSupport);
 
 		// if yes, store presentation family queue index!
-		if (bPresentSupport)
+		if (bPresentSupport && !m_QueueFamilyIndices.presentFamily.has_value())
 		{
 			m_QueueFamilyIndices.presentFamily = i;
 		}
 
-		if (m_QueueFamilyIndices.isComplete())
-			break;
+		// compute families support transfer even if they don't report it!
+		if (queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			continue;
+
+		if ((queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFlags & VK_QUEUE_COMPUTE_BIT))
+		{
+			m_QueueFamilyIndices.transferFamily = i;
+		}
+		else if ((queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) && !anyTransferFamily.has_value())
+		{
+			anyTransferFamily = i;
+		}
+	}
+
+	if (!m_QueueFamilyIndices.transferFamily.has_value())
+	{
+		m_QueueFamilyIndices.transferFamily = anyTransferFamily;
 	}
 }
 
@@ -304,3 +380,61 @@ bool VulkanDevice::CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
 	return true;
 }
 
+
+//-------------------------------------------------------------------------------------------------------------------
+// Only valid for the selected device, supported extension list is from the last device checked!
+bool VulkanDevice::IsExtensionSupported(const char* extensionName) const
+{
+	for (const VkExtensionProperties& extension : m_vecSupportedExtensions)
+	{
+		if (strcmp(extensionName, extension.extensionName) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+// Extension alone isn't enough. Streamed textures are sampled in SHADER_READ_ONLY layout, host copies must be able
+// to write into it directly or we'd need a queue transition anyway!
+
+bool VulkanDevice::QueryHostImageCopySupport(VkPhysicalDevice physicalDevice) const
+{
+#ifdef VK_EXT_host_image_copy
+	if (!IsExtensionSupported(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME))
+		return false;
+
+	VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {};
+	hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+
+	VkPhysicalDeviceFeatures2 features2 = {};
+	features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features2.pNext = &hostImageCopyFeatures;
+
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+	if (!hostImageCopyFeatures.hostImageCopy)
+		return false;
+
+	// First query only fills in the layout counts...
+	VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProps = {};
+	hostImageCopyProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT;
+
+	VkPhysicalDeviceProperties2 props2 = {};
+	props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	props2.pNext = &hostImageCopyProps;
+
+	vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+
+	// ...second one the layouts themselves!
+	std::vector<VkImageLayout> listDstLayouts(hostImageCopyProps.copyDstLayoutCount);
+	hostImageCopyProps.pCopyDstLayouts = listDstLayouts.data();
+	hostImageCopyProps.copySrcLayoutCount = 0;
+
+	vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+
+	return std::find(listDstLayouts.begin(), listDstLayouts.end(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) != listDstLayouts.end();
+#else
+	return false;
+#endif
+}
@@ -12,10 +12,12 @@ struct QueueFamilyIndices
 	{
 		graphicsFamily.reset();
 		presentFamily.reset();
+		transferFamily.reset();
 	}
 
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily;
+	std::optional<uint32_t> transferFamily;		// Optional, only set when GPU has a family without graphics which can copy!
 
 	bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 };
@@ -39,6 +41,8 @@ private:
 	bool								CreateLogicalDevice(VulkanContext* pRC);
 	void								FetchQueueFamilies(VkPhysicalDevice physicalDevice, const VulkanContext* pRC);
 	bool								CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice);
+	bool								IsExtensionSupported(const char* extensionName) const;
+	bool								QueryHostImageCopySupport(VkPhysicalDevice physicalDevice) const;
 
 private:
 	
@@ -2,16 +2,15 @@
 #include "VulkanTexture.h"
 #include "VulkanMaterial.h"
 #include "VulkanContext.h"
+#include "VulkanTextureStreamer.h"
 
 //-----------------------------------------------------------------------------------------------------------------------
 VulkanMaterial::VulkanMaterial()
 {
 	m_pTextureAlbedo = nullptr;
 	m_pTextureEmission = nullptr;
-	m_pTextureMetalness = nullptr;
 	m_pTextureNormal = nullptr;
-	m_pTextureOcclusion = nullptr;
-	m_pTextureRoughness = nullptr;
+	m_pTextureORM = nullptr;
 	m_pTextureHDRI = nullptr;
 	m_pTextureError = nullptr;
 
@@ -26,23 +25,25 @@ VulkanMaterial::~VulkanMaterial()
 {
 	SAFE_DELETE(m_pTextureAlbedo);
 	SAFE_DELETE(m_pTextureEmission);
-	SAFE_DELETE(m_pTextureMetalness);
 	SAFE_DELETE(m_pTextureNormal);
-	SAFE_DELETE(m_pTextureOcclusion);
-	SAFE_DELETE(m_pTextureRoughness);
+	SAFE_DELETE(m_pTextureORM);
 	SAFE_DELETE(m_pTextureHDRI);
 	SAFE_DELETE(m_pTextureError);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-bool VulkanMaterial::LoadTexture(const VulkanContext* pContext, const std::string& filePath, TextureType type)
+bool VulkanMaterial::LoadTexture(const VulkanContext* pContext, const std::string& filePath, TextureType type, const StreamingBounds* pBounds)
 {
+	// Textures are only requested here, streamer binds a placeholder & uploads actual data in the background! Path is
+	// the cooked file, see Helper::GetCookedTexturePath()
+	VulkanTextureStreamer* pStreamer = pContext->pTextureStreamer;
+
 	switch (type)
 	{
 		case TextureType::TEXTURE_ALBEDO:
 		{
 			m_pTextureAlbedo = new VulkanTexture();
-			CHECK(m_pTextureAlbedo->CreateTexture(pContext, filePath, VK_FORMAT_R8G8B8A8_SRGB));
+			CHECK(pStreamer->RequestTexture(pContext, m_pTextureAlbedo, filePath, VK_FORMAT_R8G8B8A8_SRGB, type, pBounds));
 			++m_uiNumTextures;
 			break;
 		}
@@ -50,15 +51,7 @@ bool VulkanMaterial::LoadTexture(const VulkanContext* pContext, const std::strin
 		case TextureType::TEXTURE_EMISSIVE:
 		{
 			m_pTextureEmission = new VulkanTexture();
-			CHECK(m_pTextureEmission->CreateTexture(pContext, filePath, VK_FORMAT_R8G8B8A8_UNORM));
-			++m_uiNumTextures;
-			break;
-		}
-			
-		case TextureType::TEXTURE_METALNESS:
-		{
-			m_pTextureMetalness = new VulkanTexture();
-			CHECK(m_pTextureMetalness->CreateTexture(pContext, filePath, VK_FORMAT_R8G8B8A8_UNORM));
+			CHECK(pStreamer->RequestTexture(pContext, m_pTextureEmission, filePath, VK_FORMAT_R8G8B8A8_UNORM, type, pBounds));
 			++m_uiNumTextures;
 			break;
 		}
@@ -66,23 +59,16 @@ bool VulkanMaterial::LoadTexture(const VulkanContext* pContext, const std::strin
 		case TextureType::TEXTURE_NORMAL:
 		{
 			m_pTextureNormal = new VulkanTexture();
-			CHECK(m_pTextureNormal->CreateTexture(pContext, filePath, VK_FORMAT_R8G8B8A8_UNORM));
-			++m_uiNumTextures;
-			break;
-		}
-			
-		case TextureType::TEXTURE_ROUGHNESS:
-		{
-			m_pTextureRoughness = new VulkanTexture();
-			CHECK(m_pTextureRoughness->CreateTexture(pContext, filePath, VK_FORMAT_R8G8B8A8_UNORM));
+			CHECK(pStreamer->RequestTexture(pContext, m_pTextureNormal, filePath, VK_FORMAT_R8G8B8A8_UNORM, type, pBounds));
 			++m_uiNumTextures;
 			break;
 		}
 			
-		case TextureType::TEXTURE_AO:
+		// Occlusion, roughness & metalness maps come packed into one texture by the cooker
+		case TextureType::TEXTURE_ORM:
 		{
-			m_pTextureOcclusion = new VulkanTexture();
-			CHECK(m_pTextureOcclusion->CreateTexture(pContext, filePath, VK_FORMAT_R8G8B8A8_UNORM));
+			m_pTextureORM = new VulkanTexture();
+			CHECK(pStreamer->RequestTexture(pContext, m_pTextureORM, filePath, VK_FORMAT_R8G8B8A8_UNORM, type, pBounds));
 			++m_uiNumTextures;
 			break;
 		}
@@ -90,7 +76,7 @@ bool VulkanMaterial::LoadTexture(const VulkanContext* pContext, const std::strin
 		case TextureType::TEXTURE_HDRI:
 		{
 			m_pTextureHDRI = new VulkanTexture();
-			CHECK(m_pTextureHDRI->CreateTexture(pContext, filePath, VK_FORMAT_R32G32B32A32_SFLOAT));
+			CHECK(pStreamer->RequestTexture(pContext, m_pTextureHDRI, filePath, VK_FORMAT_R32G32B32A32_SFLOAT, type, pBounds));
 			++m_uiNumTextures;
 			break;
 		}
@@ -98,7 +84,7 @@ bool VulkanMaterial::LoadTexture(const VulkanContext* pContext, const std::strin
 		case TextureType::TEXTURE_ERROR:
 		{
 			m_pTextureError = new VulkanTexture();
-			CHECK(m_pTextureError->CreateTexture(pContext, filePath, VK_FORMAT_R8G8B8A8_UNORM));
+			CHECK(pStreamer->RequestTexture(pContext, m_pTextureError, filePath, VK_FORMAT_R8G8B8A8_UNORM, type, pBounds));
 			++m_uiNumTextures;
 			break;
 		}
@@ -117,10 +103,8 @@ void VulkanMaterial::Cleanup(const VulkanContext* pContext)
 	if (m_pTextureEmission)		{ m_pTextureEmission->Cleanup(pContext); }
 	if (m_pTextureError)		{ m_pTextureError->Cleanup(pContext); }
 	if (m_pTextureHDRI)			{ m_pTextureHDRI->Cleanup(pContext); }
-	if (m_pTextureMetalness)	{ m_pTextureMetalness->Cleanup(pContext); }
 	if (m_pTextureNormal)		{ m_pTextureNormal->Cleanup(pContext); }
-	if (m_pTextureOcclusion)	{ m_pTextureOcclusion->Cleanup(pContext); }
-	if (m_pTextureRoughness)	{ m_pTextureRoughness->Cleanup(pContext); }
+	if (m_pTextureORM)			{ m_pTextureORM->Cleanup(pContext); }
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
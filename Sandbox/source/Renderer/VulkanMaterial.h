@@ -4,15 +4,14 @@
 
 class VulkanTexture;
 class VulkanContext;
+struct StreamingBounds;
 
 //---------------------------------------------------------------------------------------------------------------------
 enum class TextureType
 {
 	TEXTURE_ALBEDO,
-	TEXTURE_METALNESS,
 	TEXTURE_NORMAL,
-	TEXTURE_ROUGHNESS,
-	TEXTURE_AO,
+	TEXTURE_ORM,				// Occlusion | Roughness | Metalness packed in R | G | B
 	TEXTURE_EMISSIVE,
 	TEXTURE_HDRI,
 	TEXTURE_ERROR
@@ -25,7 +24,7 @@ public:
 	VulkanMaterial();
 	~VulkanMaterial();
 
-	bool					LoadTexture(const VulkanContext* pContext, const std::string& filePath, TextureType type);
+	bool					LoadTexture(const VulkanContext* pContext, const std::string& filePath, TextureType type, const StreamingBounds* pBounds = nullptr);
 	void					Cleanup(const VulkanContext* pContext);
 	void					CleanupOnWindowResize(const VulkanContext* pContext);
 
@@ -38,9 +37,7 @@ public:
 	VulkanTexture*			m_pTextureAlbedo;
 	VulkanTexture*			m_pTextureEmission;
 	VulkanTexture*			m_pTextureNormal;
-	VulkanTexture*			m_pTextureMetalness;
-	VulkanTexture*			m_pTextureRoughness;
-	VulkanTexture*			m_pTextureOcclusion;
+	VulkanTexture*			m_pTextureORM;
 	VulkanTexture*			m_pTextureHDRI;
 	VulkanTexture*			m_pTextureError;
 
@@ -0,0 +1,491 @@
+#include "sandboxPCH.h"
+#include "VulkanPageStreamer.h"
+#include "VulkanContext.h"
+#include "VulkanUploadBatch.h"
+#include "VertexLayout.h"
+#include "Renderables/VulkanPagedMesh.h"
+#include "Core/VirtualFileSystem.h"
+#include "Core/Core.h"
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	// Mesh is nulled when it's unregistered while the page is in flight, its slot is only free again once the copy is done
+	struct PageUploadEntry
+	{
+		PageUploadEntry() : pMesh(nullptr), uiPage(0), uiSlot(0), bFailed(false) {}
+
+		VulkanPagedMesh*					pMesh;
+		uint32_t							uiPage;
+		uint32_t							uiSlot;
+		std::atomic<bool>					bFailed;
+	};
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pages of one frame, read into the batch's staging & submitted once every read has landed
+struct VulkanPageStreamer::PageUpload
+{
+	PageUpload(size_t numPages) : listEntries(numPages), uiNumPendingReads(static_cast<uint32_t>(numPages)), bSubmitted(false) {}
+
+	VulkanUploadBatch						batch;
+	std::vector<PageUploadEntry>			listEntries;
+	std::atomic<uint32_t>					uiNumPendingReads;
+	bool									bSubmitted;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanPageStreamer::VulkanPageStreamer()
+{
+	m_vkVertexBuffer = VK_NULL_HANDLE;
+	m_vkVertexBufferMemory = VK_NULL_HANDLE;
+	m_vkIndexBuffer = VK_NULL_HANDLE;
+	m_vkIndexBufferMemory = VK_NULL_HANDLE;
+
+	m_vkSlotPositionsSize = 0;
+	m_vkSlotAttributesSize = 0;
+	m_vkAttributesOffset = 0;
+	m_vkSlotIndicesSize = 0;
+	m_uiNumSlots = 0;
+	m_bPoolAllocated = false;
+	m_uiNumPinnedPages = 0;
+	m_ListFreeSlots.clear();
+
+	m_ListMeshes.clear();
+	m_ListUploads.clear();
+	m_uiNextCandidate = 0;
+
+	m_uiFrame = 0;
+	m_uiNumResidentPages = 0;
+	m_bPoolFullReported = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanPageStreamer::~VulkanPageStreamer()
+{
+	m_ListFreeSlots.clear();
+	m_ListMeshes.clear();
+	m_ListUploads.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Slots fit the biggest vertex format, so any page can go into any free slot! Only sizes the pool, see AllocatePool()
+bool VulkanPageStreamer::Initialize(const VulkanContext* pContext)
+{
+	uint32_t maxVertexSize = 0;
+	for (uint32_t i = 0; i < Helper::g_uiVertexFormatCount; i++)
+	{
+		maxVertexSize = glm::max(maxVertexSize, Helper::GetVertexSize(static_cast<Helper::EVertexFormat>(i)));
+	}
+
+	m_vkSlotPositionsSize = Helper::g_uiClusterPageVertices * sizeof(Helper::AttributePosition);
+	m_vkSlotAttributesSize = Helper::g_uiClusterPageVertices * (maxVertexSize - sizeof(Helper::AttributePosition));
+	m_vkSlotIndicesSize = Helper::g_uiClusterPageTriangles * 3 * sizeof(uint16_t);
+
+	m_uiNumSlots = static_cast<uint32_t>(Helper::g_vkPagePoolSize / (m_vkSlotPositionsSize + m_vkSlotAttributesSize + m_vkSlotIndicesSize));
+	m_vkAttributesOffset = m_uiNumSlots * m_vkSlotPositionsSize;
+
+	LOG_DEBUG("Page streamer initialized, {0} page slots in {1} MB once a paged mesh shows up", m_uiNumSlots, Helper::g_vkPagePoolSize / (1024 * 1024));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// First registered mesh allocates the pool, with the meshes' lock held. A buffer that did get created is kept, so a
+// later mesh only retries whatever failed!
+bool VulkanPageStreamer::AllocatePool(const VulkanContext* pContext)
+{
+	if (m_vkVertexBuffer == VK_NULL_HANDLE)
+	{
+		CHECK(pContext->CreateBuffer(m_vkAttributesOffset + m_uiNumSlots * m_vkSlotAttributesSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+										VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_vkVertexBuffer, &m_vkVertexBufferMemory));
+	}
+
+	if (m_vkIndexBuffer == VK_NULL_HANDLE)
+	{
+		CHECK(pContext->CreateBuffer(m_uiNumSlots * m_vkSlotIndicesSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+										VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_vkIndexBuffer, &m_vkIndexBufferMemory));
+	}
+
+	// Popped from the back, lowest slots go first
+	m_ListFreeSlots.resize(m_uiNumSlots);
+	for (uint32_t i = 0; i < m_uiNumSlots; i++)
+	{
+		m_ListFreeSlots[i] = m_uiNumSlots - 1 - i;
+	}
+
+	m_bPoolAllocated = true;
+
+	LOG_DEBUG("Page pool allocated, {0} page slots in {1} MB", m_uiNumSlots, Helper::g_vkPagePoolSize / (1024 * 1024));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Roots stay resident for good, a pool that can't hold all of them would sooner or later have no slot left for anything!
+bool VulkanPageStreamer::RegisterMesh(const VulkanContext* pContext, VulkanPagedMesh* pMesh)
+{
+	std::lock_guard<std::mutex> lock(m_MutexMeshes);
+
+	if (!m_bPoolAllocated && !AllocatePool(pContext))
+	{
+		LOG_ERROR("Failed to allocate page pool, paged mesh {0} can't be drawn!", pMesh->m_strName);
+		return false;
+	}
+
+	if (m_uiNumPinnedPages + pMesh->GetNumRoots() > m_uiNumSlots)
+	{
+		LOG_ERROR("Paged mesh {0} has {1} root pages, only {2} of {3} slots are left to pin! Raise Helper::g_vkPagePoolSize",
+					pMesh->m_strName, pMesh->GetNumRoots(), m_uiNumSlots - m_uiNumPinnedPages, m_uiNumSlots);
+		return false;
+	}
+
+	m_uiNumPinnedPages += pMesh->GetNumRoots();
+	m_ListMeshes.push_back(pMesh);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Resident slots are free right away, caller makes sure no frame in flight still draws the mesh!
+void VulkanPageStreamer::UnregisterMesh(VulkanPagedMesh* pMesh)
+{
+	std::lock_guard<std::mutex> lock(m_MutexMeshes);
+
+	m_ListMeshes.erase(std::remove(m_ListMeshes.begin(), m_ListMeshes.end(), pMesh), m_ListMeshes.end());
+	m_uiNumPinnedPages -= pMesh->GetNumRoots();
+
+	for (PageUpload* pUpload : m_ListUploads)
+	{
+		for (PageUploadEntry& entry : pUpload->listEntries)
+		{
+			if (entry.pMesh == pMesh)
+				entry.pMesh = nullptr;
+		}
+	}
+
+	for (PageResidency& residency : pMesh->m_ListResidency)
+	{
+		if (residency.eState == PageState::RESIDENT)
+		{
+			m_ListFreeSlots.push_back(residency.uiSlot);
+			m_uiNumResidentPages--;
+		}
+
+		residency.eState = PageState::NOT_RESIDENT;
+	}
+
+	pMesh->m_vkResidentBytes = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runs after every mesh's visibility update, before the frame's draws are recorded. Frame number only moves on here,
+// pages a mesh visited this frame carry the same one!
+void VulkanPageStreamer::Update(const VulkanContext* pContext)
+{
+	std::lock_guard<std::mutex> lock(m_MutexMeshes);
+
+	RetireUploads(pContext);
+	IssueUploads(pContext);
+
+	m_uiFrame++;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reads land, their completions run & only then whatever got submitted is waited for, staging goes back to the ring
+// after that. Pages still in flight are simply dropped!
+void VulkanPageStreamer::Shutdown(const VulkanContext* pContext)
+{
+	pContext->pFileSystem->WaitAsyncIdle();
+
+	std::lock_guard<std::mutex> lock(m_MutexMeshes);
+	if (m_ListUploads.empty())
+		return;
+
+	// Acquire on graphics queue is the last submit of every batch, see VulkanUploadBatch
+	vkQueueWaitIdle(pContext->vkQueueGraphics);
+
+	for (PageUpload* pUpload : m_ListUploads)
+	{
+		FinishUpload(pContext, pUpload, false);
+	}
+
+	m_ListUploads.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanPageStreamer::Cleanup(const VulkanContext* pContext)
+{
+	Shutdown(pContext);
+
+	vkDestroyBuffer(pContext->vkDevice, m_vkIndexBuffer, nullptr);
+	vkFreeMemory(pContext->vkDevice, m_vkIndexBufferMemory, nullptr);
+
+	vkDestroyBuffer(pContext->vkDevice, m_vkVertexBuffer, nullptr);
+	vkFreeMemory(pContext->vkDevice, m_vkVertexBufferMemory, nullptr);
+
+	m_vkIndexBuffer = VK_NULL_HANDLE;
+	m_vkIndexBufferMemory = VK_NULL_HANDLE;
+	m_vkVertexBuffer = VK_NULL_HANDLE;
+	m_vkVertexBufferMemory = VK_NULL_HANDLE;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Batches whose reads have all landed are submitted, submitted ones whose fence has signaled make their pages resident
+void VulkanPageStreamer::RetireUploads(const VulkanContext* pContext)
+{
+	auto itrUpload = m_ListUploads.begin();
+	while (itrUpload != m_ListUploads.end())
+	{
+		PageUpload* pUpload = *itrUpload;
+
+		if (!pUpload->bSubmitted)
+		{
+			if (pUpload->uiNumPendingReads > 0)
+			{
+				++itrUpload;
+				continue;
+			}
+
+			if (pUpload->batch.SubmitAsync(pContext))
+			{
+				pUpload->bSubmitted = true;
+				++itrUpload;
+				continue;
+			}
+
+			LOG_ERROR("Failed to upload {0} pages!", pUpload->listEntries.size());
+
+			// Whatever did get submitted must be done before staging goes back to the ring!
+			vkQueueWaitIdle(pContext->vkQueueGraphics);
+
+			FinishUpload(pContext, pUpload, false);
+			itrUpload = m_ListUploads.erase(itrUpload);
+			continue;
+		}
+
+		if (!pUpload->batch.IsComplete(pContext))
+		{
+			++itrUpload;
+			continue;
+		}
+
+		FinishUpload(pContext, pUpload, true);
+		itrUpload = m_ListUploads.erase(itrUpload);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pages that weren't uploaded can be asked for again, ones whose read failed never will be. Deletes the upload!
+void VulkanPageStreamer::FinishUpload(const VulkanContext* pContext, PageUpload* pUpload, bool bUploaded)
+{
+	for (PageUploadEntry& entry : pUpload->listEntries)
+	{
+		if (!entry.pMesh)
+		{
+			m_ListFreeSlots.push_back(entry.uiSlot);
+			continue;
+		}
+
+		PageResidency& residency = entry.pMesh->m_ListResidency[entry.uiPage];
+
+		if (!bUploaded || entry.bFailed)
+		{
+			if (entry.bFailed)
+				LOG_ERROR("Failed to read page {0} of {1} from cooked file, re-run the Cooker!", entry.uiPage, entry.pMesh->m_strName);
+
+			residency.eState = entry.bFailed ? PageState::FAILED : PageState::NOT_RESIDENT;
+			m_ListFreeSlots.push_back(entry.uiSlot);
+			continue;
+		}
+
+		residency.eState = PageState::RESIDENT;
+		entry.pMesh->m_vkResidentBytes += entry.pMesh->m_ListPages[entry.uiPage].uiDataSize;
+		m_uiNumResidentPages++;
+	}
+
+	pUpload->batch.Cleanup(pContext);
+	SAFE_DELETE(pUpload);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Requests of every mesh are ranked together, biggest projected error first. Pages whose reads are still pending count
+// against the per frame limit, so slow reads throttle new ones instead of piling up staging memory!
+void VulkanPageStreamer::IssueUploads(const VulkanContext* pContext)
+{
+	m_ListRequests.clear();
+
+	for (VulkanPagedMesh* pMesh : m_ListMeshes)
+	{
+		for (const PageRequest& request : pMesh->m_ListRequests)
+		{
+			if (pMesh->m_ListResidency[request.uiPage].eState == PageState::NOT_RESIDENT)
+				m_ListRequests.push_back({ pMesh, request.uiPage, request.fPriority });
+		}
+
+		// Meshes not in the scene any more don't update, their last requests mustn't stay around
+		pMesh->m_ListRequests.clear();
+	}
+
+	uint32_t numPending = 0;
+	for (const PageUpload* pUpload : m_ListUploads)
+	{
+		numPending += pUpload->bSubmitted ? 0 : static_cast<uint32_t>(pUpload->listEntries.size());
+	}
+
+	if (m_ListRequests.empty() || numPending >= Helper::g_uiMaxPageUploadsPerFrame)
+		return;
+
+	const size_t maxUploads = std::min<size_t>(m_ListRequests.size(), Helper::g_uiMaxPageUploadsPerFrame - numPending);
+	std::partial_sort(m_ListRequests.begin(), m_ListRequests.begin() + maxUploads, m_ListRequests.end(),
+						[](const QueuedRequest& a, const QueuedRequest& b) { return a.fPriority > b.fPriority; });
+
+	// Slots first, batch is then only as big as what actually fits into the pool
+	m_ListEvictionCandidates.clear();
+	m_uiNextCandidate = 0;
+	bool bCandidatesFound = false;
+
+	size_t numUploads = 0;
+	VkDeviceSize stagingSize = 0;
+
+	for (; numUploads < maxUploads; numUploads++)
+	{
+		const QueuedRequest& request = m_ListRequests[numUploads];
+
+		if (m_ListFreeSlots.empty() && !bCandidatesFound)
+		{
+			FindEvictionCandidates();
+			bCandidatesFound = true;
+		}
+
+		uint32_t slot = 0;
+		if (!AllocateSlot(&slot))
+		{
+			if (!m_bPoolFullReported)
+				LOG_WARNING("Page pool is full, all {0} slots are in use! Raise Helper::g_vkPagePoolSize", m_uiNumSlots);
+
+			m_bPoolFullReported = true;
+			break;
+		}
+
+		PageResidency& residency = request.pMesh->m_ListResidency[request.uiPage];
+		residency.eState = PageState::LOADING;
+		residency.uiSlot = slot;
+
+		// Each reservation may need up to 16 bytes of alignment padding!
+		stagingSize += request.pMesh->m_ListPages[request.uiPage].uiDataSize + 16;
+	}
+
+	if (numUploads == 0)
+		return;
+
+	PageUpload* pUpload = new PageUpload(numUploads);
+
+	if (!pUpload->batch.Begin(pContext, stagingSize))
+	{
+		// Staging ring is busy, pages are asked for again next frame
+		for (size_t i = 0; i < numUploads; i++)
+		{
+			PageResidency& residency = m_ListRequests[i].pMesh->m_ListResidency[m_ListRequests[i].uiPage];
+			residency.eState = PageState::NOT_RESIDENT;
+			m_ListFreeSlots.push_back(residency.uiSlot);
+		}
+
+		pUpload->batch.Cleanup(pContext);
+		SAFE_DELETE(pUpload);
+		return;
+	}
+
+	for (size_t i = 0; i < numUploads; i++)
+	{
+		VulkanPagedMesh* pMesh = m_ListRequests[i].pMesh;
+		const ClusterPage& page = pMesh->m_ListPages[m_ListRequests[i].uiPage];
+
+		PageUploadEntry& entry = pUpload->listEntries[i];
+		entry.pMesh = pMesh;
+		entry.uiPage = m_ListRequests[i].uiPage;
+		entry.uiSlot = pMesh->m_ListResidency[entry.uiPage].uiSlot;
+
+		VkDeviceSize stagingOffset = 0;
+		void* pStaging = pUpload->batch.Reserve(page.uiDataSize, &stagingOffset);
+		if (!pStaging)
+		{
+			entry.bFailed = true;
+			--pUpload->uiNumPendingReads;
+			continue;
+		}
+
+		// Page data is its positions, attributes & indices back to back, each goes to its own part of the slot
+		const VkDeviceSize positionsSize = page.uiVertexCount * sizeof(Helper::AttributePosition);
+		const VkDeviceSize attributesSize = page.uiVertexCount * Helper::GetVertexSize(pMesh->m_eVertexFormat) - positionsSize;
+
+		pUpload->batch.AddBufferCopy(m_vkVertexBuffer, stagingOffset, positionsSize, VK_NULL_HANDLE, GetPositionsOffset(entry.uiSlot));
+		pUpload->batch.AddBufferCopy(m_vkVertexBuffer, stagingOffset + positionsSize, attributesSize, VK_NULL_HANDLE, GetAttributesOffset(entry.uiSlot));
+		pUpload->batch.AddBufferCopy(m_vkIndexBuffer, stagingOffset + page.uiIndexDataOffset, page.uiIndexCount * sizeof(uint16_t), VK_NULL_HANDLE,
+										GetFirstIndex(entry.uiSlot) * sizeof(uint16_t));
+
+		// Completions only flag the page, they run on the I/O thread! Compressed data is decoded on the file system's workers
+		PageUploadEntry* pEntry = &entry;
+		pContext->pFileSystem->ReadAsync(pMesh->m_strFilePath, pMesh->m_uiPayloadOffset + page.uiDataOffset, page.uiDataSize, pStaging, nullptr,
+											[pUpload, pEntry](bool bSucceeded)
+											{
+												if (!bSucceeded)
+													pEntry->bFailed = true;
+
+												--pUpload->uiNumPendingReads;
+											});
+	}
+
+	m_ListUploads.push_back(pUpload);
+
+	LOG_DEBUG("Streaming {0} pages, {1} more requested, {2:.2f} MB", numUploads, m_ListRequests.size() - numUploads, stagingSize / (1024.0f * 1024.0f));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Only pages that aren't pinned & weren't visited for longer than frames in flight, so nothing recorded may still draw
+// them. Visiting touches every resident input of a group that's being refined, so no cut in use or on the way loses a
+// page. Least recently used first!
+void VulkanPageStreamer::FindEvictionCandidates()
+{
+	for (VulkanPagedMesh* pMesh : m_ListMeshes)
+	{
+		for (uint32_t i = 0; i < pMesh->m_ListResidency.size(); i++)
+		{
+			const PageResidency& residency = pMesh->m_ListResidency[i];
+			if (residency.eState != PageState::RESIDENT || residency.bPinned || residency.uiLastUsed + Helper::gMaxFramesDraws >= m_uiFrame)
+				continue;
+
+			m_ListEvictionCandidates.push_back({ pMesh, i });
+		}
+	}
+
+	std::sort(m_ListEvictionCandidates.begin(), m_ListEvictionCandidates.end(),
+				[](const std::pair<VulkanPagedMesh*, uint32_t>& a, const std::pair<VulkanPagedMesh*, uint32_t>& b)
+				{
+					return a.first->m_ListResidency[a.second].uiLastUsed < b.first->m_ListResidency[b.second].uiLastUsed;
+				});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanPageStreamer::AllocateSlot(uint32_t* pOutSlot)
+{
+	if (!m_ListFreeSlots.empty())
+	{
+		*pOutSlot = m_ListFreeSlots.back();
+		m_ListFreeSlots.pop_back();
+		return true;
+	}
+
+	if (m_uiNextCandidate >= m_ListEvictionCandidates.size())
+		return false;
+
+	const std::pair<VulkanPagedMesh*, uint32_t>& candidate = m_ListEvictionCandidates[m_uiNextCandidate++];
+	PageResidency& residency = candidate.first->m_ListResidency[candidate.second];
+
+	residency.eState = PageState::NOT_RESIDENT;
+	candidate.first->m_vkResidentBytes -= candidate.first->m_ListPages[candidate.second].uiDataSize;
+	m_uiNumResidentPages--;
+
+	*pOutSlot = residency.uiSlot;
+	return true;
+}
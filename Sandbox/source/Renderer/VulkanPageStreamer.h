@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Renderer/Utility.h"
+
+class VulkanContext;
+class VulkanUploadBatch;
+class VulkanPagedMesh;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Owns the page pool every paged mesh draws from: one vertex & one index buffer cut into equal slots, each one big
+// enough for the largest page (see Helper::g_uiClusterPageTriangles). Positions of all slots come first, then their
+// attributes, like within a single mesh's vertex buffer. Pool size is fixed, so memory stays bounded however much
+// paged geometry the scene has. It's only allocated once the first paged mesh registers, scenes without any never
+// pay for it!
+//
+// Once per frame, after the meshes' visibility update, pages they asked for are read straight into staging memory,
+// most important first, & uploaded on the transfer queue. Slots come from a free list, else from the least recently
+// used page that isn't pinned & no frame in flight still draws. Main thread only, apart from registering!
+class VulkanPageStreamer
+{
+public:
+	VulkanPageStreamer();
+	~VulkanPageStreamer();
+
+	bool								Initialize(const VulkanContext* pContext);
+
+	// Any thread, loaders create their models on their own threads. Registering fails when the mesh's roots don't fit
+	// next to the ones already pinned or the pool couldn't be allocated, unregistering orphans pages still in flight!
+	bool								RegisterMesh(const VulkanContext* pContext, VulkanPagedMesh* pMesh);
+	void								UnregisterMesh(VulkanPagedMesh* pMesh);
+
+	void								Update(const VulkanContext* pContext);
+
+	// Waits for every read & upload in flight, must be called before any paged mesh is destroyed!
+	void								Shutdown(const VulkanContext* pContext);
+	void								Cleanup(const VulkanContext* pContext);
+
+	inline VkBuffer						GetVertexBuffer() const						{ return m_vkVertexBuffer; }
+	inline VkBuffer						GetIndexBuffer() const						{ return m_vkIndexBuffer; }
+	inline VkDeviceSize					GetPositionsOffset(uint32_t slot) const		{ return slot * m_vkSlotPositionsSize; }
+	inline VkDeviceSize					GetAttributesOffset(uint32_t slot) const	{ return m_vkAttributesOffset + slot * m_vkSlotAttributesSize; }
+	inline uint32_t						GetFirstIndex(uint32_t slot) const			{ return slot * Helper::g_uiClusterPageTriangles * 3; }
+
+	inline uint64_t						GetFrame() const							{ return m_uiFrame; }
+	inline uint32_t						GetNumSlots() const							{ return m_uiNumSlots; }
+	inline uint32_t						GetNumResidentPages() const					{ return m_uiNumResidentPages; }
+
+private:
+	struct PageUpload;
+
+	struct QueuedRequest
+	{
+		VulkanPagedMesh*				pMesh;
+		uint32_t						uiPage;
+		float							fPriority;
+	};
+
+	bool								AllocatePool(const VulkanContext* pContext);
+	void								RetireUploads(const VulkanContext* pContext);
+	void								IssueUploads(const VulkanContext* pContext);
+	bool								AllocateSlot(uint32_t* pOutSlot);
+	void								FindEvictionCandidates();
+	void								FinishUpload(const VulkanContext* pContext, PageUpload* pUpload, bool bUploaded);
+
+private:
+	VkBuffer							m_vkVertexBuffer;
+	VkDeviceMemory						m_vkVertexBufferMemory;
+	VkBuffer							m_vkIndexBuffer;
+	VkDeviceMemory						m_vkIndexBufferMemory;
+
+	VkDeviceSize						m_vkSlotPositionsSize;
+	VkDeviceSize						m_vkSlotAttributesSize;
+	VkDeviceSize						m_vkAttributesOffset;
+	VkDeviceSize						m_vkSlotIndicesSize;
+	uint32_t							m_uiNumSlots;					// pool's capacity, allocated or not
+	bool								m_bPoolAllocated;
+	uint32_t							m_uiNumPinnedPages;				// roots of the registered meshes, never evicted
+	std::vector<uint32_t>				m_ListFreeSlots;
+
+	std::mutex							m_MutexMeshes;					// meshes, their residency & the uploads
+	std::vector<VulkanPagedMesh*>		m_ListMeshes;
+	std::vector<PageUpload*>			m_ListUploads;					// oldest first
+
+	// Scratch of Update(), kept so it doesn't allocate every frame
+	std::vector<QueuedRequest>			m_ListRequests;
+	std::vector<std::pair<VulkanPagedMesh*, uint32_t>>	m_ListEvictionCandidates;
+	size_t								m_uiNextCandidate;
+
+	uint64_t							m_uiFrame;
+	uint32_t							m_uiNumResidentPages;
+	bool								m_bPoolFullReported;
+};
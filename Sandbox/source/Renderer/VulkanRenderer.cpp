@@ -3,10 +3,16 @@
 #include "VulkanDevice.h"
 #include "VulkanFrameBuffer.h"
 #include "VulkanContext.h"
+#include "VulkanStagingRing.h"
+#include "VulkanTextureStreamer.h"
+#include "VulkanPageStreamer.h"
+#include "VertexLayout.h"
+#include "Renderables/VulkanMeshCache.h"
 #include "Renderables/VulkanMesh.h"
 #include "Renderables/VulkanCube.h"
 #include "Renderables/VulkanModel.h"
 #include "World/Scene.h"
+#include "Core/VirtualFileSystem.h"
 #include "Core/Core.h"
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -22,6 +28,11 @@ VulkanRenderer::VulkanRenderer()
 //---------------------------------------------------------------------------------------------------------------------
 VulkanRenderer::~VulkanRenderer()
 {
+	SAFE_DELETE(m_pContext->pMeshCache);
+	SAFE_DELETE(m_pContext->pPageStreamer);
+	SAFE_DELETE(m_pContext->pTextureStreamer);
+	SAFE_DELETE(m_pContext->pStagingRing);
+	SAFE_DELETE(m_pContext->pFileSystem);
 	SAFE_DELETE(m_pFrameBuffer);
 	SAFE_DELETE(m_pVulkanDevice);
 	SAFE_DELETE(m_pContext);
@@ -39,10 +50,20 @@ void VulkanRenderer::Cleanup()
 		vkDestroyFence(m_pContext->vkDevice, m_vkListFences[i], nullptr);
 	}
 
-	vkDestroyPipeline(m_pContext->vkDevice, m_pContext->vkForwardRenderingPipeline, nullptr);
+	for (VkPipeline forwardPipeline : m_pContext->vkListForwardRenderingPipelines)
+	{
+		vkDestroyPipeline(m_pContext->vkDevice, forwardPipeline, nullptr);
+	}
+
+	vkDestroyPipeline(m_pContext->vkDevice, m_pContext->vkDepthPrepassPipeline, nullptr);
 	vkDestroyPipelineLayout(m_pContext->vkDevice, m_pContext->vkForwardRenderingPipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(m_pContext->vkDevice, m_pContext->vkModelDescriptorSetLayout, nullptr);
 
 	m_pFrameBuffer->Cleanup(m_pContext);
+	m_pContext->pMeshCache->Cleanup(m_pContext);
+	m_pContext->pPageStreamer->Cleanup(m_pContext);
+	m_pContext->pTextureStreamer->Cleanup(m_pContext);
+	m_pContext->pStagingRing->Cleanup(m_pContext);
 
 	vkDestroyRenderPass(m_pContext->vkDevice, m_pContext->vkForwardRenderingRenderPass, nullptr);
 	
@@ -84,6 +105,63 @@ bool VulkanRenderer::CreateCommandBuffers()
 	return true;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+// Every cooked asset is read through this one. Bad or missing pack only means loose cooked files are read instead!
+bool VulkanRenderer::CreateFileSystem()
+{
+	m_pContext->pFileSystem = new VirtualFileSystem();
+	m_pContext->pFileSystem->Mount(Helper::g_strPackPath);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every upload goes through this one, so it's created before anything which needs uploading!
+bool VulkanRenderer::CreateStagingRing()
+{
+	m_pContext->pStagingRing = new VulkanStagingRing();
+	CHECK(m_pContext->pStagingRing->Initialize(m_pContext, 128 * 1024 * 1024));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanRenderer::CreateTextureStreamer()
+{
+	m_pContext->pTextureStreamer = new VulkanTextureStreamer();
+	CHECK(m_pContext->pTextureStreamer->Initialize(m_pContext));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Models share identical mesh geometry through this, scene cleanup must run before it goes away!
+bool VulkanRenderer::CreateMeshCache()
+{
+	m_pContext->pMeshCache = new VulkanMeshCache();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Fixed page pool is allocated up front, paged meshes register with it as their models are created
+bool VulkanRenderer::CreatePageStreamer()
+{
+	m_pContext->pPageStreamer = new VulkanPageStreamer();
+	CHECK(m_pContext->pPageStreamer->Initialize(m_pContext));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Models stream in after the first frames, so pipeline layout can't borrow one from them. Needed before any model loads!
+bool VulkanRenderer::CreateDescriptorSetLayouts()
+{
+	CHECK(VulkanModel::CreateDescriptorSetLayout(m_pContext, &(m_pContext->vkModelDescriptorSetLayout)));
+
+	return true;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 bool VulkanRenderer::Initialize(GLFWwindow* pWindow, VkInstance instance)
 {
@@ -102,6 +180,14 @@ bool VulkanRenderer::PreSceneLoad()
 	CHECK(CreateRenderPass());	
 	CHECK(CreateFrameBuffers());
 	CHECK(CreateCommandBuffers());
+	CHECK(CreateFileSystem());
+	CHECK(CreateStagingRing());
+	CHECK(CreateTextureStreamer());
+	CHECK(CreateMeshCache());
+	CHECK(CreatePageStreamer());
+	CHECK(CreateDescriptorSetLayouts());
+
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -109,13 +195,34 @@ bool VulkanRenderer::PreSceneLoad()
 bool VulkanRenderer::PostSceneLoad(Scene* pScene)
 {
 	CHECK(CreateGraphicsPipeline(pScene, Helper::FORWARD));
+
+	if (Helper::g_bEnableDepthPrepass)
+		CHECK(CreateGraphicsPipeline(pScene, Helper::DEPTH_PREPASS));
+
 	CHECK(CreateSynchronization());
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+// Scene resources are about to be destroyed, make sure neither GPU nor streaming workers are still using them!
+void VulkanRenderer::PreSceneCleanup(Scene* pScene)
+{
+	pScene->StopLoading();
+
+	vkDeviceWaitIdle(m_pContext->vkDevice);
+	m_pContext->pTextureStreamer->Shutdown(m_pContext);
+	m_pContext->pPageStreamer->Shutdown(m_pContext);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanRenderer::Update(Scene* pScene, float dt)
 {
-	pScene->Update(dt);
+	pScene->Update(m_pContext, dt);
+
+	// Upload whatever got decoded since last frame, ranked with updated camera!
+	m_pContext->pTextureStreamer->Update(m_pContext, pScene->GetCamera());
+
+	// Pages the meshes asked for during their visibility update
+	m_pContext->pPageStreamer->Update(m_pContext);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -150,6 +257,8 @@ void VulkanRenderer::Render(Scene* pScene)
 		return;
 	}
 
+	// Texture descriptors that streamed in are written first, nothing has the sets bound yet
+	pScene->RefreshDescriptors(m_pContext, imageIndex);
 	RecordCommands(pScene, imageIndex);
 
 	pScene->UpdateUniforms(m_pContext, imageIndex);
@@ -273,9 +382,14 @@ void VulkanRenderer::RecordCommands(Scene* pScene, uint32_t currentImage)
 	// Begin RenderPass
 	vkCmdBeginRenderPass(m_pContext->vkListGraphicsCommandBuffers[currentImage], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 	
-	// Bind pipeline to be used in RenderPass
-	vkCmdBindPipeline(m_pContext->vkListGraphicsCommandBuffers[currentImage], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pContext->vkForwardRenderingPipeline);
-	
+	// Depth first, position stream only. Same subpass, forward pass then tests against it!
+	if (Helper::g_bEnableDepthPrepass)
+	{
+		vkCmdBindPipeline(m_pContext->vkListGraphicsCommandBuffers[currentImage], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pContext->vkDepthPrepassPipeline);
+		pScene->RenderDepth(m_pContext, currentImage);
+	}
+
+	// Forward pipelines are bound per vertex format by the models themselves
 	pScene->Render(m_pContext, currentImage);
 	
 	// End RenderPass
@@ -319,16 +433,9 @@ bool VulkanRenderer::CreateGraphicsPipeline(Scene* pScene, Helper::ePipeline pip
 	{
 		case Helper::FORWARD:
 		{
-			// Read shader code & create modules
-			VkShaderModule vsModule = m_pContext->CreateShaderModule("Assets/Shaders/triangle.vert.spv");
-			VkShaderModule fsModule = m_pContext->CreateShaderModule("Assets/Shaders/triangle.frag.spv");
-
-			// Vertex Shader stage creation info
-			VkPipelineShaderStageCreateInfo vsCreateInfo = {};
-			vsCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-			vsCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-			vsCreateInfo.module = vsModule;
-			vsCreateInfo.pName = "main";
+			// Fragment shader is shared, vertex shader & vertex input differ per vertex format (see Helper::VertexLayout)
+			VkShaderModule fsModule = VK_NULL_HANDLE;
+			CHECK(m_pContext->CreateShaderModule("Assets/Shaders/triangle.frag.spv", &fsModule));
 
 			// Fragment Shader stage creation info
 			VkPipelineShaderStageCreateInfo fsCreateInfo = {};
@@ -337,54 +444,6 @@ bool VulkanRenderer::CreateGraphicsPipeline(Scene* pScene, Helper::ePipeline pip
 			fsCreateInfo.module = fsModule;
 			fsCreateInfo.pName = "main";
 
-			std::array<VkPipelineShaderStageCreateInfo, 2> arrShaderStages = { vsCreateInfo, fsCreateInfo };
-
-			// How the data for a single vertex is as a whole!
-			VkVertexInputBindingDescription inputBindingDesc = {};
-			inputBindingDesc.binding = 0;
-			inputBindingDesc.stride = sizeof(Helper::VertexPNTBT);
-			inputBindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-			std::array<VkVertexInputAttributeDescription, 5> attrDesc = {};
-
-			// Position
-			attrDesc[0].binding = 0;
-			attrDesc[0].location = 0;
-			attrDesc[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attrDesc[0].offset = offsetof(Helper::VertexPNTBT, Position);
-
-			// Normal
-			attrDesc[1].binding = 0;
-			attrDesc[1].location = 1;
-			attrDesc[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attrDesc[1].offset = offsetof(Helper::VertexPNTBT, Normal);
-
-			// Tangent
-			attrDesc[2].binding = 0;
-			attrDesc[2].location = 2;
-			attrDesc[2].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attrDesc[2].offset = offsetof(Helper::VertexPNTBT, Tangent);
-
-			// BiNormal
-			attrDesc[3].binding = 0;
-			attrDesc[3].location = 3;
-			attrDesc[3].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attrDesc[3].offset = offsetof(Helper::VertexPNTBT, BiNormal);
-
-			// UV
-			attrDesc[4].binding = 0;
-			attrDesc[4].location = 4;
-			attrDesc[4].format = VK_FORMAT_R32G32_SFLOAT;
-			attrDesc[4].offset = offsetof(Helper::VertexPNTBT, UV);
-
-			// Vertex Input (TODO)
-			VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
-			vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attrDesc.size());
-			vertexInputCreateInfo.pVertexAttributeDescriptions = attrDesc.data();
-			vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-			vertexInputCreateInfo.pVertexBindingDescriptions = &inputBindingDesc;
-			
 			// Input Assembly
 			VkPipelineInputAssemblyStateCreateInfo inputASCreateInfo = {};
 			inputASCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -455,14 +514,21 @@ bool VulkanRenderer::CreateGraphicsPipeline(Scene* pScene, Helper::ePipeline pip
 			colorBlendCreateInfo.attachmentCount = 1;
 			colorBlendCreateInfo.pAttachments = &colorState;
 
-			// Pipeline layout (TODO: Descriptor set layouts)
-			std::array<VkDescriptorSetLayout, 1> setLayouts = { pScene->GetFirstModel()->m_vkDescriptorSetLayout };
+			// Pipeline layout
+			std::array<VkDescriptorSetLayout, 1> setLayouts = { m_pContext->vkModelDescriptorSetLayout };
 			VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
 			pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 			pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
 			pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
-			pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-			pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+
+			// Per mesh quantization bounds
+			VkPushConstantRange pushConstantRange = {};
+			pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			pushConstantRange.offset = 0;
+			pushConstantRange.size = sizeof(Helper::QuantizationBounds);
+
+			pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+			pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
 			VK_CHECK(vkCreatePipelineLayout(m_pContext->vkDevice, &pipelineLayoutCreateInfo, nullptr, &(m_pContext->vkForwardRenderingPipelineLayout)));
 
@@ -470,16 +536,15 @@ bool VulkanRenderer::CreateGraphicsPipeline(Scene* pScene, Helper::ePipeline pip
 			VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
 			depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 			depthStencilCreateInfo.depthTestEnable = VK_TRUE;
-			depthStencilCreateInfo.depthWriteEnable = VK_TRUE;
-			depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+
+			// With prepass depth is already final, only the closest surface passes
+			depthStencilCreateInfo.depthWriteEnable = Helper::g_bEnableDepthPrepass ? VK_FALSE : VK_TRUE;
+			depthStencilCreateInfo.depthCompareOp = Helper::g_bEnableDepthPrepass ? VK_COMPARE_OP_LESS_OR_EQUAL : VK_COMPARE_OP_LESS;
 			depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
 			depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
 
 			VkGraphicsPipelineCreateInfo forwardRenderingPipelineInfo = {};
 			forwardRenderingPipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-			forwardRenderingPipelineInfo.stageCount = static_cast<uint32_t>(arrShaderStages.size());
-			forwardRenderingPipelineInfo.pStages = arrShaderStages.data();
-			forwardRenderingPipelineInfo.pVertexInputState = &vertexInputCreateInfo;
 			forwardRenderingPipelineInfo.pInputAssemblyState = &inputASCreateInfo;
 			forwardRenderingPipelineInfo.pViewportState = &vpCreateInfo;
 			forwardRenderingPipelineInfo.pDynamicState = nullptr;
@@ -493,13 +558,153 @@ bool VulkanRenderer::CreateGraphicsPipeline(Scene* pScene, Helper::ePipeline pip
 			forwardRenderingPipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 			forwardRenderingPipelineInfo.basePipelineIndex = -1;
 
-			//--  Create Graphics Pipeline!!
-			VK_CHECK(vkCreateGraphicsPipelines(m_pContext->vkDevice, VK_NULL_HANDLE, 1, &forwardRenderingPipelineInfo, nullptr, &(m_pContext->vkForwardRenderingPipeline)));
+			// triangle.vert compiled with HAS_UV & HAS_TANGENT defined as each format needs, in Helper::EVertexFormat order
+			const std::array<std::string, Helper::g_uiVertexFormatCount> vertexShaders =
+			{
+				"Assets/Shaders/triangle_pn.vert.spv",
+				"Assets/Shaders/triangle_pnu.vert.spv",
+				"Assets/Shaders/triangle.vert.spv"
+			};
+
+			m_pContext->vkListForwardRenderingPipelines.resize(Helper::g_uiVertexFormatCount, VK_NULL_HANDLE);
+
+			for (uint32_t format = 0; format < Helper::g_uiVertexFormatCount; format++)
+			{
+				VkShaderModule vsModule = VK_NULL_HANDLE;
+				if (!m_pContext->CreateShaderModule(vertexShaders[format], &vsModule))
+				{
+					vkDestroyShaderModule(m_pContext->vkDevice, fsModule, nullptr);
+					return false;
+				}
+
+				// Vertex Shader stage creation info
+				VkPipelineShaderStageCreateInfo vsCreateInfo = {};
+				vsCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+				vsCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+				vsCreateInfo.module = vsModule;
+				vsCreateInfo.pName = "main";
+
+				std::array<VkPipelineShaderStageCreateInfo, 2> arrShaderStages = { vsCreateInfo, fsCreateInfo };
+
+				// Binding & attribute descriptions come from the format's layout, built at compile time
+				VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = Helper::VisitVertexLayout(static_cast<Helper::EVertexFormat>(format),
+																										[](auto layout) { return decltype(layout)::GetInputState(); });
 
-			LOG_DEBUG("Forward Graphics Pipeline created!");
+				forwardRenderingPipelineInfo.stageCount = static_cast<uint32_t>(arrShaderStages.size());
+				forwardRenderingPipelineInfo.pStages = arrShaderStages.data();
+				forwardRenderingPipelineInfo.pVertexInputState = &vertexInputCreateInfo;
+
+				//--  Create Graphics Pipeline!!
+				VK_CHECK(vkCreateGraphicsPipelines(m_pContext->vkDevice, VK_NULL_HANDLE, 1, &forwardRenderingPipelineInfo, nullptr, &(m_pContext->vkListForwardRenderingPipelines[format])));
+
+				vkDestroyShaderModule(m_pContext->vkDevice, vsModule, nullptr);
+			}
+
+			LOG_DEBUG("Forward Graphics Pipelines created, one per vertex format!");
 
 			// Destroy shader module
 			vkDestroyShaderModule(m_pContext->vkDevice, fsModule, nullptr);
+
+			break;
+		}
+
+		// Needs FORWARD's layout, so it's created after it!
+		case Helper::DEPTH_PREPASS:
+		{
+			VkShaderModule vsModule = VK_NULL_HANDLE;
+			CHECK(m_pContext->CreateShaderModule("Assets/Shaders/depth.vert.spv", &vsModule));
+
+			// Vertex stage only, no fragment shader needed for depth
+			VkPipelineShaderStageCreateInfo vsCreateInfo = {};
+			vsCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			vsCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+			vsCreateInfo.module = vsModule;
+			vsCreateInfo.pName = "main";
+
+			// Position stream only, 8 bytes per vertex. Same in every vertex format, so one pipeline takes all meshes
+			VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = Helper::VertexLayoutP::GetInputState();
+
+			VkPipelineInputAssemblyStateCreateInfo inputASCreateInfo = {};
+			inputASCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			inputASCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			inputASCreateInfo.primitiveRestartEnable = VK_FALSE;
+
+			VkViewport vp = {};
+			vp.x = 0.0f;
+			vp.y = 0.0f;
+			vp.width = static_cast<float>(m_pContext->vkSwapchainExtent.width);
+			vp.height = static_cast<float>(m_pContext->vkSwapchainExtent.height);
+			vp.maxDepth = 1.0f;
+			vp.minDepth = 0.0f;
+
+			VkRect2D scissor = {};
+			scissor.offset = { 0, 0 };
+			scissor.extent = m_pContext->vkSwapchainExtent;
+
+			VkPipelineViewportStateCreateInfo vpCreateInfo = {};
+			vpCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			vpCreateInfo.viewportCount = 1;
+			vpCreateInfo.pViewports = &vp;
+			vpCreateInfo.scissorCount = 1;
+			vpCreateInfo.pScissors = &scissor;
+
+			// Must match forward rasterizer so both passes produce the same depth!
+			VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
+			rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			rasterizerCreateInfo.depthClampEnable = VK_FALSE;
+			rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;
+			rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+			rasterizerCreateInfo.lineWidth = 1.0f;
+			rasterizerCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+			rasterizerCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+			rasterizerCreateInfo.depthBiasEnable = VK_FALSE;
+
+			VkPipelineMultisampleStateCreateInfo msCreateInfo = {};
+			msCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			msCreateInfo.sampleShadingEnable = VK_FALSE;
+			msCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+			// Subpass still has the color attachment, nothing gets written to it though
+			VkPipelineColorBlendAttachmentState colorState = {};
+			colorState.colorWriteMask = 0;
+			colorState.blendEnable = VK_FALSE;
+
+			VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo = {};
+			colorBlendCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			colorBlendCreateInfo.logicOpEnable = VK_FALSE;
+			colorBlendCreateInfo.attachmentCount = 1;
+			colorBlendCreateInfo.pAttachments = &colorState;
+
+			VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
+			depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+			depthStencilCreateInfo.depthTestEnable = VK_TRUE;
+			depthStencilCreateInfo.depthWriteEnable = VK_TRUE;
+			depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+			depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
+			depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
+
+			VkGraphicsPipelineCreateInfo depthPrepassPipelineInfo = {};
+			depthPrepassPipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			depthPrepassPipelineInfo.stageCount = 1;
+			depthPrepassPipelineInfo.pStages = &vsCreateInfo;
+			depthPrepassPipelineInfo.pVertexInputState = &vertexInputCreateInfo;
+			depthPrepassPipelineInfo.pInputAssemblyState = &inputASCreateInfo;
+			depthPrepassPipelineInfo.pViewportState = &vpCreateInfo;
+			depthPrepassPipelineInfo.pDynamicState = nullptr;
+			depthPrepassPipelineInfo.pRasterizationState = &rasterizerCreateInfo;
+			depthPrepassPipelineInfo.pMultisampleState = &msCreateInfo;
+			depthPrepassPipelineInfo.pColorBlendState = &colorBlendCreateInfo;
+			depthPrepassPipelineInfo.pDepthStencilState = &depthStencilCreateInfo;
+			depthPrepassPipelineInfo.layout = m_pContext->vkForwardRenderingPipelineLayout;
+			depthPrepassPipelineInfo.renderPass = m_pContext->vkForwardRenderingRenderPass;
+			depthPrepassPipelineInfo.subpass = 0;
+			depthPrepassPipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+			depthPrepassPipelineInfo.basePipelineIndex = -1;
+
+			VK_CHECK(vkCreateGraphicsPipelines(m_pContext->vkDevice, VK_NULL_HANDLE, 1, &depthPrepassPipelineInfo, nullptr, &(m_pContext->vkDepthPrepassPipeline)));
+
+			LOG_DEBUG("Depth Prepass Pipeline created!");
+
 			vkDestroyShaderModule(m_pContext->vkDevice, vsModule, nullptr);
 
 			break;
@@ -24,6 +24,7 @@ public:
 	bool								Initialize(GLFWwindow* pWindow, VkInstance instance);
 	bool								PreSceneLoad();
 	bool								PostSceneLoad(Scene* pScene);
+	void								PreSceneCleanup(Scene* pScene);
 	void								Update(Scene* pScene, float dt);
 	void								Render(Scene* pScene);
 	void								HandleWindowsResize();
@@ -39,6 +40,12 @@ private:
 	bool								CreateFrameBufferAttachments();
 	bool								CreateFrameBuffers();
 	bool								CreateCommandBuffers();
+	bool								CreateFileSystem();
+	bool								CreateStagingRing();
+	bool								CreateTextureStreamer();
+	bool								CreateMeshCache();
+	bool								CreatePageStreamer();
+	bool								CreateDescriptorSetLayouts();
 	bool								CreateGraphicsPipeline(Scene* pScene, Helper::ePipeline pipeline);
 	bool								CreateRenderPass();
 
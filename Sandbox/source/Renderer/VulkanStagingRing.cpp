@@ -0,0 +1,120 @@
+#include "sandboxPCH.h"
+#include "VulkanStagingRing.h"
+#include "VulkanContext.h"
+#include "Core/Core.h"
+
+// Covers texel size of every format we copy into images!
+static const VkDeviceSize gRingAlignment = 16;
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanStagingRing::VulkanStagingRing()
+{
+	m_uiNumDedicated = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanStagingRing::~VulkanStagingRing()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanStagingRing::Initialize(const VulkanContext* pContext, VkDeviceSize capacity)
+{
+	CHECK(pContext->CreateStagingBuffer(capacity, &m_Staging));
+	m_Ring.Reset(capacity, gRingAlignment);
+
+	LOG_DEBUG("Staging ring created, {0} MB", capacity / (1024 * 1024));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Anything bigger than half the ring would block it for everyone else, those get their own buffer. Everything else
+// comes from the ring or fails: main thread callers try again next frame, once retired uploads gave space back. Worker
+// threads can afford to wait a bit for it first!
+bool VulkanStagingRing::Allocate(const VulkanContext* pContext, VkDeviceSize size, StagingAllocation* pOutAllocation, bool bWaitForSpace)
+{
+	if (size > m_Staging.size / 2)
+		return AllocateDedicated(pContext, size, pOutAllocation);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (TryAllocate(size, pOutAllocation))
+		return true;
+
+	if (bWaitForSpace)
+		return m_cvSpaceAvailable.wait_for(lock, std::chrono::milliseconds(250), [&]() { return TryAllocate(size, pOutAllocation); });
+
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Only call once GPU is done reading from the allocation!
+void VulkanStagingRing::Release(const VulkanContext* pContext, StagingAllocation* pAllocation)
+{
+	if (pAllocation->IsDedicated())
+	{
+		pContext->DestroyStagingBuffer(&(pAllocation->dedicated));
+	}
+	else if (pAllocation->uiRegionID != 0)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Ring.Release(pAllocation->uiRegionID);
+		m_cvSpaceAvailable.notify_all();
+	}
+
+	*pAllocation = StagingAllocation();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::Cleanup(const VulkanContext* pContext)
+{
+	if (m_Ring.GetNumRegions() > 0)
+	{
+		LOG_WARNING("Staging ring destroyed with {0} regions still in use!", m_Ring.GetNumRegions());
+	}
+
+	if (m_uiNumDedicated > 0)
+	{
+		LOG_DEBUG("Staging ring needed {0} dedicated buffers for oversized uploads", m_uiNumDedicated.load());
+	}
+
+	pContext->DestroyStagingBuffer(&m_Staging);
+	m_Ring.Reset(0, gRingAlignment);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Caller holds the mutex!
+bool VulkanStagingRing::TryAllocate(VkDeviceSize size, StagingAllocation* pOutAllocation)
+{
+	uint64_t offset = 0;
+	uint64_t uiRegionID = 0;
+	if (!m_Ring.Allocate(size, &offset, &uiRegionID))
+		return false;
+
+	pOutAllocation->buffer = m_Staging.buffer;
+	pOutAllocation->offset = offset;
+	pOutAllocation->size = std::max(size, gRingAlignment);
+	pOutAllocation->pMappedData = m_Staging.pMappedData + offset;
+	pOutAllocation->uiRegionID = uiRegionID;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanStagingRing::AllocateDedicated(const VulkanContext* pContext, VkDeviceSize size, StagingAllocation* pOutAllocation)
+{
+	CHECK(pContext->CreateStagingBuffer(size, &(pOutAllocation->dedicated)));
+
+	pOutAllocation->buffer = pOutAllocation->dedicated.buffer;
+	pOutAllocation->offset = 0;
+	pOutAllocation->size = size;
+	pOutAllocation->pMappedData = pOutAllocation->dedicated.pMappedData;
+	pOutAllocation->uiRegionID = 0;
+
+	++m_uiNumDedicated;
+	LOG_DEBUG("{0} KB is too big for the staging ring, using a dedicated buffer", size / 1024);
+
+	return true;
+}
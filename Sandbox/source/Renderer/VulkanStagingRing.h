@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Renderer/Utility.h"
+#include "Core/RingAllocator.h"
+
+class VulkanContext;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Slice of staging memory, either from the ring or a dedicated buffer for assets too big for it!
+struct StagingAllocation
+{
+	StagingAllocation() : buffer(VK_NULL_HANDLE), offset(0), size(0), pMappedData(nullptr), uiRegionID(0) {}
+
+	inline bool						IsValid() const		{ return buffer != VK_NULL_HANDLE; }
+	inline bool						IsDedicated() const	{ return uiRegionID == 0 && dedicated.buffer != VK_NULL_HANDLE; }
+
+	VkBuffer						buffer;
+	VkDeviceSize					offset;				// into buffer, copy regions must add it!
+	VkDeviceSize					size;
+	uint8_t*						pMappedData;		// already offset
+	uint64_t						uiRegionID;
+	Helper::StagingBuffer			dedicated;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// One persistently mapped staging buffer shared by every upload path. Allocations are handed out front to back &
+// wrap around, space is reclaimed in allocation order once their owner releases them, which upload batches do after
+// the fence of the submit that consumed them has signaled (see RingAllocator). A full ring fails the allocation,
+// callers retry later. Thread safe, workers allocate while main thread releases!
+class VulkanStagingRing
+{
+public:
+	VulkanStagingRing();
+	~VulkanStagingRing();
+
+	bool								Initialize(const VulkanContext* pContext, VkDeviceSize capacity);
+	bool								Allocate(const VulkanContext* pContext, VkDeviceSize size, StagingAllocation* pOutAllocation, bool bWaitForSpace = false);
+	void								Release(const VulkanContext* pContext, StagingAllocation* pAllocation);
+	void								Cleanup(const VulkanContext* pContext);
+
+	inline VkDeviceSize					GetCapacity() const { return m_Staging.size; }
+
+private:
+	bool								TryAllocate(VkDeviceSize size, StagingAllocation* pOutAllocation);
+	bool								AllocateDedicated(const VulkanContext* pContext, VkDeviceSize size, StagingAllocation* pOutAllocation);
+
+private:
+	Helper::StagingBuffer				m_Staging;
+
+	std::mutex							m_Mutex;
+	std::condition_variable				m_cvSpaceAvailable;
+	RingAllocator						m_Ring;
+
+	std::atomic<uint32_t>				m_uiNumDedicated;
+};
@@ -1,15 +1,25 @@
 #include "sandboxPCH.h"
 #include "VulkanContext.h"
 #include "VulkanTexture.h"
+#include "VulkanUploadBatch.h"
+#include "Core/VirtualFileSystem.h"
 #include "Core/Core.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
 //---------------------------------------------------------------------------------------------------------------------
 VulkanTexture::VulkanTexture()
 {
 	m_pImage = nullptr;
+	m_vkTailImageView = VK_NULL_HANDLE;
+	m_vkTextureSampler = VK_NULL_HANDLE;
+	m_pPlaceholder = nullptr;
+	m_bResident = false;
+	m_uiFirstResidentMip = 0;
+	m_bStreaming = false;
+
+	m_iTextureWidth = 0;
+	m_iTextureHeight = 0;
+	m_uiNumMips = 0;
+	m_vkTextureDeviceSize = 0;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -19,102 +29,141 @@ VulkanTexture::~VulkanTexture()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanTexture::CreateTexture(const VulkanContext* pContext, const std::string& filename, VkFormat format)
+bool VulkanTexture::CreateTextureFromData(const VulkanContext* pContext, const unsigned char* pPixels, int width, int height, VkFormat format)
 {
-	m_pImage = new Helper::VulkanImage();
+	CHECK(AllocateImage(pContext, width, height, 1, 0, format));
 
-	CHECK(CreateImage(pContext, filename, format));
-	CHECK(pContext->CreateImageView2D(m_pImage->image, format, VK_IMAGE_ASPECT_COLOR_BIT, &(m_pImage->imageView)));
+	// Batch of one, streamer batches many of them together!
+	VulkanUploadBatch batch;
+	CHECK(batch.Begin(pContext, m_vkTextureDeviceSize));
 
-	// Create Sampler
-	CHECK(CreateTextureSampler(pContext));
+	VkDeviceSize offset = batch.Stage(pPixels, m_vkTextureDeviceSize);
+	RecordUpload(&batch, offset, 0, 1);
+
+	bool bSubmitted = batch.Submit(pContext);
+	batch.Cleanup(pContext);
 
-	LOG_DEBUG("Created Vulkan Texture for {0}", filename);
+	CHECK(bSubmitted);
+
+	m_bResident = true;
 
 	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanTexture::Cleanup(const VulkanContext* pContext)
+// Creates image with all of its mips, views & sampler without any data. Texture stays non-resident till its upload is
+// submitted! Mips from tailMip on get a view of their own, so they can be shown before the finer ones are in. Host copy
+// images can additionally be written by UploadFromHost() instead of going through a batch.
+bool VulkanTexture::AllocateImage(const VulkanContext* pContext, int width, int height, uint32_t numMips, uint32_t tailMip, VkFormat format, bool bHostCopy)
 {
-	vkDestroySampler(pContext->vkDevice, m_vkTextureSampler, nullptr);
+	VkImageUsageFlags usageFlags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
-	vkDestroyImageView(pContext->vkDevice, m_pImage->imageView, nullptr);
-	vkDestroyImage(pContext->vkDevice, m_pImage->image, nullptr);
-	vkFreeMemory(pContext->vkDevice, m_pImage->deviceMemory, nullptr);
+#ifdef VK_EXT_host_image_copy
+	if (bHostCopy)
+		usageFlags |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+#endif
+
+	m_iTextureWidth = width;
+	m_iTextureHeight = height;
+	m_uiNumMips = numMips;
+	m_vkTextureDeviceSize = Helper::GetMipRangeSize(static_cast<uint32_t>(width), static_cast<uint32_t>(height), 0, numMips);
+
+	if (!m_pImage)
+		m_pImage = new Helper::VulkanImage();
+
+	CHECK(	pContext->CreateImage2D(m_iTextureWidth, 
+									m_iTextureHeight, 
+									format, 
+									VK_IMAGE_TILING_OPTIMAL, 
+									usageFlags, 
+									VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
+									&(m_pImage->image), 
+									&(m_pImage->deviceMemory),
+									numMips));
+
+	CHECK(pContext->CreateImageView2D(m_pImage->image, format, VK_IMAGE_ASPECT_COLOR_BIT, &(m_pImage->imageView), 0, numMips));
+
+	if (tailMip > 0)
+	{
+		CHECK(pContext->CreateImageView2D(m_pImage->image, format, VK_IMAGE_ASPECT_COLOR_BIT, &m_vkTailImageView, tailMip, numMips - tailMip));
+	}
+
+	// Create Sampler
+	CHECK(CreateTextureSampler(pContext));
+
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanTexture::CleanupOnWindowResize(const VulkanContext* pContext)
+void VulkanTexture::RecordUpload(VulkanUploadBatch* pBatch, VkDeviceSize stagingOffset, uint32_t firstMip, uint32_t endMip, VkBuffer srcBuffer) const
 {
+	const uint32_t width = static_cast<uint32_t>(m_iTextureWidth);
+	const uint32_t height = static_cast<uint32_t>(m_iTextureHeight);
+
+	for (uint32_t mip = firstMip; mip < endMip; mip++)
+	{
+		VkDeviceSize offset = stagingOffset + Helper::GetMipRangeSize(width, height, mip + 1, endMip);
+		pBatch->AddImageCopy(m_pImage->image, mip, offset, Helper::GetMipExtent(width, mip), Helper::GetMipExtent(height, mip), srcBuffer);
+	}
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-unsigned char* VulkanTexture::LoadImageData(const VulkanContext* pContext, const std::string& filename)
+// Image must have been allocated with bHostCopy, caller still has to MarkResident() on main thread!
+bool VulkanTexture::UploadFromHost(const VulkanContext* pContext, const unsigned char* pPixels, uint32_t firstMip, uint32_t endMip) const
 {
-	// Number of channels in image
-	int channels = 0;
+	const uint32_t width = static_cast<uint32_t>(m_iTextureWidth);
+	const uint32_t height = static_cast<uint32_t>(m_iTextureHeight);
 
-	// Load pixel data for an image
-	unsigned char* imageData = stbi_load(filename.c_str(), &m_iTextureWidth, &m_iTextureHeight, &m_iTextureChannels, STBI_rgb_alpha);
-	if (!imageData)
+	for (uint32_t mip = firstMip; mip < endMip; mip++)
 	{
-		LOG_ERROR(("Failed to load a Texture file! (" + filename + ")").c_str());
+		const unsigned char* pMip = pPixels + Helper::GetMipRangeSize(width, height, mip + 1, endMip);
+		CHECK(pContext->CopyMemoryToImage(pMip, m_pImage->image, Helper::GetMipExtent(width, mip), Helper::GetMipExtent(height, mip), mip));
 	}
 
-	// Calculate image size using given data
-	m_vkTextureDeviceSize = m_iTextureWidth * m_iTextureHeight * 4;
-
-	return imageData;
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanTexture::CreateImage(const VulkanContext* pContext, const std::string& filename, VkFormat format)
+bool VulkanTexture::ReadCookedHeader(const VirtualFileSystem* pFileSystem, const std::string& filePath, Helper::CookedTextureHeader& outHeader)
 {
-	// Load image data!
-	stbi_uc* imgData = LoadImageData(pContext, filename);
-	
-	// Create staging buffer to hold the loaded data, ready to copy to device
-	VkBuffer imageStagingBuffer;
-	VkDeviceMemory imageStagingBufferMemory;
-
-	CHECK(pContext->CreateBuffer(	m_vkTextureDeviceSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-									VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-									&imageStagingBuffer, &imageStagingBufferMemory));
-
-	// Copy image data to staging buffer
-	void* data;
-	vkMapMemory(pContext->vkDevice, imageStagingBufferMemory, 0, m_vkTextureDeviceSize, 0, &data);
-	memcpy(data, imgData, static_cast<uint32_t>(m_vkTextureDeviceSize));
-	vkUnmapMemory(pContext->vkDevice, imageStagingBufferMemory);
-
-	// Free original image data
-	stbi_image_free(imgData);
-
-	// Create Image...
-	CHECK(	pContext->CreateImage2D(m_iTextureWidth, 
-									m_iTextureHeight, 
-									format, 
-									VK_IMAGE_TILING_OPTIMAL, 
-									VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
-									VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-									&(m_pImage->image), 
-									&(m_pImage->deviceMemory)));
+	uint64_t fileSize = 0;
+	if (!pFileSystem->GetFileSize(filePath, &fileSize) || fileSize < sizeof(outHeader) || !pFileSystem->Read(filePath, 0, sizeof(outHeader), &outHeader))
+	{
+		LOG_ERROR("Failed to open cooked Texture {0}, is the Cooker run?", filePath);
+		return false;
+	}
 
-	// Transition image to be DST for copy operation
-	pContext->TransitionImageLayout(m_pImage->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	if (outHeader.uiMagic != Helper::g_uiCookedTextureMagic || outHeader.uiVersion != Helper::g_uiCookedVersion || outHeader.uiWidth == 0 || outHeader.uiHeight == 0 ||
+		outHeader.uiNumMips == 0 || outHeader.uiNumMips > Helper::GetMipCount(outHeader.uiWidth, outHeader.uiHeight) ||
+		outHeader.uiDataSize != Helper::GetMipRangeSize(outHeader.uiWidth, outHeader.uiHeight, 0, outHeader.uiNumMips) || sizeof(outHeader) + outHeader.uiDataSize > fileSize)
+	{
+		LOG_ERROR("Cooked Texture {0} is stale or corrupt, re-run the Cooker!", filePath);
+		return false;
+	}
 
-	// COPY DATA TO IMAGE!
-	pContext->CopyImageBuffer(imageStagingBuffer, m_pImage->image, m_iTextureWidth, m_iTextureHeight);
+	return true;
+}
 
-	// Transition image to be Shader Readable for shader usage
-	pContext->TransitionImageLayout(m_pImage->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTexture::Cleanup(const VulkanContext* pContext)
+{
+	// Streamed texture which never became resident doesn't own any Vulkan object yet!
+	if (!m_pImage)
+		return;
 
-	// Destroy staging buffers
-	vkDestroyBuffer(pContext->vkDevice, imageStagingBuffer, nullptr);
-	vkFreeMemory(pContext->vkDevice, imageStagingBufferMemory, nullptr);
+	vkDestroySampler(pContext->vkDevice, m_vkTextureSampler, nullptr);
 
-	return true;
+	vkDestroyImageView(pContext->vkDevice, m_vkTailImageView, nullptr);
+	vkDestroyImageView(pContext->vkDevice, m_pImage->imageView, nullptr);
+	vkDestroyImage(pContext->vkDevice, m_pImage->image, nullptr);
+	vkFreeMemory(pContext->vkDevice, m_pImage->deviceMemory, nullptr);
+
+	m_bResident = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTexture::CleanupOnWindowResize(const VulkanContext* pContext)
+{
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -133,7 +182,7 @@ bool VulkanTexture::CreateTextureSampler(const VulkanContext* pContext)
 	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;				// Mipmap interpolation mode
 	samplerCreateInfo.mipLodBias = 0.0f;										// Level of detail bias for mip level
 	samplerCreateInfo.minLod = 0.0f;											// minimum level of detail to pick mip level
-	samplerCreateInfo.maxLod = 0.0f;											// maximum level of detail to pick mip level
+	samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;								// maximum level of detail to pick mip level, view limits it to its mips
 	samplerCreateInfo.anisotropyEnable = VK_FALSE;								// Enable Anisotropy or not? Check physical device features to see if anisotropy is supported or not!
 	samplerCreateInfo.maxAnisotropy = 16;										// Anisotropy sample level
 
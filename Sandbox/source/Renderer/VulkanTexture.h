@@ -1,8 +1,11 @@
 #pragma once
 
 #include "Renderer/Utility.h"
+#include "Renderer/CookedFormat.h"
 
 class VulkanContext;
+class VulkanUploadBatch;
+class VirtualFileSystem;
 enum class TextureType;
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -12,27 +15,53 @@ public:
 	VulkanTexture();
 	~VulkanTexture();
 
-	bool						CreateTexture(const VulkanContext* pContext, const std::string& filename, VkFormat format);
+	bool						CreateTextureFromData(const VulkanContext* pContext, const unsigned char* pPixels, int width, int height, VkFormat format);
+	bool						AllocateImage(const VulkanContext* pContext, int width, int height, uint32_t numMips, uint32_t tailMip, VkFormat format, bool bHostCopy = false);
+
+	// Mips [firstMip, endMip) laid out smallest first, just like cooked textures store them!
+	void						RecordUpload(VulkanUploadBatch* pBatch, VkDeviceSize stagingOffset, uint32_t firstMip, uint32_t endMip, VkBuffer srcBuffer = VK_NULL_HANDLE) const;
+	bool						UploadFromHost(const VulkanContext* pContext, const unsigned char* pPixels, uint32_t firstMip, uint32_t endMip) const;
 	void						Cleanup(const VulkanContext* pContext);
 	void						CleanupOnWindowResize(const VulkanContext* pContext);
 
+	// Reads & checks a cooked texture's header, texels follow it & are read by caller. Safe to call from worker threads!
+	static bool					ReadCookedHeader(const VirtualFileSystem* pFileSystem, const std::string& filePath, Helper::CookedTextureHeader& outHeader);
+
 public:
-	inline VkImage				getVkImage()		{ return m_pImage->image; }
-	inline VkImageView			getVkImageView()	{ return m_pImage->imageView; }
-	inline VkSampler			getVkSampler()		{ return m_vkTextureSampler; }
+	// Until the real data is uploaded, texture hands out placeholder's view & sampler so it can be bound right away!
+	inline void					SetPlaceholder(const VulkanTexture* pPlaceholder)	{ m_pPlaceholder = pPlaceholder; }
+	inline bool					IsResident() const									{ return m_bResident; }
+	inline bool					IsFullyResident() const								{ return m_bResident && m_uiFirstResidentMip == 0; }
+	inline bool					IsAllocated() const									{ return m_pImage != nullptr; }
+
+	// Mips from uiFirstMip on can be sampled, either all of them or the tail AllocateImage() was given. Streaming goes on
+	// till the finer ones are in too!
+	inline void					MarkResident(uint32_t uiFirstMip = 0)				{ m_uiFirstResidentMip = uiFirstMip; m_bResident = true; m_bStreaming = (uiFirstMip > 0); }
+
+	// Set while the streamer may still write into it, cleared once resident or given up on. Not safe to destroy before!
+	inline bool					IsStreaming() const									{ return m_bStreaming; }
+	inline void					SetStreaming(bool bStreaming)						{ m_bStreaming = bStreaming; }
+	inline VkDeviceSize			GetDeviceSize() const								{ return m_vkTextureDeviceSize; }
+
+	inline VkImage				getVkImage() const			{ return (m_bResident || !m_pPlaceholder) ? m_pImage->image : m_pPlaceholder->getVkImage(); }
+	inline VkImageView			getVkImageView() const		{ return (m_bResident || !m_pPlaceholder) ? GetResidentView() : m_pPlaceholder->getVkImageView(); }
+	inline VkSampler			getVkSampler() const		{ return (m_bResident || !m_pPlaceholder) ? m_vkTextureSampler : m_pPlaceholder->getVkSampler(); }
 
 private:
 	Helper::VulkanImage*		m_pImage;
+	VkImageView					m_vkTailImageView;					// coarse mips only, sampled till the finer ones are in
 	VkSampler					m_vkTextureSampler;
-								
-private:						
-	unsigned char*				LoadImageData(const VulkanContext* pContext, const std::string& filename);
-	bool						CreateImage(const VulkanContext* pContext, const std::string& filename, VkFormat format);
+	const VulkanTexture*		m_pPlaceholder;
+	bool						m_bResident;
+	uint32_t					m_uiFirstResidentMip;
+	std::atomic<bool>			m_bStreaming;						// cleared on streamer's workers too
+
+private:
 	bool						CreateTextureSampler(const VulkanContext* pContext);
-								
+	inline VkImageView			GetResidentView() const		{ return (m_uiFirstResidentMip > 0) ? m_vkTailImageView : m_pImage->imageView; }
+
 	int							m_iTextureWidth;
 	int							m_iTextureHeight;
-	int							m_iTextureChannels;
+	uint32_t					m_uiNumMips;
 	VkDeviceSize				m_vkTextureDeviceSize;
 };
-
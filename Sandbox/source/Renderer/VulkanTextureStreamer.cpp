@@ -0,0 +1,656 @@
+#include "sandboxPCH.h"
+#include "VulkanTextureStreamer.h"
+#include "VulkanTexture.h"
+#include "VulkanMaterial.h"
+#include "VulkanContext.h"
+#include "VulkanUploadBatch.h"
+#include "Core/ThreadPool.h"
+#include "Core/VirtualFileSystem.h"
+#include "Core/Core.h"
+#include "World/Camera.h"
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	// Given up on: textures keep sampling their placeholder, but their owners may destroy them now!
+	void StopStreaming(const std::vector<VulkanTexture*>& listTextures)
+	{
+		for (VulkanTexture* pTexture : listTextures)
+			pTexture->SetStreaming(false);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// First mip that fits the tail size, the smallest one if none does. Zero means there are no finer mips!
+	uint32_t GetTailMip(uint32_t width, uint32_t height, uint32_t numMips)
+	{
+		uint32_t mip = 0;
+		while (mip + 1 < numMips && std::max(Helper::GetMipExtent(width, mip), Helper::GetMipExtent(height, mip)) > Helper::g_uiTextureTailSize)
+			mip++;
+
+		return mip;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Every tail before any finer mips, most important first within either!
+	bool IsLessImportant(const TextureStreamRequest& a, const TextureStreamRequest& b)
+	{
+		if (a.bFineMips != b.bFineMips)
+			return a.bFineMips;
+
+		return a.fPriority < b.fPriority;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanTextureStreamer::VulkanTextureStreamer()
+{
+	m_pWorkers = nullptr;
+
+	m_ListPendingRequests.clear();
+	m_ListDecodedTextures.clear();
+
+	m_uiNumInFlight = 0;
+	m_uiNumDeferred = 0;
+	m_vkMaxUploadBytesPerFrame = 0;
+
+	m_pPlaceholderAlbedo = nullptr;
+	m_pPlaceholderNormal = nullptr;
+	m_pPlaceholderBlack = nullptr;
+	m_pPlaceholderError = nullptr;
+	m_pPlaceholderORM = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanTextureStreamer::~VulkanTextureStreamer()
+{
+	SAFE_DELETE(m_pWorkers);
+
+	SAFE_DELETE(m_pPlaceholderAlbedo);
+	SAFE_DELETE(m_pPlaceholderNormal);
+	SAFE_DELETE(m_pPlaceholderBlack);
+	SAFE_DELETE(m_pPlaceholderError);
+	SAFE_DELETE(m_pPlaceholderORM);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTextureStreamer::Initialize(const VulkanContext* pContext)
+{
+	CHECK(CreatePlaceholders(pContext));
+
+	// Half the ring per frame, so decoded textures waiting for next frame still have room!
+	m_vkMaxUploadBytesPerFrame = pContext->pStagingRing->GetCapacity() / 2;
+
+	// Leave one core for the main thread, it's busy recording & uploading!
+	uint32_t numCores = std::thread::hardware_concurrency();
+	m_pWorkers = new ThreadPool(numCores > 1 ? numCores - 1 : 1);
+
+	LOG_DEBUG("Texture streamer initialized!");
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTextureStreamer::RequestTexture(const VulkanContext* pContext, VulkanTexture* pTexture, const std::string& filePath, VkFormat format, TextureType type, const StreamingBounds* pBounds)
+{
+	return QueueRequest(pContext, pTexture, filePath, format, type, pBounds);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTextureStreamer::QueueRequest(const VulkanContext* pContext, VulkanTexture* pTexture, const std::string& key, VkFormat format, TextureType type, const StreamingBounds* pBounds)
+{
+	if (!pTexture)
+		return false;
+
+	// Texture can be bound right away, it just samples the placeholder till real data arrives!
+	pTexture->SetPlaceholder(GetPlaceholder(type));
+	pTexture->SetStreaming(true);
+
+	{
+		std::lock_guard<std::mutex> lock(m_MutexRequests);
+
+		// Same file's tail still waiting for a worker? Piggyback on it!
+		for (TextureStreamRequest& pending : m_ListPendingRequests)
+		{
+			if (pending.strFilePath == key && pending.vkFormat == format && !pending.bFineMips)
+			{
+				pending.listTextures.push_back(pTexture);
+				if (pBounds)
+					pending.listBounds.push_back(pBounds);
+
+				return true;
+			}
+		}
+
+		TextureStreamRequest request;
+		request.listTextures.push_back(pTexture);
+		if (pBounds)
+			request.listBounds.push_back(pBounds);
+		request.strFilePath = key;
+		request.vkFormat = format;
+
+		m_ListPendingRequests.push_back(request);
+	}
+
+	++m_uiNumInFlight;
+
+	// Job doesn't carry the request, it picks whatever is most important at the time it gets to run!
+	m_pWorkers->Enqueue([this, pContext]() { LoadNextRequest(pContext); });
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTextureStreamer::Update(const VulkanContext* pContext, const Camera* pCamera)
+{
+	if (m_uiNumInFlight == 0)
+		return;
+
+	RetireCompletedUploads(pContext, false);
+	ResolveHostCopiedTextures(pContext);
+
+	// Retired uploads gave staging ring space back, requests which found it full get another go
+	for (uint32_t uiNumDeferred = m_uiNumDeferred.exchange(0); uiNumDeferred > 0; --uiNumDeferred)
+		m_pWorkers->Enqueue([this, pContext]() { LoadNextRequest(pContext); });
+
+	UpdatePriorities(pCamera);
+	UploadDecodedTextures(pContext, m_vkMaxUploadBytesPerFrame);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Stop decoding, must be called before any texture which might still be pending is destroyed!
+void VulkanTextureStreamer::Shutdown(const VulkanContext* pContext)
+{
+	DropPendingRequests();
+
+	// Requests already picked up finish issuing their reads, reads finish & queue their completions, completions run.
+	// Only then workers are joined, in-progress decodes will land in decoded list! Ones which found the staging ring
+	// full meanwhile went back to pending list.
+	if (m_pWorkers)
+	{
+		m_pWorkers->WaitIdle();
+		pContext->pFileSystem->WaitAsyncIdle();
+		m_pWorkers->WaitIdle();
+	}
+
+	SAFE_DELETE(m_pWorkers);
+
+	DropPendingRequests();
+	m_uiNumDeferred = 0;
+
+	std::lock_guard<std::mutex> lock(m_MutexDecoded);
+	for (DecodedTexture& decoded : m_ListDecodedTextures)
+	{
+		pContext->pStagingRing->Release(pContext, &decoded.staging);
+		StopStreaming(decoded.listTextures);
+	}
+
+	for (const DecodedTexture& decoded : m_ListHostCopiedTextures)
+		StopStreaming(decoded.listTextures);
+
+	m_uiNumInFlight -= static_cast<uint32_t>(m_ListDecodedTextures.size() + m_ListHostCopiedTextures.size());
+	m_ListDecodedTextures.clear();
+	m_ListHostCopiedTextures.clear();
+
+	RetireCompletedUploads(pContext, true);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTextureStreamer::Cleanup(const VulkanContext* pContext)
+{
+	Shutdown(pContext);
+
+	if (m_pPlaceholderAlbedo)	{ m_pPlaceholderAlbedo->Cleanup(pContext); }
+	if (m_pPlaceholderNormal)	{ m_pPlaceholderNormal->Cleanup(pContext); }
+	if (m_pPlaceholderBlack)	{ m_pPlaceholderBlack->Cleanup(pContext); }
+	if (m_pPlaceholderError)	{ m_pPlaceholderError->Cleanup(pContext); }
+	if (m_pPlaceholderORM)		{ m_pPlaceholderORM->Cleanup(pContext); }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTextureStreamer::CreatePlaceholders(const VulkanContext* pContext)
+{
+	// 1x1 texel is all we need, sampler repeats it across the whole mesh!
+	const unsigned char albedo[4] = { 188, 188, 188, 255 };		// ~0.5 linear grey
+	const unsigned char normal[4] = { 128, 128, 255, 255 };		// flat tangent space normal
+	const unsigned char black[4]  = { 0, 0, 0, 255 };
+	const unsigned char error[4]  = { 255, 0, 255, 255 };
+	const unsigned char orm[4]    = { 255, 128, 64, 255 };		// same values as Missing*.png defaults
+
+	m_pPlaceholderAlbedo = new VulkanTexture();
+	CHECK(m_pPlaceholderAlbedo->CreateTextureFromData(pContext, albedo, 1, 1, VK_FORMAT_R8G8B8A8_SRGB));
+
+	m_pPlaceholderNormal = new VulkanTexture();
+	CHECK(m_pPlaceholderNormal->CreateTextureFromData(pContext, normal, 1, 1, VK_FORMAT_R8G8B8A8_UNORM));
+
+	m_pPlaceholderBlack = new VulkanTexture();
+	CHECK(m_pPlaceholderBlack->CreateTextureFromData(pContext, black, 1, 1, VK_FORMAT_R8G8B8A8_UNORM));
+
+	m_pPlaceholderError = new VulkanTexture();
+	CHECK(m_pPlaceholderError->CreateTextureFromData(pContext, error, 1, 1, VK_FORMAT_R8G8B8A8_UNORM));
+
+	m_pPlaceholderORM = new VulkanTexture();
+	CHECK(m_pPlaceholderORM->CreateTextureFromData(pContext, orm, 1, 1, VK_FORMAT_R8G8B8A8_UNORM));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const VulkanTexture* VulkanTextureStreamer::GetPlaceholder(TextureType type) const
+{
+	switch (type)
+	{
+		case TextureType::TEXTURE_ALBEDO:		return m_pPlaceholderAlbedo;
+		case TextureType::TEXTURE_NORMAL:		return m_pPlaceholderNormal;
+		case TextureType::TEXTURE_EMISSIVE:		return m_pPlaceholderBlack;
+		case TextureType::TEXTURE_ORM:			return m_pPlaceholderORM;
+		case TextureType::TEXTURE_HDRI:			return m_pPlaceholderBlack;
+		default:								return m_pPlaceholderError;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Priority is the approximate radius in pixels the owner covers on screen. Projection already accounts for camera
+// distance, objects behind the camera still get streamed but after everything which is visible! Shared textures
+// take the priority of their most important owner.
+
+void VulkanTextureStreamer::UpdatePriorities(const Camera* pCamera)
+{
+	const float projScale = glm::abs(pCamera->m_matProjection[1][1]) * 0.5f * static_cast<float>(gWindowHeight);
+
+	std::lock_guard<std::mutex> lock(m_MutexRequests);
+
+	for (TextureStreamRequest& request : m_ListPendingRequests)
+	{
+		// Requests without owner bounds are always needed first!
+		if (request.listBounds.size() < request.listTextures.size())
+		{
+			request.fPriority = std::numeric_limits<float>::max();
+			continue;
+		}
+
+		request.fPriority = 0.0f;
+
+		for (const StreamingBounds* pBounds : request.listBounds)
+		{
+			glm::vec3 toBounds = pBounds->center - pCamera->m_vecCameraPosition;
+			float distance = glm::length(toBounds);
+			float radius = pBounds->radius;
+
+			// Camera inside the bounds, it covers the entire screen!
+			float priority = static_cast<float>(gWindowHeight);
+
+			if (distance > radius)
+			{
+				priority = (radius * projScale) / glm::sqrt(distance * distance - radius * radius);
+
+				if (glm::dot(toBounds, pCamera->m_vecCameraDirection) < -radius)
+				{
+					priority *= 0.1f;
+				}
+			}
+
+			request.fPriority = std::max(request.fPriority, priority);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cooked textures are already RGBA8 with all of their mips, texels are read through the file system straight into
+// staging memory, there's no decode & no heap copy. Either the tail or the finer mips, each is one contiguous range of
+// the file. Worker only issues the read & moves on, completion comes back as a job of its own so many textures are read
+// at once. Main thread never touches the pixels! Worker waits a bit for staging ring space, request is retried next
+// frame if that's not enough.
+void VulkanTextureStreamer::LoadNextRequest(const VulkanContext* pContext)
+{
+	TextureStreamRequest request;
+
+	{
+		std::lock_guard<std::mutex> lock(m_MutexRequests);
+
+		if (m_ListPendingRequests.empty())
+			return;
+
+		auto iter = std::max_element(m_ListPendingRequests.begin(), m_ListPendingRequests.end(), IsLessImportant);
+
+		request = *iter;
+		*iter = m_ListPendingRequests.back();
+		m_ListPendingRequests.pop_back();
+	}
+
+	DecodedTexture decoded;
+	decoded.listTextures = request.listTextures;
+	decoded.listBounds = request.listBounds;
+	decoded.strFilePath = request.strFilePath;
+	decoded.vkFormat = request.vkFormat;
+
+	// Missing or stale file keeps sampling the placeholder, error is already logged!
+	Helper::CookedTextureHeader header;
+	if (!VulkanTexture::ReadCookedHeader(pContext->pFileSystem, request.strFilePath, header))
+	{
+		StopStreaming(request.listTextures);
+		--m_uiNumInFlight;
+		return;
+	}
+
+	decoded.iWidth = static_cast<int>(header.uiWidth);
+	decoded.iHeight = static_cast<int>(header.uiHeight);
+	decoded.uiNumMips = header.uiNumMips;
+	decoded.uiTailMip = GetTailMip(header.uiWidth, header.uiHeight, header.uiNumMips);
+	decoded.uiFirstMip = request.bFineMips ? 0 : decoded.uiTailMip;
+	decoded.uiEndMip = request.bFineMips ? decoded.uiTailMip : header.uiNumMips;
+
+	// Smaller mips come first in the file, so whatever is coarser than this range sits between header & range
+	const uint64_t offset = sizeof(header) + Helper::GetMipRangeSize(header.uiWidth, header.uiHeight, decoded.uiEndMip, header.uiNumMips);
+	const VkDeviceSize size = Helper::GetMipRangeSize(header.uiWidth, header.uiHeight, decoded.uiFirstMip, decoded.uiEndMip);
+
+	// Host image copy: no staging, no command buffer, no queue. Worker writes every target image right here! Decided
+	// once per file with its tail, images without host transfer usage can't take it for their finer mips.
+	const bool bHostCopy = request.bFineMips ? request.bHostCopy : pContext->SupportsHostImageCopy(request.vkFormat);
+	if (bHostCopy && pContext->bUseHostImageCopy)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+
+		// Uncompressed pack entry is copied into the images right from the mapping, anything else is read first
+		uint64_t mappedSize = 0;
+		const unsigned char* pPixels = pContext->pFileSystem->GetMappedData(request.strFilePath, &mappedSize);
+		if (pPixels)
+		{
+			HostCopyTexture(pContext, decoded, pPixels + offset, startTime);
+			return;
+		}
+
+		auto pListPixels = std::make_shared<std::vector<unsigned char>>(static_cast<size_t>(size));
+		pContext->pFileSystem->ReadAsync(request.strFilePath, offset, size, pListPixels->data(), m_pWorkers,
+			[this, pContext, decoded, pListPixels, startTime](bool bRead)
+			{
+				if (!bRead)
+				{
+					LOG_ERROR("Failed to read cooked texture {0}", decoded.strFilePath);
+					StopStreaming(decoded.listTextures);
+					--m_uiNumInFlight;
+					return;
+				}
+
+				HostCopyTexture(pContext, decoded, pListPixels->data(), startTime);
+			});
+
+		return;
+	}
+
+	// Ring is still full after waiting a bit, back to pending list till main thread retired some uploads
+	if (!pContext->pStagingRing->Allocate(pContext, size, &decoded.staging, true))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_MutexRequests);
+			m_ListPendingRequests.push_back(request);
+		}
+
+		++m_uiNumDeferred;
+		return;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	pContext->pFileSystem->ReadAsync(request.strFilePath, offset, size, decoded.staging.pMappedData, m_pWorkers,
+		[this, pContext, decoded, startTime](bool bRead) mutable
+		{
+			if (!bRead)
+			{
+				LOG_ERROR("Failed to read cooked texture {0}", decoded.strFilePath);
+				pContext->pStagingRing->Release(pContext, &decoded.staging);
+				StopStreaming(decoded.listTextures);
+				--m_uiNumInFlight;
+				return;
+			}
+
+			float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+			LOG_DEBUG("Read {0} ({1}x{2}, mips {3}-{4}) into staging in {5:.2f} ms", decoded.strFilePath, decoded.iWidth, decoded.iHeight, decoded.uiFirstMip,
+						decoded.uiEndMip - 1, elapsedMs);
+
+			std::lock_guard<std::mutex> lock(m_MutexDecoded);
+			m_ListDecodedTextures.push_back(decoded);
+		});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Worker writes every target image right here, main thread only flips them resident! Images are allocated along with
+// their tail, finer mips go into the same ones.
+void VulkanTextureStreamer::HostCopyTexture(const VulkanContext* pContext, DecodedTexture decoded, const unsigned char* pPixels,
+											std::chrono::steady_clock::time_point startTime)
+{
+	std::vector<VulkanTexture*> listTextures;
+	listTextures.swap(decoded.listTextures);
+
+	const bool bAllocate = (decoded.uiEndMip == decoded.uiNumMips);
+
+	for (VulkanTexture* pTexture : listTextures)
+	{
+		if ((!bAllocate || pTexture->AllocateImage(pContext, decoded.iWidth, decoded.iHeight, decoded.uiNumMips, decoded.uiTailMip, decoded.vkFormat, true)) &&
+			pTexture->UploadFromHost(pContext, pPixels, decoded.uiFirstMip, decoded.uiEndMip))
+		{
+			decoded.listTextures.push_back(pTexture);
+		}
+		else
+		{
+			LOG_ERROR("Failed to host copy streamed texture {0}", decoded.strFilePath);
+			pTexture->SetStreaming(false);
+		}
+	}
+
+	float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	LOG_DEBUG("Host copied {0} ({1}x{2}, mips {3}-{4}) into {5} textures in {6:.2f} ms", decoded.strFilePath, decoded.iWidth, decoded.iHeight, decoded.uiFirstMip,
+				decoded.uiEndMip - 1, decoded.listTextures.size(), elapsedMs);
+
+	std::lock_guard<std::mutex> lock(m_MutexDecoded);
+	m_ListHostCopiedTextures.push_back(decoded);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Everything decoded so far goes into one submit, capped by size so a burst of 4K textures doesn't stall a single
+// frame for too long. At least one texture always goes through! Copies source straight from the staging buffers
+// workers decoded into, batch releases them once the submit is done.
+
+void VulkanTextureStreamer::UploadDecodedTextures(const VulkanContext* pContext, VkDeviceSize maxUploadBytes)
+{
+	std::vector<DecodedTexture> listUploads;
+	VkDeviceSize uploadSize = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_MutexDecoded);
+
+		size_t numUploads = 0;
+		for (; numUploads < m_ListDecodedTextures.size(); ++numUploads)
+		{
+			VkDeviceSize size = m_ListDecodedTextures[numUploads].staging.size;
+
+			if (numUploads > 0 && uploadSize + size > maxUploadBytes)
+				break;
+
+			uploadSize += size;
+		}
+
+		listUploads.assign(m_ListDecodedTextures.begin(), m_ListDecodedTextures.begin() + numUploads);
+		m_ListDecodedTextures.erase(m_ListDecodedTextures.begin(), m_ListDecodedTextures.begin() + numUploads);
+	}
+
+	if (listUploads.empty())
+		return;
+
+	InFlightUpload upload;
+	upload.pBatch = new VulkanUploadBatch();
+	upload.uiNumFiles = static_cast<uint32_t>(listUploads.size());
+
+	bool bBatchReady = upload.pBatch->Begin(pContext, 0);
+
+	for (DecodedTexture& decoded : listUploads)
+	{
+		// Images are allocated along with their tail, finer mips go into the same ones
+		const bool bAllocate = (decoded.uiEndMip == decoded.uiNumMips);
+
+		TextureStreamRequest fineMips;
+		fineMips.listBounds = decoded.listBounds;
+		fineMips.strFilePath = decoded.strFilePath;
+		fineMips.vkFormat = decoded.vkFormat;
+		fineMips.bFineMips = true;
+
+		// Shared file: one staging buffer, one copy per mip & target image!
+		for (VulkanTexture* pTexture : decoded.listTextures)
+		{
+			if (!bBatchReady)
+			{
+				pTexture->SetStreaming(false);
+				continue;
+			}
+
+			if (!bAllocate || pTexture->AllocateImage(pContext, decoded.iWidth, decoded.iHeight, decoded.uiNumMips, decoded.uiTailMip, decoded.vkFormat))
+			{
+				pTexture->RecordUpload(upload.pBatch, decoded.staging.offset, decoded.uiFirstMip, decoded.uiEndMip, decoded.staging.buffer);
+				upload.listTextures.push_back(pTexture);
+				upload.listFirstMips.push_back(decoded.uiFirstMip);
+				fineMips.listTextures.push_back(pTexture);
+			}
+			else
+			{
+				LOG_ERROR("Failed to allocate streamed texture {0}", decoded.strFilePath);
+				pTexture->SetStreaming(false);
+			}
+		}
+
+		if (decoded.uiFirstMip > 0 && !fineMips.listTextures.empty())
+			upload.listFineMipRequests.push_back(fineMips);
+
+		upload.pBatch->AdoptStaging(decoded.staging);
+	}
+
+	if (bBatchReady && upload.pBatch->SubmitAsync(pContext))
+	{
+		LOG_DEBUG("Submitted {0} files into {1} textures, {2} MB on transfer queue", listUploads.size(), upload.listTextures.size(), uploadSize / (1024 * 1024));
+
+		// Files stay in flight until the batch has retired!
+		upload.submitTime = std::chrono::steady_clock::now();
+		m_ListInFlightUploads.push_back(upload);
+		return;
+	}
+
+	LOG_ERROR("Failed to upload {0} streamed textures!", listUploads.size());
+
+	// Whatever did get submitted must be done before staging goes back to the ring!
+	vkQueueWaitIdle(pContext->vkQueueGraphics);
+
+	upload.pBatch->Cleanup(pContext);
+	SAFE_DELETE(upload.pBatch);
+
+	StopStreaming(upload.listTextures);
+	m_uiNumInFlight -= upload.uiNumFiles;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Polls fences of submitted batches, oldest first. Textures of a finished batch get flagged resident & its staging
+// goes back to the ring. Waiting for all is only meant for shutdown!
+void VulkanTextureStreamer::RetireCompletedUploads(const VulkanContext* pContext, bool bWaitForAll)
+{
+	if (m_ListInFlightUploads.empty())
+		return;
+
+	// Acquire submit on graphics queue is the last one of every batch, idle graphics queue means all of them are done!
+	if (bWaitForAll)
+	{
+		vkQueueWaitIdle(pContext->vkQueueGraphics);
+	}
+
+	auto itrUpload = m_ListInFlightUploads.begin();
+	while (itrUpload != m_ListInFlightUploads.end())
+	{
+		if (!itrUpload->pBatch->IsComplete(pContext))
+		{
+			++itrUpload;
+			continue;
+		}
+
+		for (size_t i = 0; i < itrUpload->listTextures.size(); ++i)
+		{
+			itrUpload->listTextures[i]->MarkResident(itrUpload->listFirstMips[i]);
+		}
+
+		for (const TextureStreamRequest& request : itrUpload->listFineMipRequests)
+		{
+			QueueFineMips(pContext, request);
+		}
+
+		// Upper bound of the GPU side, fence is only polled once per frame!
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - itrUpload->submitTime).count();
+		LOG_DEBUG("Streamed in {0} files into {1} textures, retired {2:.2f} ms after submit", itrUpload->uiNumFiles, itrUpload->listTextures.size(), elapsedMs);
+
+		itrUpload->pBatch->Cleanup(pContext);
+		SAFE_DELETE(itrUpload->pBatch);
+
+		m_uiNumInFlight -= itrUpload->uiNumFiles;
+		itrUpload = m_ListInFlightUploads.erase(itrUpload);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pixels are already in the images, residency just has to flip on main thread so descriptors get re-written!
+void VulkanTextureStreamer::ResolveHostCopiedTextures(const VulkanContext* pContext)
+{
+	std::vector<DecodedTexture> listHostCopied;
+
+	{
+		std::lock_guard<std::mutex> lock(m_MutexDecoded);
+		listHostCopied.swap(m_ListHostCopiedTextures);
+	}
+
+	for (const DecodedTexture& decoded : listHostCopied)
+	{
+		for (VulkanTexture* pTexture : decoded.listTextures)
+		{
+			pTexture->MarkResident(decoded.uiFirstMip);
+		}
+
+		if (decoded.uiFirstMip > 0 && !decoded.listTextures.empty())
+		{
+			TextureStreamRequest fineMips;
+			fineMips.listTextures = decoded.listTextures;
+			fineMips.listBounds = decoded.listBounds;
+			fineMips.strFilePath = decoded.strFilePath;
+			fineMips.vkFormat = decoded.vkFormat;
+			fineMips.bFineMips = true;
+			fineMips.bHostCopy = true;
+
+			QueueFineMips(pContext, fineMips);
+		}
+
+		--m_uiNumInFlight;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Tail is in, finer mips of the same textures wait behind every other tail. Once workers are gone textures just keep
+// showing their tail!
+void VulkanTextureStreamer::QueueFineMips(const VulkanContext* pContext, const TextureStreamRequest& request)
+{
+	if (!m_pWorkers)
+	{
+		StopStreaming(request.listTextures);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_MutexRequests);
+		m_ListPendingRequests.push_back(request);
+	}
+
+	++m_uiNumInFlight;
+	m_pWorkers->Enqueue([this, pContext]() { LoadNextRequest(pContext); });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTextureStreamer::DropPendingRequests()
+{
+	std::lock_guard<std::mutex> lock(m_MutexRequests);
+	for (const TextureStreamRequest& request : m_ListPendingRequests)
+		StopStreaming(request.listTextures);
+
+	m_uiNumInFlight -= static_cast<uint32_t>(m_ListPendingRequests.size());
+	m_ListPendingRequests.clear();
+}
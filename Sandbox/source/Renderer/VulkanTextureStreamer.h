@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Renderer/Utility.h"
+#include "Renderer/VulkanStagingRing.h"
+#include "Renderer/VulkanTexture.h"
+
+class VulkanContext;
+class VulkanUploadBatch;
+class ThreadPool;
+class Camera;
+enum class TextureType;
+
+//---------------------------------------------------------------------------------------------------------------------
+// World space bounding sphere of whoever requested the texture, used to rank pending requests!
+struct StreamingBounds
+{
+	StreamingBounds() : center(glm::vec3(0)), radius(0.0f) {}
+
+	glm::vec3						center;
+	float							radius;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Several textures may point to the same cooked file (shared PBR sets, Missing*.png fallbacks), one read serves them all!
+// Every file is requested for its coarse mip tail first, then once more for the finer mips.
+struct TextureStreamRequest
+{
+	TextureStreamRequest() : vkFormat(VK_FORMAT_UNDEFINED), fPriority(0.0f), bFineMips(false), bHostCopy(false) {}
+
+	std::vector<VulkanTexture*>				listTextures;
+	std::vector<const StreamingBounds*>		listBounds;
+	std::string								strFilePath;
+	VkFormat								vkFormat;
+	float									fPriority;
+	bool									bFineMips;						// textures already show their tail
+	bool									bHostCopy;						// finer mips only, whether tail was host copied
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pixels of mips [uiFirstMip, uiEndMip) already live in staging ring memory, main thread only records the copies!
+struct DecodedTexture
+{
+	DecodedTexture() : vkFormat(VK_FORMAT_UNDEFINED), iWidth(0), iHeight(0), uiNumMips(0), uiTailMip(0), uiFirstMip(0), uiEndMip(0) {}
+
+	std::vector<VulkanTexture*>				listTextures;
+	std::vector<const StreamingBounds*>		listBounds;						// carried over to the finer mips' request
+	std::string								strFilePath;
+	VkFormat								vkFormat;
+	StagingAllocation						staging;
+	int										iWidth;
+	int										iHeight;
+	uint32_t								uiNumMips;
+	uint32_t								uiTailMip;
+	uint32_t								uiFirstMip;
+	uint32_t								uiEndMip;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Batch submitted on transfer queue, its textures stay on placeholders until graphics queue has acquired them!
+struct InFlightUpload
+{
+	InFlightUpload() : pBatch(nullptr), uiNumFiles(0) {}
+
+	VulkanUploadBatch*						pBatch;
+	std::vector<VulkanTexture*>				listTextures;
+	std::vector<uint32_t>					listFirstMips;					// per texture, resident from there on once retired
+	std::vector<TextureStreamRequest>		listFineMipRequests;			// queued once retired
+	uint32_t								uiNumFiles;
+	std::chrono::steady_clock::time_point	submitTime;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Textures are bound with a tiny placeholder as soon as they are requested. Worker threads read the cooked texture
+// files, highest screen space coverage first. Coarse mips up to Helper::g_uiTextureTailSize come first & are shown on
+// their own, finer mips of a file are only read once no tail is waiting any more. With host image copy workers write
+// the pixels into the image themselves, otherwise main thread uploads whatever is read in a single batched submit on
+// the transfer queue & flags it resident once the fence says so, render loop never waits on it. Owners are expected to
+// re-write their descriptors whenever IsResident() or IsFullyResident() flips!
+class VulkanTextureStreamer
+{
+public:
+	VulkanTextureStreamer();
+	~VulkanTextureStreamer();
+
+	bool								Initialize(const VulkanContext* pContext);
+	bool								RequestTexture(const VulkanContext* pContext, VulkanTexture* pTexture, const std::string& filePath, VkFormat format, TextureType type, const StreamingBounds* pBounds = nullptr);
+	void								Update(const VulkanContext* pContext, const Camera* pCamera);
+	void								Shutdown(const VulkanContext* pContext);
+	void								Cleanup(const VulkanContext* pContext);
+
+	inline uint32_t						GetNumPendingRequests() const { return m_uiNumInFlight; }
+
+	// Never block on each other's reads, so other loaders' read completions can run on them too. Gone after Shutdown()!
+	inline ThreadPool*					GetWorkers() const { return m_pWorkers; }
+
+private:
+	bool								QueueRequest(const VulkanContext* pContext, VulkanTexture* pTexture, const std::string& key, VkFormat format, TextureType type, const StreamingBounds* pBounds);
+	bool								CreatePlaceholders(const VulkanContext* pContext);
+	const VulkanTexture*				GetPlaceholder(TextureType type) const;
+	void								UpdatePriorities(const Camera* pCamera);
+	void								LoadNextRequest(const VulkanContext* pContext);
+	void								HostCopyTexture(const VulkanContext* pContext, DecodedTexture decoded, const unsigned char* pPixels, std::chrono::steady_clock::time_point startTime);
+	void								UploadDecodedTextures(const VulkanContext* pContext, VkDeviceSize maxUploadBytes);
+	void								RetireCompletedUploads(const VulkanContext* pContext, bool bWaitForAll);
+	void								ResolveHostCopiedTextures(const VulkanContext* pContext);
+	void								QueueFineMips(const VulkanContext* pContext, const TextureStreamRequest& request);
+	void								DropPendingRequests();
+
+private:
+	ThreadPool*							m_pWorkers;
+
+	std::mutex							m_MutexRequests;
+	std::vector<TextureStreamRequest>	m_ListPendingRequests;
+
+	std::mutex							m_MutexDecoded;
+	std::vector<DecodedTexture>			m_ListDecodedTextures;
+	std::vector<DecodedTexture>			m_ListHostCopiedTextures;		// already written by worker, no staging
+
+	std::vector<InFlightUpload>			m_ListInFlightUploads;			// main thread only
+
+	std::atomic<uint32_t>				m_uiNumInFlight;
+	std::atomic<uint32_t>				m_uiNumDeferred;				// requests back in pending list, staging ring was full
+	VkDeviceSize						m_vkMaxUploadBytesPerFrame;
+
+	// Shared placeholders, one per texture type!
+	VulkanTexture*						m_pPlaceholderAlbedo;
+	VulkanTexture*						m_pPlaceholderNormal;
+	VulkanTexture*						m_pPlaceholderBlack;
+	VulkanTexture*						m_pPlaceholderError;
+	VulkanTexture*						m_pPlaceholderORM;
+};
@@ -0,0 +1,407 @@
+#include "sandboxPCH.h"
+#include "VulkanUploadBatch.h"
+#include "VulkanContext.h"
+#include "VulkanStagingRing.h"
+#include "Core/Core.h"
+
+// Offsets into staging buffer must be a multiple of texel size for image copies, 16 covers every format we use!
+static const VkDeviceSize gStagingAlignment = 16;
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanUploadBatch::VulkanUploadBatch()
+{
+	m_vkStagingHead = 0;
+	m_ListAdoptedStaging.clear();
+
+	m_vkFence = VK_NULL_HANDLE;
+	m_vkSemaphore = VK_NULL_HANDLE;
+	m_vkTransferCmdBuffer = VK_NULL_HANDLE;
+	m_vkGraphicsCmdBuffer = VK_NULL_HANDLE;
+
+	m_ListImageCopies.clear();
+	m_ListBufferCopies.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanUploadBatch::~VulkanUploadBatch()
+{
+	m_ListImageCopies.clear();
+	m_ListBufferCopies.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Staging size must cover every Reserve() call of this batch, including alignment padding between them. Zero is
+// fine when every copy sources from adopted staging buffers! Fails while the staging ring is full, see VulkanStagingRing.
+bool VulkanUploadBatch::Begin(const VulkanContext* pContext, VkDeviceSize stagingSize, bool bWaitForSpace)
+{
+	m_vkStagingHead = 0;
+
+	if (stagingSize > 0 && !pContext->pStagingRing->Allocate(pContext, stagingSize, &m_Staging, bWaitForSpace))
+		return false;
+
+	VkFenceCreateInfo fenceCreateInfo = {};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	VK_CHECK(vkCreateFence(pContext->vkDevice, &fenceCreateInfo, nullptr, &m_vkFence));
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns mapped, write-combined memory. Write it sequentially & never read it back!
+void* VulkanUploadBatch::Reserve(VkDeviceSize size, VkDeviceSize* pOutOffset)
+{
+	VkDeviceSize offset = (m_vkStagingHead + gStagingAlignment - 1) & ~(gStagingAlignment - 1);
+
+	if (offset + size > m_Staging.size)
+	{
+		LOG_ERROR("Upload batch staging buffer overflow! ({0} + {1} > {2})", offset, size, m_Staging.size);
+		return nullptr;
+	}
+
+	m_vkStagingHead = offset + size;
+	*pOutOffset = m_Staging.offset + offset;
+
+	return m_Staging.pMappedData + offset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VkDeviceSize VulkanUploadBatch::Stage(const void* pData, VkDeviceSize size)
+{
+	VkDeviceSize offset = 0;
+
+	void* pStaging = Reserve(size, &offset);
+	if (pStaging)
+	{
+		memcpy(pStaging, pData, static_cast<size_t>(size));
+	}
+
+	return offset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Batch takes ownership, allocation goes back to the ring in Cleanup() once the copies sourcing from it are done!
+void VulkanUploadBatch::AdoptStaging(const StagingAllocation& staging)
+{
+	m_ListAdoptedStaging.push_back(staging);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// One mip per copy, barriers only cover that mip. Rest of the image may be sampled by frames in flight meanwhile!
+void VulkanUploadBatch::AddImageCopy(VkImage image, uint32_t mipLevel, VkDeviceSize stagingOffset, uint32_t width, uint32_t height, VkBuffer srcBuffer)
+{
+	ImageUploadRegion region = {};
+	region.srcBuffer = (srcBuffer != VK_NULL_HANDLE) ? srcBuffer : m_Staging.buffer;
+	region.image = image;
+	region.mipLevel = mipLevel;
+	region.stagingOffset = stagingOffset;
+	region.width = width;
+	region.height = height;
+
+	m_ListImageCopies.push_back(region);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Barriers only cover the copied range, rest of the buffer may be in use by frames in flight meanwhile!
+void VulkanUploadBatch::AddBufferCopy(VkBuffer buffer, VkDeviceSize stagingOffset, VkDeviceSize size, VkBuffer srcBuffer, VkDeviceSize dstOffset)
+{
+	BufferUploadRegion region = {};
+	region.srcBuffer = (srcBuffer != VK_NULL_HANDLE) ? srcBuffer : m_Staging.buffer;
+	region.buffer = buffer;
+	region.stagingOffset = stagingOffset;
+	region.dstOffset = dstOffset;
+	region.size = size;
+
+	m_ListBufferCopies.push_back(region);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Blocking, on graphics queue. Meant for load time where nothing is being rendered yet!
+bool VulkanUploadBatch::Submit(const VulkanContext* pContext)
+{
+	if (IsEmpty())
+		return true;
+
+	m_vkGraphicsCmdBuffer = pContext->BeginCommandBuffer();
+
+	RecordCopies(m_vkGraphicsCmdBuffer, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+	VK_CHECK(vkEndCommandBuffer(m_vkGraphicsCmdBuffer));
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_vkGraphicsCmdBuffer;
+
+	// Only wait for our own work, not for everything else which might be on the graphics queue!
+	VK_CHECK(vkQueueSubmit(pContext->vkQueueGraphics, 1, &submitInfo, m_vkFence));
+	VK_CHECK(vkWaitForFences(pContext->vkDevice, 1, &m_vkFence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+
+	m_ListImageCopies.clear();
+	m_ListBufferCopies.clear();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Copies run on transfer queue & end with a release barrier. Graphics queue waits on the semaphore & acquires the
+// resources in a tiny command buffer of its own, fence signals once that one is done. Without a dedicated transfer
+// family, it's a single non blocking submit on graphics queue!
+bool VulkanUploadBatch::SubmitAsync(const VulkanContext* pContext)
+{
+	if (IsEmpty())
+		return true;
+
+	const uint32_t transferFamily = pContext->uiTransferQueueFamily;
+	const uint32_t graphicsFamily = pContext->uiGraphicsQueueFamily;
+
+	if (transferFamily == graphicsFamily)
+	{
+		m_vkGraphicsCmdBuffer = pContext->BeginCommandBuffer();
+		RecordCopies(m_vkGraphicsCmdBuffer, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+		VK_CHECK(vkEndCommandBuffer(m_vkGraphicsCmdBuffer));
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_vkGraphicsCmdBuffer;
+
+		VK_CHECK(vkQueueSubmit(pContext->vkQueueGraphics, 1, &submitInfo, m_vkFence));
+
+		m_ListImageCopies.clear();
+		m_ListBufferCopies.clear();
+
+		return true;
+	}
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VK_CHECK(vkCreateSemaphore(pContext->vkDevice, &semaphoreCreateInfo, nullptr, &m_vkSemaphore));
+
+	// Copies + release on transfer queue...
+	m_vkTransferCmdBuffer = pContext->BeginCommandBuffer(pContext->vkTransferCommandPool);
+	RecordCopies(m_vkTransferCmdBuffer, transferFamily, graphicsFamily);
+	VK_CHECK(vkEndCommandBuffer(m_vkTransferCmdBuffer));
+
+	// ...acquire on graphics queue!
+	m_vkGraphicsCmdBuffer = pContext->BeginCommandBuffer();
+	RecordAcquire(m_vkGraphicsCmdBuffer, transferFamily, graphicsFamily);
+	VK_CHECK(vkEndCommandBuffer(m_vkGraphicsCmdBuffer));
+
+	VkSubmitInfo transferSubmitInfo = {};
+	transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	transferSubmitInfo.commandBufferCount = 1;
+	transferSubmitInfo.pCommandBuffers = &m_vkTransferCmdBuffer;
+	transferSubmitInfo.signalSemaphoreCount = 1;
+	transferSubmitInfo.pSignalSemaphores = &m_vkSemaphore;
+
+	VK_CHECK(vkQueueSubmit(pContext->vkQueueTransfer, 1, &transferSubmitInfo, VK_NULL_HANDLE));
+
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	VkSubmitInfo graphicsSubmitInfo = {};
+	graphicsSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	graphicsSubmitInfo.waitSemaphoreCount = 1;
+	graphicsSubmitInfo.pWaitSemaphores = &m_vkSemaphore;
+	graphicsSubmitInfo.pWaitDstStageMask = &waitStage;
+	graphicsSubmitInfo.commandBufferCount = 1;
+	graphicsSubmitInfo.pCommandBuffers = &m_vkGraphicsCmdBuffer;
+
+	VK_CHECK(vkQueueSubmit(pContext->vkQueueGraphics, 1, &graphicsSubmitInfo, m_vkFence));
+
+	m_ListImageCopies.clear();
+	m_ListBufferCopies.clear();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanUploadBatch::IsComplete(const VulkanContext* pContext) const
+{
+	// Nothing was submitted, nothing to wait for!
+	if (m_vkGraphicsCmdBuffer == VK_NULL_HANDLE)
+		return true;
+
+	return vkGetFenceStatus(pContext->vkDevice, m_vkFence) == VK_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Must only be called once IsComplete() says so, or after a blocking Submit()!
+void VulkanUploadBatch::Cleanup(const VulkanContext* pContext)
+{
+	pContext->pStagingRing->Release(pContext, &m_Staging);
+
+	for (StagingAllocation& staging : m_ListAdoptedStaging)
+	{
+		pContext->pStagingRing->Release(pContext, &staging);
+	}
+
+	m_ListAdoptedStaging.clear();
+
+	if (m_vkGraphicsCmdBuffer != VK_NULL_HANDLE)
+		vkFreeCommandBuffers(pContext->vkDevice, pContext->vkGraphicsCommandPool, 1, &m_vkGraphicsCmdBuffer);
+
+	if (m_vkTransferCmdBuffer != VK_NULL_HANDLE)
+		vkFreeCommandBuffers(pContext->vkDevice, pContext->vkTransferCommandPool, 1, &m_vkTransferCmdBuffer);
+
+	vkDestroySemaphore(pContext->vkDevice, m_vkSemaphore, nullptr);
+	vkDestroyFence(pContext->vkDevice, m_vkFence, nullptr);
+
+	m_vkGraphicsCmdBuffer = VK_NULL_HANDLE;
+	m_vkTransferCmdBuffer = VK_NULL_HANDLE;
+	m_vkSemaphore = VK_NULL_HANDLE;
+	m_vkFence = VK_NULL_HANDLE;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// With different queue families, post copy barriers only release ownership. Layout transition is part of the release
+// & is repeated by the matching acquire, access flags on the other queue's side must be zero!
+void VulkanUploadBatch::RecordCopies(VkCommandBuffer cmdBuffer, uint32_t srcQueueFamily, uint32_t dstQueueFamily)
+{
+	std::vector<VkImageMemoryBarrier> listToTransfer(m_ListImageCopies.size());
+
+	for (size_t i = 0; i < m_ListImageCopies.size(); ++i)
+	{
+		// UNDEFINED --> TRANSFER_DST, old content doesn't matter so there's nothing to acquire!
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_ListImageCopies[i].image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = m_ListImageCopies[i].mipLevel;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		listToTransfer[i] = barrier;
+	}
+
+	if (!listToTransfer.empty())
+	{
+		vkCmdPipelineBarrier(	cmdBuffer,
+								VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+								0,
+								0, nullptr,
+								0, nullptr,
+								static_cast<uint32_t>(listToTransfer.size()), listToTransfer.data());
+	}
+
+	// Copy all images...
+	for (const ImageUploadRegion& copy : m_ListImageCopies)
+	{
+		VkBufferImageCopy imgRegion = {};
+		imgRegion.bufferOffset = copy.stagingOffset;
+		imgRegion.bufferRowLength = 0;
+		imgRegion.bufferImageHeight = 0;
+		imgRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imgRegion.imageSubresource.mipLevel = copy.mipLevel;
+		imgRegion.imageSubresource.baseArrayLayer = 0;
+		imgRegion.imageSubresource.layerCount = 1;
+		imgRegion.imageOffset = { 0, 0, 0 };
+		imgRegion.imageExtent = { copy.width, copy.height, 1 };
+
+		vkCmdCopyBufferToImage(cmdBuffer, copy.srcBuffer, copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imgRegion);
+	}
+
+	// ...and all buffers!
+	for (const BufferUploadRegion& copy : m_ListBufferCopies)
+	{
+		VkBufferCopy bufferRegion = {};
+		bufferRegion.srcOffset = copy.stagingOffset;
+		bufferRegion.dstOffset = copy.dstOffset;
+		bufferRegion.size = copy.size;
+
+		vkCmdCopyBuffer(cmdBuffer, copy.srcBuffer, copy.buffer, 1, &bufferRegion);
+	}
+
+	std::vector<VkImageMemoryBarrier> listImageBarriers;
+	std::vector<VkBufferMemoryBarrier> listBufferBarriers;
+	BuildPostCopyBarriers(srcQueueFamily, dstQueueFamily, listImageBarriers, listBufferBarriers);
+
+	VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	// Release, transfer queue doesn't know about graphics stages!
+	if (srcQueueFamily != dstQueueFamily)
+	{
+		dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		for (VkImageMemoryBarrier& barrier : listImageBarriers)		{ barrier.dstAccessMask = 0; }
+		for (VkBufferMemoryBarrier& barrier : listBufferBarriers)	{ barrier.dstAccessMask = 0; }
+	}
+
+	vkCmdPipelineBarrier(	cmdBuffer,
+							VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+							0,
+							0, nullptr,
+							static_cast<uint32_t>(listBufferBarriers.size()), listBufferBarriers.data(),
+							static_cast<uint32_t>(listImageBarriers.size()), listImageBarriers.data());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanUploadBatch::RecordAcquire(VkCommandBuffer cmdBuffer, uint32_t srcQueueFamily, uint32_t dstQueueFamily)
+{
+	std::vector<VkImageMemoryBarrier> listImageBarriers;
+	std::vector<VkBufferMemoryBarrier> listBufferBarriers;
+	BuildPostCopyBarriers(srcQueueFamily, dstQueueFamily, listImageBarriers, listBufferBarriers);
+
+	for (VkImageMemoryBarrier& barrier : listImageBarriers)		{ barrier.srcAccessMask = 0; }
+	for (VkBufferMemoryBarrier& barrier : listBufferBarriers)	{ barrier.srcAccessMask = 0; }
+
+	// Semaphore wait already covers transfer queue's writes, chain onto its wait stage!
+	vkCmdPipelineBarrier(	cmdBuffer,
+							VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+							0,
+							0, nullptr,
+							static_cast<uint32_t>(listBufferBarriers.size()), listBufferBarriers.data(),
+							static_cast<uint32_t>(listImageBarriers.size()), listImageBarriers.data());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// TRANSFER_DST --> SHADER_READ_ONLY for images & transfer write --> vertex/index read for buffers!
+void VulkanUploadBatch::BuildPostCopyBarriers(uint32_t srcQueueFamily, uint32_t dstQueueFamily, std::vector<VkImageMemoryBarrier>& listImageBarriers,
+												std::vector<VkBufferMemoryBarrier>& listBufferBarriers) const
+{
+	listImageBarriers.resize(m_ListImageCopies.size());
+	listBufferBarriers.resize(m_ListBufferCopies.size());
+
+	for (size_t i = 0; i < m_ListImageCopies.size(); ++i)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = srcQueueFamily;
+		barrier.dstQueueFamilyIndex = dstQueueFamily;
+		barrier.image = m_ListImageCopies[i].image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = m_ListImageCopies[i].mipLevel;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		listImageBarriers[i] = barrier;
+	}
+
+	for (size_t i = 0; i < m_ListBufferCopies.size(); ++i)
+	{
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+		barrier.srcQueueFamilyIndex = srcQueueFamily;
+		barrier.dstQueueFamilyIndex = dstQueueFamily;
+		barrier.buffer = m_ListBufferCopies[i].buffer;
+		barrier.offset = m_ListBufferCopies[i].dstOffset;
+		barrier.size = m_ListBufferCopies[i].size;
+
+		listBufferBarriers[i] = barrier;
+	}
+}
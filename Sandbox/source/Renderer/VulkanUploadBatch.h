@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Renderer/Utility.h"
+#include "Renderer/VulkanStagingRing.h"
+
+class VulkanContext;
+
+//---------------------------------------------------------------------------------------------------------------------
+struct ImageUploadRegion
+{
+	VkBuffer						srcBuffer;
+	VkImage							image;
+	uint32_t						mipLevel;
+	VkDeviceSize					stagingOffset;
+	uint32_t						width;							// of the mip
+	uint32_t						height;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct BufferUploadRegion
+{
+	VkBuffer						srcBuffer;
+	VkBuffer						buffer;
+	VkDeviceSize					stagingOffset;
+	VkDeviceSize					dstOffset;
+	VkDeviceSize					size;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Collects any number of buffer & image uploads into one staging buffer & records them into a single command buffer.
+// All layout transitions are batched into one barrier before & one after the copies, so N textures cost one submit!
+// Loaders should Reserve() & write straight into the mapped staging memory instead of building their own copy first.
+// Staging comes from the context's staging ring. Copies may also source from other ring allocations, adopted ones are
+// released together with the batch once its fence has signaled.
+// Reserve() offsets are into the ring buffer, not the batch's allocation, they can go into copy regions as they are.
+//
+// Submit() blocks & runs on graphics queue, fine during load. SubmitAsync() runs the copies on the transfer queue &
+// hands ownership over to graphics queue through a semaphore, caller polls IsComplete() & calls Cleanup() after!
+class VulkanUploadBatch
+{
+public:
+	VulkanUploadBatch();
+	~VulkanUploadBatch();
+
+	bool								Begin(const VulkanContext* pContext, VkDeviceSize stagingSize, bool bWaitForSpace = false);
+	void*								Reserve(VkDeviceSize size, VkDeviceSize* pOutOffset);
+	VkDeviceSize						Stage(const void* pData, VkDeviceSize size);
+	void								AdoptStaging(const StagingAllocation& staging);
+	void								AddImageCopy(VkImage image, uint32_t mipLevel, VkDeviceSize stagingOffset, uint32_t width, uint32_t height,
+													VkBuffer srcBuffer = VK_NULL_HANDLE);
+	void								AddBufferCopy(VkBuffer buffer, VkDeviceSize stagingOffset, VkDeviceSize size, VkBuffer srcBuffer = VK_NULL_HANDLE,
+													VkDeviceSize dstOffset = 0);
+	bool								Submit(const VulkanContext* pContext);
+	bool								SubmitAsync(const VulkanContext* pContext);
+	bool								IsComplete(const VulkanContext* pContext) const;
+	void								Cleanup(const VulkanContext* pContext);
+
+	inline bool							IsEmpty() const { return m_ListImageCopies.empty() && m_ListBufferCopies.empty(); }
+
+private:
+	void								RecordCopies(VkCommandBuffer cmdBuffer, uint32_t srcQueueFamily, uint32_t dstQueueFamily);
+	void								RecordAcquire(VkCommandBuffer cmdBuffer, uint32_t srcQueueFamily, uint32_t dstQueueFamily);
+	void								BuildPostCopyBarriers(uint32_t srcQueueFamily, uint32_t dstQueueFamily, std::vector<VkImageMemoryBarrier>& listImageBarriers,
+															std::vector<VkBufferMemoryBarrier>& listBufferBarriers) const;
+
+private:
+	StagingAllocation					m_Staging;
+	VkDeviceSize						m_vkStagingHead;
+	std::vector<StagingAllocation>		m_ListAdoptedStaging;
+
+	VkFence								m_vkFence;
+	VkSemaphore							m_vkSemaphore;					// transfer --> graphics handoff
+	VkCommandBuffer						m_vkTransferCmdBuffer;
+	VkCommandBuffer						m_vkGraphicsCmdBuffer;
+
+	std::vector<ImageUploadRegion>		m_ListImageCopies;
+	std::vector<BufferUploadRegion>		m_ListBufferCopies;
+};
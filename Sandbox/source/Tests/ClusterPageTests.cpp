@@ -0,0 +1,243 @@
+#include "sandboxPCH.h"
+#include "TestFramework.h"
+#include "Renderables/ClusterPageBuilder.h"
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<glm::vec3>			listPositions;
+		std::vector<uint32_t>			listIndices;
+	};
+
+	struct TestHierarchy
+	{
+		std::vector<ClusterPage>		listPages;
+		std::vector<ClusterPageGroup>	listGroups;
+		std::vector<uint32_t>			listGroupParents;
+		std::vector<std::vector<uint32_t>> listPageIndices;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Gently rolling height field, so simplification has something to lose at every level
+	TestMesh MakeTerrain(uint32_t size)
+	{
+		TestMesh mesh;
+
+		for (uint32_t z = 0; z <= size; z++)
+		{
+			for (uint32_t x = 0; x <= size; x++)
+			{
+				const float height = std::sin(x * 0.15f) * std::cos(z * 0.11f) * 2.0f;
+				mesh.listPositions.push_back(glm::vec3(float(x), height, float(z)));
+			}
+		}
+
+		for (uint32_t z = 0; z < size; z++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const uint32_t i = z * (size + 1) + x;
+				mesh.listIndices.insert(mesh.listIndices.end(), { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 });
+			}
+		}
+
+		return mesh;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Triangles sharing no vertices, few enough for one page by count but with three times as many vertices
+	TestMesh MakeSoup(uint32_t numTriangles)
+	{
+		TestMesh mesh;
+
+		for (uint32_t t = 0; t < numTriangles; t++)
+		{
+			const glm::vec3 corner = glm::vec3(float(t % 64), 0.0f, float(t / 64));
+			const uint32_t first = static_cast<uint32_t>(mesh.listPositions.size());
+
+			mesh.listPositions.push_back(corner);
+			mesh.listPositions.push_back(corner + glm::vec3(0.0f, 0.0f, 0.5f));
+			mesh.listPositions.push_back(corner + glm::vec3(0.5f, 0.0f, 0.0f));
+			mesh.listIndices.insert(mesh.listIndices.end(), { first, first + 1, first + 2 });
+		}
+
+		return mesh;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	TestHierarchy Build(const TestMesh& mesh)
+	{
+		TestHierarchy hierarchy;
+		ClusterPageBuilder::Build(mesh.listIndices, &mesh.listPositions[0].x, sizeof(glm::vec3), static_cast<uint32_t>(mesh.listPositions.size()),
+									hierarchy.listPages, hierarchy.listGroups, hierarchy.listGroupParents, hierarchy.listPageIndices);
+		return hierarchy;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Rotated so the smallest index comes first, winding stays as it is
+	std::array<uint32_t, 3> GetTriangle(const std::vector<uint32_t>& listIndices, size_t triangle)
+	{
+		const uint32_t a = listIndices[triangle * 3 + 0];
+		const uint32_t b = listIndices[triangle * 3 + 1];
+		const uint32_t c = listIndices[triangle * 3 + 2];
+
+		if (a <= b && a <= c)
+			return { a, b, c };
+
+		return b <= c ? std::array<uint32_t, 3>{ b, c, a } : std::array<uint32_t, 3>{ c, a, b };
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	size_t CountUniqueVertices(const std::vector<uint32_t>& listIndices)
+	{
+		return std::set<uint32_t>(listIndices.begin(), listIndices.end()).size();
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(ClusterPage_Localize)
+{
+	std::vector<uint32_t> listStamps(16, 0);
+	std::vector<uint32_t> listVertices;
+	std::vector<uint32_t> listLocalIndices;
+
+	ClusterPageBuilder::Localize({ 5, 3, 5, 9, 3, 7 }, listStamps, listVertices, listLocalIndices);
+	EXPECT_TRUE(listVertices == std::vector<uint32_t>({ 5, 3, 9, 7 }));
+	EXPECT_TRUE(listLocalIndices == std::vector<uint32_t>({ 0, 1, 0, 2, 1, 3 }));
+
+	// Stamps left over from the call before must not leak into this one
+	ClusterPageBuilder::Localize({ 7, 0, 9, 0 }, listStamps, listVertices, listLocalIndices);
+	EXPECT_TRUE(listVertices == std::vector<uint32_t>({ 7, 0, 9 }));
+	EXPECT_TRUE(listLocalIndices == std::vector<uint32_t>({ 0, 1, 2, 1 }));
+
+	// Garbage stamps are just as fine
+	std::fill(listStamps.begin(), listStamps.end(), 0xFFFFFFFF);
+	ClusterPageBuilder::Localize({ 1, 2, 1 }, listStamps, listVertices, listLocalIndices);
+	EXPECT_TRUE(listVertices == std::vector<uint32_t>({ 1, 2 }));
+	EXPECT_TRUE(listLocalIndices == std::vector<uint32_t>({ 0, 1, 0 }));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Fits a single page, nothing to group or simplify
+TEST_CASE(ClusterPage_SmallMeshIsOnePage)
+{
+	TestMesh mesh = MakeTerrain(8);
+	TestHierarchy hierarchy = Build(mesh);
+
+	EXPECT_EQ(hierarchy.listPages.size(), size_t(1));
+	EXPECT_TRUE(hierarchy.listGroups.empty());
+	EXPECT_TRUE(!hierarchy.listPages.empty() && hierarchy.listPages[0].uiSourceGroup == g_uiNoPageGroup && hierarchy.listPages[0].uiParentGroup == g_uiNoPageGroup);
+	EXPECT_TRUE(!hierarchy.listPageIndices.empty() && hierarchy.listPageIndices[0] == mesh.listIndices);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Terrain runs into the triangle limit, soup into the vertex one
+TEST_CASE(ClusterPage_PagesFitLimits)
+{
+	const uint32_t numSoupTriangles = Helper::g_uiClusterPageVertices / 3 * 2;
+
+	for (const TestMesh& mesh : { MakeTerrain(160), MakeSoup(numSoupTriangles) })
+	{
+		TestHierarchy hierarchy = Build(mesh);
+		EXPECT_TRUE(hierarchy.listPages.size() > 1);
+		EXPECT_EQ(hierarchy.listPages.size(), hierarchy.listPageIndices.size());
+
+		for (const std::vector<uint32_t>& listIndices : hierarchy.listPageIndices)
+		{
+			EXPECT_TRUE(!listIndices.empty() && listIndices.size() % 3 == 0);
+			EXPECT_TRUE(listIndices.size() / 3 <= Helper::g_uiClusterPageTriangles);
+			EXPECT_TRUE(CountUniqueVertices(listIndices) <= Helper::g_uiClusterPageVertices);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Leaves are the full detail mesh, every input triangle in exactly one of them & as it was wound
+TEST_CASE(ClusterPage_LeavesCoverEveryTriangle)
+{
+	TestMesh mesh = MakeTerrain(160);
+	TestHierarchy hierarchy = Build(mesh);
+
+	std::vector<std::array<uint32_t, 3>> listExpected;
+	for (size_t t = 0; t < mesh.listIndices.size() / 3; t++)
+		listExpected.push_back(GetTriangle(mesh.listIndices, t));
+
+	std::vector<std::array<uint32_t, 3>> listLeafTriangles;
+	for (size_t p = 0; p < hierarchy.listPages.size(); p++)
+	{
+		if (hierarchy.listPages[p].uiSourceGroup != g_uiNoPageGroup)
+			continue;
+
+		for (size_t t = 0; t < hierarchy.listPageIndices[p].size() / 3; t++)
+			listLeafTriangles.push_back(GetTriangle(hierarchy.listPageIndices[p], t));
+	}
+
+	std::sort(listExpected.begin(), listExpected.end());
+	std::sort(listLeafTriangles.begin(), listLeafTriangles.end());
+	EXPECT_TRUE(listLeafTriangles == listExpected);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Groups finest first with contiguous inputs, parents always later, spheres & errors only grow towards the roots
+TEST_CASE(ClusterPage_HierarchyIsConsistent)
+{
+	TestMesh mesh = MakeTerrain(160);
+	TestHierarchy hierarchy = Build(mesh);
+
+	const uint32_t numPages = static_cast<uint32_t>(hierarchy.listPages.size());
+	const uint32_t numGroups = static_cast<uint32_t>(hierarchy.listGroups.size());
+	EXPECT_TRUE(numGroups > 0);
+
+	size_t numLeafTriangles = 0;
+	size_t numRootTriangles = 0;
+
+	for (uint32_t p = 0; p < numPages; p++)
+	{
+		const ClusterPage& page = hierarchy.listPages[p];
+		EXPECT_TRUE(page.uiSourceGroup == g_uiNoPageGroup || page.uiSourceGroup < numGroups);
+		EXPECT_TRUE(page.uiParentGroup == g_uiNoPageGroup || page.uiParentGroup < numGroups);
+		EXPECT_TRUE(page.uiSourceGroup == g_uiNoPageGroup || page.uiParentGroup == g_uiNoPageGroup || page.uiSourceGroup < page.uiParentGroup);
+
+		if (page.uiParentGroup != g_uiNoPageGroup)
+		{
+			const ClusterPageGroup& parent = hierarchy.listGroups[page.uiParentGroup];
+			EXPECT_TRUE(p >= parent.uiFirstPage && p < parent.uiFirstPage + parent.uiNumPages);
+		}
+
+		// Page sphere holds its own vertices
+		for (uint32_t index : hierarchy.listPageIndices[p])
+			EXPECT_TRUE(glm::length(mesh.listPositions[index] - page.center) <= page.radius * 1.001f + 1e-4f);
+
+		if (page.uiSourceGroup == g_uiNoPageGroup)
+			numLeafTriangles += hierarchy.listPageIndices[p].size() / 3;
+
+		if (page.uiParentGroup == g_uiNoPageGroup)
+			numRootTriangles += hierarchy.listPageIndices[p].size() / 3;
+	}
+
+	EXPECT_EQ(numLeafTriangles, mesh.listIndices.size() / 3);
+	EXPECT_TRUE(numRootTriangles < numLeafTriangles / 2);
+
+	for (uint32_t g = 0; g < numGroups; g++)
+	{
+		const ClusterPageGroup& group = hierarchy.listGroups[g];
+		EXPECT_TRUE(group.uiNumPages > 0 && group.uiFirstPage + group.uiNumPages <= numPages);
+		EXPECT_TRUE(group.uiFirstParent + group.uiNumParents <= hierarchy.listGroupParents.size());
+
+		for (uint32_t p = group.uiFirstPage; p < group.uiFirstPage + group.uiNumPages && p < numPages; p++)
+			EXPECT_EQ(hierarchy.listPages[p].uiParentGroup, g);
+
+		for (uint32_t i = group.uiFirstParent; i < group.uiFirstParent + group.uiNumParents && i < hierarchy.listGroupParents.size(); i++)
+		{
+			const uint32_t parentIndex = hierarchy.listGroupParents[i];
+			EXPECT_TRUE(parentIndex > g && parentIndex < numGroups);
+			if (parentIndex >= numGroups)
+				continue;
+
+			const ClusterPageGroup& parent = hierarchy.listGroups[parentIndex];
+			EXPECT_TRUE(parent.fError >= group.fError);
+			EXPECT_TRUE(glm::length(parent.center - group.center) + group.radius <= parent.radius * 1.001f + 1e-4f);
+		}
+	}
+}
@@ -0,0 +1,186 @@
+#include "sandboxPCH.h"
+#include "TestFramework.h"
+#include "Core/LZCodec.h"
+
+#include <random>
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	std::vector<uint8_t> Compress(const std::vector<uint8_t>& listData)
+	{
+		std::vector<uint8_t> listCompressed(LZCodec::GetMaxCompressedSize(listData.size()));
+
+		uint64_t size = LZCodec::Compress(listData.data(), listData.size(), listCompressed.data(), listCompressed.size());
+		EXPECT_TRUE(size > 0);
+
+		listCompressed.resize(size);
+		return listCompressed;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	bool RoundTrips(const std::vector<uint8_t>& listData)
+	{
+		std::vector<uint8_t> listCompressed = Compress(listData);
+		std::vector<uint8_t> listDecompressed(listData.size());
+
+		return LZCodec::Decompress(listCompressed.data(), listCompressed.size(), listDecompressed.data(), listDecompressed.size())
+			&& listDecompressed == listData;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	std::vector<uint8_t> MakeRandom(size_t size, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+
+		std::vector<uint8_t> listData(size);
+		for (uint8_t& byte : listData)
+			byte = static_cast<uint8_t>(random());
+
+		return listData;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Runs of literals & repeats of every length, some closer than the 64 KB window & some further away
+	std::vector<uint8_t> MakeMixed(size_t size, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<uint8_t> listData;
+		listData.reserve(size);
+
+		while (listData.size() < size)
+		{
+			const uint32_t length = 1 + random() % 300;
+
+			if (listData.size() < 16 || random() % 2)
+			{
+				for (uint32_t i = 0; i < length; i++)
+					listData.push_back(static_cast<uint8_t>(random()));
+			}
+			else
+			{
+				const size_t offset = 1 + random() % std::min<size_t>(listData.size(), 100000);
+				for (uint32_t i = 0; i < length; i++)
+					listData.push_back(listData[listData.size() - offset]);
+			}
+		}
+
+		listData.resize(size);
+		return listData;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(LZCodec_RoundTripSmall)
+{
+	EXPECT_TRUE(RoundTrips({}));
+
+	// Everything up to & a bit past the size where matching starts
+	for (size_t size = 1; size < 64; size++)
+	{
+		EXPECT_TRUE(RoundTrips(MakeRandom(size, uint32_t(size))));
+		EXPECT_TRUE(RoundTrips(std::vector<uint8_t>(size, 0xAB)));
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(LZCodec_RoundTripLarge)
+{
+	EXPECT_TRUE(RoundTrips(MakeRandom(300000, 1)));
+	EXPECT_TRUE(RoundTrips(MakeMixed(1 << 20, 2)));
+
+	// Short periods make matches overlap their own output
+	for (uint32_t period : { 1u, 2u, 3u, 7u, 8u, 9u, 31u })
+	{
+		std::vector<uint8_t> listData(100000);
+		for (size_t i = 0; i < listData.size(); i++)
+			listData[i] = static_cast<uint8_t>(i % period);
+
+		EXPECT_TRUE(RoundTrips(listData));
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(LZCodec_CompressesRepeats)
+{
+	std::vector<uint8_t> listZeros(1 << 20, 0);
+	EXPECT_TRUE(Compress(listZeros).size() < listZeros.size() / 100);
+
+	// Incompressible data may only grow by the documented bound
+	std::vector<uint8_t> listRandom = MakeRandom(100000, 3);
+	EXPECT_TRUE(Compress(listRandom).size() <= LZCodec::GetMaxCompressedSize(listRandom.size()));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(LZCodec_FailsWhenOutputTooSmall)
+{
+	std::vector<uint8_t> listData = MakeRandom(4096, 4);
+	std::vector<uint8_t> listCompressed(listData.size() / 2);
+
+	EXPECT_EQ(LZCodec::Compress(listData.data(), listData.size(), listCompressed.data(), listCompressed.size()), 0ull);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(LZCodec_RejectsWrongSize)
+{
+	std::vector<uint8_t> listData = MakeMixed(10000, 5);
+	std::vector<uint8_t> listCompressed = Compress(listData);
+	std::vector<uint8_t> listDecompressed(listData.size() + 1);
+
+	EXPECT_TRUE(!LZCodec::Decompress(listCompressed.data(), listCompressed.size(), listDecompressed.data(), listData.size() - 1));
+	EXPECT_TRUE(!LZCodec::Decompress(listCompressed.data(), listCompressed.size(), listDecompressed.data(), listData.size() + 1));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(LZCodec_RejectsTruncated)
+{
+	std::vector<uint8_t> listData = MakeMixed(5000, 6);
+	std::vector<uint8_t> listCompressed = Compress(listData);
+	std::vector<uint8_t> listDecompressed(listData.size());
+
+	for (size_t size = 0; size < listCompressed.size(); size++)
+		EXPECT_TRUE(!LZCodec::Decompress(listCompressed.data(), size, listDecompressed.data(), listDecompressed.size()));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(LZCodec_RejectsBadOffsets)
+{
+	uint8_t listDecompressed[16] = {};
+
+	// One literal then a 4 byte match, offset 0 & offset past the start of the output
+	const uint8_t listZeroOffset[] = { 0x10, 'a', 0x00, 0x00 };
+	const uint8_t listFarOffset[] = { 0x10, 'a', 0x02, 0x00 };
+
+	EXPECT_TRUE(!LZCodec::Decompress(listZeroOffset, sizeof(listZeroOffset), listDecompressed, 5));
+	EXPECT_TRUE(!LZCodec::Decompress(listFarOffset, sizeof(listFarOffset), listDecompressed, 5));
+
+	// Offset 1 is fine, repeats the literal
+	const uint8_t listGoodOffset[] = { 0x10, 'a', 0x01, 0x00 };
+	EXPECT_TRUE(LZCodec::Decompress(listGoodOffset, sizeof(listGoodOffset), listDecompressed, 5));
+	EXPECT_EQ(std::string(reinterpret_cast<const char*>(listDecompressed), 5), std::string("aaaaa"));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Flipped bytes may still decode to something, but nothing may ever be written past the output
+TEST_CASE(LZCodec_CorruptNeverOverruns)
+{
+	const size_t guardSize = 64;
+	const uint8_t guardByte = 0xCD;
+
+	std::vector<uint8_t> listData = MakeMixed(20000, 7);
+	std::vector<uint8_t> listCompressed = Compress(listData);
+
+	std::mt19937 random(8);
+	for (uint32_t round = 0; round < 2000; round++)
+	{
+		std::vector<uint8_t> listCorrupt = listCompressed;
+		for (uint32_t i = 0; i < 1 + round % 4; i++)
+			listCorrupt[random() % listCorrupt.size()] ^= static_cast<uint8_t>(1 + random() % 255);
+
+		std::vector<uint8_t> listDecompressed(listData.size() + guardSize, guardByte);
+		LZCodec::Decompress(listCorrupt.data(), listCorrupt.size(), listDecompressed.data(), listData.size());
+
+		bool bGuardIntact = std::all_of(listDecompressed.begin() + listData.size(), listDecompressed.end(), [&](uint8_t byte) { return byte == guardByte; });
+		EXPECT_TRUE(bGuardIntact);
+	}
+}
@@ -0,0 +1,230 @@
+#include "sandboxPCH.h"
+#include "TestFramework.h"
+#include "Cooker/PackBuilder.h"
+#include "Core/VirtualFileSystem.h"
+#include "Core/ThreadPool.h"
+
+#include <random>
+
+namespace
+{
+	struct TestFile
+	{
+		std::string						strPath;
+		std::vector<uint8_t>			listData;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Files for one test in their own temp folder, deleted again when it goes out of scope
+	struct TestFolder
+	{
+		TestFolder(const char* strName)
+		{
+			root = std::filesystem::temp_directory_path() / "SandboxTests" / strName;
+			std::filesystem::remove_all(root);
+			std::filesystem::create_directories(root);
+		}
+
+		~TestFolder()
+		{
+			std::error_code error;
+			std::filesystem::remove_all(root, error);
+		}
+
+		std::string GetPath(const std::string& name) const
+		{
+			return (root / name).generic_string();
+		}
+
+		TestFile Write(const std::string& name, std::vector<uint8_t> listData) const
+		{
+			TestFile file = { GetPath(name), std::move(listData) };
+			std::filesystem::create_directories(std::filesystem::path(file.strPath).parent_path());
+			std::ofstream(file.strPath, std::ios::binary).write(reinterpret_cast<const char*>(file.listData.data()), file.listData.size());
+			return file;
+		}
+
+		std::filesystem::path			root;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	std::vector<uint8_t> MakeRandom(size_t size, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+
+		std::vector<uint8_t> listData(size);
+		for (uint8_t& byte : listData)
+			byte = static_cast<uint8_t>(random());
+
+		return listData;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Compresses well, several chunks long so reads get spread over the workers
+	std::vector<uint8_t> MakeCompressible(size_t size)
+	{
+		std::vector<uint8_t> listData(size);
+		for (size_t i = 0; i < size; i++)
+			listData[i] = static_cast<uint8_t>((i / 37) % 7);
+
+		return listData;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	bool ReadsBack(const VirtualFileSystem& vfs, const TestFile& file)
+	{
+		uint64_t size = 0;
+		if (!vfs.GetFileSize(file.strPath, &size) || size != file.listData.size())
+			return false;
+
+		std::vector<uint8_t> listRead(static_cast<size_t>(size));
+		return vfs.Read(file.strPath, 0, size, listRead.data()) && listRead == file.listData;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	bool ReadsRange(const VirtualFileSystem& vfs, const TestFile& file, uint64_t offset, uint64_t size)
+	{
+		std::vector<uint8_t> listRead(static_cast<size_t>(size));
+		return vfs.Read(file.strPath, offset, size, listRead.data()) && std::equal(listRead.begin(), listRead.end(), file.listData.begin() + offset);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Pack_ReadsEveryEntry)
+{
+	TestFolder folder("Pack_ReadsEveryEntry");
+
+	// Names sharing prefixes sort next to each other, lookup must still find the exact one
+	std::vector<TestFile> listFiles =
+	{
+		folder.Write("Cooked/a.tex", MakeRandom(100, 1)),
+		folder.Write("Cooked/a.tex2", MakeRandom(200, 2)),
+		folder.Write("Cooked/ab.tex", MakeRandom(300, 3)),
+		folder.Write("Cooked/Models/big.model", MakeCompressible(3 * Helper::g_uiPackChunkSize + 1234)),
+		folder.Write("Cooked/Models/random.model", MakeRandom(Helper::g_uiPackChunkSize + 10, 4)),
+		folder.Write("Cooked/empty.tex", {}),
+		folder.Write("Cooked/Scenes/world.snap", MakeCompressible(50000))
+	};
+
+	std::vector<std::string> listPaths;
+	for (const TestFile& file : listFiles)
+		listPaths.push_back(file.strPath);
+
+	// Duplicates are packed once, missing files are left out
+	listPaths.push_back(listFiles[0].strPath);
+	listPaths.push_back(folder.GetPath("Cooked/missing.tex"));
+
+	const std::string packPath = folder.GetPath("Cooked/Assets.pak");
+
+	ThreadPool workers(2);
+	EXPECT_TRUE(PackBuilder::Build(listPaths, packPath, &workers));
+	EXPECT_TRUE(PackBuilder::IsCurrent(packPath));
+
+	// Loose copies go away, every read below must come out of the pack
+	for (const TestFile& file : listFiles)
+		std::filesystem::remove(file.strPath);
+
+	VirtualFileSystem vfs;
+	EXPECT_TRUE(vfs.Mount(packPath));
+
+	for (const TestFile& file : listFiles)
+		EXPECT_TRUE(ReadsBack(vfs, file));
+
+	uint64_t size = 0;
+	EXPECT_TRUE(!vfs.GetFileSize(folder.GetPath("Cooked/missing.tex"), &size));
+	EXPECT_TRUE(!vfs.GetFileSize(folder.GetPath("Cooked/a.te"), &size));
+
+	// Ranges inside one chunk, across chunk boundaries & at the very end of compressed & stored entries
+	const TestFile& big = listFiles[3];
+	const uint64_t chunkSize = Helper::g_uiPackChunkSize;
+
+	EXPECT_TRUE(ReadsRange(vfs, big, 10, 100));
+	EXPECT_TRUE(ReadsRange(vfs, big, chunkSize - 50, 100));
+	EXPECT_TRUE(ReadsRange(vfs, big, chunkSize - 1, 2 * chunkSize + 2));
+	EXPECT_TRUE(ReadsRange(vfs, big, big.listData.size() - 7, 7));
+	EXPECT_TRUE(ReadsRange(vfs, listFiles[4], chunkSize, 10));
+
+	// Past the end fails instead of reading neighbouring entries
+	uint8_t listBytes[8];
+	EXPECT_TRUE(!vfs.Read(big.strPath, big.listData.size() - 4, 8, listBytes));
+	EXPECT_TRUE(!vfs.Read(listFiles[0].strPath, 101, 0, listBytes));
+
+	// Mapped assets & incompressible entries are stored as they are, compressed ones have no straight view
+	uint64_t mappedSize = 0;
+	const uint8_t* pMapped = vfs.GetMappedData(listFiles[6].strPath, &mappedSize);
+	EXPECT_TRUE(pMapped != nullptr && mappedSize == listFiles[6].listData.size());
+	EXPECT_TRUE(pMapped != nullptr && memcmp(pMapped, listFiles[6].listData.data(), listFiles[6].listData.size()) == 0);
+	EXPECT_TRUE(vfs.GetMappedData(listFiles[4].strPath, &mappedSize) != nullptr);
+	EXPECT_TRUE(vfs.GetMappedData(big.strPath, &mappedSize) == nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Pack_ReadsAsync)
+{
+	TestFolder folder("Pack_ReadsAsync");
+
+	TestFile big = folder.Write("Cooked/big.model", MakeCompressible(2 * Helper::g_uiPackChunkSize + 99));
+	TestFile loose = folder.Write("Cooked/loose.tex", MakeRandom(5000, 5));
+
+	const std::string packPath = folder.GetPath("Cooked/Assets.pak");
+
+	ThreadPool workers(2);
+	EXPECT_TRUE(PackBuilder::Build({ big.strPath }, packPath, &workers));
+
+	VirtualFileSystem vfs;
+	EXPECT_TRUE(vfs.Mount(packPath));
+
+	std::vector<uint8_t> listBig(big.listData.size());
+	std::vector<uint8_t> listLoose(loose.listData.size());
+	std::atomic<uint32_t> numSucceeded(0);
+
+	auto OnComplete = [&numSucceeded](bool bSucceeded) { numSucceeded += bSucceeded ? 1 : 0; };
+	vfs.ReadAsync(big.strPath, 0, listBig.size(), listBig.data(), &workers, OnComplete);
+	vfs.ReadAsync(loose.strPath, 0, listLoose.size(), listLoose.data(), &workers, OnComplete);
+
+	vfs.WaitAsyncIdle();
+	workers.WaitIdle();
+
+	EXPECT_EQ(numSucceeded.load(), 2u);
+	EXPECT_TRUE(listBig == big.listData);
+	EXPECT_TRUE(listLoose == loose.listData);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Pack_FallsBackToLooseFiles)
+{
+	TestFolder folder("Pack_FallsBackToLooseFiles");
+
+	TestFile packed = folder.Write("Cooked/packed.tex", MakeRandom(1000, 6));
+	TestFile loose = folder.Write("Cooked/loose.tex", MakeRandom(1000, 7));
+
+	const std::string packPath = folder.GetPath("Cooked/Assets.pak");
+
+	// No pack at all is fine, everything is loose
+	VirtualFileSystem vfs;
+	EXPECT_TRUE(vfs.Mount(packPath));
+	EXPECT_TRUE(ReadsBack(vfs, packed));
+	EXPECT_TRUE(ReadsBack(vfs, loose));
+
+	ThreadPool workers(2);
+	EXPECT_TRUE(PackBuilder::Build({ packed.strPath }, packPath, &workers));
+
+	// Cooked after packing, still found next to the pack
+	EXPECT_TRUE(vfs.Mount(packPath));
+	EXPECT_TRUE(ReadsBack(vfs, packed));
+	EXPECT_TRUE(ReadsBack(vfs, loose));
+	vfs.Unmount();
+
+	// Stale pack is refused, reads go to loose files
+	{
+		std::fstream file(packPath, std::ios::in | std::ios::out | std::ios::binary);
+		const uint32_t uiVersion = Helper::g_uiPackVersion + 1;
+		file.seekp(offsetof(Helper::PackHeader, uiVersion));
+		file.write(reinterpret_cast<const char*>(&uiVersion), sizeof(uiVersion));
+	}
+
+	EXPECT_TRUE(!PackBuilder::IsCurrent(packPath));
+	EXPECT_TRUE(!vfs.Mount(packPath));
+	EXPECT_TRUE(ReadsBack(vfs, packed));
+	EXPECT_TRUE(ReadsBack(vfs, loose));
+}
@@ -0,0 +1,245 @@
+#include "sandboxPCH.h"
+#include "TestFramework.h"
+#include "Renderer/VertexLayout.h"
+#include "glm/gtc/constants.hpp"
+
+#include <random>
+
+namespace
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	// What the input assembler hands the shader for a R16G16_SNORM attribute
+	float UnpackSnorm16(int16_t value)
+	{
+		return std::max(value / 32767.0f, -1.0f);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Same as OctahedralDecode in triangle.vert, keep them in sync!
+	glm::vec3 OctahedralDecode(const glm::vec2& e)
+	{
+		glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - glm::abs(e.x) - glm::abs(e.y));
+		float t = std::max(-n.z, 0.0f);
+		n.x += (n.x >= 0.0f) ? -t : t;
+		n.y += (n.y >= 0.0f) ? -t : t;
+
+		return glm::normalize(n);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Same as main in triangle.vert, whole grid steps first
+	glm::vec3 DecodePosition(const Helper::AttributePosition& packed, const Helper::QuantizationBounds& bounds)
+	{
+		glm::vec3 unorm = glm::vec3(packed.Position[0], packed.Position[1], packed.Position[2]) / 65535.0f;
+		glm::vec3 grid = glm::round(unorm * 65535.0f) + glm::vec3(bounds.gridOffset);
+		return glm::vec3(bounds.boundsMin) + grid * (glm::vec3(bounds.boundsExtent) / 65535.0f);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	glm::vec3 RoundTripNormal(const glm::vec3& normal)
+	{
+		Helper::VertexPNTBT vertex;
+		vertex.Normal = normal;
+
+		Helper::AttributeNormal packed;
+		Helper::AttributeNormal::Pack(packed, vertex, Helper::QuantizationBounds());
+
+		return OctahedralDecode(glm::vec2(UnpackSnorm16(packed.Normal[0]), UnpackSnorm16(packed.Normal[1])));
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// Spread evenly over the whole sphere plus the axes & octant diagonals, which sit on the folds of the octahedron
+	std::vector<glm::vec3> MakeDirections(uint32_t numSpiral)
+	{
+		std::vector<glm::vec3> listDirections =
+		{
+			glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+		};
+
+		for (float x : { -1.0f, 1.0f })
+			for (float y : { -1.0f, 1.0f })
+				for (float z : { -1.0f, 1.0f })
+					listDirections.push_back(glm::normalize(glm::vec3(x, y, z)));
+
+		const float goldenAngle = glm::pi<float>() * (3.0f - std::sqrt(5.0f));
+		for (uint32_t i = 0; i < numSpiral; i++)
+		{
+			float z = 1.0f - 2.0f * (i + 0.5f) / numSpiral;
+			float radius = std::sqrt(1.0f - z * z);
+			float phi = goldenAngle * i;
+			listDirections.push_back(glm::vec3(radius * std::cos(phi), radius * std::sin(phi), z));
+		}
+
+		return listDirections;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Quantization_PackSnorm16)
+{
+	EXPECT_EQ(Helper::PackSnorm16(0.0f), int16_t(0));
+	EXPECT_EQ(Helper::PackSnorm16(1.0f), int16_t(32767));
+	EXPECT_EQ(Helper::PackSnorm16(-1.0f), int16_t(-32767));
+	EXPECT_EQ(Helper::PackSnorm16(0.5f), int16_t(16384));
+
+	// Out of range clamps, -32768 is never produced
+	EXPECT_EQ(Helper::PackSnorm16(2.0f), int16_t(32767));
+	EXPECT_EQ(Helper::PackSnorm16(-2.0f), int16_t(-32767));
+
+	for (int i = -100; i <= 100; i++)
+	{
+		float value = i / 100.0f;
+		EXPECT_TRUE(std::abs(UnpackSnorm16(Helper::PackSnorm16(value)) - value) <= 0.5f / 32767.0f + 1e-7f);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Quantization_PackUnorm16)
+{
+	EXPECT_EQ(Helper::PackUnorm16(0.0f), uint16_t(0));
+	EXPECT_EQ(Helper::PackUnorm16(1.0f), uint16_t(65535));
+	EXPECT_EQ(Helper::PackUnorm16(-0.5f), uint16_t(0));
+	EXPECT_EQ(Helper::PackUnorm16(1.5f), uint16_t(65535));
+
+	for (int i = 0; i <= 100; i++)
+	{
+		float value = i / 100.0f;
+		EXPECT_TRUE(std::abs(Helper::PackUnorm16(value) / 65535.0f - value) <= 0.5f / 65535.0f + 1e-7f);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Snorm16 octahedral is well under a hundredth of a degree, anything near that means encode & decode disagree
+TEST_CASE(Quantization_OctahedralRoundTrip)
+{
+	const float maxError = glm::radians(0.01f);
+
+	float worstError = 0.0f;
+	for (const glm::vec3& direction : MakeDirections(4096))
+	{
+		glm::vec3 decoded = RoundTripNormal(direction);
+		// Chord length is the angle this close, acos of a float dot can't resolve errors this small
+		float error = glm::length(decoded - direction);
+		worstError = std::max(worstError, error);
+	}
+
+	EXPECT_TRUE(worstError < maxError);
+
+	// Scaled input encodes the same as its direction
+	EXPECT_TRUE(glm::dot(RoundTripNormal(glm::vec3(0.0f, 0.0f, -5.0f)), glm::vec3(0.0f, 0.0f, -1.0f)) > 0.9999f);
+	EXPECT_TRUE(glm::dot(RoundTripNormal(glm::vec3(3.0f, -4.0f, 0.0f)), glm::vec3(0.6f, -0.8f, 0.0f)) > 0.9999f);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Quantization_OctahedralDegenerate)
+{
+	glm::vec2 encoded = Helper::OctahedralEncode(glm::vec3(0.0f));
+	EXPECT_EQ(encoded.x, 0.0f);
+	EXPECT_EQ(encoded.y, 0.0f);
+
+	glm::vec3 decoded = RoundTripNormal(glm::vec3(0.0f));
+	EXPECT_TRUE(glm::dot(decoded, glm::vec3(0.0f, 0.0f, 1.0f)) > 0.9999f);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Quantization_PositionRoundTrip)
+{
+	const glm::vec3 boundsMin = glm::vec3(-12.5f, 0.25f, -3.0f);
+	const glm::vec3 boundsMax = glm::vec3(40.0f, 9.75f, 1000.0f);
+
+	Helper::QuantizationBounds bounds = Helper::MakeQuantizationBounds(boundsMin, boundsMax);
+	const glm::vec3 halfStep = glm::vec3(bounds.boundsExtent) / 65535.0f * 0.5f;
+
+	Helper::VertexPNTBT vertex;
+	Helper::AttributePosition packed;
+
+	// Corners land exactly on the first & last step
+	vertex.Position = boundsMin;
+	Helper::AttributePosition::Pack(packed, vertex, bounds);
+	EXPECT_EQ(packed.Position[0], uint16_t(0));
+	EXPECT_EQ(packed.Position[2], uint16_t(0));
+
+	vertex.Position = boundsMax;
+	Helper::AttributePosition::Pack(packed, vertex, bounds);
+	EXPECT_EQ(packed.Position[0], uint16_t(65535));
+	EXPECT_EQ(packed.Position[2], uint16_t(65535));
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		glm::vec3 t = glm::vec3(distribution(random), distribution(random), distribution(random));
+		vertex.Position = boundsMin + t * (boundsMax - boundsMin);
+
+		Helper::AttributePosition::Pack(packed, vertex, bounds);
+		glm::vec3 error = glm::abs(DecodePosition(packed, bounds) - vertex.Position);
+
+		// Float math on both sides eats a little more than half a step
+		EXPECT_TRUE(error.x <= halfStep.x * 1.01f && error.y <= halfStep.y * 1.01f && error.z <= halfStep.z * 1.01f);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Flat meshes have a zero extent axis, it must neither divide by zero nor move the vertices off the plane
+TEST_CASE(Quantization_FlatAxis)
+{
+	Helper::QuantizationBounds bounds = Helper::MakeQuantizationBounds(glm::vec3(-1.0f, 2.0f, -1.0f), glm::vec3(1.0f, 2.0f, 1.0f));
+	EXPECT_EQ(bounds.boundsExtent.y, 1.0f);
+
+	Helper::VertexPNTBT vertex;
+	vertex.Position = glm::vec3(0.3f, 2.0f, -0.7f);
+
+	Helper::AttributePosition packed;
+	Helper::AttributePosition::Pack(packed, vertex, bounds);
+
+	EXPECT_EQ(packed.Position[1], uint16_t(0));
+	EXPECT_EQ(DecodePosition(packed, bounds).y, 2.0f);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Pages of a paged mesh only differ in gridOffset, a vertex they share must decode to the very same bits
+TEST_CASE(Quantization_GridOffsetMatchesWholeMesh)
+{
+	Helper::QuantizationBounds wholeMesh = Helper::MakeQuantizationBounds(glm::vec3(-7.0f), glm::vec3(13.0f));
+
+	Helper::QuantizationBounds page = wholeMesh;
+	page.gridOffset = glm::vec4(1000.0f, 20000.0f, 333.0f, 0.0f);
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> distribution(0.5f, 1.0f);
+
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		Helper::VertexPNTBT vertex;
+		vertex.Position = glm::vec3(-7.0f) + glm::vec3(distribution(random), distribution(random), distribution(random)) * 20.0f;
+
+		Helper::AttributePosition packedWhole, packedPage;
+		Helper::AttributePosition::Pack(packedWhole, vertex, wholeMesh);
+		Helper::AttributePosition::Pack(packedPage, vertex, page);
+
+		glm::vec3 decodedWhole = DecodePosition(packedWhole, wholeMesh);
+		glm::vec3 decodedPage = DecodePosition(packedPage, page);
+
+		EXPECT_TRUE(decodedWhole.x == decodedPage.x && decodedWhole.y == decodedPage.y && decodedWhole.z == decodedPage.z);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(Quantization_TangentHandedness)
+{
+	Helper::VertexPNTBT vertex;
+	vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+	vertex.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+
+	Helper::AttributePosition packed;
+
+	vertex.BiNormal = glm::vec3(0.0f, 1.0f, 0.0f);
+	Helper::AttributePosition::Pack(packed, vertex, Helper::QuantizationBounds());
+	EXPECT_EQ(packed.Position[3], uint16_t(65535));
+
+	// Mirrored UVs flip the binormal
+	vertex.BiNormal = glm::vec3(0.0f, -1.0f, 0.0f);
+	Helper::AttributePosition::Pack(packed, vertex, Helper::QuantizationBounds());
+	EXPECT_EQ(packed.Position[3], uint16_t(0));
+}
@@ -0,0 +1,127 @@
+#include "sandboxPCH.h"
+#include "TestFramework.h"
+#include "Core/RingAllocator.h"
+
+namespace
+{
+	struct TestRegion
+	{
+		uint64_t						uiOffset;
+		uint64_t						uiID;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------
+	TestRegion Allocate(RingAllocator& ring, uint64_t size)
+	{
+		TestRegion region = { ~0ull, 0 };
+		EXPECT_TRUE(ring.Allocate(size, &region.uiOffset, &region.uiID));
+		return region;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(RingAllocator_AlignsOffsets)
+{
+	RingAllocator ring;
+	ring.Reset(1024, 16);
+
+	TestRegion a = Allocate(ring, 5);
+	TestRegion b = Allocate(ring, 20);
+	TestRegion c = Allocate(ring, 1);
+
+	EXPECT_EQ(a.uiOffset, 0ull);
+	EXPECT_EQ(b.uiOffset, 16ull);
+	EXPECT_EQ(c.uiOffset, 48ull);
+	EXPECT_TRUE(a.uiID != 0 && b.uiID != 0 && c.uiID != 0);
+	EXPECT_EQ(ring.GetNumRegions(), size_t(3));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(RingAllocator_FailsWhenFull)
+{
+	RingAllocator ring;
+	ring.Reset(256, 16);
+
+	TestRegion a = Allocate(ring, 128);
+	Allocate(ring, 128);
+
+	uint64_t offset = 0, uiID = 0;
+	EXPECT_TRUE(!ring.Allocate(16, &offset, &uiID));
+
+	// Only the oldest region went back, new one fits in front of the one still in use
+	ring.Release(a.uiID);
+	EXPECT_TRUE(ring.Allocate(64, &offset, &uiID));
+	EXPECT_EQ(offset, 0ull);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(RingAllocator_WrapsAround)
+{
+	RingAllocator ring;
+	ring.Reset(256, 16);
+
+	TestRegion a = Allocate(ring, 96);
+	TestRegion b = Allocate(ring, 96);
+	ring.Release(a.uiID);
+
+	// 64 bytes left at the end aren't enough, 96 at the front are
+	TestRegion c = Allocate(ring, 80);
+	EXPECT_EQ(c.uiOffset, 0ull);
+
+	// Head must stay behind tail, only [80, 96) is free now & a region may never fill it up to tail
+	uint64_t offset = 0, uiID = 0;
+	EXPECT_TRUE(!ring.Allocate(16, &offset, &uiID));
+
+	// Skipped end belonged to c, once b & c are gone the whole ring is free again
+	ring.Release(b.uiID);
+	ring.Release(c.uiID);
+	EXPECT_EQ(ring.GetNumRegions(), size_t(0));
+
+	TestRegion d = Allocate(ring, 256);
+	EXPECT_EQ(d.uiOffset, 0ull);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(RingAllocator_OutOfOrderRelease)
+{
+	RingAllocator ring;
+	ring.Reset(256, 16);
+
+	TestRegion a = Allocate(ring, 64);
+	TestRegion b = Allocate(ring, 64);
+	TestRegion c = Allocate(ring, 64);
+
+	// Newer regions released first don't give anything back while the oldest is still in use
+	ring.Release(c.uiID);
+	ring.Release(b.uiID);
+	EXPECT_EQ(ring.GetNumRegions(), size_t(3));
+
+	uint64_t offset = 0, uiID = 0;
+	EXPECT_TRUE(!ring.Allocate(128, &offset, &uiID));
+
+	// Oldest one going back frees all three at once
+	ring.Release(a.uiID);
+	EXPECT_EQ(ring.GetNumRegions(), size_t(0));
+	EXPECT_TRUE(ring.Allocate(128, &offset, &uiID));
+	EXPECT_EQ(offset, 0ull);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(RingAllocator_IgnoresUnknownAndDoubleRelease)
+{
+	RingAllocator ring;
+	ring.Reset(256, 16);
+
+	TestRegion a = Allocate(ring, 64);
+	TestRegion b = Allocate(ring, 64);
+
+	ring.Release(a.uiID);
+	ring.Release(a.uiID);
+	ring.Release(12345);
+	EXPECT_EQ(ring.GetNumRegions(), size_t(1));
+
+	// Ids are never handed out twice, not even across a reset
+	ring.Reset(256, 16);
+	TestRegion c = Allocate(ring, 64);
+	EXPECT_TRUE(c.uiID != a.uiID && c.uiID != b.uiID);
+}
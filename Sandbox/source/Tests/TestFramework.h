@@ -0,0 +1,42 @@
+#pragma once
+
+//---------------------------------------------------------------------------------------------------------------------
+// Just enough of a test framework for the Tests project. TEST_CASE registers a function before main runs, EXPECT_*
+// logs the failing line & marks the running test failed but carries on, so one run reports every broken expectation.
+// Nothing here needs a device or a window!
+struct TestCase
+{
+	const char*							strName;
+	void								(*pfnRun)();
+};
+
+std::vector<TestCase>&					GetTestCases();
+void									ReportFailure(const char* strFile, int line, const std::string& strMessage);
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* strName, void (*pfnRun)())	{ GetTestCases().push_back({ strName, pfnRun }); }
+};
+
+#define TEST_CASE(name)																	\
+	static void name();																	\
+	static TestRegistrar gRegistrar_##name(#name, name);								\
+	static void name()
+
+#define EXPECT_TRUE(x)																	\
+{																						\
+	if (!(x))																			\
+		ReportFailure(__FILE__, __LINE__, #x);											\
+}
+
+#define EXPECT_EQ(a, b)																	\
+{																						\
+	const auto valueA = (a);															\
+	const auto valueB = (b);															\
+	if (!(valueA == valueB))															\
+	{																					\
+		std::ostringstream message;														\
+		message << #a << " == " << #b << " (" << valueA << " vs " << valueB << ")";		\
+		ReportFailure(__FILE__, __LINE__, message.str());								\
+	}																					\
+}
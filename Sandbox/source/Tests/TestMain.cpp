@@ -0,0 +1,60 @@
+#include "sandboxPCH.h"
+#include "TestFramework.h"
+#include "Core/Core.h"
+
+namespace
+{
+	uint32_t gNumFailures = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Function local, so registrars in other files never run before it's constructed!
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> listTestCases;
+	return listTestCases;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void ReportFailure(const char* strFile, int line, const std::string& strMessage)
+{
+	LOG_ERROR("{0}({1}): expected {2}", strFile, line, strMessage);
+	++gNumFailures;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Tests [name...]
+//	name				runs only the tests whose name contains it, all of them when none is given
+// Exits with failure when any expectation failed!
+int main(int argc, char** argv)
+{
+	uint32_t numRun = 0;
+	uint32_t numFailed = 0;
+
+	for (const TestCase& test : GetTestCases())
+	{
+		bool bSelected = argc < 2;
+		for (int i = 1; i < argc && !bSelected; i++)
+			bSelected = std::string(test.strName).find(argv[i]) != std::string::npos;
+
+		if (!bSelected)
+			continue;
+
+		const uint32_t numFailuresBefore = gNumFailures;
+		test.pfnRun();
+		++numRun;
+
+		if (gNumFailures != numFailuresBefore)
+		{
+			LOG_ERROR("FAILED {0}", test.strName);
+			++numFailed;
+		}
+		else
+		{
+			LOG_INFO("passed {0}", test.strName);
+		}
+	}
+
+	LOG_INFO("{0} of {1} tests passed", numRun - numFailed, numRun);
+	return numFailed == 0 && numRun > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
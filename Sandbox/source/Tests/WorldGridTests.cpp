@@ -0,0 +1,157 @@
+#include "sandboxPCH.h"
+#include "TestFramework.h"
+#include "World/WorldGrid.h"
+
+#include <random>
+
+namespace
+{
+	const float gCellSize = 64.0f;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	SceneModel MakeModel(const std::string& path, const std::vector<glm::vec3>& listPositions)
+	{
+		SceneModel model;
+		model.strModelPath = path;
+
+		for (const glm::vec3& position : listPositions)
+		{
+			SceneInstance instance;
+			instance.position = position;
+			model.listInstances.push_back(instance);
+		}
+
+		return model;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	const WorldGridCell* FindCell(const std::vector<WorldGridCell>& listCells, int32_t iX, int32_t iZ)
+	{
+		for (const WorldGridCell& cell : listCells)
+		{
+			if (cell.iX == iX && cell.iZ == iZ)
+				return &cell;
+		}
+
+		return nullptr;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+TEST_CASE(WorldGrid_EmptyScene)
+{
+	SceneFile scene;
+	EXPECT_TRUE(WorldGrid::Build(scene, gCellSize).empty());
+
+	// Models without instances don't make cells either
+	scene.m_ListModels.push_back(MakeModel("Empty.fbx", {}));
+	EXPECT_TRUE(WorldGrid::Build(scene, gCellSize).empty());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cells are half open & keep going below zero, Y doesn't matter
+TEST_CASE(WorldGrid_CellCoordinates)
+{
+	EXPECT_EQ(WorldGrid::GetCellCoordinate(0.0f, gCellSize), 0);
+	EXPECT_EQ(WorldGrid::GetCellCoordinate(63.9f, gCellSize), 0);
+	EXPECT_EQ(WorldGrid::GetCellCoordinate(64.0f, gCellSize), 1);
+	EXPECT_EQ(WorldGrid::GetCellCoordinate(-0.1f, gCellSize), -1);
+	EXPECT_EQ(WorldGrid::GetCellCoordinate(-64.0f, gCellSize), -1);
+	EXPECT_EQ(WorldGrid::GetCellCoordinate(-64.1f, gCellSize), -2);
+
+	SceneFile scene;
+	scene.m_ListModels.push_back(MakeModel("Rock.fbx",
+	{
+		glm::vec3(1.0f, 0.0f, 1.0f), glm::vec3(10.0f, 5000.0f, 20.0f), glm::vec3(-1.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, -1.0f), glm::vec3(64.0f, 0.0f, 0.0f)
+	}));
+
+	std::vector<WorldGridCell> listCells = WorldGrid::Build(scene, gCellSize);
+	EXPECT_EQ(listCells.size(), size_t(4));
+
+	const WorldGridCell* pOrigin = FindCell(listCells, 0, 0);
+	EXPECT_TRUE(pOrigin && pOrigin->uiNumInstances == 2);
+	EXPECT_TRUE(FindCell(listCells, -1, 0) && FindCell(listCells, 0, -1) && FindCell(listCells, 1, 0));
+
+	// Order of first appearance in the scene
+	EXPECT_TRUE(listCells[0].iX == 0 && listCells[0].iZ == 0);
+	EXPECT_TRUE(listCells[1].iX == -1 && listCells[1].iZ == 0);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Each cell gets one part per scene model, in scene order, carrying the model's path & material along
+TEST_CASE(WorldGrid_SplitsModelsPerCell)
+{
+	SceneFile scene;
+	scene.m_ListModels.push_back(MakeModel("Tree.fbx", { glm::vec3(1.0f), glm::vec3(100.0f, 0.0f, 1.0f), glm::vec3(2.0f) }));
+	scene.m_ListModels.push_back(MakeModel("Rock.fbx", { glm::vec3(3.0f), glm::vec3(101.0f, 0.0f, 1.0f) }));
+	scene.m_ListModels[1].material.uiOverrides = OVERRIDE_ROUGHNESS;
+	scene.m_ListModels[1].material.roughness = 0.25f;
+
+	std::vector<WorldGridCell> listCells = WorldGrid::Build(scene, gCellSize);
+	EXPECT_EQ(listCells.size(), size_t(2));
+
+	const WorldGridCell* pNear = FindCell(listCells, 0, 0);
+	EXPECT_TRUE(pNear != nullptr);
+	if (pNear)
+	{
+		EXPECT_EQ(pNear->uiNumInstances, 3u);
+		EXPECT_EQ(pNear->listModels.size(), size_t(2));
+		EXPECT_EQ(pNear->listModels[0].strModelPath, std::string("Tree.fbx"));
+		EXPECT_EQ(pNear->listModels[0].listInstances.size(), size_t(2));
+		EXPECT_EQ(pNear->listModels[1].strModelPath, std::string("Rock.fbx"));
+		EXPECT_EQ(pNear->listModels[1].material.roughness, 0.25f);
+		EXPECT_EQ(pNear->listModels[1].material.uiOverrides, uint32_t(OVERRIDE_ROUGHNESS));
+	}
+
+	const WorldGridCell* pFar = FindCell(listCells, 1, 0);
+	EXPECT_TRUE(pFar && pFar->uiNumInstances == 2 && pFar->listModels.size() == 2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every instance ends up in exactly one cell, the one its position falls in
+TEST_CASE(WorldGrid_CoversEveryInstance)
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> distribution(-500.0f, 500.0f);
+
+	SceneFile scene;
+	for (uint32_t m = 0; m < 5; m++)
+	{
+		std::vector<glm::vec3> listPositions;
+		for (uint32_t i = 0; i < 400; i++)
+			listPositions.push_back(glm::vec3(distribution(random), distribution(random), distribution(random)));
+
+		scene.m_ListModels.push_back(MakeModel("Model" + std::to_string(m) + ".fbx", listPositions));
+	}
+
+	std::vector<WorldGridCell> listCells = WorldGrid::Build(scene, gCellSize);
+
+	uint32_t numInstances = 0;
+	std::set<std::pair<int32_t, int32_t>> setCells;
+
+	for (const WorldGridCell& cell : listCells)
+	{
+		EXPECT_TRUE(setCells.insert(std::make_pair(cell.iX, cell.iZ)).second);
+
+		uint32_t numInCell = 0;
+		std::set<std::string> setPaths;
+
+		for (const SceneModel& part : cell.listModels)
+		{
+			EXPECT_TRUE(!part.listInstances.empty());
+			EXPECT_TRUE(setPaths.insert(part.strModelPath).second);
+
+			for (const SceneInstance& instance : part.listInstances)
+			{
+				EXPECT_EQ(WorldGrid::GetCellCoordinate(instance.position.x, gCellSize), cell.iX);
+				EXPECT_EQ(WorldGrid::GetCellCoordinate(instance.position.z, gCellSize), cell.iZ);
+				numInCell++;
+			}
+		}
+
+		EXPECT_EQ(numInCell, cell.uiNumInstances);
+		numInstances += numInCell;
+	}
+
+	EXPECT_EQ(numInstances, scene.GetNumInstances());
+}
@@ -2,6 +2,7 @@
 #include "UIManager.h"
 #include "Core/Core.h"
 #include "Renderer/VulkanContext.h"
+#include "Renderer/VulkanTexture.h"
 #include "vulkan/vulkan.h"
 
 #include "imgui.h"
@@ -11,17 +12,21 @@
 //---------------------------------------------------------------------------------------------------------------------
 UIManager::UIManager()
 {
-
+	m_pFontTexture = nullptr;
+	m_bHostImageCopy = false;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 UIManager::~UIManager()
 {
+	SAFE_DELETE(m_pFontTexture);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 bool UIManager::Initialize(const VulkanContext* pContext)
 {
+	m_bHostImageCopy = pContext->bUseHostImageCopy;
+
 	// create descriptor pool for imgui
 	// the size of the pool is oversized, but it's copied from the demo!
 	VkDescriptorPoolSize poolSizes[] =
@@ -77,17 +82,31 @@ bool UIManager::Initialize(const VulkanContext* pContext)
 
 	CHECK(ImGui_ImplVulkan_Init(&initInfo, pContext->vkForwardRenderingRenderPass));
 
-	// execute GPU commands to upload imgui fonts to textures
-	VkCommandBuffer cmdBuffer = pContext->BeginCommandBuffer();
-	CHECK(ImGui_ImplVulkan_CreateFontsTexture(cmdBuffer));
-	pContext->EndAndSubmitCommandBuffer(cmdBuffer);
+	// upload imgui fonts through our own texture & staging ring instead of imgui's one-off staging buffer
+	unsigned char* pFontPixels = nullptr;
+	int fontWidth = 0;
+	int fontHeight = 0;
+	io.Fonts->GetTexDataAsRGBA32(&pFontPixels, &fontWidth, &fontHeight);
+
+	m_pFontTexture = new VulkanTexture();
+	CHECK(m_pFontTexture->CreateTextureFromData(pContext, pFontPixels, fontWidth, fontHeight, VK_FORMAT_R8G8B8A8_UNORM));
+
+	VkDescriptorSet fontDescriptorSet = ImGui_ImplVulkan_AddTexture(m_pFontTexture->getVkSampler(), m_pFontTexture->getVkImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	io.Fonts->SetTexID((ImTextureID)fontDescriptorSet);
 
 	// clear fonts from the cpu memory!
-	ImGui_ImplVulkan_DestroyFontUploadObjects();
+	io.Fonts->ClearTexData();
 
 	return true;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+void UIManager::Cleanup(const VulkanContext* pContext)
+{
+	if (m_pFontTexture)
+		m_pFontTexture->Cleanup(pContext);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void UIManager::HandleWindowResize(VulkanContext* pContext)
 {
@@ -109,7 +128,22 @@ void UIManager::EndRender(const VulkanContext* pContext, uint32_t imageIndex)
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void UIManager::Render(const VulkanContext* pContext)
+void UIManager::Render(const VulkanContext* pContext, const FrameStats& stats)
 {
 	ImGui::ShowDemoWindow();
+
+	ImGui::Begin("Stats");
+	ImGui::Text("Triangles: %u / %u", stats.uiTrianglesSubmitted, stats.uiTrianglesTotal);
+	ImGui::Text("Draw calls: %u", stats.uiDrawCalls);
+	ImGui::Text("Models: %u / %u", stats.uiModelsLoaded, stats.uiModelsTotal);
+
+	if (stats.uiCellsTotal > 0)
+		ImGui::Text("Cells: %u / %u, %.1f MB resident", stats.uiCellsLoaded, stats.uiCellsTotal, stats.fWorldResidentMB);
+
+	if (stats.uiPagesResident > 0)
+		ImGui::Text("Pages: %u / %u slots", stats.uiPagesResident, stats.uiPageSlots);
+
+	if (pContext->bHostImageCopy)
+		ImGui::Checkbox("Host image copy", &m_bHostImageCopy);
+	ImGui::End();
 }
@@ -1,7 +1,27 @@
 #pragma once
 
 class VulkanContext;
+class VulkanTexture;
 
+//---------------------------------------------------------------------------------------------------------------------
+struct FrameStats
+{
+	FrameStats() : uiTrianglesSubmitted(0), uiTrianglesTotal(0), uiDrawCalls(0), uiModelsLoaded(0), uiModelsTotal(0), uiCellsLoaded(0), uiCellsTotal(0), fWorldResidentMB(0.0f),
+					uiPagesResident(0), uiPageSlots(0) {}
+
+	uint32_t		uiTrianglesSubmitted;
+	uint32_t		uiTrianglesTotal;
+	uint32_t		uiDrawCalls;
+	uint32_t		uiModelsLoaded;
+	uint32_t		uiModelsTotal;
+	uint32_t		uiCellsLoaded;					// world partition only
+	uint32_t		uiCellsTotal;
+	float			fWorldResidentMB;
+	uint32_t		uiPagesResident;				// paged meshes only
+	uint32_t		uiPageSlots;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
 class UIManager
 {
 public:
@@ -9,10 +29,18 @@ public:
 	~UIManager();
 
 	bool			Initialize(const VulkanContext* pContext);
+	void			Cleanup(const VulkanContext* pContext);
 
 	void			HandleWindowResize(VulkanContext* pContext);
 	void			BeginRender(const VulkanContext* pContext);
 	void			EndRender(const VulkanContext* pContext, uint32_t imageIndex);
-	void			Render(const VulkanContext* pContext);
+	void			Render(const VulkanContext* pContext, const FrameStats& stats);
+
+	// Toggled in Stats window, scene hands it over to the context!
+	inline bool		IsHostImageCopyOn() const { return m_bHostImageCopy; }
+
+private:
+	VulkanTexture*	m_pFontTexture;
+	bool			m_bHostImageCopy;
 };
 
@@ -2,9 +2,14 @@
 #include "Scene.h"
 
 #include "Renderer/VulkanContext.h"
+#include "Renderer/VulkanPageStreamer.h"
 #include "Renderables/VulkanModel.h"
 #include "UI/UIManager.h"
 #include "Camera.h"
+#include "SceneLoader.h"
+#include "WorldPartition.h"
+#include "Renderer/CookedFormat.h"
+#include "Core/ThreadPool.h"
 #include "Core/Core.h"
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -12,6 +17,9 @@ Scene::Scene()
 {
 	m_pCamera = nullptr;
 	m_pGUI = nullptr;
+	m_pWorkers = nullptr;
+	m_pLoader = nullptr;
+	m_pPartition = nullptr;
 	m_ListModels.clear();
 }
 
@@ -20,6 +28,9 @@ Scene::~Scene()
 {
 	SAFE_DELETE(m_pCamera);
 	SAFE_DELETE(m_pGUI);
+	SAFE_DELETE(m_pWorkers);
+	SAFE_DELETE(m_pPartition);
+	SAFE_DELETE(m_pLoader);
 	m_ListModels.clear();
 }
 
@@ -27,24 +38,73 @@ Scene::~Scene()
 bool Scene::LoadScene(const VulkanContext* pContext)
 {
 	m_pCamera = new Camera();
-	CHECK(LoadModels(pContext));
+
+	// Culling is short & the main thread waits on it, so it gets its own workers instead of queueing behind decodes!
+	uint32_t numCores = std::thread::hardware_concurrency();
+	m_pWorkers = new ThreadPool(numCores > 1 ? numCores - 1 : 1);
+
+	// Models stream in while we render, they show up in m_ListModels as they finish!
+	m_pLoader = new SceneLoader();
+	m_pLoader->Initialize();
+
+	// Large worlds keep only the cells around the camera, loaded through the same loader. Whole scene is loaded instead
+	// when partitioning is off or the partition couldn't be built!
+	if (Helper::g_bEnableWorldPartition)
+	{
+		m_pPartition = new WorldPartition();
+		if (!m_pPartition->Initialize(pContext, m_pLoader, Helper::g_strDefaultScenePath))
+		{
+			LOG_WARNING("World partition failed, loading whole scene instead!");
+			SAFE_DELETE(m_pPartition);
+		}
+	}
+
+	if (!m_pPartition)
+		m_pLoader->LoadScene(pContext, Helper::g_strDefaultScenePath);
 
 	m_pGUI = new UIManager();
 	CHECK(m_pGUI->Initialize(pContext));
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+// Loader workers still create models & request textures, they have to be gone before the streamer shuts down!
+void Scene::StopLoading()
+{
+	if (m_pLoader)
+		m_pLoader->Shutdown();
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
 void Scene::Cleanup(VulkanContext* pContext)
 {
+	if (m_pLoader)
+		m_pLoader->Cleanup(pContext);
+
+	if (m_pPartition)
+		m_pPartition->Cleanup(pContext);
+
 	for (VulkanModel* model : m_ListModels)
 	{
 		model->Cleanup(pContext); 
 	}
+
+	if (m_pGUI)
+		m_pGUI->Cleanup(pContext);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void Scene::Update(float dt)
+void Scene::Update(VulkanContext* pContext, float dt)
 {
+	pContext->bUseHostImageCopy = m_pGUI->IsHostImageCopyOn();
+
+	// Not streaming, everything was read in LoadScene() & first frame waits for all of it to upload
+	if (m_pPartition)
+		m_pPartition->Update(pContext, m_pCamera, m_ListModels);
+	else
+		m_pLoader->Update(pContext, m_ListModels, !Helper::g_bStreamSceneLoad);
+
 	m_pCamera->Update(dt);
 
 	for (VulkanModel* model : m_ListModels)
@@ -54,6 +114,43 @@ void Scene::Update(float dt)
 			model->Update(m_pCamera, dt);
 		}
 	}
+
+	// LOD selection & meshlet culling, spread over workers
+	for (VulkanModel* model : m_ListModels)
+	{
+		if (model != nullptr)
+		{
+			model->UpdateVisibility(m_pCamera, m_pWorkers);
+		}
+	}
+
+	m_pWorkers->WaitIdle();
+
+	m_FrameStats.uiTrianglesSubmitted = 0;
+	m_FrameStats.uiTrianglesTotal = 0;
+	m_FrameStats.uiDrawCalls = 0;
+	m_FrameStats.uiModelsLoaded = m_pLoader->GetNumLoaded();
+	m_FrameStats.uiModelsTotal = m_pLoader->GetNumModels();
+	m_FrameStats.uiPagesResident = pContext->pPageStreamer->GetNumResidentPages();
+	m_FrameStats.uiPageSlots = pContext->pPageStreamer->GetNumSlots();
+
+	if (m_pPartition)
+	{
+		m_FrameStats.uiModelsLoaded = m_pPartition->GetNumResidentModels();
+		m_FrameStats.uiModelsTotal = m_pPartition->GetNumInstances();
+		m_FrameStats.uiCellsLoaded = m_pPartition->GetNumLoadedCells();
+		m_FrameStats.uiCellsTotal = m_pPartition->GetNumCells();
+		m_FrameStats.fWorldResidentMB = m_pPartition->GetResidentBytes() / (1024.0f * 1024.0f);
+	}
+
+	for (VulkanModel* model : m_ListModels)
+	{
+		if (model != nullptr)
+		{
+			model->GetTriangleCounts(m_FrameStats.uiTrianglesSubmitted, m_FrameStats.uiTrianglesTotal);
+			m_FrameStats.uiDrawCalls += model->GetDrawCallCount();
+		}
+	}
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -68,6 +165,19 @@ void Scene::UpdateUniforms(const VulkanContext* pContext, uint32_t imageIndex)
 	}
 }
 
+//-----------------------------------------------------------------------------------------------------------------------
+// Before recording, both passes then bind the same sets!
+void Scene::RefreshDescriptors(const VulkanContext* pContext, uint32_t imageIndex)
+{
+	for (VulkanModel* model : m_ListModels)
+	{
+		if (model != nullptr)
+		{
+			model->RefreshTextureDescriptors(pContext, imageIndex);
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------------------------------------------------
 void Scene::Render(const VulkanContext* pContext, uint32_t imageIndex)
 {
@@ -80,32 +190,18 @@ void Scene::Render(const VulkanContext* pContext, uint32_t imageIndex)
 	}
 
 	m_pGUI->BeginRender(pContext);
-	m_pGUI->Render(pContext);
+	m_pGUI->Render(pContext, m_FrameStats);
 	m_pGUI->EndRender(pContext, imageIndex);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-bool Scene::LoadModels(const VulkanContext* pContext)
+void Scene::RenderDepth(const VulkanContext* pContext, uint32_t imageIndex)
 {
-	// Load Robot Model
-	VulkanModel* pRobotModel = new VulkanModel();
-	pRobotModel->LoadModel(pContext, "Torus/Torus.fbx");
-	pRobotModel->m_vecPosition = glm::vec3(0, 0, 0);
-	pRobotModel->m_vecScale = glm::vec3(0.1f);
-	pRobotModel->m_bUpdate = true;
-	pRobotModel->SetupDescriptors(pContext);
-	
-	m_ListModels.push_back(pRobotModel);
-
-	// Load Robot Model
-	VulkanModel* pBarbModel = new VulkanModel();
-	pBarbModel->LoadModel(pContext, "Barbarian/BarbNew2.fbx");
-	pBarbModel->m_vecPosition = glm::vec3(0, 0, 0);
-	pBarbModel->m_vecScale = glm::vec3(0.1f);
-	pBarbModel->m_bUpdate = false;
-	pBarbModel->SetupDescriptors(pContext);
-
-	m_ListModels.push_back(pBarbModel);
-
-	return true;
+	for (VulkanModel* model : m_ListModels)
+	{
+		if (model != nullptr)
+		{
+			model->RenderDepth(pContext, imageIndex);
+		}
+	}
 }
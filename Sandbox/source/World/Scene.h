@@ -1,9 +1,13 @@
 #pragma once
 
+#include "UI/UIManager.h"
+
 class VulkanContext;
 class VulkanModel;
 class Camera;
-class UIManager;
+class ThreadPool;
+class SceneLoader;
+class WorldPartition;
 
 //---------------------------------------------------------------------------------------------------------------------
 class Scene
@@ -13,22 +17,25 @@ public:
 	~Scene();
 
 	bool							LoadScene(const VulkanContext* pContext);
+	void							StopLoading();
 	void							Cleanup(VulkanContext* pContext);
 
-	void							Update(float dt);
+	void							Update(VulkanContext* pContext, float dt);
 	void							UpdateUniforms(const VulkanContext* pContext, uint32_t imageIndex);
+	void							RefreshDescriptors(const VulkanContext* pContext, uint32_t imageIndex);
 	void							Render(const VulkanContext* pContext, uint32_t imageIndex);
+	void							RenderDepth(const VulkanContext* pContext, uint32_t imageIndex);
 
 public:
-	inline VulkanModel*				GetFirstModel() const { return m_ListModels[0]; }
 	inline Camera*					GetCamera()	const { return m_pCamera; }
 
 private:
-	bool							LoadModels(const VulkanContext* pContext);
-
-private:
-	std::vector <VulkanModel*>		m_ListModels;
+	std::vector <VulkanModel*>		m_ListModels;					// only what's done loading, see SceneLoader
 	Camera*							m_pCamera;
+	ThreadPool*						m_pWorkers;
+	SceneLoader*					m_pLoader;
+	WorldPartition*					m_pPartition;					// only with Helper::g_bEnableWorldPartition
+	FrameStats						m_FrameStats;
 public:
 	UIManager*						m_pGUI;
 };
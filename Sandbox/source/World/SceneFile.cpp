@@ -0,0 +1,249 @@
+#include "sandboxPCH.h"
+#include "SceneFile.h"
+#include "Core/VirtualFileSystem.h"
+#include "Core/Core.h"
+
+namespace
+{
+	const uint32_t g_uiSceneVersion = 1;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void WriteVec(std::ostream& stream, const char* tag, const float* pValues, uint32_t count)
+	{
+		stream << tag;
+		for (uint32_t i = 0; i < count; i++)
+			stream << " " << pValues[i];
+
+		stream << "\n";
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+SceneFile::SceneFile()
+{
+	m_ListModels.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+SceneFile::~SceneFile()
+{
+	m_ListModels.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cooker only, runtime reads cooked scenes through the file system!
+bool SceneFile::LoadSource(const std::string& filePath)
+{
+	std::ifstream file(filePath);
+	if (!file)
+	{
+		LOG_ERROR("Failed to open scene {0}", filePath);
+		return false;
+	}
+
+	return Parse(file, filePath);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool SceneFile::Load(const VirtualFileSystem* pFileSystem, const std::string& filePath)
+{
+	uint64_t fileSize = 0;
+	if (!pFileSystem->GetFileSize(filePath, &fileSize))
+	{
+		LOG_ERROR("Failed to open cooked scene {0}, is the Cooker run?", filePath);
+		return false;
+	}
+
+	std::string strText(static_cast<size_t>(fileSize), '\0');
+	if (fileSize > 0 && !pFileSystem->Read(filePath, 0, fileSize, &strText[0]))
+	{
+		LOG_ERROR("Failed to read cooked scene {0}", filePath);
+		return false;
+	}
+
+	std::istringstream stream(std::move(strText));
+	return Parse(stream, filePath);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Same layout the source is parsed from, comments are gone & every value is written out!
+bool SceneFile::Save(const std::string& filePath) const
+{
+	return Helper::WriteFileAtomic(filePath, [&](std::ostream& stream)
+	{
+		stream << std::setprecision(9);
+		stream << "Scene " << g_uiSceneVersion << "\n";
+
+		for (const SceneModel& model : m_ListModels)
+		{
+			stream << "model " << std::quoted(model.strModelPath) << "\n";
+
+			const SceneMaterial& material = model.material;
+			if (material.uiOverrides & OVERRIDE_ALBEDO)		WriteVec(stream, "albedo", &material.albedoColor.x, 4);
+			if (material.uiOverrides & OVERRIDE_EMISSION)	WriteVec(stream, "emission", &material.emissionColor.x, 4);
+			if (material.uiOverrides & OVERRIDE_ROUGHNESS)	WriteVec(stream, "roughness", &material.roughness, 1);
+			if (material.uiOverrides & OVERRIDE_METALNESS)	WriteVec(stream, "metalness", &material.metalness, 1);
+			if (material.uiOverrides & OVERRIDE_OCCLUSION)	WriteVec(stream, "occlusion", &material.occlusion, 1);
+
+			for (const SceneInstance& instance : model.listInstances)
+			{
+				stream << "instance\n";
+				WriteVec(stream, "position", &instance.position.x, 3);
+				stream << "rotation " << instance.rotationAxis.x << " " << instance.rotationAxis.y << " " << instance.rotationAxis.z << " " << instance.rotation << "\n";
+				WriteVec(stream, "scale", &instance.scale.x, 3);
+				stream << "spin " << (instance.bSpin ? 1 : 0) << "\n";
+			}
+
+			stream << "end\n";
+		}
+
+		return static_cast<bool>(stream);
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t SceneFile::GetNumInstances() const
+{
+	uint32_t numInstances = 0;
+	for (const SceneModel& model : m_ListModels)
+	{
+		numInstances += static_cast<uint32_t>(model.listInstances.size());
+	}
+
+	return numInstances;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Whole file or nothing, a bad line leaves the scene as it was!
+bool SceneFile::Parse(std::istream& input, const std::string& filePath)
+{
+	// Comments go first, what's left is read tag by tag
+	std::stringstream stream;
+	std::string line;
+	while (std::getline(input, line))
+	{
+		stream << line.substr(0, line.find('#')) << "\n";
+	}
+
+	std::string tag;
+	uint32_t version = 0;
+	if (!(stream >> tag >> version) || tag != "Scene" || version != g_uiSceneVersion)
+	{
+		LOG_ERROR("{0} isn't a version {1} scene!", filePath, g_uiSceneVersion);
+		return false;
+	}
+
+	std::vector<SceneModel> listModels;
+	SceneModel* pModel = nullptr;
+	SceneInstance* pInstance = nullptr;
+
+	while (stream >> tag)
+	{
+		if (tag == "model")
+		{
+			if (pModel)
+			{
+				LOG_ERROR("{0}: model {1} has no end!", filePath, pModel->strModelPath);
+				return false;
+			}
+
+			listModels.emplace_back();
+			pModel = &listModels.back();
+			pInstance = nullptr;
+
+			stream >> std::quoted(pModel->strModelPath);
+		}
+		else if (!pModel)
+		{
+			LOG_ERROR("{0}: {1} outside of a model!", filePath, tag);
+			return false;
+		}
+		else if (tag == "end")
+		{
+			if (pModel->listInstances.empty())
+				LOG_WARNING("{0}: model {1} has no instances, nothing gets loaded", filePath, pModel->strModelPath);
+
+			pModel = nullptr;
+			pInstance = nullptr;
+		}
+		else if (tag == "albedo")
+		{
+			SceneMaterial& material = pModel->material;
+			stream >> material.albedoColor.r >> material.albedoColor.g >> material.albedoColor.b >> material.albedoColor.a;
+			material.uiOverrides |= OVERRIDE_ALBEDO;
+		}
+		else if (tag == "emission")
+		{
+			SceneMaterial& material = pModel->material;
+			stream >> material.emissionColor.r >> material.emissionColor.g >> material.emissionColor.b >> material.emissionColor.a;
+			material.uiOverrides |= OVERRIDE_EMISSION;
+		}
+		else if (tag == "roughness")
+		{
+			stream >> pModel->material.roughness;
+			pModel->material.uiOverrides |= OVERRIDE_ROUGHNESS;
+		}
+		else if (tag == "metalness")
+		{
+			stream >> pModel->material.metalness;
+			pModel->material.uiOverrides |= OVERRIDE_METALNESS;
+		}
+		else if (tag == "occlusion")
+		{
+			stream >> pModel->material.occlusion;
+			pModel->material.uiOverrides |= OVERRIDE_OCCLUSION;
+		}
+		else if (tag == "instance")
+		{
+			pModel->listInstances.emplace_back();
+			pInstance = &pModel->listInstances.back();
+		}
+		else if (!pInstance)
+		{
+			LOG_ERROR("{0}: {1} of model {2} comes before any instance!", filePath, tag, pModel->strModelPath);
+			return false;
+		}
+		else if (tag == "position")
+		{
+			stream >> pInstance->position.x >> pInstance->position.y >> pInstance->position.z;
+		}
+		else if (tag == "rotation")
+		{
+			stream >> pInstance->rotationAxis.x >> pInstance->rotationAxis.y >> pInstance->rotationAxis.z >> pInstance->rotation;
+
+			if (stream && glm::dot(pInstance->rotationAxis, pInstance->rotationAxis) == 0.0f)
+			{
+				LOG_ERROR("{0}: rotation axis of model {1} is zero!", filePath, pModel->strModelPath);
+				return false;
+			}
+		}
+		else if (tag == "scale")
+		{
+			stream >> pInstance->scale.x >> pInstance->scale.y >> pInstance->scale.z;
+		}
+		else if (tag == "spin")
+		{
+			stream >> pInstance->bSpin;
+		}
+		else
+		{
+			LOG_ERROR("{0}: unknown tag {1}!", filePath, tag);
+			return false;
+		}
+
+		if (!stream)
+		{
+			LOG_ERROR("{0}: bad value for {1}!", filePath, tag);
+			return false;
+		}
+	}
+
+	if (pModel)
+	{
+		LOG_ERROR("{0}: model {1} has no end!", filePath, pModel->strModelPath);
+		return false;
+	}
+
+	m_ListModels.swap(listModels);
+	return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+class VirtualFileSystem;
+
+//---------------------------------------------------------------------------------------------------------------------
+// One placement of a model, each one becomes a VulkanModel of its own. Rotation is in radians around the axis!
+struct SceneInstance
+{
+	SceneInstance() : position(0.0f), rotationAxis(0, 1, 0), rotation(0.0f), scale(1.0f), bSpin(false) {}
+
+	glm::vec3						position;
+	glm::vec3						rotationAxis;
+	float							rotation;
+	glm::vec3						scale;
+	bool							bSpin;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Shader constants every instance of the model starts with, only the ones flagged are overridden!
+enum SceneMaterialOverride : uint32_t
+{
+	OVERRIDE_ALBEDO		= 1 << 0,
+	OVERRIDE_EMISSION	= 1 << 1,
+	OVERRIDE_ROUGHNESS	= 1 << 2,
+	OVERRIDE_METALNESS	= 1 << 3,
+	OVERRIDE_OCCLUSION	= 1 << 4
+};
+
+struct SceneMaterial
+{
+	SceneMaterial() : uiOverrides(0), albedoColor(1.0f), emissionColor(1.0f), roughness(1.0f), metalness(0.0f), occlusion(1.0f) {}
+
+	uint32_t						uiOverrides;
+	glm::vec4						albedoColor;
+	glm::vec4						emissionColor;
+	float							roughness;
+	float							metalness;
+	float							occlusion;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Model path is relative to Assets/Models, same as VulkanModel::LoadModel() takes it
+struct SceneModel
+{
+	std::string						strModelPath;
+	SceneMaterial					material;
+	std::vector<SceneInstance>		listInstances;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Models, their instances & material overrides of one scene. Source lives under Assets/Scenes, the Cooker checks it &
+// writes it out again in the same layout, see Helper::GetCookedScenePath(). Every tag sits on its own line:
+//
+//	Scene <version>
+//	model "<path>"				starts a model, everything up to its "end" belongs to it
+//	albedo|emission <r g b a>
+//	roughness|metalness|occlusion <value>
+//	instance					starts an instance, following transform tags set it
+//	position|scale <x y z>
+//	rotation <axis x y z> <radians>
+//	spin <0|1>
+//	end
+//
+// Anything after '#' is a comment!
+class SceneFile
+{
+public:
+	SceneFile();
+	~SceneFile();
+
+	bool							LoadSource(const std::string& filePath);
+	bool							Load(const VirtualFileSystem* pFileSystem, const std::string& filePath);
+	bool							Save(const std::string& filePath) const;
+
+	uint32_t						GetNumInstances() const;
+
+private:
+	bool							Parse(std::istream& stream, const std::string& filePath);
+
+public:
+	std::vector<SceneModel>			m_ListModels;
+};
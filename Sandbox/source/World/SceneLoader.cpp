@@ -0,0 +1,380 @@
+#include "sandboxPCH.h"
+#include "SceneLoader.h"
+#include "Renderer/VulkanContext.h"
+#include "Renderer/VulkanUploadBatch.h"
+#include "Renderables/VulkanModel.h"
+#include "Renderables/VulkanSceneSnapshot.h"
+#include "World/SceneSnapshot.h"
+#include "Core/ThreadPool.h"
+#include "Core/Core.h"
+
+namespace
+{
+	const uint32_t g_uiNoCell = std::numeric_limits<uint32_t>::max();		// whole scene loads
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+SceneLoader::SceneLoader()
+{
+	m_pWorkers = nullptr;
+	m_ListLoadedModels.clear();
+	m_ListInFlightModels.clear();
+	m_ListDoneMaterials.clear();
+	m_pSnapshot = nullptr;
+	m_ListSnapshotModels.clear();
+	m_ListFailedSnapshotModels.clear();
+	m_strFilePath.clear();
+	m_bCancelled = false;
+	m_bFileLoaded = false;
+	m_bDone = false;
+	m_uiNumModels = 0;
+	m_uiNumLoaded = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+SceneLoader::~SceneLoader()
+{
+	SAFE_DELETE(m_pWorkers);
+	SAFE_DELETE(m_pSnapshot);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Own workers: loads wait on reads for a long time, they'd hold up culling jobs the main thread waits on every frame!
+void SceneLoader::Initialize()
+{
+	if (Helper::g_bStreamSceneLoad)
+		m_pWorkers = new ThreadPool(std::max(Helper::g_uiSceneLoadThreads, 1u));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Scene file itself is read on a worker too, so first frame doesn't even wait on that!
+void SceneLoader::LoadScene(const VulkanContext* pContext, const std::string& sourcePath)
+{
+	m_StartTime = std::chrono::steady_clock::now();
+
+	m_strFilePath = Helper::GetCookedSnapshotPath(sourcePath);
+	if (Helper::g_bLoadSceneSnapshot && LoadSnapshot(pContext, m_strFilePath))
+		return;
+
+	const std::string filePath = Helper::GetCookedScenePath(sourcePath);
+	m_strFilePath = filePath;
+
+	if (m_pWorkers)
+		m_pWorkers->Enqueue([this, pContext, filePath]() { LoadSceneFile(pContext, filePath); });
+	else
+		LoadSceneFile(pContext, filePath);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Everything is resolved already: one mapping, one upload for all geometry & one allocation for all descriptor sets.
+// Falls back to the scene file when there's no snapshot or it fails!
+bool SceneLoader::LoadSnapshot(const VulkanContext* pContext, const std::string& filePath)
+{
+	SceneSnapshot snapshot;
+	if (!snapshot.Load(pContext->pFileSystem, filePath))
+		return false;
+
+	m_pSnapshot = new VulkanSceneSnapshot();
+	if (!m_pSnapshot->Create(pContext, snapshot, m_ListSnapshotModels))
+	{
+		LOG_ERROR("Failed to create scene snapshot {0}, streaming the scene instead", filePath);
+
+		// Geometry transfer in Create() blocks, but textures of its materials may be requested already & the streamer
+		// writes into them & reads models' bounds. Nothing is handed over, all of it is only destroyed in Cleanup()!
+		m_ListFailedSnapshotModels.swap(m_ListSnapshotModels);
+		return false;
+	}
+
+	m_uiNumModels = static_cast<uint32_t>(m_ListSnapshotModels.size());
+	m_bFileLoaded = true;
+
+	LOG_INFO("Loading scene snapshot {0}: {1} instances", filePath, m_uiNumModels.load());
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// One job per scene model, its instances load one after another so later ones find its meshes in the cache!
+void SceneLoader::LoadSceneFile(const VulkanContext* pContext, const std::string& filePath)
+{
+	SceneFile scene;
+	if (scene.Load(pContext->pFileSystem, filePath))
+	{
+		m_uiNumModels = scene.GetNumInstances();
+		LOG_INFO("Loading scene {0}: {1} models, {2} instances", filePath, scene.m_ListModels.size(), m_uiNumModels.load());
+	}
+	else
+	{
+		LOG_CRITICAL("Failed to load scene {0}, run the Cooker!", filePath);
+	}
+
+	m_bFileLoaded = true;
+
+	for (const SceneModel& model : scene.m_ListModels)
+	{
+		if (m_pWorkers)
+			m_pWorkers->Enqueue([this, pContext, model]() { LoadModel(pContext, model, g_uiNoCell); });
+		else
+			LoadModel(pContext, model, g_uiNoCell);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Same jobs as a whole scene, so cells share the workers & the upload order with it!
+void SceneLoader::LoadCell(const VulkanContext* pContext, const std::vector<SceneModel>& listModels, uint32_t uiCell)
+{
+	for (const SceneModel& model : listModels)
+	{
+		if (m_pWorkers)
+			m_pWorkers->Enqueue([this, pContext, model, uiCell]() { LoadModel(pContext, model, uiCell); });
+		else
+			LoadModel(pContext, model, uiCell);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reads run in parallel across workers, only recording the upload is serialized: a model shares meshes only with ones
+// already in the cache, which recorded theirs earlier & so get submitted first! Instances share textures & descriptor
+// pool too, each one only adds its uniform buffers & sets.
+void SceneLoader::LoadModel(const VulkanContext* pContext, const SceneModel& model, uint32_t uiCell)
+{
+	SharedModelMaterial* pSharedMaterial = new SharedModelMaterial(static_cast<uint32_t>(model.listInstances.size()));
+
+	for (const SceneInstance& instance : model.listInstances)
+	{
+		if (m_bCancelled)
+			break;
+
+		VulkanModel* pModel = new VulkanModel();
+		VulkanUploadBatch* pBatch = new VulkanUploadBatch();
+
+		// Workers can wait for ring space, main thread is the one handing it back
+		if (!pModel->ReadModel(pContext, model.strModelPath, pBatch, m_pWorkers != nullptr))
+		{
+			pBatch->Cleanup(pContext);
+			SAFE_DELETE(pBatch);
+			SAFE_DELETE(pModel);
+
+			std::lock_guard<std::mutex> lock(m_MutexLoaded);
+			m_ListLoadedModels.push_back({ nullptr, nullptr, uiCell, false });
+			continue;
+		}
+
+		pModel->m_vecPosition = instance.position;
+		pModel->m_vecRotationAxis = instance.rotationAxis;
+		pModel->m_fRotation = instance.rotation;
+		pModel->m_fCurrentAngle = instance.rotation;
+		pModel->m_vecScale = instance.scale;
+		pModel->m_bUpdate = instance.bSpin;
+
+		std::lock_guard<std::mutex> lock(m_MutexLoaded);
+
+		// Failed one still submits its batch, later models may share meshes it recorded!
+		const bool bCreated = pModel->CreateModel(pContext, pBatch, pSharedMaterial);
+		if (bCreated)
+			pModel->ApplyMaterialOverrides(model.material);
+		else
+			LOG_ERROR("Failed to create {0}, dropped once its upload is done", model.strModelPath);
+
+		// Loading on main thread: nothing would give staging back till the whole scene is read, upload right away!
+		if (!m_pWorkers)
+		{
+			pBatch->Submit(pContext);
+			pBatch->Cleanup(pContext);
+			SAFE_DELETE(pBatch);
+		}
+
+		m_ListLoadedModels.push_back({ pModel, pBatch, uiCell, !bCreated });
+	}
+
+	// Dropping the last reference destroys textures the streamer may know of, that's for the main thread
+	std::lock_guard<std::mutex> lock(m_MutexLoaded);
+	m_ListDoneMaterials.push_back(pSharedMaterial);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void SceneLoader::Update(VulkanContext* pContext, std::vector<VulkanModel*>& outListModels, bool bWaitForAll)
+{
+	for (VulkanModel* pModel : m_ListSnapshotModels)
+		outListModels.push_back(pModel);
+
+	m_uiNumLoaded += static_cast<uint32_t>(m_ListSnapshotModels.size());
+	m_ListSnapshotModels.clear();
+
+	std::vector<LoadedModel> listLoaded;
+	HandOver(pContext, listLoaded, bWaitForAll);
+
+	for (const LoadedModel& loaded : listLoaded)
+	{
+		if (!loaded.pModel)
+		{
+			--m_uiNumModels;
+			continue;
+		}
+
+		outListModels.push_back(loaded.pModel);
+		++m_uiNumLoaded;
+	}
+
+	if (!m_bDone && m_bFileLoaded && m_uiNumLoaded == m_uiNumModels)
+	{
+		m_bDone = true;
+
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_StartTime).count();
+		LOG_INFO("Scene {0} loaded: {1} models in {2:.2f} ms", m_strFilePath, m_uiNumLoaded.load(), elapsedMs);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Failed ones come back too, a cell only counts as loaded once every instance it asked for is accounted for!
+void SceneLoader::UpdateCells(VulkanContext* pContext, std::vector<StreamedModel>& outListModels, bool bWaitForAll)
+{
+	std::vector<LoadedModel> listLoaded;
+	HandOver(pContext, listLoaded, bWaitForAll);
+
+	for (const LoadedModel& loaded : listLoaded)
+		outListModels.push_back({ loaded.pModel, loaded.uiCell });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Uploads go on the transfer queue & never block the frame. Models are handed over oldest first & only while their
+// batch is done, so a model never shows up before geometry it shares with an earlier one! Dropped ones come out null.
+void SceneLoader::HandOver(VulkanContext* pContext, std::vector<LoadedModel>& outListLoaded, bool bWaitForAll)
+{
+	std::vector<LoadedModel> listLoaded;
+	std::vector<SharedModelMaterial*> listDoneMaterials;
+	{
+		std::lock_guard<std::mutex> lock(m_MutexLoaded);
+		listLoaded.swap(m_ListLoadedModels);
+		listDoneMaterials.swap(m_ListDoneMaterials);
+	}
+
+	// Instances hold their own references, it's only gone here if none of them is left
+	for (SharedModelMaterial* pSharedMaterial : listDoneMaterials)
+	{
+		if (pSharedMaterial->Release(pContext))
+			SAFE_DELETE(pSharedMaterial);
+	}
+
+	for (LoadedModel& loaded : listLoaded)
+	{
+		if (!loaded.pModel)
+		{
+			outListLoaded.push_back(loaded);
+			continue;
+		}
+
+		// Uploaded already, see LoadModel()
+		if (!loaded.pBatch)
+		{
+			if (loaded.bFailed)
+			{
+				loaded.pModel->Cleanup(pContext);
+				SAFE_DELETE(loaded.pModel);
+			}
+
+			outListLoaded.push_back(loaded);
+			continue;
+		}
+
+		if (loaded.pBatch->SubmitAsync(pContext))
+		{
+			m_ListInFlightModels.push_back(loaded);
+			continue;
+		}
+
+		LOG_ERROR("Failed to upload streamed model, dropped!");
+
+		// Whatever did get submitted must be done before staging goes back to the ring!
+		vkQueueWaitIdle(pContext->vkQueueGraphics);
+
+		loaded.pBatch->Cleanup(pContext);
+		SAFE_DELETE(loaded.pBatch);
+		loaded.pModel->Cleanup(pContext);
+		SAFE_DELETE(loaded.pModel);
+
+		outListLoaded.push_back(loaded);
+	}
+
+	// Acquire submit on graphics queue is the last one of every batch, idle graphics queue means all of them are done!
+	if (bWaitForAll && !m_ListInFlightModels.empty())
+		vkQueueWaitIdle(pContext->vkQueueGraphics);
+
+	while (!m_ListInFlightModels.empty() && m_ListInFlightModels.front().pBatch->IsComplete(pContext))
+	{
+		LoadedModel& loaded = m_ListInFlightModels.front();
+
+		loaded.pBatch->Cleanup(pContext);
+		SAFE_DELETE(loaded.pBatch);
+
+		if (loaded.bFailed)
+		{
+			loaded.pModel->Cleanup(pContext);
+			SAFE_DELETE(loaded.pModel);
+		}
+
+		outListLoaded.push_back(loaded);
+		m_ListInFlightModels.pop_front();
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Jobs still queued return right away, ones already running finish the model they're on!
+void SceneLoader::Shutdown()
+{
+	m_bCancelled = true;
+
+	if (m_pWorkers)
+		m_pWorkers->WaitIdle();
+
+	SAFE_DELETE(m_pWorkers);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Models never handed over to the scene are still ours! Snapshot's models only borrow from it, so it goes with them.
+void SceneLoader::Cleanup(VulkanContext* pContext)
+{
+	for (VulkanModel* pModel : m_ListSnapshotModels)
+		SAFE_DELETE(pModel);
+
+	for (VulkanModel* pModel : m_ListFailedSnapshotModels)
+		SAFE_DELETE(pModel);
+
+	m_ListSnapshotModels.clear();
+	m_ListFailedSnapshotModels.clear();
+
+	if (m_pSnapshot)
+	{
+		m_pSnapshot->Cleanup(pContext);
+		SAFE_DELETE(m_pSnapshot);
+	}
+
+	for (const LoadedModel& loaded : m_ListLoadedModels)
+	{
+		if (loaded.pModel)
+			m_ListInFlightModels.push_back(loaded);
+	}
+
+	m_ListLoadedModels.clear();
+
+	for (LoadedModel& loaded : m_ListInFlightModels)
+	{
+		if (loaded.pBatch)
+		{
+			loaded.pBatch->Cleanup(pContext);
+			SAFE_DELETE(loaded.pBatch);
+		}
+
+		loaded.pModel->Cleanup(pContext);
+		SAFE_DELETE(loaded.pModel);
+	}
+
+	m_ListInFlightModels.clear();
+
+	for (SharedModelMaterial* pSharedMaterial : m_ListDoneMaterials)
+	{
+		if (pSharedMaterial->Release(pContext))
+			SAFE_DELETE(pSharedMaterial);
+	}
+
+	m_ListDoneMaterials.clear();
+}
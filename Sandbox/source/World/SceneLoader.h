@@ -0,0 +1,85 @@
+#pragma once
+
+#include "World/SceneFile.h"
+
+class VulkanContext;
+class VulkanModel;
+class VulkanUploadBatch;
+class VulkanSceneSnapshot;
+class ThreadPool;
+struct SharedModelMaterial;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Instance a cell load handed over, model is null when it failed to load. See WorldPartition!
+struct StreamedModel
+{
+	VulkanModel*						pModel;
+	uint32_t							uiCell;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Streams the models of a cooked scene in on its own workers while frames keep rendering. Workers read each model &
+// record its upload, main thread submits the uploads in the order they were recorded & hands models over to the scene
+// once the GPU is done with them. Order matters: a model may share geometry an earlier one is still uploading, see
+// VulkanMeshCache! Nothing the main thread does here grows with the scene, besides models that just finished.
+class SceneLoader
+{
+public:
+	SceneLoader();
+	~SceneLoader();
+
+	void								Initialize();
+
+	// Takes the source path & loads the cooked scene's snapshot when there is one, blocking till it's on the GPU.
+	// Otherwise returns right away, unless Helper::g_bStreamSceneLoad is off: then every model is read & recorded first
+	void								LoadScene(const VulkanContext* pContext, const std::string& sourcePath);
+
+	// Main thread, once per frame. Appends models that are ready to be rendered!
+	void								Update(VulkanContext* pContext, std::vector<VulkanModel*>& outListModels, bool bWaitForAll = false);
+
+	// World partition loads part of a scene at a time: instances of these models, all of them in one cell, load like a
+	// whole scene's do. Every one of them comes back once through UpdateCells(), tagged with the cell!
+	void								LoadCell(const VulkanContext* pContext, const std::vector<SceneModel>& listModels, uint32_t uiCell);
+	void								UpdateCells(VulkanContext* pContext, std::vector<StreamedModel>& outListModels, bool bWaitForAll = false);
+
+	// Shutdown() joins the workers & must come before the texture streamer stops, Cleanup() once GPU is idle
+	void								Shutdown();
+	void								Cleanup(VulkanContext* pContext);
+
+	inline uint32_t						GetNumLoaded() const { return m_uiNumLoaded; }
+	inline uint32_t						GetNumModels() const { return m_uiNumModels; }
+
+private:
+	struct LoadedModel
+	{
+		VulkanModel*					pModel;						// null once it failed, nothing else to do with it
+		VulkanUploadBatch*				pBatch;						// null when it was uploaded while loading on main thread
+		uint32_t						uiCell;
+		bool							bFailed;					// creation failed, dropped once its batch is done
+	};
+
+	bool								LoadSnapshot(const VulkanContext* pContext, const std::string& filePath);
+	void								LoadSceneFile(const VulkanContext* pContext, const std::string& filePath);
+	void								LoadModel(const VulkanContext* pContext, const SceneModel& model, uint32_t uiCell);
+	void								HandOver(VulkanContext* pContext, std::vector<LoadedModel>& outListLoaded, bool bWaitForAll);
+
+private:
+	ThreadPool*							m_pWorkers;
+
+	std::mutex							m_MutexLoaded;				// held while a model records its upload, recording order is submit order
+	std::vector<LoadedModel>			m_ListLoadedModels;
+	std::deque<LoadedModel>				m_ListInFlightModels;		// main thread only, oldest first
+	std::vector<SharedModelMaterial*>	m_ListDoneMaterials;		// of finished jobs, their reference is dropped on the main thread
+
+	VulkanSceneSnapshot*				m_pSnapshot;				// owns what its models share, outlives them
+	std::vector<VulkanModel*>			m_ListSnapshotModels;		// ready, handed over on next Update()
+	std::vector<VulkanModel*>			m_ListFailedSnapshotModels;	// snapshot failed after requesting textures, kept till Cleanup()
+
+	std::string							m_strFilePath;
+	std::atomic<bool>					m_bCancelled;
+	std::atomic<bool>					m_bFileLoaded;
+	bool								m_bDone;
+	std::atomic<uint32_t>				m_uiNumModels;				// one per instance
+	std::atomic<uint32_t>				m_uiNumLoaded;
+	std::chrono::steady_clock::time_point	m_StartTime;
+};
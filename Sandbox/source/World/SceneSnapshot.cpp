@@ -0,0 +1,433 @@
+#include "sandboxPCH.h"
+#include "SceneSnapshot.h"
+#include "Renderables/VulkanMesh.h"
+#include "Core/VirtualFileSystem.h"
+#include "Core/MappedFile.h"
+#include "Core/Core.h"
+
+namespace
+{
+	const uint64_t g_uiBlockAlignment = 16;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	inline uint64_t AlignBlock(uint64_t offset)
+	{
+		return (offset + g_uiBlockAlignment - 1) & ~(g_uiBlockAlignment - 1);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	inline bool IsRange(uint64_t first, uint64_t count, uint64_t total)
+	{
+		return first <= total && count <= total - first;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+SceneSnapshot::SceneSnapshot()
+{
+	m_pFile = nullptr;
+	m_pData = nullptr;
+	m_uiSize = 0;
+	m_Header = {};
+	m_bHasPagedMeshes = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+SceneSnapshot::~SceneSnapshot()
+{
+	Unload();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Each cooked model is read once, however many scene models name it. Scene models become materials, their instances
+// point at the model & the material!
+bool SceneSnapshot::Build(const SceneFile& scene, const VirtualFileSystem* pFileSystem, std::vector<std::string>& outListModelPaths)
+{
+	m_ListInstances.clear();
+	m_ListModels.clear();
+	m_ListMeshes.clear();
+	m_ListLods.clear();
+	m_ListMeshlets.clear();
+	m_ListMaterials.clear();
+	m_strStrings.clear();
+	m_ListVertexData.clear();
+	m_ListIndexData.clear();
+	m_bHasPagedMeshes = false;
+
+	std::map<std::string, BuildModel> mapModels;
+	std::map<uint64_t, uint32_t> mapGeometry;
+
+	for (const SceneModel& sceneModel : scene.m_ListModels)
+	{
+		if (sceneModel.listInstances.empty())
+			continue;
+
+		const std::string cookedPath = Helper::GetCookedModelPath(Helper::g_strSourceRoot + "Models/" + sceneModel.strModelPath);
+
+		auto itr = mapModels.find(cookedPath);
+		if (itr == mapModels.end())
+		{
+			CookedModel cooked;
+			if (!cooked.Load(pFileSystem, cookedPath))
+			{
+				LOG_WARNING("Snapshot leaves out {0}, it isn't cooked", sceneModel.strModelPath);
+				continue;
+			}
+
+			if (!cooked.m_ListPagedMeshes.empty())
+			{
+				LOG_INFO("No snapshot, {0} has paged meshes", sceneModel.strModelPath);
+				m_bHasPagedMeshes = true;
+				outListModelPaths.push_back(cookedPath);
+				return false;
+			}
+
+			BuildModel model;
+			if (!AddModel(cooked, mapGeometry, model))
+				return false;
+
+			itr = mapModels.emplace(cookedPath, model).first;
+			outListModelPaths.push_back(cookedPath);
+		}
+
+		SnapshotMaterial material = {};
+		std::copy(std::begin(itr->second.arrTextures), std::end(itr->second.arrTextures), std::begin(material.arrTextures));
+		material.overrides = sceneModel.material;
+
+		m_ListMaterials.push_back(material);
+
+		for (const SceneInstance& sceneInstance : sceneModel.listInstances)
+		{
+			SnapshotInstance instance = {};
+			instance.uiModel = itr->second.uiModel;
+			instance.uiMaterial = static_cast<uint32_t>(m_ListMaterials.size() - 1);
+			instance.position = sceneInstance.position;
+			instance.rotationAxis = sceneInstance.rotationAxis;
+			instance.rotation = sceneInstance.rotation;
+			instance.scale = sceneInstance.scale;
+			instance.uiSpin = sceneInstance.bSpin ? 1 : 0;
+
+			m_ListInstances.push_back(instance);
+		}
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Cook time, so the payload is simply read again & compared with what's stored already. LODs come from the same data!
+bool SceneSnapshot::IsSameGeometry(CookedModel& cooked, const CookedMesh& mesh, const SnapshotMesh& stored)
+{
+	if (mesh.eVertexFormat != stored.eVertexFormat || mesh.uiVertexCount != stored.uiVertexCount || mesh.uiIndexCount != stored.uiIndexCount)
+		return false;
+
+	std::vector<uint8_t> listVertices(static_cast<size_t>(mesh.uiVertexDataSize));
+	std::vector<uint8_t> listIndices(static_cast<size_t>(mesh.uiIndexDataSize));
+
+	if (!cooked.ReadPayload(mesh.uiVertexDataOffset, mesh.uiVertexDataSize, listVertices.data()) ||
+		!cooked.ReadPayload(mesh.uiIndexDataOffset, mesh.uiIndexDataSize, listIndices.data()))
+		return false;
+
+	return	memcmp(listVertices.data(), m_ListVertexData.data() + stored.uiVertexOffset, listVertices.size()) == 0 &&
+			memcmp(listIndices.data(), m_ListIndexData.data() + stored.uiIndexOffset, listIndices.size()) == 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runtime binds the last of the model's materials (see VulkanModel::LoadTextures()), so that's the one kept. Geometry
+// already in the snapshot under the same hash is shared, data & LODs, once its bytes turn out to be the same too!
+bool SceneSnapshot::AddModel(CookedModel& cooked, std::map<uint64_t, uint32_t>& mapGeometry, BuildModel& outModel)
+{
+	if (cooked.m_ListMaterials.empty())
+	{
+		LOG_ERROR("Cooked model {0} has no material, re-run the Cooker!", cooked.m_strName);
+		return false;
+	}
+
+	const CookedMaterial& material = cooked.m_ListMaterials.back();
+	for (size_t i = 0; i < material.arrTextures.size(); i++)
+	{
+		outModel.arrTextures[i] = AddString(material.arrTextures[i]);
+	}
+
+	SnapshotModel model = {};
+	model.name = AddString(cooked.m_strName);
+	model.uiFirstMesh = static_cast<uint32_t>(m_ListMeshes.size());
+	model.uiNumMeshes = static_cast<uint32_t>(cooked.m_ListMeshes.size());
+	model.vecBoundsMin = cooked.m_vecBoundsMin;
+	model.vecBoundsMax = cooked.m_vecBoundsMax;
+
+	std::vector<const CookedMesh*> listMeshes;
+	for (const CookedMesh& mesh : cooked.m_ListMeshes)
+		listMeshes.push_back(&mesh);
+
+	std::stable_sort(listMeshes.begin(), listMeshes.end(), [](const CookedMesh* a, const CookedMesh* b) { return a->eVertexFormat < b->eVertexFormat; });
+
+	for (const CookedMesh* pCooked : listMeshes)
+	{
+		auto itr = mapGeometry.find(pCooked->uiHash);
+		if (itr != mapGeometry.end())
+		{
+			const SnapshotMesh shared = m_ListMeshes[itr->second];
+			if (IsSameGeometry(cooked, *pCooked, shared))
+			{
+				m_ListMeshes.push_back(shared);
+				continue;
+			}
+
+			LOG_WARNING("{0} mesh {1} collides with different geometry under hash {2:016x}, it's stored on its own", cooked.m_strName, pCooked->strName, pCooked->uiHash);
+		}
+
+		SnapshotMesh mesh = {};
+		mesh.uiHash = pCooked->uiHash;
+		mesh.quantization = pCooked->quantization;
+		mesh.eVertexFormat = pCooked->eVertexFormat;
+		mesh.uiVertexCount = pCooked->uiVertexCount;
+		mesh.uiIndexCount = pCooked->uiIndexCount;
+		mesh.uiFirstLod = static_cast<uint32_t>(m_ListLods.size());
+
+		// Mesh without LODs is drawn whole, same as VulkanMesh sets itself up
+		if (pCooked->listLods.empty())
+		{
+			m_ListLods.push_back({ 0, pCooked->uiIndexCount, 0.0f, static_cast<uint32_t>(m_ListMeshlets.size()), 0 });
+		}
+
+		for (const MeshLod& lod : pCooked->listLods)
+		{
+			m_ListLods.push_back({ lod.firstIndex, lod.indexCount, lod.fError, static_cast<uint32_t>(m_ListMeshlets.size()), static_cast<uint32_t>(lod.listMeshlets.size()) });
+			m_ListMeshlets.insert(m_ListMeshlets.end(), lod.listMeshlets.begin(), lod.listMeshlets.end());
+		}
+
+		mesh.uiNumLods = static_cast<uint32_t>(m_ListLods.size()) - mesh.uiFirstLod;
+
+		// Both blocks keep every mesh 16 byte aligned, index buffer offsets must be a multiple of the index size!
+		mesh.uiVertexOffset = AlignBlock(m_ListVertexData.size());
+		mesh.uiIndexOffset = AlignBlock(m_ListIndexData.size());
+		m_ListVertexData.resize(mesh.uiVertexOffset + pCooked->uiVertexDataSize);
+		m_ListIndexData.resize(mesh.uiIndexOffset + pCooked->uiIndexDataSize);
+
+		if (!cooked.ReadPayload(pCooked->uiVertexDataOffset, pCooked->uiVertexDataSize, m_ListVertexData.data() + mesh.uiVertexOffset) ||
+			!cooked.ReadPayload(pCooked->uiIndexDataOffset, pCooked->uiIndexDataSize, m_ListIndexData.data() + mesh.uiIndexOffset))
+		{
+			LOG_ERROR("Failed to read {0} mesh {1}, re-run the Cooker!", cooked.m_strName, pCooked->strName);
+			return false;
+		}
+
+		mapGeometry.emplace(mesh.uiHash, static_cast<uint32_t>(m_ListMeshes.size()));
+		m_ListMeshes.push_back(mesh);
+	}
+
+	outModel.uiModel = static_cast<uint32_t>(m_ListModels.size());
+	m_ListModels.push_back(model);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+SnapshotString SceneSnapshot::AddString(const std::string& string)
+{
+	SnapshotString snapshotString = { static_cast<uint32_t>(m_strStrings.size()), static_cast<uint32_t>(string.size()) };
+	m_strStrings += string;
+
+	return snapshotString;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Blocks are placed first, then written in the same order with padding in between!
+bool SceneSnapshot::Save(const std::string& filePath) const
+{
+	Helper::SceneSnapshotHeader header = {};
+	header.uiMagic = Helper::g_uiSceneSnapshotMagic;
+	header.uiVersion = Helper::g_uiCookedVersion;
+	header.uiNumInstances = static_cast<uint32_t>(m_ListInstances.size());
+	header.uiNumModels = static_cast<uint32_t>(m_ListModels.size());
+	header.uiNumMeshes = static_cast<uint32_t>(m_ListMeshes.size());
+	header.uiNumLods = static_cast<uint32_t>(m_ListLods.size());
+	header.uiNumMeshlets = static_cast<uint32_t>(m_ListMeshlets.size());
+	header.uiNumMaterials = static_cast<uint32_t>(m_ListMaterials.size());
+
+	struct Block
+	{
+		const void*					pData;
+		uint64_t					uiSize;
+		uint64_t*					pOffset;
+	};
+
+	const std::array<Block, 9> arrBlocks =
+	{ {
+		{ m_ListInstances.data(),	m_ListInstances.size() * sizeof(SnapshotInstance),	&header.uiInstancesOffset },
+		{ m_ListModels.data(),		m_ListModels.size() * sizeof(SnapshotModel),		&header.uiModelsOffset },
+		{ m_ListMeshes.data(),		m_ListMeshes.size() * sizeof(SnapshotMesh),			&header.uiMeshesOffset },
+		{ m_ListLods.data(),		m_ListLods.size() * sizeof(SnapshotLod),			&header.uiLodsOffset },
+		{ m_ListMeshlets.data(),	m_ListMeshlets.size() * sizeof(Meshlet),			&header.uiMeshletsOffset },
+		{ m_ListMaterials.data(),	m_ListMaterials.size() * sizeof(SnapshotMaterial),	&header.uiMaterialsOffset },
+		{ m_strStrings.data(),		m_strStrings.size(),								&header.uiStringsOffset },
+		{ m_ListVertexData.data(),	m_ListVertexData.size(),							&header.uiVertexDataOffset },
+		{ m_ListIndexData.data(),	m_ListIndexData.size(),								&header.uiIndexDataOffset },
+	} };
+
+	uint64_t offset = sizeof(header);
+	for (const Block& block : arrBlocks)
+	{
+		*block.pOffset = AlignBlock(offset);
+		offset = *block.pOffset + block.uiSize;
+	}
+
+	header.uiStringsSize = m_strStrings.size();
+	header.uiVertexDataSize = m_ListVertexData.size();
+	header.uiIndexDataSize = m_ListIndexData.size();
+
+	return Helper::WriteFileAtomic(filePath, [&](std::ostream& stream)
+	{
+		const char padding[g_uiBlockAlignment] = {};
+
+		Helper::WritePod(stream, header);
+
+		uint64_t written = sizeof(header);
+		for (const Block& block : arrBlocks)
+		{
+			stream.write(padding, *block.pOffset - written);
+			stream.write(static_cast<const char*>(block.pData), block.uiSize);
+			written = *block.pOffset + block.uiSize;
+		}
+
+		return static_cast<bool>(stream);
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool SceneSnapshot::Load(const VirtualFileSystem* pFileSystem, const std::string& filePath)
+{
+	Unload();
+
+	m_pData = pFileSystem->GetMappedData(filePath, &m_uiSize);
+	if (!m_pData)
+	{
+		m_pFile = new MappedFile();
+		if (!m_pFile->Open(filePath))
+		{
+			LOG_WARNING("No scene snapshot at {0}, is the Cooker run?", filePath);
+			Unload();
+			return false;
+		}
+
+		m_pData = m_pFile->GetData();
+		m_uiSize = m_pFile->GetSize();
+	}
+
+	if (m_uiSize < sizeof(m_Header))
+	{
+		LOG_ERROR("Scene snapshot {0} is truncated, re-run the Cooker!", filePath);
+		Unload();
+		return false;
+	}
+
+	memcpy(&m_Header, m_pData, sizeof(m_Header));
+
+	if (!Validate(filePath))
+	{
+		Unload();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void SceneSnapshot::Unload()
+{
+	if (m_pFile)
+		m_pFile->Close();
+
+	SAFE_DELETE(m_pFile);
+
+	m_pData = nullptr;
+	m_uiSize = 0;
+	m_Header = {};
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Blocks first, then every index & range in the tables. Tables are small next to the geometry, even for big scenes!
+bool SceneSnapshot::Validate(const std::string& filePath) const
+{
+	const Helper::SceneSnapshotHeader& header = m_Header;
+
+	auto IsBlock = [this](uint64_t offset, uint64_t count, uint64_t stride)
+	{
+		return offset % g_uiBlockAlignment == 0 && IsRange(offset, count * stride, m_uiSize);
+	};
+
+	if (header.uiMagic != Helper::g_uiSceneSnapshotMagic || header.uiVersion != Helper::g_uiCookedVersion ||
+		!IsBlock(header.uiInstancesOffset, header.uiNumInstances, sizeof(SnapshotInstance)) ||
+		!IsBlock(header.uiModelsOffset, header.uiNumModels, sizeof(SnapshotModel)) ||
+		!IsBlock(header.uiMeshesOffset, header.uiNumMeshes, sizeof(SnapshotMesh)) ||
+		!IsBlock(header.uiLodsOffset, header.uiNumLods, sizeof(SnapshotLod)) ||
+		!IsBlock(header.uiMeshletsOffset, header.uiNumMeshlets, sizeof(Meshlet)) ||
+		!IsBlock(header.uiMaterialsOffset, header.uiNumMaterials, sizeof(SnapshotMaterial)) ||
+		!IsBlock(header.uiStringsOffset, header.uiStringsSize, 1) ||
+		!IsBlock(header.uiVertexDataOffset, header.uiVertexDataSize, 1) ||
+		!IsBlock(header.uiIndexDataOffset, header.uiIndexDataSize, 1))
+	{
+		LOG_ERROR("Scene snapshot {0} is stale or corrupt, re-run the Cooker!", filePath);
+		return false;
+	}
+
+	auto IsString = [&header](const SnapshotString& string) { return IsRange(string.uiOffset, string.uiLength, header.uiStringsSize); };
+
+	bool bValid = true;
+
+	const SnapshotInstance* pInstances = GetInstances();
+	for (uint32_t i = 0; bValid && i < header.uiNumInstances; i++)
+	{
+		bValid = pInstances[i].uiModel < header.uiNumModels && pInstances[i].uiMaterial < header.uiNumMaterials;
+	}
+
+	const SnapshotModel* pModels = GetModels();
+	for (uint32_t i = 0; bValid && i < header.uiNumModels; i++)
+	{
+		bValid = IsString(pModels[i].name) && IsRange(pModels[i].uiFirstMesh, pModels[i].uiNumMeshes, header.uiNumMeshes);
+	}
+
+	const SnapshotMaterial* pMaterials = GetMaterials();
+	for (uint32_t i = 0; bValid && i < header.uiNumMaterials; i++)
+	{
+		bValid = std::all_of(std::begin(pMaterials[i].arrTextures), std::end(pMaterials[i].arrTextures), IsString);
+	}
+
+	const SnapshotMesh* pMeshes = GetMeshes();
+	const SnapshotLod* pLods = GetLods();
+	const Meshlet* pMeshlets = GetMeshlets();
+
+	for (uint32_t i = 0; bValid && i < header.uiNumMeshes; i++)
+	{
+		const SnapshotMesh& mesh = pMeshes[i];
+		if (mesh.eVertexFormat >= Helper::EVertexFormat::COUNT || mesh.uiNumLods == 0 || !IsRange(mesh.uiFirstLod, mesh.uiNumLods, header.uiNumLods))
+		{
+			bValid = false;
+			break;
+		}
+
+		const uint64_t indexSize = VulkanMesh::GetIndexSize(VulkanMesh::ChooseIndexType(mesh.uiVertexCount));
+
+		bValid =	IsRange(mesh.uiVertexOffset, uint64_t(mesh.uiVertexCount) * Helper::GetVertexSize(mesh.eVertexFormat), header.uiVertexDataSize) &&
+					IsRange(mesh.uiIndexOffset, uint64_t(mesh.uiIndexCount) * indexSize, header.uiIndexDataSize) &&
+					mesh.uiIndexOffset % indexSize == 0;
+
+		for (uint32_t j = mesh.uiFirstLod; bValid && j < mesh.uiFirstLod + mesh.uiNumLods; j++)
+		{
+			bValid = IsRange(pLods[j].uiFirstIndex, pLods[j].uiIndexCount, mesh.uiIndexCount) && IsRange(pLods[j].uiFirstMeshlet, pLods[j].uiNumMeshlets, header.uiNumMeshlets);
+
+			for (uint32_t k = pLods[j].uiFirstMeshlet; bValid && k < pLods[j].uiFirstMeshlet + pLods[j].uiNumMeshlets; k++)
+			{
+				bValid = IsRange(pMeshlets[k].firstIndex, pMeshlets[k].indexCount, mesh.uiIndexCount);
+			}
+		}
+	}
+
+	if (!bValid)
+	{
+		LOG_ERROR("Scene snapshot {0} has broken tables, re-run the Cooker!", filePath);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "World/SceneFile.h"
+#include "Renderer/CookedFormat.h"
+#include "Renderables/CookedModel.h"
+
+class VirtualFileSystem;
+class MappedFile;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Tables of a snapshot, stored as they are & used right out of the mapping. Strings are ranges of the string block!
+struct SnapshotString
+{
+	uint32_t						uiOffset;
+	uint32_t						uiLength;
+};
+
+struct SnapshotInstance
+{
+	uint32_t						uiModel;
+	uint32_t						uiMaterial;
+	glm::vec3						position;
+	glm::vec3						rotationAxis;
+	float							rotation;
+	glm::vec3						scale;
+	uint32_t						uiSpin;
+};
+
+//--- Meshes of a model are already sorted by vertex format, like VulkanModel::CreateModel() sorts them
+struct SnapshotModel
+{
+	SnapshotString					name;
+	uint32_t						uiFirstMesh;
+	uint32_t						uiNumMeshes;
+	glm::vec3						vecBoundsMin;
+	glm::vec3						vecBoundsMax;
+};
+
+//--- Offsets are into the vertex & index data blocks, meshes with the same hash & bytes point to the same data
+struct SnapshotMesh
+{
+	uint64_t						uiHash;
+	uint64_t						uiVertexOffset;
+	uint64_t						uiIndexOffset;
+	Helper::QuantizationBounds		quantization;
+	Helper::EVertexFormat			eVertexFormat;
+	uint32_t						uiVertexCount;
+	uint32_t						uiIndexCount;
+	uint32_t						uiFirstLod;
+	uint32_t						uiNumLods;
+	uint32_t						uiReserved;
+};
+
+struct SnapshotLod
+{
+	uint32_t						uiFirstIndex;
+	uint32_t						uiIndexCount;
+	float							fError;
+	uint32_t						uiFirstMeshlet;
+	uint32_t						uiNumMeshlets;
+};
+
+//--- Cooked textures of the model & the scene's overrides, instances of one scene model share it
+struct SnapshotMaterial
+{
+	SnapshotString					arrTextures[static_cast<size_t>(CookedTextureSlot::COUNT)];
+	SceneMaterial					overrides;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Scene with everything it names already resolved, in one file: instances, meshes & LODs of their cooked models,
+// materials with the scene's overrides & vertex & index data of every distinct mesh, laid out so it can go into one
+// vertex & one index buffer as it is. Cooker builds it from the scene & the cooked models, runtime maps it & reads every
+// table straight out of the mapping, nothing is parsed! See VulkanSceneSnapshot for the GPU side.
+class SceneSnapshot
+{
+public:
+	SceneSnapshot();
+	~SceneSnapshot();
+
+	// Cook side. Models come from their cooked files, missing ones only warn & their instances are left out. Paths of
+	// the cooked models it read go to outListModelPaths, snapshot has to be rebuilt when any of them changes! Paged
+	// meshes stream their pages on their own & can't be part of it, fails with HasPagedMeshes() set for those.
+	bool								Build(const SceneFile& scene, const VirtualFileSystem* pFileSystem, std::vector<std::string>& outListModelPaths);
+	inline bool							HasPagedMeshes() const			{ return m_bHasPagedMeshes; }
+	bool								Save(const std::string& filePath) const;
+
+	// Runtime. Pack entries are used where the pack is mapped, loose files get a mapping of their own. Every index is
+	// checked here, so tables can be trusted till Unload()!
+	bool								Load(const VirtualFileSystem* pFileSystem, const std::string& filePath);
+	void								Unload();
+
+	inline const Helper::SceneSnapshotHeader&	GetHeader() const		{ return m_Header; }
+	inline const SnapshotInstance*		GetInstances() const			{ return GetTable<SnapshotInstance>(m_Header.uiInstancesOffset); }
+	inline const SnapshotModel*			GetModels() const				{ return GetTable<SnapshotModel>(m_Header.uiModelsOffset); }
+	inline const SnapshotMesh*			GetMeshes() const				{ return GetTable<SnapshotMesh>(m_Header.uiMeshesOffset); }
+	inline const SnapshotLod*			GetLods() const					{ return GetTable<SnapshotLod>(m_Header.uiLodsOffset); }
+	inline const Meshlet*				GetMeshlets() const				{ return GetTable<Meshlet>(m_Header.uiMeshletsOffset); }
+	inline const SnapshotMaterial*		GetMaterials() const			{ return GetTable<SnapshotMaterial>(m_Header.uiMaterialsOffset); }
+	inline const uint8_t*				GetVertexData() const			{ return m_pData + m_Header.uiVertexDataOffset; }
+	inline const uint8_t*				GetIndexData() const			{ return m_pData + m_Header.uiIndexDataOffset; }
+
+	inline std::string					GetString(const SnapshotString& string) const
+	{
+		return std::string(reinterpret_cast<const char*>(m_pData + m_Header.uiStringsOffset + string.uiOffset), string.uiLength);
+	}
+
+private:
+	struct BuildModel
+	{
+		uint32_t						uiModel;
+		SnapshotString					arrTextures[static_cast<size_t>(CookedTextureSlot::COUNT)];
+	};
+
+	template<typename T>
+	inline const T*						GetTable(uint64_t offset) const	{ return reinterpret_cast<const T*>(m_pData + offset); }
+
+	bool								AddModel(CookedModel& cooked, std::map<uint64_t, uint32_t>& mapGeometry, BuildModel& outModel);
+	bool								IsSameGeometry(CookedModel& cooked, const CookedMesh& mesh, const SnapshotMesh& stored);
+	SnapshotString						AddString(const std::string& string);
+	bool								Validate(const std::string& filePath) const;
+
+private:
+	// Cook side
+	std::vector<SnapshotInstance>		m_ListInstances;
+	std::vector<SnapshotModel>			m_ListModels;
+	std::vector<SnapshotMesh>			m_ListMeshes;
+	std::vector<SnapshotLod>			m_ListLods;
+	std::vector<Meshlet>				m_ListMeshlets;
+	std::vector<SnapshotMaterial>		m_ListMaterials;
+	std::string							m_strStrings;
+	std::vector<uint8_t>				m_ListVertexData;
+	std::vector<uint8_t>				m_ListIndexData;
+	bool								m_bHasPagedMeshes;
+
+	// Runtime
+	MappedFile*							m_pFile;						// loose files only
+	const uint8_t*						m_pData;
+	uint64_t							m_uiSize;
+	Helper::SceneSnapshotHeader			m_Header;
+};
@@ -0,0 +1,50 @@
+#include "sandboxPCH.h"
+#include "WorldGrid.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Instances of one scene model stay together within a cell, they load one after another & later ones find the first
+// one's meshes in the cache!
+std::vector<WorldGridCell> WorldGrid::Build(const SceneFile& scene, float cellSize)
+{
+	std::vector<WorldGridCell> listCells;
+	std::map<std::pair<int32_t, int32_t>, uint32_t> mapCells;
+	std::vector<size_t> listLastModel;								// per cell, scene model its last part came from
+
+	for (size_t i = 0; i < scene.m_ListModels.size(); i++)
+	{
+		const SceneModel& model = scene.m_ListModels[i];
+
+		for (const SceneInstance& instance : model.listInstances)
+		{
+			const int32_t iX = GetCellCoordinate(instance.position.x, cellSize);
+			const int32_t iZ = GetCellCoordinate(instance.position.z, cellSize);
+
+			auto itr = mapCells.find(std::make_pair(iX, iZ));
+			if (itr == mapCells.end())
+			{
+				itr = mapCells.emplace(std::make_pair(iX, iZ), static_cast<uint32_t>(listCells.size())).first;
+
+				WorldGridCell cell;
+				cell.iX = iX;
+				cell.iZ = iZ;
+				listCells.push_back(cell);
+				listLastModel.push_back(std::numeric_limits<size_t>::max());
+			}
+
+			WorldGridCell& cell = listCells[itr->second];
+			if (listLastModel[itr->second] != i)
+			{
+				SceneModel part = model;
+				part.listInstances.clear();
+
+				cell.listModels.push_back(part);
+				listLastModel[itr->second] = i;
+			}
+
+			cell.listModels.back().listInstances.push_back(instance);
+			cell.uiNumInstances++;
+		}
+	}
+
+	return listCells;
+}
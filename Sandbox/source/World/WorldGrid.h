@@ -0,0 +1,28 @@
+#pragma once
+
+#include "World/SceneFile.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Square column of the world on XZ, holds every instance whose position falls inside it. Scene models are split per
+// cell, so a cell only has its own instances!
+struct WorldGridCell
+{
+	WorldGridCell() : iX(0), iZ(0), uiNumInstances(0) {}
+
+	int32_t								iX;
+	int32_t								iZ;
+	std::vector<SceneModel>				listModels;
+	uint32_t							uiNumInstances;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Grid behind WorldPartition, knows nothing about loading or the GPU. Cell (iX, iZ) covers [iX, iX + 1) * cellSize on
+// X & the same on Z, negative positions included!
+class WorldGrid
+{
+public:
+	// Only cells that hold something exist, in the order their first instance shows up in the scene
+	static std::vector<WorldGridCell>	Build(const SceneFile& scene, float cellSize);
+
+	static inline int32_t				GetCellCoordinate(float position, float cellSize) { return static_cast<int32_t>(std::floor(position / cellSize)); }
+};
@@ -0,0 +1,320 @@
+#include "sandboxPCH.h"
+#include "WorldPartition.h"
+#include "SceneLoader.h"
+#include "Camera.h"
+#include "Renderer/VulkanContext.h"
+#include "Renderer/CookedFormat.h"
+#include "Renderables/VulkanModel.h"
+#include "Core/Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+WorldPartition::WorldPartition()
+{
+	m_pLoader = nullptr;
+	m_ListCells.clear();
+	m_ListRetiredModels.clear();
+
+	m_uiFrame = 0;
+	m_uiNumInstances = 0;
+	m_uiNumLoadedCells = 0;
+	m_uiNumResidentModels = 0;
+	m_vkResidentBytes = 0;
+	m_vkRetiredBytes = 0;
+	m_vkBytesPerInstance = 0;
+	m_bBudgetFull = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+WorldPartition::~WorldPartition()
+{
+	m_ListCells.clear();
+	m_ListRetiredModels.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Scene file is small next to what it places, so it's read right here. Models are what streams!
+bool WorldPartition::Initialize(const VulkanContext* pContext, SceneLoader* pLoader, const std::string& sourcePath)
+{
+	m_pLoader = pLoader;
+
+	const std::string filePath = Helper::GetCookedScenePath(sourcePath);
+
+	SceneFile scene;
+	if (!scene.Load(pContext->pFileSystem, filePath))
+	{
+		LOG_CRITICAL("Failed to load scene {0}, run the Cooker!", filePath);
+		return false;
+	}
+
+	BuildCells(scene);
+
+	LOG_INFO("World partition {0}: {1} instances in {2} cells of {3} units", filePath, m_uiNumInstances, m_ListCells.size(), Helper::g_fWorldCellSize);
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void WorldPartition::BuildCells(const SceneFile& scene)
+{
+	for (WorldGridCell& gridCell : WorldGrid::Build(scene, Helper::g_fWorldCellSize))
+	{
+		WorldCell cell;
+		static_cast<WorldGridCell&>(cell) = std::move(gridCell);
+
+		m_uiNumInstances += cell.uiNumInstances;
+		m_ListCells.push_back(std::move(cell));
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void WorldPartition::Update(VulkanContext* pContext, const Camera* pCamera, std::vector<VulkanModel*>& listSceneModels)
+{
+	m_uiFrame++;
+
+	DestroyRetiredModels(pContext, false);
+	ReceiveModels(pContext, listSceneModels);
+
+	UpdateCells(pCamera);
+	UnloadFarCells(listSceneModels);
+	LoadNearCells(pContext, listSceneModels);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Not streaming, loads were read on this thread & the first frame after waits for their uploads
+void WorldPartition::ReceiveModels(VulkanContext* pContext, std::vector<VulkanModel*>& listSceneModels)
+{
+	std::vector<StreamedModel> listStreamed;
+	m_pLoader->UpdateCells(pContext, listStreamed, !Helper::g_bStreamSceneLoad);
+
+	for (const StreamedModel& streamed : listStreamed)
+	{
+		WorldCell& cell = m_ListCells[streamed.uiCell];
+
+		if (streamed.pModel)
+		{
+			cell.listLoadedModels.push_back(streamed.pModel);
+			listSceneModels.push_back(streamed.pModel);
+			m_uiNumResidentModels++;
+		}
+
+		if (--cell.uiNumPending == 0)
+		{
+			cell.eState = CellState::LOADED;
+			m_uiNumLoadedCells++;
+
+			LOG_DEBUG("Loaded cell ({0}, {1}): {2} of {3} models", cell.iX, cell.iZ, cell.listLoadedModels.size(), cell.uiNumInstances);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Distances & sizes, once a frame. Loaded cells are measured as their textures stream in, loading ones count with
+// whatever is more, what arrived so far or their estimate!
+void WorldPartition::UpdateCells(const Camera* pCamera)
+{
+	const glm::vec3& cameraPosition = pCamera->m_vecCameraPosition;
+
+	VkDeviceSize vkLoadedBytes = 0;
+	uint32_t uiLoadedInstances = 0;
+	m_vkResidentBytes = m_vkRetiredBytes;
+
+	// Shared meshes & textures are counted with the first cell that has them, nearest or not
+	m_CountedResources.Clear();
+
+	for (WorldCell& cell : m_ListCells)
+	{
+		const float fMinX = cell.iX * Helper::g_fWorldCellSize;
+		const float fMinZ = cell.iZ * Helper::g_fWorldCellSize;
+
+		const float dx = std::max({ fMinX - cameraPosition.x, 0.0f, cameraPosition.x - (fMinX + Helper::g_fWorldCellSize) });
+		const float dz = std::max({ fMinZ - cameraPosition.z, 0.0f, cameraPosition.z - (fMinZ + Helper::g_fWorldCellSize) });
+		cell.fDistance = glm::sqrt(dx * dx + dz * dz);
+
+		if (cell.eState == CellState::UNLOADED)
+			continue;
+
+		VkDeviceSize vkBytes = 0;
+		for (const VulkanModel* pModel : cell.listLoadedModels)
+		{
+			vkBytes += pModel->GetResidentSize(m_CountedResources);
+		}
+
+		if (cell.eState == CellState::LOADING)
+		{
+			vkBytes = std::max(vkBytes, EstimateCellSize(cell));
+		}
+		else
+		{
+			vkLoadedBytes += vkBytes;
+			uiLoadedInstances += cell.uiNumInstances;
+		}
+
+		cell.vkResidentBytes = vkBytes;
+		m_vkResidentBytes += vkBytes;
+	}
+
+	if (uiLoadedInstances > 0)
+		m_vkBytesPerInstance = vkLoadedBytes / uiLoadedInstances;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void WorldPartition::UnloadFarCells(std::vector<VulkanModel*>& listSceneModels)
+{
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_ListCells.size()); i++)
+	{
+		if (m_ListCells[i].eState == CellState::LOADED && m_ListCells[i].fDistance > Helper::g_fCellUnloadRadius)
+			UnloadCell(i, listSceneModels);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Nearest first. Cell that doesn't fit evicts loaded cells farther than itself, farthest first, & waits: their memory
+// only comes back once their models are destroyed a few frames later. Cells that are still loading are never evicted,
+// a cell that left the radius while loading finishes first & goes on a later frame!
+void WorldPartition::LoadNearCells(const VulkanContext* pContext, std::vector<VulkanModel*>& listSceneModels)
+{
+	std::vector<uint32_t> listCandidates;
+	uint32_t uiNumLoading = 0;
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_ListCells.size()); i++)
+	{
+		if (m_ListCells[i].eState == CellState::LOADING)
+			uiNumLoading++;
+		else if (m_ListCells[i].eState == CellState::UNLOADED && m_ListCells[i].fDistance <= Helper::g_fCellLoadRadius)
+			listCandidates.push_back(i);
+	}
+
+	std::sort(listCandidates.begin(), listCandidates.end(), [this](uint32_t a, uint32_t b) { return m_ListCells[a].fDistance < m_ListCells[b].fDistance; });
+
+	bool bBudgetFull = false;
+	for (uint32_t uiCell : listCandidates)
+	{
+		if (uiNumLoading >= Helper::g_uiMaxLoadingCells)
+			break;
+
+		WorldCell& cell = m_ListCells[uiCell];
+
+		// Nothing loaded yet to estimate from, a cell would count as free: one at a time till the first is measured
+		if (!cell.bMeasured && m_vkBytesPerInstance == 0 && uiNumLoading > 0)
+			break;
+
+		const VkDeviceSize vkEstimate = EstimateCellSize(cell);
+
+		if (m_vkResidentBytes + vkEstimate > Helper::g_vkWorldPartitionBudget)
+		{
+			VkDeviceSize vkEvicted = 0;
+			while (m_vkResidentBytes - vkEvicted + vkEstimate > Helper::g_vkWorldPartitionBudget)
+			{
+				int32_t iFarthest = -1;
+				for (uint32_t i = 0; i < static_cast<uint32_t>(m_ListCells.size()); i++)
+				{
+					const WorldCell& other = m_ListCells[i];
+					if (other.eState == CellState::LOADED && other.fDistance > cell.fDistance && (iFarthest < 0 || other.fDistance > m_ListCells[iFarthest].fDistance))
+						iFarthest = static_cast<int32_t>(i);
+				}
+
+				// Nothing farther, or farthest one is still streaming textures & can't go yet
+				if (iFarthest < 0 || !UnloadCell(static_cast<uint32_t>(iFarthest), listSceneModels))
+					break;
+
+				vkEvicted += m_ListCells[iFarthest].vkResidentBytes;
+			}
+
+			bBudgetFull = vkEvicted == 0;
+			break;
+		}
+
+		m_pLoader->LoadCell(pContext, cell.listModels, uiCell);
+
+		cell.eState = CellState::LOADING;
+		cell.uiNumPending = cell.uiNumInstances;
+		cell.vkResidentBytes = vkEstimate;
+
+		m_vkResidentBytes += vkEstimate;
+		uiNumLoading++;
+	}
+
+	// Only on change, it stays full for as long as the camera doesn't move!
+	if (bBudgetFull && !m_bBudgetFull)
+		LOG_WARNING("World partition budget of {0} MB is full, nearer cells wait for farther ones to go", Helper::g_vkWorldPartitionBudget / (1024 * 1024));
+
+	m_bBudgetFull = bBudgetFull;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Models leave the scene right away & are destroyed later, see DestroyRetiredModels(). Streamer may still write into
+// textures of a model that isn't done streaming, whole cell waits for that!
+bool WorldPartition::UnloadCell(uint32_t uiCell, std::vector<VulkanModel*>& listSceneModels)
+{
+	WorldCell& cell = m_ListCells[uiCell];
+
+	if (cell.eState != CellState::LOADED)
+		return false;
+
+	if (std::any_of(cell.listLoadedModels.begin(), cell.listLoadedModels.end(), [](const VulkanModel* pModel) { return pModel->IsStreaming(); }))
+		return false;
+
+	std::vector<VulkanModel*> listSorted = cell.listLoadedModels;
+	std::sort(listSorted.begin(), listSorted.end());
+
+	listSceneModels.erase(std::remove_if(listSceneModels.begin(), listSceneModels.end(),
+							[&listSorted](VulkanModel* pModel) { return std::binary_search(listSorted.begin(), listSorted.end(), pModel); }),
+							listSceneModels.end());
+
+	// Meshes other cells still share are counted as retired too, till the models are destroyed a few frames later
+	VkDeviceSize vkBytes = 0;
+	m_CountedResources.Clear();
+
+	for (VulkanModel* pModel : cell.listLoadedModels)
+	{
+		const VkDeviceSize vkModelBytes = pModel->GetResidentSize(m_CountedResources);
+
+		m_ListRetiredModels.push_back({ pModel, m_uiFrame, vkModelBytes });
+		vkBytes += vkModelBytes;
+	}
+
+	LOG_DEBUG("Unloaded cell ({0}, {1}): {2} models, {3:.2f} MB", cell.iX, cell.iZ, cell.listLoadedModels.size(), vkBytes / (1024.0f * 1024.0f));
+
+	m_vkRetiredBytes += vkBytes;
+	m_uiNumResidentModels -= static_cast<uint32_t>(cell.listLoadedModels.size());
+	m_uiNumLoadedCells--;
+
+	cell.listLoadedModels.clear();
+	cell.eState = CellState::UNLOADED;
+	cell.vkResidentBytes = vkBytes;
+	cell.bMeasured = true;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VkDeviceSize WorldPartition::EstimateCellSize(const WorldCell& cell) const
+{
+	return cell.bMeasured ? cell.vkResidentBytes : m_vkBytesPerInstance * cell.uiNumInstances;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Frame a model was retired in doesn't record it anymore. Last one that did is done once its fence has been waited on,
+// which happens by the time gMaxFramesDraws more frames have started!
+void WorldPartition::DestroyRetiredModels(VulkanContext* pContext, bool bAll)
+{
+	while (!m_ListRetiredModels.empty() && (bAll || m_uiFrame >= m_ListRetiredModels.front().uiFrame + Helper::gMaxFramesDraws))
+	{
+		RetiredModel& retired = m_ListRetiredModels.front();
+
+		retired.pModel->Cleanup(pContext);
+		SAFE_DELETE(retired.pModel);
+
+		m_vkRetiredBytes -= retired.vkBytes;
+		m_ListRetiredModels.pop_front();
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void WorldPartition::Cleanup(VulkanContext* pContext)
+{
+	DestroyRetiredModels(pContext, true);
+
+	m_ListCells.clear();
+	m_uiNumLoadedCells = 0;
+	m_uiNumResidentModels = 0;
+}
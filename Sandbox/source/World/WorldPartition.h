@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Renderer/Utility.h"
+#include "World/WorldGrid.h"
+#include "Renderables/VulkanModel.h"
+
+class VulkanContext;
+class Camera;
+class SceneLoader;
+struct StreamedModel;
+
+//---------------------------------------------------------------------------------------------------------------------
+enum class CellState
+{
+	UNLOADED,
+	LOADING,							// waiting on the loader for some of its instances
+	LOADED
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Grid cell (see WorldGrid) plus where its loading stands!
+struct WorldCell : public WorldGridCell
+{
+	WorldCell() : eState(CellState::UNLOADED), uiNumPending(0), vkResidentBytes(0), bMeasured(false), fDistance(0.0f) {}
+
+	CellState							eState;
+	std::vector<VulkanModel*>			listLoadedModels;
+	uint32_t							uiNumPending;
+	VkDeviceSize						vkResidentBytes;
+	bool								bMeasured;						// unloaded once, its size is known for the next load
+	float								fDistance;						// camera to the cell's square on XZ
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Removed from the scene, still referenced by frames the GPU may not have finished yet!
+struct RetiredModel
+{
+	VulkanModel*						pModel;
+	uint64_t							uiFrame;
+	VkDeviceSize						vkBytes;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Splits a cooked scene into a grid of cells & keeps only the ones around the camera resident. Cells within the load
+// radius are loaded through the scene loader, nearest first, while everything resident plus their last known size fits
+// the memory budget. Farther cells are evicted to make room for nearer ones & cells past the unload radius go away on
+// their own. Unloaded models leave the scene right away but are only destroyed once no frame in flight can still use
+// them, so resident memory stays bounded by the budget however big the world gets!
+class WorldPartition
+{
+public:
+	WorldPartition();
+	~WorldPartition();
+
+	// Takes the source path, only reads the cooked scene & builds the grid. Nothing is loaded till the first Update()
+	bool								Initialize(const VulkanContext* pContext, SceneLoader* pLoader, const std::string& sourcePath);
+
+	// Main thread, once per frame. Adds models of cells that finished loading to listSceneModels & takes out the ones
+	// of cells that are unloaded!
+	void								Update(VulkanContext* pContext, const Camera* pCamera, std::vector<VulkanModel*>& listSceneModels);
+
+	// Once GPU is idle, after the loader's Cleanup(). Models still in the scene are the scene's to clean up
+	void								Cleanup(VulkanContext* pContext);
+
+	inline uint32_t						GetNumCells() const				{ return static_cast<uint32_t>(m_ListCells.size()); }
+	inline uint32_t						GetNumLoadedCells() const		{ return m_uiNumLoadedCells; }
+	inline uint32_t						GetNumInstances() const			{ return m_uiNumInstances; }
+	inline uint32_t						GetNumResidentModels() const	{ return m_uiNumResidentModels; }
+	inline VkDeviceSize					GetResidentBytes() const		{ return m_vkResidentBytes; }
+
+private:
+	void								BuildCells(const SceneFile& scene);
+	void								ReceiveModels(VulkanContext* pContext, std::vector<VulkanModel*>& listSceneModels);
+	void								UpdateCells(const Camera* pCamera);
+	void								UnloadFarCells(std::vector<VulkanModel*>& listSceneModels);
+	void								LoadNearCells(const VulkanContext* pContext, std::vector<VulkanModel*>& listSceneModels);
+	bool								UnloadCell(uint32_t uiCell, std::vector<VulkanModel*>& listSceneModels);
+	VkDeviceSize						EstimateCellSize(const WorldCell& cell) const;
+	void								DestroyRetiredModels(VulkanContext* pContext, bool bAll);
+
+private:
+	SceneLoader*						m_pLoader;
+	std::vector<WorldCell>				m_ListCells;
+	std::deque<RetiredModel>			m_ListRetiredModels;			// oldest first
+
+	uint64_t							m_uiFrame;
+	uint32_t							m_uiNumInstances;
+	uint32_t							m_uiNumLoadedCells;
+	uint32_t							m_uiNumResidentModels;
+	VkDeviceSize						m_vkResidentBytes;				// loaded & loading cells plus retired models
+	VkDeviceSize						m_vkRetiredBytes;
+	VkDeviceSize						m_vkBytesPerInstance;			// of loaded cells, estimate for cells never loaded. 0 till one is
+	CountedResources					m_CountedResources;				// scratch, see VulkanModel::GetResidentSize()
+	bool								m_bBudgetFull;
+};
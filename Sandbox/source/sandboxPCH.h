@@ -7,6 +7,7 @@
 
 #include <filesystem>
 #include <sstream>
+#include <iomanip>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -14,4 +15,12 @@
 #include <set>
 #include <tuple>
 #include <array>
-#include <list>
\ No newline at end of file
+#include <list>
+#include <deque>
+#include <queue>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
\ No newline at end of file